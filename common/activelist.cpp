@@ -0,0 +1,89 @@
+#include "activelist.h"
+
+#include <stddef.h>
+
+ActiveListClass::ActiveListClass()
+    : Pointers(NULL)
+    , Blocks(NULL)
+    , Positions(NULL)
+    , Length(0)
+    , Active(0)
+{
+}
+
+ActiveListClass::~ActiveListClass()
+{
+    Clear();
+}
+
+/*
+**	Sets the number of blocks, none of them active.
+*/
+bool ActiveListClass::Resize(int count)
+{
+    Clear();
+
+    if (count <= 0) {
+        return true;
+    }
+
+    Pointers = new void*[count];
+    Blocks = new int[count];
+    Positions = new int[count];
+    Length = count;
+    Reset();
+
+    return true;
+}
+
+void ActiveListClass::Clear()
+{
+    delete[] Pointers;
+    delete[] Blocks;
+    delete[] Positions;
+    Pointers = NULL;
+    Blocks = NULL;
+    Positions = NULL;
+    Length = 0;
+    Active = 0;
+}
+
+void ActiveListClass::Reset()
+{
+    for (int i = 0; i < Length; ++i) {
+        Positions[i] = -1;
+    }
+    Active = 0;
+}
+
+/*
+**	Adds a block to the end of the order. The block must not already be active.
+*/
+void ActiveListClass::Add(int index, void* pointer)
+{
+    Pointers[Active] = pointer;
+    Blocks[Active] = index;
+    Positions[index] = Active;
+    ++Active;
+}
+
+/*
+**	Takes a block out of the order, moving the last active block into the hole. Does nothing if the block isn't active.
+*/
+void ActiveListClass::Remove(int index)
+{
+    int position = Position(index);
+
+    if (position < 0) {
+        return;
+    }
+
+    int last = --Active;
+
+    if (position != last) {
+        Pointers[position] = Pointers[last];
+        Blocks[position] = Blocks[last];
+        Positions[Blocks[position]] = position;
+    }
+    Positions[index] = -1;
+}
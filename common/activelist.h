@@ -0,0 +1,45 @@
+#ifndef ACTIVELIST_H
+#define ACTIVELIST_H
+
+/*
+**	The allocated blocks of a heap in the order they are iterated, along with the position of each block in that
+**	order so a block can be removed without searching for it. Removing a block moves the last one into its place, so
+**	the order only depends on the sequence of adds and removes.
+*/
+class ActiveListClass
+{
+public:
+    ActiveListClass();
+    ~ActiveListClass();
+
+    bool Resize(int count);
+    void Clear();
+    void Reset();
+    void Add(int index, void* pointer);
+    void Remove(int index);
+
+    int Count() const
+    {
+        return Active;
+    }
+    int Position(int index) const
+    {
+        return index >= 0 && index < Length ? Positions[index] : -1;
+    }
+    void* operator[](int position) const
+    {
+        return Pointers[position];
+    }
+
+private:
+    void** Pointers; // Active blocks in iteration order.
+    int* Blocks;     // Index of the block at each position.
+    int* Positions;  // Position of each block, or -1 if it isn't active.
+    int Length;
+    int Active;
+
+    ActiveListClass(ActiveListClass const&);
+    ActiveListClass& operator=(ActiveListClass const&);
+};
+
+#endif /* ACTIVELIST_H */
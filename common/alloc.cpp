@@ -35,12 +35,25 @@
  *   Resize_Alloc -- Change the size of an allocated block.                *
  *   Heap_Size -- Size of the heap we have.                                *
  *   Total_Ram_Free -- Total amount of free RAM.                           *
+ *   Memory_Tag_Set -- Sets the subsystem this thread's memory goes to.    *
+ *   Memory_Tag_Add -- Accounts memory that doesn't come from Alloc.       *
+ *   Memory_Stats -- Fetches the memory accounting for a subsystem.        *
+ *   Memory_Report -- Formats the memory accounting as a table.            *
+ *   Memory_Report_File -- Writes the memory accounting table to a file.   *
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
+#include <assert.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
 
 #include "wwmem.h"
+#ifdef SLAB_ALLOC
+#include "slaballoc.h"
+#endif
 
 unsigned long Largest_Mem_Block(void);
 
@@ -58,6 +71,75 @@ static unsigned long Memory_Calls = 0L;
 void (*Memory_Error)(void) = NULL;
 extern void (*Memory_Error_Exit)(char* string) = NULL;
 
+/*
+**	Every block from Alloc starts with this header, so Free and Resize_Alloc only take pointers that Alloc (or
+**	operator new, which goes through it) handed out. The magic word is cleared on Free and only checks for blocks
+**	freed twice or from somewhere else.
+*/
+struct AllocHeaderType
+{
+    size_t Size;
+    uint32_t Magic;
+    uint32_t Tag;
+};
+
+#define ALLOC_HEADER 16
+static_assert(sizeof(AllocHeaderType) <= ALLOC_HEADER, "Alloc header must keep blocks 16 byte aligned.");
+
+/*
+**	Counts for each subsystem, with the totals for all of them in the extra entry at the end.
+*/
+struct TagCountType
+{
+    std::atomic<long> Current;
+    std::atomic<long> Peak;
+    std::atomic<unsigned long> Allocs;
+    std::atomic<unsigned long> Frees;
+};
+
+static TagCountType TagCounts[MEM_TAG_COUNT + 1];
+static thread_local int CurrentTag = MEM_TAG_OTHER;
+
+static char const* const TagNames[MEM_TAG_COUNT + 1] =
+    {"Other", "Mixfiles", "Shapes", "Movies", "Audio", "INI", "Object heaps", "Map", "Total"};
+
+static inline uint32_t Alloc_Magic(AllocHeaderType const* header)
+{
+    return (uint32_t)((uintptr_t)header >> 4) ^ 0xA110C8EDu;
+}
+
+static AllocHeaderType* Alloc_Header(void const* pointer)
+{
+    AllocHeaderType* header = (AllocHeaderType*)((char*)pointer - ALLOC_HEADER);
+    assert(header->Magic == Alloc_Magic(header));
+    return header;
+}
+
+static void Count_Bytes(TagCountType& count, long bytes)
+{
+    long current = count.Current.fetch_add(bytes) + bytes;
+    long peak = count.Peak.load();
+
+    while (current > peak && !count.Peak.compare_exchange_weak(peak, current)) {
+    }
+}
+
+static void Count_Alloc(int tag, long bytes)
+{
+    Count_Bytes(TagCounts[tag], bytes);
+    Count_Bytes(TagCounts[MEM_TAG_COUNT], bytes);
+    TagCounts[tag].Allocs++;
+    TagCounts[MEM_TAG_COUNT].Allocs++;
+}
+
+static void Count_Free(int tag, long bytes)
+{
+    TagCounts[tag].Current -= bytes;
+    TagCounts[MEM_TAG_COUNT].Current -= bytes;
+    TagCounts[tag].Frees++;
+    TagCounts[MEM_TAG_COUNT].Frees++;
+}
+
 /***************************************************************************
  * Alloc -- Allocates system RAM.                                          *
  *                                                                         *
@@ -71,6 +153,9 @@ extern void (*Memory_Error_Exit)(char* string) = NULL;
  *             MEM_CLEAR:  Zero out memory block.                        	*
  *             MEM_NEW:		Called by a new.                                *
  *                                                                         *
+ *          With SLAB_ALLOC defined, small MEM_NEW blocks come from the    *
+ *          size class pools in SLABALLOC.CPP.                             *
+ *                                                                         *
  * OUTPUT:  Returns with pointer to allocated block.  If NULL was returned *
  *          it indicates a failure to allocate.  Note: NULL will never be  *
  *          returned if the standard library allocation error routine is   *
@@ -91,17 +176,60 @@ void* Alloc(size_t bytes_to_alloc, MemoryFlagType flags)
 {
     void* mem_ptr;
 
+    /*
+    **	Record which subsystem the block belongs to, so Free can take it off the right count.
+    */
+    int tag = (flags & MEM_TAG) ? ((flags & MEM_TAG) >> 8) - 1 : CurrentTag;
+    if (tag < 0 || tag >= MEM_TAG_COUNT) {
+        tag = MEM_TAG_OTHER;
+    }
+
+#ifdef SLAB_ALLOC
+    /*
+    **	The pools keep the tag with the chunk instead of in a header, and count the whole block.
+    */
+    if (flags & MEM_NEW) {
+        mem_ptr = Slab_Alloc(bytes_to_alloc, (MemoryTagType)tag);
+
+        if (mem_ptr != NULL) {
+            size_t slab_size;
+            MemoryTagType slab_tag;
+            Slab_Info(mem_ptr, slab_size, slab_tag);
+            Count_Alloc(tag, (long)slab_size);
+
+            if (flags & MEM_CLEAR) {
+                memset(mem_ptr, 0, bytes_to_alloc);
+            }
+
+            Memory_Calls++;
+            return (mem_ptr);
+        }
+    }
+#endif
+
 #ifdef MEM_CHECK
     bytes_to_alloc += 32;
 #endif // MEM_CHECK
 
-    mem_ptr = malloc(bytes_to_alloc);
+    mem_ptr = malloc(bytes_to_alloc + ALLOC_HEADER);
 
     if (!mem_ptr && Memory_Error) {
         Memory_Error();
     }
 
-    if (mem_ptr && (flags & MEM_CLEAR)) {
+    if (!mem_ptr) {
+        return (NULL);
+    }
+
+    AllocHeaderType* header = (AllocHeaderType*)mem_ptr;
+    header->Size = bytes_to_alloc;
+    header->Magic = Alloc_Magic(header);
+    header->Tag = tag;
+    Count_Alloc(tag, (long)bytes_to_alloc);
+
+    mem_ptr = (char*)mem_ptr + ALLOC_HEADER;
+
+    if (flags & MEM_CLEAR) {
         memset(mem_ptr, 0, bytes_to_alloc);
     }
 
@@ -143,6 +271,18 @@ void Free(void const* pointer)
 
     if (pointer) {
 
+#ifdef SLAB_ALLOC
+        size_t slab_size;
+        MemoryTagType slab_tag;
+
+        if (Slab_Info(pointer, slab_size, slab_tag)) {
+            Count_Free(slab_tag, (long)slab_size);
+            Slab_Free((void*)pointer);
+            Memory_Calls--;
+            return;
+        }
+#endif
+
 #ifdef MEM_CHECK
 
         unsigned long* magic_ptr = (unsigned long*)(((char*)pointer) - 16);
@@ -162,7 +302,11 @@ void Free(void const* pointer)
         pointer = (void*)(((char*)pointer) - 16);
 #endif // MEM_CHECK
 
-        free((void*)pointer);
+        AllocHeaderType* header = Alloc_Header(pointer);
+        Count_Free(header->Tag, (long)header->Size);
+        header->Magic = 0;
+
+        free(header);
         Memory_Calls--;
     }
 }
@@ -179,27 +323,54 @@ void Free(void const* pointer)
  *                                                                         *
  * OUTPUT:  Returns with a pointer to the new allocation.                  *
  *                                                                         *
- * WARNINGS:   ???                                                         *
+ * WARNINGS:   The block must have come from Alloc.                        *
  *                                                                         *
  * HISTORY:                                                                *
  *   02/01/1992 JLB : Commented.                                           *
  *=========================================================================*/
 void* Resize_Alloc(void* original_ptr, unsigned long new_size_in_bytes)
 {
+    if (original_ptr == NULL) {
+        return (Alloc(new_size_in_bytes, MEM_NORMAL));
+    }
+
+#ifdef SLAB_ALLOC
+    /*
+    **	A block from the pools can't grow in place, so move it to a new one under the same tag.
+    */
+    size_t slab_size;
+    MemoryTagType slab_tag;
 
-    unsigned long* temp;
+    if (Slab_Info(original_ptr, slab_size, slab_tag)) {
+        void* resized = Alloc(new_size_in_bytes, Memory_Tag_Flag(slab_tag, MEM_NEW));
 
-    temp = (unsigned long*)original_ptr;
+        if (resized != NULL) {
+            memcpy(resized, original_ptr, slab_size < new_size_in_bytes ? slab_size : new_size_in_bytes);
+            Free(original_ptr);
+        }
+        return (resized);
+    }
+#endif
+
+    AllocHeaderType* header = Alloc_Header(original_ptr);
 
     /* ReAlloc the space */
-    temp = (unsigned long*)realloc(temp, new_size_in_bytes);
-    if (temp == NULL) {
+    long old_size = (long)header->Size;
+    int tag = header->Tag;
+
+    header = (AllocHeaderType*)realloc(header, new_size_in_bytes + ALLOC_HEADER);
+    if (header == NULL) {
         if (Memory_Error != NULL)
             Memory_Error();
         return NULL;
     }
 
-    return (temp);
+    header->Size = new_size_in_bytes;
+    header->Magic = Alloc_Magic(header);
+    Count_Bytes(TagCounts[tag], (long)new_size_in_bytes - old_size);
+    Count_Bytes(TagCounts[MEM_TAG_COUNT], (long)new_size_in_bytes - old_size);
+
+    return ((char*)header + ALLOC_HEADER);
 }
 
 /***************************************************************************
@@ -264,3 +435,140 @@ long Total_Ram_Free(MemoryFlagType)
 {
     return (64 * 1024 * 1024);
 }
+
+/***************************************************************************
+ * Memory_Tag_Set -- Sets the subsystem this thread's memory goes to.      *
+ *                                                                         *
+ *    Allocations on this thread that don't give a tag in their flags are  *
+ *    accounted to this subsystem from now on. MemoryTagClass is the       *
+ *    usual way to call this.                                              *
+ *                                                                         *
+ * INPUT:   tag   -- The subsystem to account to.                          *
+ *                                                                         *
+ * OUTPUT:  Returns with the subsystem that was set before.                *
+ *                                                                         *
+ * WARNINGS:   none                                                        *
+ *=========================================================================*/
+MemoryTagType Memory_Tag_Set(MemoryTagType tag)
+{
+    MemoryTagType previous = (MemoryTagType)CurrentTag;
+    CurrentTag = tag;
+    return (previous);
+}
+
+/***************************************************************************
+ * Memory_Tag_Add -- Accounts memory that doesn't come from Alloc.         *
+ *                                                                         *
+ *    Code that gets its memory some other way can still show up in the    *
+ *    accounting by reporting it here. Each call counts as one block.      *
+ *                                                                         *
+ * INPUT:   tag   -- The subsystem the memory belongs to.                  *
+ *                                                                         *
+ *          bytes -- Bytes allocated, or negative for bytes freed.         *
+ *                                                                         *
+ * OUTPUT:  none                                                           *
+ *                                                                         *
+ * WARNINGS:   none                                                        *
+ *=========================================================================*/
+void Memory_Tag_Add(MemoryTagType tag, long bytes)
+{
+    if (tag < 0 || tag >= MEM_TAG_COUNT) {
+        tag = MEM_TAG_OTHER;
+    }
+
+    if (bytes >= 0) {
+        Count_Alloc(tag, bytes);
+    } else {
+        Count_Free(tag, -bytes);
+    }
+}
+
+/***************************************************************************
+ * Memory_Stats -- Fetches the memory accounting for a subsystem.          *
+ *                                                                         *
+ * INPUT:   tag   -- The subsystem, or MEM_TAG_COUNT for all of them.      *
+ *                                                                         *
+ *          stats -- Filled in with the counts.                            *
+ *                                                                         *
+ * OUTPUT:  none                                                           *
+ *                                                                         *
+ * WARNINGS:   none                                                        *
+ *=========================================================================*/
+void Memory_Stats(MemoryTagType tag, MemoryStatsType& stats)
+{
+    if (tag < 0 || tag > MEM_TAG_COUNT) {
+        tag = MEM_TAG_OTHER;
+    }
+
+    TagCountType& count = TagCounts[tag];
+    stats.Current = (unsigned long)count.Current.load();
+    stats.Peak = (unsigned long)count.Peak.load();
+    stats.Allocs = count.Allocs.load();
+    stats.Frees = count.Frees.load();
+}
+
+char const* Memory_Tag_Name(MemoryTagType tag)
+{
+    if (tag < 0 || tag > MEM_TAG_COUNT) {
+        tag = MEM_TAG_OTHER;
+    }
+    return (TagNames[tag]);
+}
+
+/***************************************************************************
+ * Memory_Report -- Formats the memory accounting as a table.              *
+ *                                                                         *
+ *    Writes one line for each subsystem and one for the totals, in        *
+ *    kilobytes for the sizes.                                             *
+ *                                                                         *
+ * INPUT:   buffer   -- Where to put the text.                             *
+ *                                                                         *
+ *          length   -- Size of the buffer.                                *
+ *                                                                         *
+ * OUTPUT:  Returns with the length of the text, not counting the null.    *
+ *                                                                         *
+ * WARNINGS:   The text is cut short if the buffer is too small.           *
+ *=========================================================================*/
+int Memory_Report(char* buffer, int length)
+{
+    int used = snprintf(
+        buffer, length, "%-14s %10s %10s %10s %10s\n", "Subsystem", "Current K", "Peak K", "Allocs", "Frees");
+
+    for (int tag = 0; tag <= MEM_TAG_COUNT && used >= 0 && used < length; ++tag) {
+        MemoryStatsType stats;
+        Memory_Stats((MemoryTagType)tag, stats);
+        used += snprintf(buffer + used,
+                         length - used,
+                         "%-14s %10lu %10lu %10lu %10lu\n",
+                         TagNames[tag],
+                         stats.Current / 1024,
+                         stats.Peak / 1024,
+                         stats.Allocs,
+                         stats.Frees);
+    }
+
+    return (used < length ? used : length - 1);
+}
+
+/***************************************************************************
+ * Memory_Report_File -- Writes the memory accounting table to a file.     *
+ *                                                                         *
+ * INPUT:   filename -- The file to write, replacing what was there.       *
+ *                                                                         *
+ * OUTPUT:  Returns true if the file was written.                          *
+ *                                                                         *
+ * WARNINGS:   none                                                        *
+ *=========================================================================*/
+bool Memory_Report_File(char const* filename)
+{
+    char report[1024];
+    int length = Memory_Report(report, sizeof(report));
+
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        return (false);
+    }
+
+    bool ok = fwrite(report, 1, length, file) == (size_t)length;
+    return (fclose(file) == 0 && ok);
+}
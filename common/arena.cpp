@@ -0,0 +1,175 @@
+#include "arena.h"
+#include "straw.h"
+#include "wwmem.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+**	Everything handed out is aligned to this, and block headers are padded out to it.
+*/
+static int const ArenaAlign = sizeof(void*) * 2;
+
+#define ARENA_HEADER ((int)((sizeof(BlockType) + ArenaAlign - 1) & ~(ArenaAlign - 1)))
+
+ArenaClass::ArenaClass(int block_size)
+    : Blocks(NULL)
+    , Current(NULL)
+    , Large(NULL)
+    , BlockSize(block_size)
+    , UsedBytes(0)
+    , ReservedBytes(0)
+    , HighWater(0)
+    , PeakBytes(0)
+{
+}
+
+ArenaClass::~ArenaClass()
+{
+    Release();
+}
+
+void ArenaClass::Add_Used(int size)
+{
+    UsedBytes += size;
+    if (UsedBytes > HighWater) {
+        HighWater = UsedBytes;
+    }
+    if (UsedBytes > PeakBytes) {
+        PeakBytes = UsedBytes;
+    }
+}
+
+/*
+**	Returns aligned memory, or NULL if no block could be had.
+*/
+void* ArenaClass::Alloc(int size)
+{
+    size = (size + ArenaAlign - 1) & ~(ArenaAlign - 1);
+
+    if (size > BlockSize) {
+        BlockType* block = (BlockType*)::Alloc(ARENA_HEADER + size, MEM_NORMAL);
+        if (block == NULL) {
+            return NULL;
+        }
+        block->Size = size;
+        block->Used = size;
+        block->Next = Large;
+        Large = block;
+        ReservedBytes += size;
+        Add_Used(size);
+        return (char*)block + ARENA_HEADER;
+    }
+
+    if (Current == NULL || Current->Size - Current->Used < size) {
+        BlockType* next = Current != NULL ? Current->Next : Blocks;
+
+        /*
+        **	Blocks kept from before the last reset are used again before any new ones are made.
+        */
+        if (next == NULL) {
+            next = (BlockType*)::Alloc(ARENA_HEADER + BlockSize, MEM_NORMAL);
+            if (next == NULL) {
+                return NULL;
+            }
+            next->Size = BlockSize;
+            next->Next = NULL;
+            if (Current != NULL) {
+                Current->Next = next;
+            } else {
+                Blocks = next;
+            }
+            ReservedBytes += BlockSize;
+        }
+        next->Used = 0;
+        Current = next;
+    }
+
+    void* ptr = (char*)Current + ARENA_HEADER + Current->Used;
+    Current->Used += size;
+    Add_Used(size);
+    return ptr;
+}
+
+/*
+**	Reads a whole stream into a block of its own. There is always one writable byte past the end of the data.
+*/
+char* ArenaClass::Read(Straw& straw, int& length)
+{
+    int capacity = BlockSize;
+    BlockType* block = (BlockType*)::Alloc(ARENA_HEADER + capacity + 1, MEM_NORMAL);
+    if (block == NULL) {
+        return NULL;
+    }
+
+    length = 0;
+    for (;;) {
+        if (length == capacity) {
+            capacity *= 2;
+            BlockType* grown = (BlockType*)Resize_Alloc(block, ARENA_HEADER + capacity + 1);
+            if (grown == NULL) {
+                Free(block);
+                return NULL;
+            }
+            block = grown;
+        }
+
+        int got = straw.Get((char*)block + ARENA_HEADER + length, capacity - length);
+        if (got <= 0) {
+            break;
+        }
+        length += got;
+    }
+
+    block->Size = capacity;
+    block->Used = capacity;
+    block->Next = Large;
+    Large = block;
+    ReservedBytes += capacity;
+    Add_Used(length + 1);
+
+    return (char*)block + ARENA_HEADER;
+}
+
+char* ArenaClass::Duplicate(char const* string)
+{
+    int length = (int)strlen(string) + 1;
+    char* copy = (char*)Alloc(length);
+    if (copy != NULL) {
+        memcpy(copy, string, length);
+    }
+    return copy;
+}
+
+/*
+**	Forgets everything allocated. Standard blocks are kept for reuse, so only the large ones are walked.
+*/
+void ArenaClass::Reset()
+{
+    while (Large != NULL) {
+        BlockType* next = Large->Next;
+        ReservedBytes -= Large->Size;
+        Free(Large);
+        Large = next;
+    }
+
+    Current = NULL;
+    UsedBytes = 0;
+    HighWater = 0;
+}
+
+/*
+**	Forgets everything allocated and gives every block back.
+*/
+void ArenaClass::Release()
+{
+    Reset();
+
+    while (Blocks != NULL) {
+        BlockType* next = Blocks->Next;
+        Free(Blocks);
+        Blocks = next;
+    }
+
+    ReservedBytes = 0;
+}
@@ -0,0 +1,73 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+class Straw;
+
+/*
+**	Block allocator for data that all goes away at once. Allocations are carved out of fixed size blocks and never
+**	freed one at a time; Reset() rewinds to the first block in constant time and keeps the blocks for the next
+**	round, so a load that is repeated over and over reuses the same memory instead of breaking up the heap.
+**	Requests bigger than a block, and whole streams from Read(), get blocks of their own which Reset() frees.
+**
+**	Nothing allocated from an arena may be used, or have its destructor run, after the arena is reset.
+*/
+class ArenaClass
+{
+public:
+    ArenaClass(int block_size = 16 * 1024);
+    ~ArenaClass();
+
+    void* Alloc(int size);
+    char* Read(Straw& straw, int& length);
+    char* Duplicate(char const* string);
+    void Reset();
+    void Release();
+
+    /*
+    **	Bytes handed out since the last reset, and the most there have been at once in that time and overall.
+    */
+    unsigned long Used() const
+    {
+        return UsedBytes;
+    }
+    unsigned long High_Water() const
+    {
+        return HighWater;
+    }
+    unsigned long Peak() const
+    {
+        return PeakBytes;
+    }
+
+    /*
+    **	Bytes held in blocks, used or not.
+    */
+    unsigned long Reserved() const
+    {
+        return ReservedBytes;
+    }
+
+private:
+    struct BlockType
+    {
+        BlockType* Next;
+        int Size;
+        int Used;
+    };
+
+    void Add_Used(int size);
+
+    BlockType* Blocks;  // Standard blocks, kept over a reset.
+    BlockType* Current; // The standard block being filled.
+    BlockType* Large;   // Blocks of their own, freed by a reset.
+    int BlockSize;
+    unsigned long UsedBytes;
+    unsigned long ReservedBytes;
+    unsigned long HighWater;
+    unsigned long PeakBytes;
+
+    ArenaClass(ArenaClass const&);
+    ArenaClass& operator=(ArenaClass const&);
+};
+
+#endif /* ARENA_H */
@@ -56,6 +56,28 @@ typedef struct
 } AUDHeaderType;
 #pragma pack(pop)
 
+/*
+**	Counters kept by backends that mix and stream on their own thread. They only ever count up, sample them once
+**	a frame and take the difference for per frame figures.
+*/
+typedef struct
+{
+    unsigned Underruns;   // Times a playing stream ran dry before its next buffer was ready.
+    unsigned QueueStalls; // Times the game waited for room in the audio thread's command queue.
+    unsigned Commands;    // Play, stop and fade requests handled by the audio thread.
+
+    unsigned CacheHits;      // Sound effects played from already decoded data.
+    unsigned CacheMisses;    // Sound effects that had to be decoded first.
+    unsigned CacheEvictions; // Decoded samples dropped to stay within the cache size.
+    unsigned CacheBytes;     // Decoded data currently cached.
+    unsigned CacheCount;     // Samples currently cached.
+
+    unsigned VoiceStarts;    // Sound effects given a voice of their own.
+    unsigned VoiceCoalesced; // Repeats of a sample that joined the voice already playing it.
+    unsigned VoiceCulls;     // Sound effects dropped as inaudible or outranked before anything was decoded.
+    unsigned VoiceSteals;    // Playing sounds stopped to make room for a more important one.
+} SoundStatisticsType;
+
 /*=========================================================================*/
 /*	There can be a different sound driver for sound effects, digitized		*/
 /*	samples, and musical scores.  Each one must be of these specified			*/
@@ -144,6 +166,7 @@ void Restore_Sound_Buffers(void);
 bool Set_Primary_Buffer_Format(void);
 bool Start_Primary_Sound_Buffer(bool forced);
 void Stop_Primary_Sound_Buffer(void);
+void Get_Sound_Statistics(SoundStatisticsType* stats);
 
 /*
 ** Function to call if we detect focus loss
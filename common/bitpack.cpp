@@ -0,0 +1,186 @@
+#include "bitpack.h"
+
+BitPackClass::BitPackClass(void* buffer, int size)
+    : Buffer((unsigned char*)buffer)
+    , Size(size * 8)
+    , Bits(0)
+    , Overflow(false)
+{
+}
+
+/*
+**	Appends the low 'bits' bits of value, up to 32. Once a write has overflowed all further writes are ignored until
+**	the caller rewinds.
+*/
+void BitPackClass::Put(uint32_t value, int bits)
+{
+    if (Overflow || Bits + bits > Size) {
+        Overflow = true;
+        return;
+    }
+
+    while (bits > 0) {
+        int offset = Bits & 7;
+        int count = bits < 8 - offset ? bits : 8 - offset;
+        unsigned char* byte = Buffer + (Bits >> 3);
+
+        // First write to a byte clears whatever was left in it.
+        if (offset == 0) {
+            *byte = 0;
+        }
+
+        *byte |= (value & ((1u << count) - 1)) << offset;
+        value >>= count;
+        Bits += count;
+        bits -= count;
+    }
+}
+
+/*
+**	Seven bits at a time with a continuation flag, so small values take a byte and frame numbers three.
+*/
+void BitPackClass::Put_Varint(uint32_t value)
+{
+    while (value >= 0x80) {
+        Put((value & 0x7F) | 0x80, 8);
+        value >>= 7;
+    }
+
+    Put(value, 8);
+}
+
+/*
+**	Zigzag maps small negative and positive values alike onto small varints.
+*/
+void BitPackClass::Put_Signed(int32_t value)
+{
+    Put_Varint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+void BitPackClass::Put_Bytes(void const* data, int length)
+{
+    unsigned char const* bytes = (unsigned char const*)data;
+
+    for (int i = 0; i < length; ++i) {
+        Put(bytes[i], 8);
+    }
+}
+
+/*
+**	Stores data as a change against prev: one bit per byte saying whether it differs, then only the bytes that do.
+**	Records that repeat most of the previous one of their kind shrink to little more than the mask. Records are
+**	limited to 256 bytes.
+*/
+void BitPackClass::Put_Delta(void const* data, void const* prev, int length)
+{
+    unsigned char const* bytes = (unsigned char const*)data;
+    unsigned char const* old = (unsigned char const*)prev;
+
+    for (int i = 0; i < length; ++i) {
+        Put(bytes[i] != old[i], 1);
+    }
+
+    for (int i = 0; i < length; ++i) {
+        if (bytes[i] != old[i]) {
+            Put(bytes[i], 8);
+        }
+    }
+}
+
+void BitPackClass::Rewind(int position)
+{
+    Bits = position;
+    Overflow = false;
+
+    // Clear the tail of a partly written byte so the next write can OR into it.
+    if (Bits & 7) {
+        Buffer[Bits >> 3] &= (1u << (Bits & 7)) - 1;
+    }
+}
+
+BitUnpackClass::BitUnpackClass(void const* buffer, int size)
+    : Buffer((unsigned char const*)buffer)
+    , Size(size * 8)
+    , Bits(0)
+    , Underflow(false)
+{
+}
+
+uint32_t BitUnpackClass::Get(int bits)
+{
+    if (Underflow || Bits + bits > Size) {
+        Underflow = true;
+        return 0;
+    }
+
+    uint32_t value = 0;
+    int shift = 0;
+
+    while (bits > 0) {
+        int offset = Bits & 7;
+        int count = bits < 8 - offset ? bits : 8 - offset;
+
+        value |= (uint32_t)((Buffer[Bits >> 3] >> offset) & ((1u << count) - 1)) << shift;
+        shift += count;
+        Bits += count;
+        bits -= count;
+    }
+
+    return value;
+}
+
+uint32_t BitUnpackClass::Get_Varint()
+{
+    uint32_t value = 0;
+
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint32_t byte = Get(8);
+        value |= (byte & 0x7F) << shift;
+
+        if (!(byte & 0x80)) {
+            break;
+        }
+    }
+
+    return value;
+}
+
+int32_t BitUnpackClass::Get_Signed()
+{
+    uint32_t value = Get_Varint();
+
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+void BitUnpackClass::Get_Bytes(void* data, int length)
+{
+    unsigned char* bytes = (unsigned char*)data;
+
+    for (int i = 0; i < length; ++i) {
+        bytes[i] = Get(8);
+    }
+}
+
+/*
+**	Inverse of BitPackClass::Put_Delta. Data and prev may be the same buffer.
+*/
+void BitUnpackClass::Get_Delta(void* data, void const* prev, int length)
+{
+    unsigned char* bytes = (unsigned char*)data;
+    unsigned char const* old = (unsigned char const*)prev;
+    uint32_t mask[8] = {0};
+
+    // Masks longer than 256 bytes aren't used by anything and would need a bigger buffer.
+    if (length > 256) {
+        Underflow = true;
+        return;
+    }
+
+    for (int i = 0; i < length; ++i) {
+        mask[i >> 5] |= Get(1) << (i & 31);
+    }
+
+    for (int i = 0; i < length; ++i) {
+        bytes[i] = (mask[i >> 5] >> (i & 31)) & 1 ? Get(8) : old[i];
+    }
+}
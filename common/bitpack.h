@@ -0,0 +1,77 @@
+#ifndef BITPACK_H
+#define BITPACK_H
+
+#include <stdint.h>
+
+/*
+**	Writes values of arbitrary bit width into a byte buffer, least significant bit first. A write that doesn't fit
+**	sets the overflow flag and leaves the buffer as it was, so a caller can try to add a record, check Overflowed()
+**	and Rewind() to the position it saved before the attempt.
+*/
+class BitPackClass
+{
+public:
+    BitPackClass(void* buffer, int size);
+
+    void Put(uint32_t value, int bits);
+    void Put_Varint(uint32_t value);
+    void Put_Signed(int32_t value);
+    void Put_Bytes(void const* data, int length);
+    void Put_Delta(void const* data, void const* prev, int length);
+    void Rewind(int position);
+
+    int Position() const
+    {
+        return Bits;
+    }
+    int Length() const
+    {
+        return (Bits + 7) / 8;
+    }
+    bool Overflowed() const
+    {
+        return Overflow;
+    }
+
+private:
+    unsigned char* Buffer;
+    int Size; // In bits.
+    int Bits;
+    bool Overflow;
+};
+
+/*
+**	Reads back what BitPackClass wrote. Reading past the end returns zeros and sets the underflow flag.
+*/
+class BitUnpackClass
+{
+public:
+    BitUnpackClass(void const* buffer, int size);
+
+    uint32_t Get(int bits);
+    uint32_t Get_Varint();
+    int32_t Get_Signed();
+    void Get_Bytes(void* data, int length);
+    void Get_Delta(void* data, void const* prev, int length);
+
+    int Position() const
+    {
+        return Bits;
+    }
+    int Remaining() const
+    {
+        return Size - Bits;
+    }
+    bool Underflowed() const
+    {
+        return Underflow;
+    }
+
+private:
+    unsigned char const* Buffer;
+    int Size; // In bits.
+    int Bits;
+    bool Underflow;
+};
+
+#endif /* BITPACK_H */
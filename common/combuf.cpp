@@ -191,6 +191,7 @@ void CommBufferClass::Init(void)
     NumDelay = 0L;
     MeanDelay = 0L;
     MaxDelay = 0L;
+    Latency.Reset();
 
     SendCount = 0;
 
@@ -651,6 +652,9 @@ ReceiveQueueType* CommBufferClass::Get_Receive(int index)
  * off the total, then the new value is added in.  Thus, any single delay	*
  * value will have an effect on the total that approaches 0 over time, and	*
  * the new delay value contributes to 1/n of the mean.							*
+ *																									*
+ * The last few values are also kept as they are, for percentiles and		*
+ * jitter.																						*
  *                                                                         *
  * INPUT:                                                                  *
  *		delay			value to add into the response time computation				*
@@ -684,6 +688,8 @@ void CommBufferClass::Add_Delay(unsigned long delay)
         MaxDelay = delay;
     }
 
+    Latency.Add(delay);
+
 } /* end of Add_Delay */
 
 /***************************************************************************
@@ -749,6 +755,7 @@ void CommBufferClass::Reset_Response_Time(void)
     NumDelay = 0L;
     MeanDelay = 0L;
     MaxDelay = 0L;
+    Latency.Reset();
 
 } /* end of Reset_Response_Time */
 
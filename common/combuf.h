@@ -48,6 +48,8 @@
 #ifndef COMBUF_H
 #define COMBUF_H
 
+#include "latency.h"
+
 /*
 ********************************** Defines **********************************
 */
@@ -143,6 +145,14 @@ public:
     unsigned long Avg_Response_Time(void); // gets mean response time
     unsigned long Max_Response_Time(void); // gets max response time
     void Reset_Response_Time(void);        // resets computations
+    unsigned long Response_Time_Percentile(int percent) // recent delay at a percentile
+    {
+        return (Latency.Percentile(percent));
+    }
+    unsigned long Response_Jitter(int percent) // recent delay change at a percentile
+    {
+        return (Latency.Jitter(percent));
+    }
 
     /*
     ........................ Debug output routines ........................
@@ -170,6 +180,7 @@ private:
     unsigned long NumDelay;  // current # delay times summed
     unsigned long MeanDelay; // current average delay time
     unsigned long MaxDelay;  // max delay ever for this queue
+    LatencyClass Latency;    // last few delay times, for percentiles
 
     /*
     ........................ Send Queue variables .........................
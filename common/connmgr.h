@@ -124,6 +124,19 @@ public:
     virtual unsigned long Response_Time(void) = 0;
     virtual void Set_Timing(unsigned long retrydelta, unsigned long maxretries, unsigned long timeout) = 0;
 
+    /*.....................................................................
+    Response time spread.  Managers that don't keep per-packet samples
+    fall back on the average, with no jitter.
+    .....................................................................*/
+    virtual unsigned long Response_Time_Percentile(int percent)
+    {
+        return (Response_Time());
+    }
+    virtual unsigned long Response_Jitter(int percent)
+    {
+        return (0);
+    }
+
     /*.....................................................................
     Debugging
     .....................................................................*/
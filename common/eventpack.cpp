@@ -0,0 +1,214 @@
+#include "eventpack.h"
+
+#include <string.h>
+
+/*
+**	The packet is a bit stream, least significant bit first:
+**
+**	  8 bits	header type, so the packet can still be told apart from others by its first byte
+**	  varint	header frame
+**	  5 bits	header ID
+**	  delta		header data, against zero
+**
+**	followed by runs of events of one type, frame and ID:
+**
+**	  6 bits	event type + 1; 0 ends the packet
+**	  1 bit		set if the run's frame and ID differ from the header's; if so, a signed varint frame delta and 5 bits
+**				of ID follow
+**
+**	and each event of the run:
+**
+**	  delta		event data, against the last event of this type in the packet (or zero)
+**	  n bytes	any extra data the caller attached to the event
+**	  1 bit		set if another event of the run follows
+**
+**	A delta is one bit per data byte, set where the byte has changed, then the changed bytes. A run of the same order
+**	to the same target costs a few bits more than the bytes that differ, and events of other types in between don't
+**	break the chain.
+*/
+EventPackClass::EventPackClass(void* buffer, int size, unsigned char const* lengths)
+    : Pack(buffer, size)
+    , Lengths(lengths)
+    , Size(size * 8)
+    , HeaderFrame(0)
+    , HeaderID(0)
+    , RunType(-1)
+    , RunFrame(0)
+    , RunID(0)
+    , Mark(-1)
+    , LastRunType(-1)
+    , LastRunFrame(0)
+    , LastRunID(0)
+{
+    memset(Prev, 0, sizeof(Prev));
+}
+
+void EventPackClass::Put_Header(int type, uint32_t frame, int id, void const* data)
+{
+    static unsigned char const zero[EVENTPACK_MAX_DATA] = {0};
+
+    HeaderFrame = frame;
+    HeaderID = id;
+
+    Pack.Put(type, 8);
+    Pack.Put_Varint(frame);
+    Pack.Put(id, 5);
+    Pack.Put_Delta(data, zero, Lengths[type]);
+}
+
+/*
+**	Adds an event, continuing the current run when it can. An event that wouldn't leave room for the end of the run
+**	and the end of the packet is left out, and false is returned with the packet as it was.
+*/
+bool EventPackClass::Put_Event(int type, uint32_t frame, int id, void const* data, void const* extra, int extrasize)
+{
+    int length = Lengths[type];
+    int mark = Pack.Position();
+
+    if (type == RunType && frame == RunFrame && id == RunID) {
+        Pack.Put(1, 1);
+    } else {
+        if (RunType != -1) {
+            Pack.Put(0, 1);
+        }
+        Pack.Put(type + 1, 6);
+
+        if (frame == HeaderFrame && id == HeaderID) {
+            Pack.Put(0, 1);
+        } else {
+            Pack.Put(1, 1);
+            Pack.Put_Signed((int)frame - (int)HeaderFrame);
+            Pack.Put(id, 5);
+        }
+    }
+
+    Pack.Put_Delta(data, Prev[type], length);
+    Pack.Put_Bytes(extra, extrasize);
+
+    if (Pack.Overflowed() || Pack.Position() + 7 > Size) {
+        Pack.Rewind(mark);
+        return false;
+    }
+
+    Mark = mark;
+    LastRunType = RunType;
+    LastRunFrame = RunFrame;
+    LastRunID = RunID;
+    memcpy(LastPrev, Prev[type], length);
+
+    memcpy(Prev[type], data, length);
+    RunType = type;
+    RunFrame = frame;
+    RunID = id;
+
+    return true;
+}
+
+/*
+**	Removes the event the last Put_Event added, for a caller that can't keep it after all. Only the last event can
+**	be taken back.
+*/
+void EventPackClass::Take_Back()
+{
+    if (Mark < 0) {
+        return;
+    }
+
+    memcpy(Prev[RunType], LastPrev, Lengths[RunType]);
+    RunType = LastRunType;
+    RunFrame = LastRunFrame;
+    RunID = LastRunID;
+    Pack.Rewind(Mark);
+    Mark = -1;
+}
+
+/*
+**	Ends the last run and the packet, and returns the packet's length in bytes.
+*/
+int EventPackClass::Finish()
+{
+    if (RunType != -1) {
+        Pack.Put(0, 1);
+    }
+    Pack.Put(0, 6);
+
+    return Pack.Length();
+}
+
+EventUnpackClass::EventUnpackClass(void const* buffer, int size, unsigned char const* lengths, int num_types)
+    : Unpack(buffer, size)
+    , Lengths(lengths)
+    , NumTypes(num_types < EVENTPACK_MAX_TYPES ? num_types : EVENTPACK_MAX_TYPES)
+    , HeaderFrame(0)
+    , HeaderID(0)
+    , RunType(-1)
+    , RunFrame(0)
+    , RunID(0)
+{
+    memset(Prev, 0, sizeof(Prev));
+}
+
+/*
+**	Reads the header into data. Returns false if the packet is too short or doesn't start with a header of this type.
+*/
+bool EventUnpackClass::Get_Header(int type, uint32_t& frame, int& id, void* data)
+{
+    static unsigned char const zero[EVENTPACK_MAX_DATA] = {0};
+
+    if (Unpack.Get(8) != (uint32_t)type) {
+        return false;
+    }
+
+    HeaderFrame = Unpack.Get_Varint();
+    HeaderID = Unpack.Get(5);
+    Unpack.Get_Delta(data, zero, Lengths[type]);
+
+    frame = HeaderFrame;
+    id = HeaderID;
+
+    return !Unpack.Underflowed();
+}
+
+/*
+**	Reads the next event and returns its type, with data pointing at its bytes until the next call. The caller reads
+**	any extra data attached to the event before asking for the next one. Returns -1 at the end of the packet, or
+**	where it is damaged.
+*/
+int EventUnpackClass::Get_Event(uint32_t& frame, int& id, void const*& data)
+{
+    if (RunType == -1 || !Unpack.Get(1)) {
+        int code = Unpack.Get(6);
+
+        if (code == 0 || code > NumTypes || Unpack.Underflowed()) {
+            RunType = -1;
+            return -1;
+        }
+
+        RunType = code - 1;
+        RunFrame = HeaderFrame;
+        RunID = HeaderID;
+
+        if (Unpack.Get(1)) {
+            RunFrame = HeaderFrame + Unpack.Get_Signed();
+            RunID = Unpack.Get(5);
+        }
+    }
+
+    Unpack.Get_Delta(Prev[RunType], Prev[RunType], Lengths[RunType]);
+
+    if (Unpack.Underflowed()) {
+        RunType = -1;
+        return -1;
+    }
+
+    frame = RunFrame;
+    id = RunID;
+    data = Prev[RunType];
+
+    return RunType;
+}
+
+void EventUnpackClass::Get_Bytes(void* data, int length)
+{
+    Unpack.Get_Bytes(data, length);
+}
@@ -0,0 +1,86 @@
+#ifndef EVENTPACK_H
+#define EVENTPACK_H
+
+#include "bitpack.h"
+
+#include <stdint.h>
+
+/*
+**	Largest event type and data the codec keeps a previous record of. The type is sent in 6 bits as type + 1, with 0
+**	ending the packet.
+*/
+#define EVENTPACK_MAX_TYPES 63
+#define EVENTPACK_MAX_DATA  256
+
+/*
+**	Bit packs a header record and a stream of events into a packet, each record delta coded against the last one of
+**	its type. The caller supplies the data length of each event type, so the codec needs nothing from the game.
+*/
+class EventPackClass
+{
+public:
+    EventPackClass(void* buffer, int size, unsigned char const* lengths);
+
+    void Put_Header(int type, uint32_t frame, int id, void const* data);
+    bool Put_Event(int type, uint32_t frame, int id, void const* data, void const* extra = 0, int extrasize = 0);
+    void Take_Back();
+    int Finish();
+
+    bool Overflowed() const
+    {
+        return Pack.Overflowed();
+    }
+
+private:
+    BitPackClass Pack;
+    unsigned char const* Lengths;
+    int Size; // In bits.
+    uint32_t HeaderFrame;
+    int HeaderID;
+
+    /*
+    **	The run the last event belongs to, and what Take_Back needs to undo that event.
+    */
+    int RunType;
+    uint32_t RunFrame;
+    int RunID;
+    int Mark;
+    int LastRunType;
+    uint32_t LastRunFrame;
+    int LastRunID;
+    unsigned char LastPrev[EVENTPACK_MAX_DATA];
+
+    unsigned char Prev[EVENTPACK_MAX_TYPES][EVENTPACK_MAX_DATA];
+};
+
+/*
+**	Reads back what EventPackClass wrote, one event at a time.
+*/
+class EventUnpackClass
+{
+public:
+    EventUnpackClass(void const* buffer, int size, unsigned char const* lengths, int num_types);
+
+    bool Get_Header(int type, uint32_t& frame, int& id, void* data);
+    int Get_Event(uint32_t& frame, int& id, void const*& data);
+    void Get_Bytes(void* data, int length);
+
+    int Remaining() const
+    {
+        return Unpack.Remaining();
+    }
+
+private:
+    BitUnpackClass Unpack;
+    unsigned char const* Lengths;
+    int NumTypes;
+    uint32_t HeaderFrame;
+    int HeaderID;
+    int RunType;
+    uint32_t RunFrame;
+    int RunID;
+
+    unsigned char Prev[EVENTPACK_MAX_TYPES][EVENTPACK_MAX_DATA];
+};
+
+#endif /* EVENTPACK_H */
@@ -40,7 +40,7 @@
 #include <arpa/inet.h>
 #endif
 
-#ifdef NETWORKING
+#if defined(NETWORKING) && defined(_WIN32)
 #include <winsock.h>
 #endif
 
@@ -0,0 +1,129 @@
+#include "freeslot.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+**	Index of the lowest set bit; value must not be zero.
+*/
+static inline int Lowest_Bit(unsigned value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(value);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (int)index;
+#else
+    int index = 0;
+    while (!(value & 1)) {
+        value >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+FreeSlotClass::FreeSlotClass()
+    : Bits(NULL)
+    , Summary(NULL)
+    , Count(0)
+    , Words(0)
+    , SummaryWords(0)
+{
+}
+
+FreeSlotClass::~FreeSlotClass()
+{
+    Clear();
+}
+
+/*
+**	Sets the number of slots, all of them free.
+*/
+bool FreeSlotClass::Resize(int count)
+{
+    Clear();
+
+    if (count <= 0) {
+        return true;
+    }
+
+    Words = (count + 31) / 32;
+    SummaryWords = (Words + 31) / 32;
+    Bits = new unsigned[Words];
+    Summary = new unsigned[SummaryWords];
+    Count = count;
+    Reset();
+
+    return true;
+}
+
+void FreeSlotClass::Clear()
+{
+    delete[] Bits;
+    delete[] Summary;
+    Bits = NULL;
+    Summary = NULL;
+    Count = 0;
+    Words = 0;
+    SummaryWords = 0;
+}
+
+/*
+**	Frees every slot. Bits past the last slot stay clear so they're never handed out.
+*/
+void FreeSlotClass::Reset()
+{
+    if (Count == 0) {
+        return;
+    }
+
+    memset(Bits, 0xFF, Words * sizeof(unsigned));
+    memset(Summary, 0xFF, SummaryWords * sizeof(unsigned));
+
+    if (Count & 31) {
+        Bits[Words - 1] = (1u << (Count & 31)) - 1;
+    }
+    if (Words & 31) {
+        Summary[SummaryWords - 1] = (1u << (Words & 31)) - 1;
+    }
+}
+
+/*
+**	Lowest numbered free slot, or -1 if they're all taken.
+*/
+int FreeSlotClass::First_Free() const
+{
+    for (int i = 0; i < SummaryWords; ++i) {
+        if (Summary[i] != 0) {
+            int word = i * 32 + Lowest_Bit(Summary[i]);
+            return word * 32 + Lowest_Bit(Bits[word]);
+        }
+    }
+
+    return -1;
+}
+
+void FreeSlotClass::Take(int index)
+{
+    int word = index >> 5;
+
+    Bits[word] &= ~(1u << (index & 31));
+
+    if (Bits[word] == 0) {
+        Summary[word >> 5] &= ~(1u << (word & 31));
+    }
+}
+
+void FreeSlotClass::Give(int index)
+{
+    int word = index >> 5;
+
+    Bits[word] |= 1u << (index & 31);
+    Summary[word >> 5] |= 1u << (word & 31);
+}
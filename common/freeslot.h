@@ -0,0 +1,42 @@
+#ifndef FREESLOT_H
+#define FREESLOT_H
+
+/*
+**	Keeps track of which of a fixed number of slots are free and finds the lowest numbered free one without looking
+**	at every slot: one bit per slot, plus a summary bit for each word of those that still has a free bit in it.
+**	Finding a slot is two bit scans for up to 1024 slots, and taking or giving one back touches two words.
+*/
+class FreeSlotClass
+{
+public:
+    FreeSlotClass();
+    ~FreeSlotClass();
+
+    bool Resize(int count);
+    void Clear();
+    void Reset();
+    int First_Free() const;
+    void Take(int index);
+    void Give(int index);
+
+    bool Is_Free(int index) const
+    {
+        return index >= 0 && index < Count && (Bits[index >> 5] >> (index & 31)) & 1;
+    }
+    int Length() const
+    {
+        return Count;
+    }
+
+private:
+    unsigned* Bits;    // Set for free slots.
+    unsigned* Summary; // Set for words of Bits with a free slot.
+    int Count;
+    int Words;
+    int SummaryWords;
+
+    FreeSlotClass(FreeSlotClass const&);
+    FreeSlotClass& operator=(FreeSlotClass const&);
+};
+
+#endif /* FREESLOT_H */
@@ -34,6 +34,8 @@
  *   INIClass::Entry_Count -- Fetches the number of entries in a specified section.            *
  *   INIClass::Find_Entry -- Find specified entry within section.                              *
  *   INIClass::Find_Section -- Find the specified section within the INI data.                 *
+ *   INIClass::Free_Entry -- Destroy an entry record.                                          *
+ *   INIClass::Free_Section -- Destroy a section record and all of its entries.                *
  *   INIClass::Get_Bool -- Fetch a boolean value for the section and entry specified.          *
  *   INIClass::Get_Entry -- Get the entry identifier name given ordinal number and section name*
  *   INIClass::Get_Fixed -- Fetch a fixed point number from the section & entry.               *
@@ -47,6 +49,7 @@
  *   INIClass::INISection::Find_Entry -- Finds a specified entry and returns pointer to it.    *
  *   INIClass::Load -- Load INI data from the file specified.                                  *
  *   INIClass::Load -- Load the INI data from the data stream (straw).                         *
+ *   INIClass::Next_Line -- Fetch the next line from INI text held in memory.                  *
  *   INIClass::Put_Bool -- Store a boolean value into the INI database.                        *
  *   INIClass::Put_Hex -- Store an integer into the INI database, but use a hex format.        *
  *   INIClass::Put_Int -- Stores a signed integer into the INI data base.                      *
@@ -66,7 +69,9 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <new>
 #include "ini.h"
+#include "memflag.h"
 #include "readline.h"
 #include "xpipe.h"
 #include "b64pipe.h"
@@ -76,10 +81,6 @@
 #include "debugstring.h"
 #include "wwstd.h" // For linux version of strupr.
 
-#ifdef FIXIT_FAST_LOAD
-#include "cstraw.h"
-#endif
-
 // Disable the "temporary object used to initialize a non-constant reference" warning.
 //#pragma warning 665 9
 
@@ -128,8 +129,11 @@ INIClass::~INIClass(void)
 bool INIClass::Clear(char const* section, char const* entry)
 {
     if (section == NULL) {
-        SectionList.Delete();
+        while (!SectionList.Is_Empty()) {
+            Free_Section(SectionList.First());
+        }
         SectionIndex.Clear();
+        OwnArena.Release();
     } else {
         INISection* secptr = Find_Section(section);
         if (secptr != NULL) {
@@ -141,7 +145,7 @@ bool INIClass::Clear(char const* section, char const* entry)
                     */
                     secptr->EntryIndex.Remove_Index(entptr->Index_ID());
 
-                    delete entptr;
+                    Free_Entry(entptr);
                 }
             } else {
                 /*
@@ -149,7 +153,7 @@ bool INIClass::Clear(char const* section, char const* entry)
                 */
                 SectionIndex.Remove_Index(secptr->Index_ID());
 
-                delete secptr;
+                Free_Section(secptr);
             }
         }
     }
@@ -176,10 +180,58 @@ bool INIClass::Load(FileClass& file)
     return (Load(fs));
 }
 
+/***********************************************************************************************
+ * INIClass::Next_Line -- Fetch the next line from INI text held in memory.                    *
+ *                                                                                             *
+ *    This is the in memory counterpart of Read_Line. The line is compacted in place at the    *
+ *    start of its own text, dropping carriage returns and any characters beyond the maximum   *
+ *    line length, then null terminated and trimmed. As with Read_Line, a final line that      *
+ *    isn't terminated by a line feed is treated as the end of file.                           *
+ *                                                                                             *
+ * INPUT:   cursor   -- Reference to the current read position. It is advanced past the line. *
+ *                                                                                             *
+ *          end      -- Pointer to the end of the text. One byte past this must be writable.   *
+ *                                                                                             *
+ *          line     -- Reference to the pointer that will be set to the line text.            *
+ *                                                                                             *
+ *          eof      -- Reference to the end of file flag.                                     *
+ *                                                                                             *
+ * OUTPUT:  Returns with the length of the line.                                               *
+ *                                                                                             *
+ * WARNINGS:   The text is modified.                                                           *
+ *=============================================================================================*/
+int INIClass::Next_Line(char*& cursor, char const* end, char*& line, bool& eof)
+{
+    line = cursor;
+    int count = 0;
+
+    for (;;) {
+        if (cursor >= end) {
+            eof = true;
+            count = 0;
+            break;
+        }
+
+        char c = *cursor++;
+        if (c == '\x0A')
+            break;
+        if (c != '\x0D' && count + 1 < MAX_LINE_LENGTH) {
+            line[count++] = c;
+        }
+    }
+    line[count] = '\0';
+
+    strtrim(line);
+    return (strlen(line));
+}
+
 /***********************************************************************************************
  * INIClass::Load -- Load the INI data from the data stream (straw).                           *
  *                                                                                             *
- *    This will fetch data from the straw and build an INI database from it.                   *
+ *    This will fetch data from the straw and build an INI database from it. The whole stream  *
+ *    is read into the INI arena first and then parsed in place, so the section, entry and     *
+ *    value strings all refer straight into the loaded text. The section and entry records     *
+ *    are allocated from the arena too and hashed as they are created.                         *
  *                                                                                             *
  * INPUT:   straw -- The straw that the data will be provided from.                            *
  *                                                                                             *
@@ -190,25 +242,23 @@ bool INIClass::Load(FileClass& file)
  * HISTORY:                                                                                    *
  *   07/10/1996 JLB : Created.                                                                 *
  *=============================================================================================*/
-#ifdef FIXIT_FAST_LOAD
-bool INIClass::Load(Straw& ffile)
-#else
 bool INIClass::Load(Straw& file)
-#endif
 {
+    MemoryTagClass tag(MEM_TAG_INI);
     bool end_of_file = false;
-    char buffer[MAX_LINE_LENGTH];
-
-#ifdef FIXIT_FAST_LOAD
-    CacheStraw file;
-    file.Get_From(ffile);
-#endif
+    int length = 0;
+    char* cursor = Arena->Read(file, length);
+    if (cursor == NULL) {
+        return (false);
+    }
+    char const* end = cursor + length;
+    char* buffer = NULL;
 
     /*
     **	Prescan until the first section is found.
     */
     while (!end_of_file) {
-        Read_Line(file, buffer, sizeof(buffer), end_of_file);
+        Next_Line(cursor, end, buffer, end_of_file);
         if (end_of_file)
             return (false);
         if (buffer[0] == '[' && strchr(buffer, ']') != NULL)
@@ -232,11 +282,12 @@ bool INIClass::Load(Straw& file)
                      SectionIndex.Fetch_Index(section_id)->Section);
             section_found = true;
         }
-        INISection* secptr = new INISection(strdup(buffer));
-        if (secptr == NULL) {
+        void* secmem = Arena->Alloc(sizeof(INISection));
+        if (secmem == NULL) {
             Clear();
             return (false);
         }
+        INISection* secptr = new (secmem) INISection(buffer, true);
 
         /*
         **	Read in the entries of this section.
@@ -248,7 +299,7 @@ bool INIClass::Load(Straw& file)
             **	of the entry loop and let the outer section loop take
             **	care of it.
             */
-            int len = Read_Line(file, buffer, sizeof(buffer), end_of_file);
+            int len = Next_Line(cursor, end, buffer, end_of_file);
             if (buffer[0] == '[' && strchr(buffer, ']') != NULL)
                 break;
 
@@ -286,14 +337,15 @@ bool INIClass::Load(Straw& file)
                          buffer,
                          secptr->EntryIndex.Fetch_Index(entry_id)->Entry);
             } else {
-                INIEntry* entryptr = new INIEntry(strdup(buffer), strdup(divider));
-                if (entryptr == NULL) {
-                    delete secptr;
+                void* entrymem = Arena->Alloc(sizeof(INIEntry));
+                if (entrymem == NULL) {
+                    Free_Section(secptr);
                     Clear();
                     return (false);
                 }
 
-                secptr->EntryIndex.Add_Index(entryptr->Index_ID(), entryptr);
+                INIEntry* entryptr = new (entrymem) INIEntry(buffer, divider, true);
+                secptr->EntryIndex.Add_Index(entry_id, entryptr);
                 secptr->EntryList.Add_Tail(entryptr);
             }
         }
@@ -303,15 +355,54 @@ bool INIClass::Load(Straw& file)
         **	don't bother storing it. Also don't store if it has a hash collision.
         */
         if (secptr->EntryList.Is_Empty() || section_found) {
-            delete secptr;
+            Free_Section(secptr);
         } else {
-            SectionIndex.Add_Index(secptr->Index_ID(), secptr);
+            SectionIndex.Add_Index(section_id, secptr);
             SectionList.Add_Tail(secptr);
         }
     }
     return (true);
 }
 
+/***********************************************************************************************
+ * INIClass::Free_Entry -- Destroy an entry record.                                            *
+ *                                                                                             *
+ *    Entries created by Load() belong to the arena, so they are only destructed here. Their   *
+ *    memory is reclaimed when the arena they came from is cleared.                            *
+ *                                                                                             *
+ * INPUT:   entry -- Pointer to the entry to destroy. It is unlinked from its section.         *
+ *                                                                                             *
+ * OUTPUT:  none                                                                               *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *=============================================================================================*/
+void INIClass::Free_Entry(INIEntry* entry)
+{
+    if (entry->InArena) {
+        entry->~INIEntry();
+    } else {
+        delete entry;
+    }
+}
+
+/***********************************************************************************************
+ * INIClass::Free_Section -- Destroy a section record and all of its entries.                  *
+ *                                                                                             *
+ * INPUT:   section -- Pointer to the section to destroy. It is unlinked from the INI data.    *
+ *                                                                                             *
+ * OUTPUT:  none                                                                               *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *=============================================================================================*/
+void INIClass::Free_Section(INISection* section)
+{
+    if (section->InArena) {
+        section->~INISection();
+    } else {
+        delete section;
+    }
+}
+
 /***********************************************************************************************
  * INIClass::Save -- Save the ini data to the file specified.                                  *
  *                                                                                             *
@@ -950,7 +1041,7 @@ bool INIClass::Put_String(char const* section, char const* entry, char const* st
     INIEntry* entryptr = secptr->Find_Entry(entry);
     if (entryptr != NULL) {
         secptr->EntryIndex.Remove_Index(entryptr->Index_ID());
-        delete entryptr;
+        Free_Entry(entryptr);
     }
 
     /*
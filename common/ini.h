@@ -43,6 +43,7 @@
 #include "fixed.h"
 #include "crc.h"
 #include "search.h"
+#include "arena.h"
 
 class FileClass;
 class Straw;
@@ -56,6 +57,7 @@ class INIClass
 {
 public:
     INIClass(void)
+        : Arena(&OwnArena)
     {
     }
     ~INIClass(void);
@@ -73,6 +75,15 @@ public:
     */
     bool Clear(char const* section = 0, char const* entry = 0);
 
+    /*
+    **	Keep what later loads parse in another arena, such as one that lasts as long as the
+    **	scenario. That arena must not be reset while this database still holds the records.
+    */
+    void Set_Arena(ArenaClass* arena)
+    {
+        Arena = (arena != NULL) ? arena : &OwnArena;
+    }
+
     int Line_Count(char const* section) const;
     bool Is_Loaded(void) const
     {
@@ -140,16 +151,19 @@ protected:
     */
     struct INIEntry : Node<INIEntry>
     {
-        INIEntry(char* entry = 0, char* value = 0)
+        INIEntry(char* entry = 0, char* value = 0, bool inarena = false)
             : Entry(entry)
             , Value(value)
+            , InArena(inarena)
         {
         }
         ~INIEntry(void)
         {
-            free(Entry);
+            if (!InArena) {
+                free(Entry);
+                free(Value);
+            }
             Entry = 0;
-            free(Value);
             Value = 0;
         }
         int Index_ID(void) const
@@ -159,6 +173,11 @@ protected:
 
         char* Entry;
         char* Value;
+
+        /*
+        **	Entries parsed by Load() live in the INI arena along with their strings.
+        */
+        bool InArena;
     };
 
     /*
@@ -167,15 +186,20 @@ protected:
     */
     struct INISection : Node<INISection>
     {
-        INISection(char* section)
+        INISection(char* section, bool inarena = false)
             : Section(section)
+            , InArena(inarena)
         {
         }
         ~INISection(void)
         {
-            free(Section);
+            if (!InArena) {
+                free(Section);
+            }
             Section = 0;
-            EntryList.Delete();
+            while (!EntryList.Is_Empty()) {
+                Free_Entry(EntryList.First());
+            }
         }
         INIEntry* Find_Entry(char const* entry) const;
         int Index_ID(void) const
@@ -184,8 +208,9 @@ protected:
         };
 
         char* Section;
+        bool InArena;
         List<INIEntry> EntryList;
-        IndexClass<INIEntry*> EntryIndex;
+        HashIndexClass<INIEntry*> EntryIndex;
     };
 
     /*
@@ -194,14 +219,24 @@ protected:
     INISection* Find_Section(char const* section) const;
     INIEntry* Find_Entry(char const* section, char const* entry) const;
     static void Strip_Comments(char* buffer);
+    static int Next_Line(char*& cursor, char const* end, char*& line, bool& eof);
     static int32_t CRC(const char* string);
+    static void Free_Entry(INIEntry* entry);
+    static void Free_Section(INISection* section);
 
     /*
     **	This is the list of all sections within this INI file.
     */
     List<INISection> SectionList;
 
-    IndexClass<INISection*> SectionIndex;
+    HashIndexClass<INISection*> SectionIndex;
+
+    /*
+    **	Storage for everything created by Load(). This is the INI's own arena unless another
+    **	one has been supplied.
+    */
+    ArenaClass OwnArena;
+    ArenaClass* Arena;
 };
 
 #endif
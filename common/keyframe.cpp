@@ -236,13 +236,13 @@ uintptr_t Build_Frame(void const* dataptr, unsigned short framenumber, void* buf
         **
         */
         if (!BigShapeBufferStart) {
-            BigShapeBufferStart = (char*)Alloc(BigShapeBufferLength, MEM_NORMAL);
+            BigShapeBufferStart = (char*)Alloc(BigShapeBufferLength, Memory_Tag_Flag(MEM_TAG_SHAPE));
             BigShapeBufferPtr = BigShapeBufferStart;
 
             /*
             ** Allocate memory for theater specific uncompressed shapes
             */
-            TheaterShapeBufferStart = (char*)Alloc(TheaterShapeBufferLength, MEM_NORMAL);
+            TheaterShapeBufferStart = (char*)Alloc(TheaterShapeBufferLength, Memory_Tag_Flag(MEM_TAG_SHAPE));
             TheaterShapeBufferPtr = TheaterShapeBufferStart;
         }
 
@@ -271,7 +271,7 @@ uintptr_t Build_Frame(void const* dataptr, unsigned short framenumber, void* buf
             /*
             ** Allocate and clear the memory for the shape info
             */
-            KeyFrameSlots[keyfr->y] = new char*[keyfr->frames];
+            KeyFrameSlots[keyfr->y] = new (Memory_Tag_Flag(MEM_TAG_SHAPE)) char*[keyfr->frames];
             memset(KeyFrameSlots[keyfr->y], 0, keyfr->frames * sizeof(char*));
         }
 
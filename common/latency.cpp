@@ -0,0 +1,111 @@
+#include "latency.h"
+
+#include <algorithm>
+
+LatencyClass::LatencyClass()
+{
+    Reset();
+}
+
+void LatencyClass::Add(unsigned long rtt)
+{
+    int last = (Next + WINDOW - 1) % WINDOW;
+
+    Changes[Next] = Filled == 0 ? 0 : (rtt > Samples[last] ? rtt - Samples[last] : Samples[last] - rtt);
+    Samples[Next] = rtt;
+    Next = (Next + 1) % WINDOW;
+
+    if (Filled < WINDOW) {
+        ++Filled;
+    }
+}
+
+void LatencyClass::Reset()
+{
+    Next = 0;
+    Filled = 0;
+}
+
+/*
+**	Nearest rank percentile of what's in the window, 0 when it's empty.
+*/
+static unsigned long Window_Percentile(unsigned long const* values, int count, int percent)
+{
+    unsigned long sorted[LatencyClass::WINDOW];
+
+    if (count == 0) {
+        return 0;
+    }
+
+    int rank = (percent * count + 99) / 100 - 1;
+    rank = std::max(0, std::min(rank, count - 1));
+
+    std::copy(values, values + count, sorted);
+    std::nth_element(sorted, sorted + rank, sorted + count);
+
+    return sorted[rank];
+}
+
+unsigned long LatencyClass::Percentile(int percent) const
+{
+    return Window_Percentile(Samples, Filled, percent);
+}
+
+unsigned long LatencyClass::Jitter(int percent) const
+{
+    return Window_Percentile(Changes, Filled, percent);
+}
+
+FrameDelayClass::FrameDelayClass(int percentile, int hold)
+    : Percent(percentile)
+    , Hold(hold)
+    , Current(0)
+    , Below(0)
+    , RaiseCount(0)
+    , LowerCount(0)
+{
+}
+
+void FrameDelayClass::Reset(int delay)
+{
+    Current = delay;
+    Below = 0;
+}
+
+/*
+**	The delay the link calls for right now, without any smoothing. Round trip times are in ticks (1/60th second);
+**	the result is in frames, a multiple of send_rate and never less than three send periods.
+*/
+int FrameDelayClass::Target(unsigned long rtt, unsigned long jitter, int frame_rate, int send_rate) const
+{
+    send_rate = std::max(send_rate, 1);
+
+    int frames = (int)(((rtt + jitter) * frame_rate + 119) / 120);
+    int target = ((frames + send_rate - 1) / send_rate) * send_rate;
+
+    target = std::max(target, send_rate * 3);
+    target = std::min(target, (MAX_DELAY / send_rate) * send_rate);
+
+    return target;
+}
+
+int FrameDelayClass::Update(unsigned long rtt, unsigned long jitter, int frame_rate, int send_rate)
+{
+    int target = Target(rtt, jitter, frame_rate, send_rate);
+
+    if (target > Current) {
+        Current = target;
+        Below = 0;
+        ++RaiseCount;
+    } else if (target < Current) {
+        if (++Below >= Hold) {
+            Current -= std::max(send_rate, 1);
+            Below = 0;
+            ++LowerCount;
+        }
+    } else {
+        Below = 0;
+    }
+
+    return Current;
+}
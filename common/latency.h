@@ -0,0 +1,81 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/*
+**	Rolling window of round trip times for one connection, in ticks. Percentiles are taken over the last WINDOW
+**	samples; jitter is the change from one sample to the next, so a link that is slow but steady has none.
+*/
+class LatencyClass
+{
+public:
+    enum
+    {
+        WINDOW = 64,
+    };
+
+    LatencyClass();
+
+    void Add(unsigned long rtt);
+    void Reset();
+    unsigned long Percentile(int percent) const;
+    unsigned long Jitter(int percent) const;
+
+    int Count() const
+    {
+        return Filled;
+    }
+
+private:
+    unsigned long Samples[WINDOW];
+    unsigned long Changes[WINDOW];
+    int Next;
+    int Filled;
+};
+
+/*
+**	Chooses the lockstep frame delay (MaxAhead) from measured round trip times. The delay covers a one way trip at
+**	the chosen percentile plus half the given jitter as a margin, rounded up to whole send periods. It rises as soon
+**	as the target does, since a delay that's too short stalls every player, and falls one send period at a time once
+**	the target has stayed lower for 'hold' updates, so a short quiet spell doesn't make it swing back and forth.
+*/
+class FrameDelayClass
+{
+public:
+    enum
+    {
+        MAX_DELAY = 255, // Largest delay a FRAMEINFO can carry.
+    };
+
+    FrameDelayClass(int percentile = 95, int hold = 4);
+
+    void Reset(int delay);
+    int Update(unsigned long rtt, unsigned long jitter, int frame_rate, int send_rate);
+    int Target(unsigned long rtt, unsigned long jitter, int frame_rate, int send_rate) const;
+
+    int Delay() const
+    {
+        return Current;
+    }
+    int Percentile() const
+    {
+        return Percent;
+    }
+    unsigned Raises() const
+    {
+        return RaiseCount;
+    }
+    unsigned Lowers() const
+    {
+        return LowerCount;
+    }
+
+private:
+    int Percent;
+    int Hold;
+    int Current;
+    int Below; // Updates in a row the target has been under the current delay.
+    unsigned RaiseCount;
+    unsigned LowerCount;
+};
+
+#endif /* LATENCY_H */
@@ -32,271 +32,456 @@
  * Functions:                                                              *
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 #include "lcw.h"
+#include <stddef.h>
 #include <string.h>
 
+/*
+**	Copies whose source and destination are at least this many bytes apart can be moved
+**	in wide overlapping blocks without changing the result of a byte by byte copy.
+*/
+#define LCW_WIDE_COPY   16
+#define LCW_NARROW_COPY 8
+
 /***************************************************************************
- * LCW_Uncompress -- Decompress an LCW encoded data block.                 *
- *                                                                         *
- * Uncompress data to the following codes in the format b = byte, w = word *
- * n = byte code pulled from compressed data.                              *
- *                                                                         *
- *   Command code, n        |Description                                   *
- * ------------------------------------------------------------------------*
- * n=0xxxyyyy,yyyyyyyy      |short copy back y bytes and run x+3 from dest *
- * n=10xxxxxx,n1,n2,...,nx+1|med length copy the next x+1 bytes from source*
- * n=11xxxxxx,w1            |med copy from dest x+3 bytes from offset w1   *
- * n=11111111,w1,w2         |long copy from dest w1 bytes from offset w2   *
- * n=11111110,w1,b1         |long run of byte b1 for w1 bytes              *
- * n=10000000               |end of data reached                           *
+ * LCW_Copy -- Copy a run with the semantics of a forward byte copy.       *
  *                                                                         *
+ * Runs that overlap their own output must replicate the pattern just as   *
+ * the original byte loops did. When source and destination are far       *
+ * enough apart the run is moved in 16 or 8 byte blocks instead, the last  *
+ * block being shifted back to end exactly on the run so that nothing past *
+ * it is ever written. This matters as several callers uncompress in place *
+ * with the compressed data held at the tail of the destination buffer.    *
  *                                                                         *
- * INPUT:                                                                  *
- *      void * source ptr                                                  *
- *      void * destination ptr                                             *
- *      unsigned long length of uncompressed data                          *
+ * INPUT:   dest_ptr -- Where to write the run.                            *
+ *          copy_ptr -- Where to read the run from.                        *
+ *          count    -- Number of bytes to copy.                           *
  *                                                                         *
+ * OUTPUT:  none                                                           *
+ *=========================================================================*/
+static inline void LCW_Copy(unsigned char* dest_ptr, unsigned char const* copy_ptr, unsigned count)
+{
+    /*
+    **	Most commands are only a handful of bytes long, so handle those first.
+    */
+    if (count < LCW_NARROW_COPY) {
+        while (count--) {
+            *dest_ptr++ = *copy_ptr++;
+        }
+        return;
+    }
+
+    ptrdiff_t distance = dest_ptr > copy_ptr ? dest_ptr - copy_ptr : copy_ptr - dest_ptr;
+    unsigned char block[LCW_WIDE_COPY];
+
+    if (count >= LCW_WIDE_COPY && distance >= LCW_WIDE_COPY) {
+        unsigned done = 0;
+        while (count - done >= LCW_WIDE_COPY) {
+            memcpy(block, copy_ptr + done, LCW_WIDE_COPY);
+            memcpy(dest_ptr + done, block, LCW_WIDE_COPY);
+            done += LCW_WIDE_COPY;
+        }
+        if (done < count) {
+            memcpy(block, copy_ptr + count - LCW_WIDE_COPY, LCW_WIDE_COPY);
+            memcpy(dest_ptr + count - LCW_WIDE_COPY, block, LCW_WIDE_COPY);
+        }
+    } else if (distance >= LCW_NARROW_COPY) {
+        unsigned done = 0;
+        while (count - done >= LCW_NARROW_COPY) {
+            memcpy(block, copy_ptr + done, LCW_NARROW_COPY);
+            memcpy(dest_ptr + done, block, LCW_NARROW_COPY);
+            done += LCW_NARROW_COPY;
+        }
+        if (done < count) {
+            memcpy(block, copy_ptr + count - LCW_NARROW_COPY, LCW_NARROW_COPY);
+            memcpy(dest_ptr + count - LCW_NARROW_COPY, block, LCW_NARROW_COPY);
+        }
+    } else if (copy_ptr + 1 == dest_ptr) {
+        memset(dest_ptr, *copy_ptr, count);
+    } else {
+        while (count--) {
+            *dest_ptr++ = *copy_ptr++;
+        }
+    }
+}
+
+/***************************************************************************
+ * LCW_Decode -- Shared body of the checked and unchecked decoders.        *
  *                                                                         *
- * OUTPUT:                                                                 *
- *     unsigned long # of destination bytes written                        *
+ * When CHECKED is set every command is validated against the supplied    *
+ * source length and every back reference must lie within the data that   *
+ * has already been uncompressed. Any violation stops decoding.            *
  *                                                                         *
- * WARNINGS:                                                               *
- *     3rd argument is dummy. It exists to provide cross-platform          *
- *      compatibility. Note therefore that this implementation does not    *
- *      check for corrupt source data by testing the uncompressed length.  *
+ * INPUT:   source     -- Compressed data.                                 *
+ *          dest       -- Buffer to uncompress to.                         *
+ *          src_length -- Bytes of compressed data (CHECKED only).         *
+ *          length     -- Size of the destination buffer.                  *
  *                                                                         *
- * HISTORY:                                                                *
- *    03/20/1995 IML : Created.                                            *
+ * OUTPUT:  Number of destination bytes written or -1 if CHECKED decoding  *
+ *          found the data to be corrupt.                                  *
  *=========================================================================*/
-int LCW_Uncompress(void const* source, void* dest, unsigned length)
+template <bool CHECKED>
+static inline int LCW_Decode(void const* source, void* dest, unsigned src_length, unsigned length)
 {
-    unsigned char *source_ptr, *dest_ptr, *copy_ptr, *dest_end, op_code;
+    unsigned char const* source_ptr = (unsigned char const*)source;
+    unsigned char const* source_end = source_ptr + src_length;
+    unsigned char* dest_start = (unsigned char*)dest;
+    unsigned char* dest_ptr = dest_start;
+    unsigned char* dest_end = dest_ptr + length;
+    unsigned char* copy_ptr;
+    unsigned char op_code;
     unsigned count;
 
-    /* Copy the source and destination ptrs. */
-    source_ptr = (unsigned char*)source;
-    dest_ptr = (unsigned char*)dest;
-    dest_end = dest_ptr + length;
+/*
+**	Ensure there are at least n bytes of compressed data left to read.
+*/
+#define LCW_NEED(n)                                                                                                    \
+    if (CHECKED && (unsigned)(source_end - source_ptr) < (unsigned)(n)) {                                              \
+        return -1;                                                                                                     \
+    }
 
     while (dest_ptr < dest_end) {
 
         /* Read in the operation code. */
+        LCW_NEED(1);
         op_code = *source_ptr++;
 
         if (!(op_code & 0x80)) {
 
             /* Do a short copy from destination. */
+            LCW_NEED(1);
             count = (op_code >> 4) + 3;
-            copy_ptr = dest_ptr - ((unsigned)*source_ptr++ + (((unsigned)op_code & 0x0f) << 8));
-
-            /* Check we aren't going to write past the end of the destination buffer */
-            if (count > (unsigned)(dest_end - dest_ptr)) {
-                count = dest_end - dest_ptr;
+            unsigned offset = (unsigned)*source_ptr++ + (((unsigned)op_code & 0x0f) << 8);
+            if (CHECKED && (offset == 0 || offset > (unsigned)(dest_ptr - dest_start))) {
+                return -1;
             }
+            copy_ptr = dest_ptr - offset;
 
-            while (count--)
-                *dest_ptr++ = *copy_ptr++;
+        } else if (!(op_code & 0x40)) {
 
-        } else {
+            if (op_code == 0x80) {
 
-            if (!(op_code & 0x40)) {
+                /* Return # of destination bytes written. */
+                return (int)(dest_ptr - dest_start);
+            }
 
-                if (op_code == 0x80) {
+            /* Do a medium copy from source. */
+            count = op_code & 0x3f;
+            LCW_NEED(count);
 
-                    /* Return # of destination bytes written. */
-                    return (int)(dest_ptr - (unsigned char*)dest);
+            /* Check we aren't going to write past the end of the destination buffer */
+            unsigned size = count;
+            if (size > (unsigned)(dest_end - dest_ptr)) {
+                size = dest_end - dest_ptr;
+            }
 
-                } else {
+            LCW_Copy(dest_ptr, source_ptr, size);
+            dest_ptr += size;
+            source_ptr += count;
+            continue;
 
-                    /* Do a medium copy from source. */
-                    count = op_code & 0x3f;
+        } else if (op_code == 0xfe) {
 
-                    /* Check we aren't going to write past the end of the destination buffer */
-                    if (count > (unsigned)(dest_end - dest_ptr)) {
-                        count = dest_end - dest_ptr;
-                    }
+            /* Do a long run. */
+            LCW_NEED(3);
+            count = source_ptr[0] + (source_ptr[1] << 8);
 
-                    while (count--)
-                        *dest_ptr++ = *source_ptr++;
-                }
+            if (count > (unsigned)(dest_end - dest_ptr)) {
+                count = dest_end - dest_ptr;
+            }
 
-            } else {
+            memset(dest_ptr, source_ptr[2], count);
+            dest_ptr += count;
+            source_ptr += 3;
+            continue;
 
-                if (op_code == 0xfe) {
+        } else {
 
-                    /* Do a long run. */
-                    count = *source_ptr++;
-                    count += (*source_ptr++) << 8;
+            unsigned offset;
 
-                    if (count > (unsigned)(dest_end - dest_ptr)) {
-                        count = dest_end - dest_ptr;
-                    }
+            if (op_code == 0xff) {
 
-                    memset(dest_ptr, (*source_ptr++), count);
-                    dest_ptr += count;
+                /* Do a long copy from destination. */
+                LCW_NEED(4);
+                count = source_ptr[0] + (source_ptr[1] << 8);
+                offset = source_ptr[2] + (source_ptr[3] << 8);
+                source_ptr += 4;
 
-                } else {
+            } else {
 
-                    if (op_code == 0xff) {
+                /* Do a medium copy from destination. */
+                LCW_NEED(2);
+                count = (op_code & 0x3f) + 3;
+                offset = source_ptr[0] + (source_ptr[1] << 8);
+                source_ptr += 2;
+            }
 
-                        /* Do a long copy from destination. */
-                        count = *source_ptr++;
-                        count += (*source_ptr++) << 8;
-                        copy_ptr = (unsigned char*)dest + *source_ptr++;
-                        copy_ptr += (*source_ptr++) << 8;
+            if (CHECKED && offset >= (unsigned)(dest_ptr - dest_start) && count != 0) {
+                return -1;
+            }
+            copy_ptr = dest_start + offset;
+        }
 
-                        if (count > (unsigned)(dest_end - dest_ptr)) {
-                            count = dest_end - dest_ptr;
-                        }
+        /* Check we aren't going to write past the end of the destination buffer */
+        if (count > (unsigned)(dest_end - dest_ptr)) {
+            count = dest_end - dest_ptr;
+        }
 
-                        while (count--)
-                            *dest_ptr++ = *copy_ptr++;
+        LCW_Copy(dest_ptr, copy_ptr, count);
+        dest_ptr += count;
+    }
 
-                    } else {
+#undef LCW_NEED
 
-                        /* Do a medium copy from destination. */
-                        count = (op_code & 0x3f) + 3;
-                        copy_ptr = (unsigned char*)dest + *source_ptr + ((unsigned)*(source_ptr + 1) << 8);
-                        source_ptr += 2;
+    return (int)(dest_ptr - dest_start);
+}
 
-                        if (count > (unsigned)(dest_end - dest_ptr)) {
-                            count = dest_end - dest_ptr;
-                        }
+/***************************************************************************
+ * LCW_Uncompress -- Decompress an LCW encoded data block.                 *
+ *                                                                         *
+ * Uncompress data to the following codes in the format b = byte, w = word *
+ * n = byte code pulled from compressed data.                              *
+ *                                                                         *
+ *   Command code, n        |Description                                   *
+ * ------------------------------------------------------------------------*
+ * n=0xxxyyyy,yyyyyyyy      |short copy back y bytes and run x+3 from dest *
+ * n=10xxxxxx,n1,n2,...,nx+1|med length copy the next x+1 bytes from source*
+ * n=11xxxxxx,w1            |med copy from dest x+3 bytes from offset w1   *
+ * n=11111111,w1,w2         |long copy from dest w1 bytes from offset w2   *
+ * n=11111110,w1,b1         |long run of byte b1 for w1 bytes              *
+ * n=10000000               |end of data reached                           *
+ *                                                                         *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *      void * source ptr                                                  *
+ *      void * destination ptr                                             *
+ *      unsigned long length of uncompressed data                          *
+ *                                                                         *
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *     unsigned long # of destination bytes written                        *
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *     3rd argument is dummy. It exists to provide cross-platform          *
+ *      compatibility. Note therefore that this implementation does not    *
+ *      check for corrupt source data by testing the uncompressed length.  *
+ *      Use LCW_Uncompress_Safe for data that can not be trusted.          *
+ *                                                                         *
+ * HISTORY:                                                                *
+ *    03/20/1995 IML : Created.                                            *
+ *=========================================================================*/
+int LCW_Uncompress(void const* source, void* dest, unsigned length)
+{
+    return LCW_Decode<false>(source, dest, 0, length);
+}
 
-                        while (count--)
-                            *dest_ptr++ = *copy_ptr++;
-                    }
-                }
-            }
-        }
-    }
+/***************************************************************************
+ * LCW_Uncompress_Safe -- Decompress LCW data from an untrusted source.    *
+ *                                                                         *
+ * Behaves as LCW_Uncompress, but never reads beyond src_length bytes of   *
+ * compressed data and rejects back references outside of the data that   *
+ * has already been uncompressed. Runs that would overflow the destination *
+ * are truncated just as LCW_Uncompress does.                              *
+ *                                                                         *
+ * INPUT:   source     -- Compressed data.                                 *
+ *          dest       -- Buffer to uncompress to.                         *
+ *          src_length -- Bytes of compressed data available.              *
+ *          length     -- Size of the destination buffer.                  *
+ *                                                                         *
+ * OUTPUT:  Number of destination bytes written, -1 if data is corrupt.    *
+ *=========================================================================*/
+int LCW_Uncompress_Safe(void const* source, void* dest, unsigned src_length, unsigned length)
+{
+    return LCW_Decode<true>(source, dest, src_length, length);
+}
 
-    return (int)(dest_ptr - (unsigned char*)dest);
+/*
+**	Hash chain depth searched by LCW_Comp for each effort level.
+*/
+static unsigned const LCW_Chain_Depth[LCW_EFFORT_BEST + 1] = {1, 2, 4, 8, 16, 32, 64, 256, 1024, 4096};
+
+/*
+**	Largest values the individual command encodings can carry.
+*/
+#define LCW_MAX_LITERAL    0x3F
+#define LCW_MAX_SHORT_LEN  10
+#define LCW_MAX_SHORT_OFF  0xFFF
+#define LCW_MAX_MEDIUM_LEN 0x40
+#define LCW_MAX_LONG       0xFFFF
+#define LCW_MIN_RUN        0x41
+
+static inline unsigned LCW_Hash(unsigned char const* ptr, unsigned shift)
+{
+    return ((ptr[0] << 16 | ptr[1] << 8 | ptr[2]) * 2654435761u) >> shift;
 }
 
-int LCW_Comp(const void* src, void* dst, unsigned int bytes)
+/***************************************************************************
+ * LCW_Comp -- Compress data into LCW format.                              *
+ *                                                                         *
+ * Candidate matches are found through hash chains keyed on the next three *
+ * bytes, most recent position first. The effort level bounds how many    *
+ * candidates are examined per position, trading ratio for speed. Output   *
+ * uses only the commands understood by LCW_Uncompress.                    *
+ *                                                                         *
+ * INPUT:   src    -- Data to compress.                                    *
+ *          dst    -- Buffer to hold the compressed data. It must allow    *
+ *                    for the worst case of bytes + bytes / 63 + 2.        *
+ *          bytes  -- Number of bytes to compress.                         *
+ *          effort -- LCW_EFFORT_FASTEST to LCW_EFFORT_BEST.               *
+ *                                                                         *
+ * OUTPUT:  Number of bytes of compressed data written.                    *
+ *=========================================================================*/
+int LCW_Comp(void const* src, void* dst, unsigned bytes, int effort)
 {
     if (!bytes) {
         return 0;
     }
 
-    const unsigned char* getp = (const unsigned char*)(src);
-    unsigned char* putp = (unsigned char*)(dst);
-    const unsigned char* getstart = getp;
-    const unsigned char* getend = getp + bytes;
+    if (effort < LCW_EFFORT_FASTEST) {
+        effort = LCW_EFFORT_FASTEST;
+    } else if (effort > LCW_EFFORT_BEST) {
+        effort = LCW_EFFORT_BEST;
+    }
+    unsigned max_chain = LCW_Chain_Depth[effort];
+
+    unsigned char const* getstart = (unsigned char const*)src;
+    unsigned char const* getend = getstart + bytes;
+    unsigned char* putp = (unsigned char*)dst;
     unsigned char* putstart = putp;
-    bool cmd_one;
+
+    /*
+    **	Size the hash table to the input so that small blocks, such as those sent
+    **	through LCWPipe, don't pay for clearing a large table.
+    */
+    unsigned hash_bits = 8;
+    while (hash_bits < 16 && (1u << hash_bits) < bytes) {
+        ++hash_bits;
+    }
+    unsigned hash_shift = 32 - hash_bits;
+    int* head = new int[1u << hash_bits];
+    int* prev = new int[bytes];
+    for (unsigned i = 0; i < (1u << hash_bits); ++i) {
+        head[i] = -1;
+    }
+
     // Write a starting cmd1 and set bool to have cmd1 in progress
     unsigned char* cmd_onep = putp;
     *putp++ = 0x81;
-    *putp++ = *getp++;
-    cmd_one = true;
+    *putp++ = *getstart;
+    bool cmd_one = true;
+    unsigned pos = 1;
+    unsigned inserted = 0;
 
     // Compress data
-    while (getp < getend) {
-        // Is RLE encode (4bytes) worth evaluating?
-        if (getend - getp > 64 && *getp == *(getp + 64)) {
-            // RLE run length is encoded as a short so max is UINT16_MAX
-            const unsigned char* rlemax = (getend - getp) < 0xFFFF ? getend : getp + 0xFFFF;
-            const unsigned char* rlep;
-
-            for (rlep = getp + 1; *rlep == *getp && rlep < rlemax; ++rlep)
-                ;
+    while (pos < bytes) {
+        unsigned char const* getp = getstart + pos;
+        unsigned remaining = bytes - pos;
 
-            unsigned short run_length = rlep - getp;
+        // Is RLE encode (4bytes) worth evaluating?
+        if (remaining >= LCW_MIN_RUN && getp[0] == getp[1] && getp[0] == getp[LCW_MIN_RUN - 1]) {
+            unsigned limit = remaining < LCW_MAX_LONG ? remaining : LCW_MAX_LONG;
+            unsigned run_length = 1;
+            while (run_length < limit && getp[run_length] == getp[0]) {
+                ++run_length;
+            }
 
-            // If run length is long enough, write the command and start loop again
-            if (run_length >= 0x41) {
+            if (run_length >= LCW_MIN_RUN) {
                 cmd_one = false;
                 *putp++ = 0xFE;
                 *putp++ = (unsigned char)run_length;
                 *putp++ = run_length >> 8;
                 *putp++ = *getp;
-                getp = rlep;
+                pos += run_length;
                 continue;
             }
         }
 
-        // current block size for an offset copy
-        int block_size = 0;
-        const unsigned char* offstart;
+        // Bring the hash chains up to date with everything before the current position.
+        while (inserted + 2 < bytes && inserted < pos) {
+            unsigned h = LCW_Hash(getstart + inserted, hash_shift);
+            prev[inserted] = head[h];
+            head[h] = inserted;
+            ++inserted;
+        }
 
-        // Set where we start looking for matching runs.
-        offstart = getstart;
+        unsigned block_size = 0;
+        unsigned best = 0;
 
-        // Look for matching runs
-        const unsigned char* offchk = offstart;
-        const unsigned char* offsetp = getp;
-        while (offchk < getp) {
-            // Move offchk to next matching position
-            while (offchk < getp && *offchk != *getp) {
-                ++offchk;
-            }
+        if (remaining >= 3) {
+            unsigned limit = remaining < LCW_MAX_LONG ? remaining : LCW_MAX_LONG;
+            unsigned chain = max_chain;
+            int cand = head[LCW_Hash(getp, hash_shift)];
 
-            // If the checking pointer has reached current pos, break
-            if (offchk >= getp) {
-                break;
-            }
+            while (cand >= 0 && chain--) {
+                unsigned rel = pos - cand;
+
+                unsigned char const* candp = getstart + cand;
+
+                // Only candidates reachable by one of the offset encodings are usable.
+                bool reachable = rel <= LCW_MAX_SHORT_OFF || (unsigned)cand <= LCW_MAX_LONG;
 
-            // find out how long the run of matches goes for
-            //<= because it can consider the current pixel as part of a run
-            int i;
-            for (i = 1; &getp[i] < getend; ++i) {
-                if (offchk[i] != getp[i]) {
-                    break;
+                if (reachable && candp[block_size] == getp[block_size] && candp[0] == getp[0]) {
+                    unsigned len = 0;
+                    while (len < limit && candp[len] == getp[len]) {
+                        ++len;
+                    }
+
+                    // A far match only pays for itself once it beats the 2 byte short form.
+                    if (len > block_size && (len >= 4 || rel <= LCW_MAX_SHORT_OFF)) {
+                        block_size = len;
+                        best = cand;
+                        if (len == limit) {
+                            break;
+                        }
+                    }
                 }
-            }
 
-            if (i >= block_size) {
-                block_size = i;
-                offsetp = offchk;
+                cand = prev[cand];
             }
-
-            ++offchk;
         }
 
         // decide what encoding to use for current run
         if (block_size <= 2) {
-            // short copy 0b10??????
             // check we have an existing 1 byte command and if its value is still
             // small enough to handle additional bytes
-            // start a new command if current one doesn't have space or we don't
-            // have one to continue
-            if (cmd_one && *cmd_onep < 0xBF) {
-                // increment command value
+            if (cmd_one && *cmd_onep < (0x80 | LCW_MAX_LITERAL)) {
                 ++*cmd_onep;
-                *putp++ = *getp++;
+                *putp++ = *getp;
             } else {
                 cmd_onep = putp;
                 *putp++ = 0x81;
-                *putp++ = *getp++;
+                *putp++ = *getp;
                 cmd_one = true;
             }
+            ++pos;
         } else {
-            unsigned short offset;
-            unsigned short rel_offset = getp - offsetp;
-            if (block_size > 0xA || (rel_offset > 0xFFF)) {
-                // write 5 byte command 0b11111111
-                if (block_size > 0x40) {
+            unsigned rel_offset = pos - best;
+
+            if (rel_offset <= LCW_MAX_SHORT_OFF && (block_size <= LCW_MAX_SHORT_LEN || best > LCW_MAX_LONG)) {
+                // Short copy relative to the current position, 0b0xxxyyyy.
+                if (block_size > LCW_MAX_SHORT_LEN) {
+                    block_size = LCW_MAX_SHORT_LEN;
+                }
+                *putp++ = ((block_size - 3) << 4) | (rel_offset >> 8);
+                *putp++ = (unsigned char)rel_offset;
+            } else {
+                if (block_size > LCW_MAX_MEDIUM_LEN) {
                     *putp++ = 0xFF;
-                    *putp++ = block_size;
+                    *putp++ = (unsigned char)block_size;
                     *putp++ = block_size >> 8;
-                    // write 3 byte command 0b11??????
                 } else {
                     *putp++ = (block_size - 3) | 0xC0;
                 }
-
-                offset = offsetp - getstart;
-                // write 2 byte command? 0b0???????
-            } else {
-                offset = rel_offset << 8 | (16 * (block_size - 3) + (rel_offset >> 8));
+                *putp++ = (unsigned char)best;
+                *putp++ = best >> 8;
             }
-            *putp++ = (unsigned char)offset;
-            *putp++ = offset >> 8;
-            getp += block_size;
+            pos += block_size;
             cmd_one = false;
         }
     }
 
+    delete[] head;
+    delete[] prev;
+
     // write final 0x80, this is why its also known as format80 compression
     *putp++ = 0x80;
     return putp - putstart;
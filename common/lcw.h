@@ -36,6 +36,15 @@
 #define LCW_H
 
 int LCW_Uncompress(void const* source, void* dest, unsigned length);
-int LCW_Comp(void const* source, void* dest, unsigned length);
+int LCW_Uncompress_Safe(void const* source, void* dest, unsigned src_length, unsigned length);
+/*
+**	Effort levels for LCW_Comp. Higher levels search more match candidates, giving
+**	better compression at the expense of speed.
+*/
+#define LCW_EFFORT_FASTEST 1
+#define LCW_EFFORT_DEFAULT 5
+#define LCW_EFFORT_BEST    9
+
+int LCW_Comp(void const* source, void* dest, unsigned length, int effort = LCW_EFFORT_DEFAULT);
 
 #endif
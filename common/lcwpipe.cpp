@@ -64,8 +64,9 @@ LCWPipe::LCWPipe(CompControl control, int blocksize)
     , Buffer(NULL)
     , Buffer2(NULL)
     , BlockSize(blocksize)
+    , IsFailed(false)
 {
-    SafetyMargin = BlockSize / 128 + 1;
+    SafetyMargin = BlockSize / 63 + 2;
     Buffer = new char[BlockSize + SafetyMargin];
     Buffer2 = new char[BlockSize + SafetyMargin];
     BlockHeader.CompCount = 0xFFFF;
@@ -106,7 +107,7 @@ LCWPipe::~LCWPipe(void)
  *          length   -- The number of bytes received.                                          *
  *                                                                                             *
  * OUTPUT:  Returns with the actual number of bytes output at the far distant final link in    *
- *          the pipe chain.                                                                    *
+ *          the pipe chain. Corrupt data stops the output; use Is_Failed to tell.              *
  *                                                                                             *
  * WARNINGS:   The compression process may be slow as well as consuming two buffers.           *
  *                                                                                             *
@@ -128,6 +129,10 @@ int LCWPipe::Put(void const* source, int slen)
     */
     if (Control == DECOMPRESS) {
 
+        if (IsFailed) {
+            return (0);
+        }
+
         while (slen > 0) {
 
             /*
@@ -148,6 +153,14 @@ int LCWPipe::Put(void const* source, int slen)
                 if (Counter == sizeof(BlockHeader)) {
                     memmove(&BlockHeader, Buffer, sizeof(BlockHeader));
                     Counter = 0;
+
+                    /*
+                    **	A block that can't fit the buffers can only come from corrupt data.
+                    */
+                    if (BlockHeader.CompCount > BlockSize + SafetyMargin || BlockHeader.UncompCount > BlockSize) {
+                        IsFailed = true;
+                        return (total);
+                    }
                 }
             }
 
@@ -168,7 +181,10 @@ int LCWPipe::Put(void const* source, int slen)
                 **	through the pipe.
                 */
                 if (Counter == BlockHeader.CompCount) {
-                    LCW_Uncompress(Buffer, Buffer2, BlockSize + SafetyMargin);
+                    if (LCW_Uncompress_Safe(Buffer, Buffer2, BlockHeader.CompCount, BlockSize + SafetyMargin) < 0) {
+                        IsFailed = true;
+                        return (total);
+                    }
                     total += Pipe::Put(Buffer2, BlockHeader.UncompCount);
                     Counter = 0;
                     BlockHeader.CompCount = 0xFFFF;
@@ -241,7 +257,7 @@ int LCWPipe::Put(void const* source, int slen)
  * INPUT:   none                                                                               *
  *                                                                                             *
  * OUTPUT:  Returns with the actual number of data bytes output to the distant final link in   *
- *          the pipe chain.                                                                    *
+ *          the pipe chain. Nothing is output once the data has been found corrupt.            *
  *                                                                                             *
  * WARNINGS:   none                                                                            *
  *                                                                                             *
@@ -252,6 +268,10 @@ int LCWPipe::Flush(void)
 {
     assert(Buffer != NULL);
 
+    if (IsFailed) {
+        return (0);
+    }
+
     int total = 0;
 
     /*
@@ -57,6 +57,15 @@ public:
     virtual int Flush(void);
     virtual int Put(void const* source, int slen);
 
+    /*
+    **	True once a corrupt block has been met while decompressing. Nothing more is passed on after that, and Put
+    **	and Flush only count what they did pass on, so this is the one place a failure shows.
+    */
+    bool Is_Failed(void) const
+    {
+        return (IsFailed);
+    }
+
 private:
     /*
     **	This tells the pipe if it should be decompressing or compressing the data stream.
@@ -85,6 +94,11 @@ private:
     */
     int SafetyMargin;
 
+    /*
+    **	Set when a block fails to decompress.
+    */
+    bool IsFailed;
+
     /*
     **	Each block has a header of this format.
     */
@@ -66,7 +66,7 @@ LCWStraw::LCWStraw(CompControl control, int blocksize)
     , Buffer2(NULL)
     , BlockSize(blocksize)
 {
-    SafetyMargin = BlockSize / 128 + 1;
+    SafetyMargin = BlockSize / 63 + 2;
     Buffer = new char[BlockSize + SafetyMargin];
     if (control == COMPRESS) {
         Buffer2 = new char[BlockSize + SafetyMargin];
@@ -156,12 +156,16 @@ int LCWStraw::Get(void* destbuf, int slen)
             if (incount != sizeof(BlockHeader))
                 break;
 
+            if (BlockHeader.CompCount > BlockSize + SafetyMargin || BlockHeader.UncompCount > BlockSize)
+                break;
+
             void* ptr = &Buffer[(BlockSize + SafetyMargin) - BlockHeader.CompCount];
             incount = Straw::Get(ptr, BlockHeader.CompCount);
             if (incount != BlockHeader.CompCount)
                 break;
 
-            LCW_Uncompress(ptr, Buffer, BlockSize + SafetyMargin);
+            if (LCW_Uncompress_Safe(ptr, Buffer, BlockHeader.CompCount, BlockSize + SafetyMargin) < 0)
+                break;
             Counter = BlockHeader.UncompCount;
         } else {
             BlockHeader.UncompCount = (unsigned short)Straw::Get(Buffer, BlockSize);
@@ -0,0 +1,682 @@
+#include "linksim.h"
+
+#include <string.h>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#endif
+
+/*
+**	Bytes in front of the data when a packet goes to another process: from, to, kind and sequence number.
+*/
+#define LINK_HEADER_SIZE 9
+
+LinkNetClass::LinkNetClass(uint32_t seed)
+    : Seed(seed)
+    , Clock(0)
+    , NextOrder(0)
+    , SentCount(0)
+    , LostCount(0)
+    , DuplicateCount(0)
+    , ReorderCount(0)
+    , DeliveredCount(0)
+#ifndef _WIN32
+    , BasePort(0)
+#endif
+{
+    memset(&Default, 0, sizeof(Default));
+}
+
+LinkNetClass::~LinkNetClass()
+{
+    Close();
+}
+
+/*
+**	Sets the conditions for packets from one id to another; -1 stands for any id, and both -1 replaces the default.
+**	Later settings take precedence over earlier ones that match the same pair.
+*/
+void LinkNetClass::Set_Link(SettingsType const& settings, int from, int to)
+{
+    if (from == -1 && to == -1) {
+        Default = settings;
+        Links.clear();
+        return;
+    }
+
+    LinkType link = {from, to, settings};
+
+    Links.push_back(link);
+}
+
+void LinkNetClass::Set_Time(unsigned long time)
+{
+    Clock = time;
+}
+
+void LinkNetClass::Advance(unsigned long ticks)
+{
+    Clock += ticks;
+}
+
+/*
+**	Joins instances in other processes, each of which opens the same base port with its own id.
+*/
+bool LinkNetClass::Open(uint16_t base_port, int id)
+{
+#ifndef _WIN32
+    BasePort = base_port;
+
+    return Socket.Open((uint16_t)(base_port + id));
+#else
+    return false;
+#endif
+}
+
+void LinkNetClass::Close()
+{
+#ifndef _WIN32
+    Socket.Close();
+#endif
+}
+
+void LinkNetClass::Attach(LinkSimClass* node)
+{
+    Nodes.push_back(node);
+}
+
+void LinkNetClass::Detach(LinkSimClass* node)
+{
+    Nodes.erase(std::remove(Nodes.begin(), Nodes.end(), node), Nodes.end());
+}
+
+bool LinkNetClass::Is_Local(int id) const
+{
+    for (size_t i = 0; i < Nodes.size(); ++i) {
+        if (Nodes[i]->ID() == id) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+**	Ids that aren't attached here can only be reached through another process.
+*/
+bool LinkNetClass::Can_Reach(int id) const
+{
+#ifndef _WIN32
+    if (Socket.Is_Open()) {
+        return true;
+    }
+#endif
+
+    return Is_Local(id);
+}
+
+LinkNetClass::SettingsType const& LinkNetClass::Settings(int from, int to) const
+{
+    for (size_t i = Links.size(); i-- > 0;) {
+        if ((Links[i].From == -1 || Links[i].From == from) && (Links[i].To == -1 || Links[i].To == to)) {
+            return Links[i].Settings;
+        }
+    }
+
+    return Default;
+}
+
+/*
+**	Same generator as the game's own, so a seed means the same thing everywhere.
+*/
+uint32_t LinkNetClass::Random()
+{
+    Seed = Seed * 1664525 + 1013904223;
+
+    return Seed >> 8;
+}
+
+/*
+**	Puts a packet on the wire. What happens to it is decided here, as it's sent, so the outcome depends only on
+**	the seed and the order packets are sent in.
+*/
+void LinkNetClass::Send(int from, int to, int kind, uint32_t seq, void const* data, int length)
+{
+    SettingsType const& settings = Settings(from, to);
+
+    ++SentCount;
+
+    if (Random() % 1000 < (uint32_t)settings.Loss) {
+        ++LostCount;
+        return;
+    }
+
+    if (!Can_Reach(to)) {
+        ++LostCount;
+        return;
+    }
+
+    int copies = 1;
+
+    if (Random() % 1000 < (uint32_t)settings.Duplicate) {
+        ++DuplicateCount;
+        copies = 2;
+    }
+
+    PacketType packet;
+    packet.From = from;
+    packet.To = to;
+    packet.Kind = kind;
+    packet.Seq = seq;
+    packet.Data.assign((char const*)data, (char const*)data + length);
+
+    for (int i = 0; i < copies; ++i) {
+        unsigned long delay = settings.Latency;
+
+        if (settings.Jitter > 0) {
+            delay += Random() % (settings.Jitter + 1);
+        }
+
+        // Holding it back longer than any jitter could puts it behind whatever is sent next.
+        if (Random() % 1000 < (uint32_t)settings.Reorder) {
+            ++ReorderCount;
+            delay += settings.Latency + settings.Jitter + 1;
+        }
+
+        packet.Time = Clock + delay;
+        Schedule(packet);
+    }
+}
+
+void LinkNetClass::Schedule(PacketType const& packet)
+{
+    std::deque<PacketType>::iterator it = InFlight.end();
+
+    // Nearly everything arrives after what's already in flight, so search from the back.
+    while (it != InFlight.begin() && (it - 1)->Time > packet.Time) {
+        --it;
+    }
+
+    it = InFlight.insert(it, packet);
+    it->Order = NextOrder++;
+}
+
+/*
+**	Takes the next packet for 'to' that has arrived by now, oldest first.
+*/
+bool LinkNetClass::Receive(int to, PacketType& packet)
+{
+    Service_Port();
+
+    for (std::deque<PacketType>::iterator it = InFlight.begin(); it != InFlight.end() && it->Time <= Clock; ++it) {
+        if (it->To == to) {
+            packet.Time = it->Time;
+            packet.Order = it->Order;
+            packet.From = it->From;
+            packet.To = it->To;
+            packet.Kind = it->Kind;
+            packet.Seq = it->Seq;
+            packet.Data.swap(it->Data);
+            InFlight.erase(it);
+            ++DeliveredCount;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+**	Sends packets for other processes once their delay is up, and takes in what they've sent us. Theirs have been
+**	through their own link already, so they're ready as soon as they arrive.
+*/
+void LinkNetClass::Service_Port()
+{
+#ifndef _WIN32
+    if (!Socket.Is_Open()) {
+        return;
+    }
+
+    std::vector<UDPSocketClass::PacketType> batch;
+
+    for (std::deque<PacketType>::iterator it = InFlight.begin(); it != InFlight.end() && it->Time <= Clock;) {
+        if (Is_Local(it->To) || (int)it->Data.size() > UDPSocketClass::MAX_PACKET_SIZE - LINK_HEADER_SIZE) {
+            ++it;
+            continue;
+        }
+
+        UDPSocketClass::PacketType out;
+        out.Address = htonl(INADDR_LOOPBACK);
+        out.Port = htons((uint16_t)(BasePort + it->To));
+        out.Data[0] = it->From & 0xFF;
+        out.Data[1] = (it->From >> 8) & 0xFF;
+        out.Data[2] = it->To & 0xFF;
+        out.Data[3] = (it->To >> 8) & 0xFF;
+        out.Data[4] = it->Kind;
+        out.Data[5] = it->Seq & 0xFF;
+        out.Data[6] = (it->Seq >> 8) & 0xFF;
+        out.Data[7] = (it->Seq >> 16) & 0xFF;
+        out.Data[8] = (it->Seq >> 24) & 0xFF;
+        std::copy(it->Data.begin(), it->Data.end(), out.Data + LINK_HEADER_SIZE);
+        out.Length = LINK_HEADER_SIZE + (int)it->Data.size();
+        batch.push_back(out);
+
+        it = InFlight.erase(it);
+    }
+
+    for (size_t sent = 0; sent < batch.size();) {
+        int count = Socket.Send(&batch[sent], (int)std::min(batch.size() - sent, (size_t)UDPSocketClass::MAX_BATCH));
+
+        if (count <= 0) {
+            break;
+        }
+        sent += count;
+    }
+
+    UDPSocketClass::PacketType in[UDPSocketClass::MAX_BATCH];
+    int count;
+
+    while ((count = Socket.Receive(in, UDPSocketClass::MAX_BATCH)) > 0) {
+        for (int i = 0; i < count; ++i) {
+            if (in[i].Length < LINK_HEADER_SIZE) {
+                continue;
+            }
+
+            PacketType packet;
+            packet.Time = Clock;
+            packet.From = (short)(in[i].Data[0] | (in[i].Data[1] << 8));
+            packet.To = (short)(in[i].Data[2] | (in[i].Data[3] << 8));
+            packet.Kind = in[i].Data[4];
+            packet.Seq = in[i].Data[5] | (in[i].Data[6] << 8) | (in[i].Data[7] << 16) | ((uint32_t)in[i].Data[8] << 24);
+            packet.Data.assign(in[i].Data + LINK_HEADER_SIZE, in[i].Data + in[i].Length);
+
+            if (Is_Local(packet.To)) {
+                Schedule(packet);
+            }
+        }
+    }
+#endif
+}
+
+LinkSimClass::LinkSimClass(LinkNetClass& net, int id)
+    : Net(net)
+    , MyID(id)
+    , RetryDelta(10)
+    , MaxRetries((unsigned long)-1)
+    , Timeout(1200)
+    , ResendCount(0)
+    , Log(NULL)
+{
+    Net.Attach(this);
+}
+
+LinkSimClass::~LinkSimClass()
+{
+    Net.Detach(this);
+
+    if (Log != NULL) {
+        fclose(Log);
+    }
+}
+
+bool LinkSimClass::Create_Connection(int id)
+{
+    if (id == MyID || Find(id) != NULL) {
+        return false;
+    }
+
+    ConnectionType conn;
+    conn.ID = id;
+    conn.NextSeq = 1;
+    conn.LastSeq = 0;
+    conn.DelaySum = 0;
+    conn.NumDelay = 0;
+    Connections.push_back(conn);
+
+    return true;
+}
+
+bool LinkSimClass::Delete_Connection(int id)
+{
+    for (size_t i = 0; i < Connections.size(); ++i) {
+        if (Connections[i].ID == id) {
+            Connections.erase(Connections.begin() + i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+**	Starts a log of the game's CRC for every frame, so the logs of two instances can be compared line by line to
+**	find the first frame they went out of sync on.
+*/
+bool LinkSimClass::Set_Log(char const* filename)
+{
+    if (Log != NULL) {
+        fclose(Log);
+    }
+
+    Log = fopen(filename, "wt");
+
+    // Line buffered, so the log is complete up to the frame a desync or crash stopped the game on.
+    if (Log != NULL) {
+        setvbuf(Log, NULL, _IOLBF, BUFSIZ);
+    }
+
+    return Log != NULL;
+}
+
+void LinkSimClass::Log_Frame_CRC(long frame, unsigned long crc)
+{
+    if (Log != NULL) {
+        fprintf(Log, "%ld %08lx\n", frame, crc);
+    }
+}
+
+LinkSimClass::ConnectionType* LinkSimClass::Find(int id)
+{
+    for (size_t i = 0; i < Connections.size(); ++i) {
+        if (Connections[i].ID == id) {
+            return &Connections[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+**	Takes in whatever has arrived and resends anything that hasn't been acknowledged in time. Returns 0 if a packet
+**	has gone unacknowledged for longer than the timeout, as the IPX manager does when a connection is lost.
+*/
+int LinkSimClass::Service(void)
+{
+    LinkNetClass::PacketType packet;
+    int ok = 1;
+
+    while (Net.Receive(MyID, packet)) {
+        Arrive(packet);
+    }
+
+    for (size_t i = 0; i < Connections.size(); ++i) {
+        ConnectionType& conn = Connections[i];
+
+        for (size_t j = 0; j < conn.Unacked.size(); ++j) {
+            SendType& entry = conn.Unacked[j];
+
+            if (Net.Clock - entry.LastTime < RetryDelta) {
+                continue;
+            }
+
+            if (entry.SendCount > MaxRetries || Net.Clock - entry.FirstTime > Timeout) {
+                ok = 0;
+                continue;
+            }
+
+            entry.LastTime = Net.Clock;
+            ++entry.SendCount;
+            ++ResendCount;
+            Net.Send(MyID,
+                     conn.ID,
+                     LinkNetClass::PACKET_DATA_ACK,
+                     entry.Seq,
+                     entry.Data.empty() ? NULL : &entry.Data[0],
+                     (int)entry.Data.size());
+        }
+    }
+
+    return ok;
+}
+
+void LinkSimClass::Arrive(LinkNetClass::PacketType const& packet)
+{
+    ConnectionType* conn = Find(packet.From);
+
+    if (conn == NULL) {
+        return;
+    }
+
+    switch (packet.Kind) {
+    case LinkNetClass::PACKET_ACK:
+        for (size_t i = 0; i < conn->Unacked.size(); ++i) {
+            if (conn->Unacked[i].Seq == packet.Seq) {
+                unsigned long delay = Net.Clock - conn->Unacked[i].FirstTime;
+
+                conn->Latency.Add(delay);
+                conn->DelaySum += delay;
+                conn->NumDelay++;
+                conn->Unacked.erase(conn->Unacked.begin() + i);
+                break;
+            }
+        }
+        break;
+
+    case LinkNetClass::PACKET_DATA:
+        if (Received.size() < MAX_RECEIVE) {
+            ReceiveType entry = {packet.From, packet.Data};
+            Received.push_back(entry);
+        }
+        break;
+
+    case LinkNetClass::PACKET_DATA_ACK:
+        // A resend of something already handed up only needs its ACK again.
+        if (packet.Seq > conn->LastSeq && conn->Pending.count(packet.Seq) == 0) {
+
+            // No room: don't ACK it, and it'll come round again.
+            if (Received.size() >= MAX_RECEIVE) {
+                break;
+            }
+
+            ReceiveType entry = {packet.From, packet.Data};
+            Received.push_back(entry);
+
+            conn->Pending.insert(packet.Seq);
+            while (!conn->Pending.empty() && *conn->Pending.begin() == conn->LastSeq + 1) {
+                conn->Pending.erase(conn->Pending.begin());
+                conn->LastSeq++;
+            }
+        }
+        Net.Send(MyID, packet.From, LinkNetClass::PACKET_ACK, packet.Seq, NULL, 0);
+        break;
+    }
+}
+
+void LinkSimClass::Send_To(ConnectionType& conn, void const* buf, int buflen, int ack_req)
+{
+    if (!ack_req) {
+        Net.Send(MyID, conn.ID, LinkNetClass::PACKET_DATA, 0, buf, buflen);
+        return;
+    }
+
+    SendType entry;
+    entry.Seq = conn.NextSeq++;
+    entry.FirstTime = Net.Clock;
+    entry.LastTime = Net.Clock;
+    entry.SendCount = 1;
+    entry.Data.assign((char const*)buf, (char const*)buf + buflen);
+    conn.Unacked.push_back(entry);
+
+    Net.Send(MyID, conn.ID, LinkNetClass::PACKET_DATA_ACK, entry.Seq, buf, buflen);
+}
+
+int LinkSimClass::Send_Private_Message(void* buf, int buflen, int ack_req, int conn_id)
+{
+    if (Connections.empty()) {
+        return (0);
+    }
+
+    if (conn_id == CONNECTION_NONE) {
+        for (size_t i = 0; i < Connections.size(); ++i) {
+            if (ack_req && Connections[i].Unacked.size() >= MAX_SEND) {
+                return (0);
+            }
+        }
+
+        for (size_t i = 0; i < Connections.size(); ++i) {
+            Send_To(Connections[i], buf, buflen, ack_req);
+        }
+
+        return (1);
+    }
+
+    ConnectionType* conn = Find(conn_id);
+
+    if (conn == NULL || (ack_req && conn->Unacked.size() >= MAX_SEND)) {
+        return (0);
+    }
+
+    Send_To(*conn, buf, buflen, ack_req);
+
+    return (1);
+}
+
+int LinkSimClass::Get_Private_Message(void* buf, int* buflen, int* conn_id)
+{
+    if (Received.empty()) {
+        return (0);
+    }
+
+    ReceiveType& entry = Received.front();
+
+    if (!entry.Data.empty()) {
+        memcpy(buf, &entry.Data[0], entry.Data.size());
+    }
+    *buflen = (int)entry.Data.size();
+    *conn_id = entry.ID;
+    Received.pop_front();
+
+    return (1);
+}
+
+int LinkSimClass::Num_Connections(void)
+{
+    return ((int)Connections.size());
+}
+
+int LinkSimClass::Connection_ID(int index)
+{
+    if (index < 0 || index >= (int)Connections.size()) {
+        return (CONNECTION_NONE);
+    }
+
+    return (Connections[index].ID);
+}
+
+int LinkSimClass::Connection_Index(int id)
+{
+    for (size_t i = 0; i < Connections.size(); ++i) {
+        if (Connections[i].ID == id) {
+            return ((int)i);
+        }
+    }
+
+    return (CONNECTION_NONE);
+}
+
+/*
+**	There's no global channel; games on the simulated link are set up by whoever creates them.
+*/
+int LinkSimClass::Global_Num_Send(void)
+{
+    return (0);
+}
+
+int LinkSimClass::Global_Num_Receive(void)
+{
+    return (0);
+}
+
+int LinkSimClass::Private_Num_Send(int id)
+{
+    int count = 0;
+
+    for (size_t i = 0; i < Connections.size(); ++i) {
+        if (id == CONNECTION_NONE || Connections[i].ID == id) {
+            count += (int)Connections[i].Unacked.size();
+        }
+    }
+
+    return (count);
+}
+
+int LinkSimClass::Private_Num_Receive(int id)
+{
+    int count = 0;
+
+    for (size_t i = 0; i < Received.size(); ++i) {
+        if (id == CONNECTION_NONE || Received[i].ID == id) {
+            ++count;
+        }
+    }
+
+    return (count);
+}
+
+void LinkSimClass::Reset_Response_Time(void)
+{
+    for (size_t i = 0; i < Connections.size(); ++i) {
+        Connections[i].Latency.Reset();
+        Connections[i].DelaySum = 0;
+        Connections[i].NumDelay = 0;
+    }
+}
+
+unsigned long LinkSimClass::Response_Time(void)
+{
+    unsigned long maxresp = 0;
+
+    for (size_t i = 0; i < Connections.size(); ++i) {
+        if (Connections[i].NumDelay > 0) {
+            maxresp = std::max(maxresp, Connections[i].DelaySum / Connections[i].NumDelay);
+        }
+    }
+
+    return (maxresp);
+}
+
+unsigned long LinkSimClass::Response_Time_Percentile(int percent)
+{
+    unsigned long maxresp = 0;
+
+    for (size_t i = 0; i < Connections.size(); ++i) {
+        maxresp = std::max(maxresp, Connections[i].Latency.Percentile(percent));
+    }
+
+    return (maxresp);
+}
+
+unsigned long LinkSimClass::Response_Jitter(int percent)
+{
+    unsigned long maxjitter = 0;
+
+    for (size_t i = 0; i < Connections.size(); ++i) {
+        maxjitter = std::max(maxjitter, Connections[i].Latency.Jitter(percent));
+    }
+
+    return (maxjitter);
+}
+
+void LinkSimClass::Set_Timing(unsigned long retrydelta, unsigned long maxretries, unsigned long timeout)
+{
+    RetryDelta = retrydelta;
+    MaxRetries = maxretries;
+    Timeout = timeout;
+}
+
+/*
+**	Nothing to show on the mono screen; the link's counters say what happened to the packets.
+*/
+void LinkSimClass::Configure_Debug(int index,
+                                   int type_offset,
+                                   int type_size,
+                                   char** names,
+                                   int namestart,
+                                   int namecount)
+{
+}
+
+void LinkSimClass::Mono_Debug_Print(int index, int refresh)
+{
+}
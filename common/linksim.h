@@ -0,0 +1,229 @@
+#ifndef LINKSIM_H
+#define LINKSIM_H
+
+#include "connmgr.h"
+#include "latency.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+#include <set>
+#include <vector>
+
+#ifndef _WIN32
+#include "udpsock.h"
+#endif
+
+class LinkSimClass;
+
+/*
+**	A simulated network joining game instances. Every LinkSimClass attached to the same LinkNetClass can reach the
+**	others; packets between them are delayed, dropped, duplicated and reordered from a seeded random number
+**	generator, so a run with the same seed and the same traffic plays out exactly the same way. Time is in ticks
+**	and only moves when the owner sets it, so a test can step it and a game can follow its own timer.
+**
+**	On POSIX systems Open() also lets instances in other processes join, one per process: packets to an id that
+**	isn't attached locally go over UDP to the loopback port for that id, after the same delays and losses.
+*/
+class LinkNetClass
+{
+public:
+    struct SettingsType
+    {
+        int Latency;   // Fixed one way delay, in ticks.
+        int Jitter;    // Random extra delay of up to this many ticks.
+        int Loss;      // Chance out of 1000 a packet is dropped.
+        int Duplicate; // Chance out of 1000 a packet arrives twice.
+        int Reorder;   // Chance out of 1000 a packet is held back behind the ones sent after it.
+    };
+
+    LinkNetClass(uint32_t seed = 1);
+    ~LinkNetClass();
+
+    void Set_Link(SettingsType const& settings, int from = -1, int to = -1);
+    void Set_Time(unsigned long time);
+    void Advance(unsigned long ticks);
+    bool Open(uint16_t base_port, int id);
+    void Close();
+
+    unsigned long Time() const
+    {
+        return Clock;
+    }
+    unsigned Packets_Sent() const
+    {
+        return SentCount;
+    }
+    unsigned Packets_Lost() const
+    {
+        return LostCount;
+    }
+    unsigned Packets_Duplicated() const
+    {
+        return DuplicateCount;
+    }
+    unsigned Packets_Reordered() const
+    {
+        return ReorderCount;
+    }
+    unsigned Packets_Delivered() const
+    {
+        return DeliveredCount;
+    }
+
+private:
+    friend class LinkSimClass;
+
+    enum PacketKindType
+    {
+        PACKET_DATA,
+        PACKET_DATA_ACK,
+        PACKET_ACK,
+    };
+
+    struct PacketType
+    {
+        unsigned long Time;  // When it arrives.
+        unsigned long Order; // Sent order, to keep arrivals at the same tick stable.
+        int From;
+        int To;
+        int Kind;
+        uint32_t Seq;
+        std::vector<char> Data;
+    };
+
+    struct LinkType
+    {
+        int From;
+        int To;
+        SettingsType Settings;
+    };
+
+    void Attach(LinkSimClass* node);
+    void Detach(LinkSimClass* node);
+    bool Is_Local(int id) const;
+    bool Can_Reach(int id) const;
+    SettingsType const& Settings(int from, int to) const;
+    uint32_t Random();
+    void Send(int from, int to, int kind, uint32_t seq, void const* data, int length);
+    void Schedule(PacketType const& packet);
+    bool Receive(int to, PacketType& packet);
+    void Service_Port();
+
+    uint32_t Seed;
+    unsigned long Clock;
+    unsigned long NextOrder;
+    SettingsType Default;
+    std::vector<LinkType> Links;
+    std::vector<LinkSimClass*> Nodes;
+    std::deque<PacketType> InFlight; // Sorted by arrival.
+
+    unsigned SentCount;
+    unsigned LostCount;
+    unsigned DuplicateCount;
+    unsigned ReorderCount;
+    unsigned DeliveredCount;
+
+#ifndef _WIN32
+    UDPSocketClass Socket;
+    uint16_t BasePort;
+#endif
+};
+
+/*
+**	Connection manager for one game instance on a LinkNetClass, standing in for the IPX or modem managers.
+**	Packets that want an ACK are resent until one comes back and handed up only once, the way ConnectionClass
+**	does it; the others take their chances with the link. Connection IDs are the other instances' ids.
+*/
+class LinkSimClass : public ConnManClass
+{
+public:
+    enum
+    {
+        MAX_SEND = 64,    // Unacknowledged packets per connection.
+        MAX_RECEIVE = 64, // Packets waiting for Get_Private_Message.
+    };
+
+    LinkSimClass(LinkNetClass& net, int id);
+    virtual ~LinkSimClass();
+
+    bool Create_Connection(int id);
+    bool Delete_Connection(int id);
+    bool Set_Log(char const* filename);
+    void Log_Frame_CRC(long frame, unsigned long crc);
+
+    int ID() const
+    {
+        return MyID;
+    }
+    unsigned Resends() const
+    {
+        return ResendCount;
+    }
+
+    virtual int Service(void);
+    virtual int Send_Private_Message(void* buf, int buflen, int ack_req = 1, int conn_id = CONNECTION_NONE);
+    virtual int Get_Private_Message(void* buf, int* buflen, int* conn_id);
+
+    virtual int Num_Connections(void);
+    virtual int Connection_ID(int index);
+    virtual int Connection_Index(int id);
+
+    virtual int Global_Num_Send(void);
+    virtual int Global_Num_Receive(void);
+    virtual int Private_Num_Send(int id = CONNECTION_NONE);
+    virtual int Private_Num_Receive(int id = CONNECTION_NONE);
+
+    virtual void Reset_Response_Time(void);
+    virtual unsigned long Response_Time(void);
+    virtual unsigned long Response_Time_Percentile(int percent);
+    virtual unsigned long Response_Jitter(int percent);
+    virtual void Set_Timing(unsigned long retrydelta, unsigned long maxretries, unsigned long timeout);
+
+    virtual void Configure_Debug(int index, int type_offset, int type_size, char** names, int namestart, int namecount);
+    virtual void Mono_Debug_Print(int index, int refresh);
+
+private:
+    struct SendType
+    {
+        uint32_t Seq;
+        unsigned long FirstTime;
+        unsigned long LastTime;
+        unsigned long SendCount;
+        std::vector<char> Data;
+    };
+
+    struct ConnectionType
+    {
+        int ID;
+        uint32_t NextSeq;
+        uint32_t LastSeq;           // Every packet up to this one has been handed up.
+        std::set<uint32_t> Pending; // Ones past LastSeq that have been.
+        std::vector<SendType> Unacked;
+        LatencyClass Latency;
+        unsigned long DelaySum;
+        unsigned long NumDelay;
+    };
+
+    struct ReceiveType
+    {
+        int ID;
+        std::vector<char> Data;
+    };
+
+    ConnectionType* Find(int id);
+    void Send_To(ConnectionType& conn, void const* buf, int buflen, int ack_req);
+    void Arrive(LinkNetClass::PacketType const& packet);
+
+    LinkNetClass& Net;
+    int MyID;
+    std::vector<ConnectionType> Connections;
+    std::deque<ReceiveType> Received;
+    unsigned long RetryDelta;
+    unsigned long MaxRetries;
+    unsigned long Timeout;
+    unsigned ResendCount;
+    FILE* Log;
+};
+
+#endif /* LINKSIM_H */
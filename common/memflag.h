@@ -48,8 +48,40 @@ typedef enum
     MEM_REAL = 0x0004,   // Clear memory before returning.
     MEM_TEMP = 0x0008,   // Clear memory before returning.
     MEM_LOCK = 0x0010,   // Lock the memory that we allocated
+    MEM_TAG = 0x0F00,    // Subsystem to account the memory to, see Memory_Tag_Flag.
 } MemoryFlagType;
 
+/*
+**	Subsystems that memory is accounted to. Alloc records the tag in each block so Free can take it back off the
+**	right total. The tag comes from the flags if one is given there, otherwise from the innermost MemoryTagClass
+**	on the calling thread, otherwise MEM_TAG_OTHER.
+*/
+typedef enum
+{
+    MEM_TAG_OTHER,
+    MEM_TAG_MIX,   // Mixfiles cached in memory.
+    MEM_TAG_SHAPE, // Shape and keyframe buffers.
+    MEM_TAG_VQA,   // Movie playback buffers.
+    MEM_TAG_AUDIO, // Samples and streaming buffers.
+    MEM_TAG_INI,   // INI databases.
+    MEM_TAG_HEAP,  // Game object heaps.
+    MEM_TAG_MAP,   // Map cells.
+    MEM_TAG_COUNT
+} MemoryTagType;
+
+struct MemoryStatsType
+{
+    unsigned long Current; // Bytes allocated right now.
+    unsigned long Peak;    // Most bytes allocated at once.
+    unsigned long Allocs;  // Blocks handed out.
+    unsigned long Frees;   // Blocks given back.
+};
+
+inline MemoryFlagType Memory_Tag_Flag(MemoryTagType tag, int flags = MEM_NORMAL)
+{
+    return (MemoryFlagType)((flags & ~MEM_TAG) | ((tag + 1) << 8));
+}
+
 /*
 ** Prototypes for VMPAGEIN.ASM
 */
@@ -67,6 +99,31 @@ void* Resize_Alloc(void* original_ptr, unsigned long new_size_in_bytes);
 long Ram_Free(MemoryFlagType flag);
 long Heap_Size(MemoryFlagType flag);
 long Total_Ram_Free(MemoryFlagType flag);
+MemoryTagType Memory_Tag_Set(MemoryTagType tag);
+void Memory_Tag_Add(MemoryTagType tag, long bytes);
+void Memory_Stats(MemoryTagType tag, MemoryStatsType& stats);
+char const* Memory_Tag_Name(MemoryTagType tag);
+int Memory_Report(char* buffer, int length);
+bool Memory_Report_File(char const* filename);
+
+/*
+**	Accounts everything allocated on this thread while it is in scope to a subsystem.
+*/
+class MemoryTagClass
+{
+public:
+    MemoryTagClass(MemoryTagType tag)
+        : Previous(Memory_Tag_Set(tag))
+    {
+    }
+    ~MemoryTagClass()
+    {
+        Memory_Tag_Set(Previous);
+    }
+
+private:
+    MemoryTagType Previous;
+};
 
 //#pragma option -Jgd
 
@@ -28,6 +28,7 @@
 #include "pkstraw.h"
 #include "shastraw.h"
 #include "wwstd.h"
+#include "memflag.h"
 #include "rndstraw.h"
 
 #ifndef _WIN32
@@ -588,7 +589,7 @@ template <class T> bool MixFileClass<T>::Cache(Buffer const* buffer)
             Data = buffer->Get_Buffer();
         }
     } else {
-        Data = new char[DataSize];
+        Data = new (Memory_Tag_Flag(MEM_TAG_MIX)) char[DataSize];
         IsAllocated = true;
     }
 
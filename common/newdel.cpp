@@ -46,6 +46,9 @@
 /***************************************************************************
  * OPERATOR NEW -- Overides the global new function.                       *
  *                                                                         *
+ *    With SLAB_ALLOC defined, Alloc serves small MEM_NEW requests from    *
+ *    the size class pools in SLABALLOC.CPP.                               *
+ *                                                                         *
  * INPUT:                                                                  *
  *                                                                         *
  * OUTPUT:                                                                 *
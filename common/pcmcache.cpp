@@ -0,0 +1,107 @@
+#include "pcmcache.h"
+
+PCMCacheClass::PCMCacheClass(size_t limit)
+    : Bytes(0)
+    , MaxBytes(limit)
+    , HitCount(0)
+    , MissCount(0)
+    , EvictCount(0)
+{
+}
+
+/*
+**	Returns the decoded data for the sample and marks it most recently used, or null if it isn't cached.
+*/
+PCMCacheClass::PCMPtr PCMCacheClass::Find(void const* sample, uint32_t check)
+{
+    auto found = Index.find(sample);
+
+    if (found == Index.end()) {
+        ++MissCount;
+        return PCMPtr();
+    }
+
+    // Same buffer, different sample.
+    if (found->second->Check != check) {
+        Remove(found->second);
+        ++MissCount;
+        return PCMPtr();
+    }
+
+    Entries.splice(Entries.begin(), Entries, found->second);
+    ++HitCount;
+
+    return Entries.front().PCM;
+}
+
+/*
+**	Takes ownership of the decoded data and caches it, evicting the least recently used entries to make room. Data
+**	larger than the whole cache is returned without being cached.
+*/
+PCMCacheClass::PCMPtr PCMCacheClass::Add(void const* sample, uint32_t check, std::vector<uint8_t>&& pcm)
+{
+    PCMPtr data = std::make_shared<const std::vector<uint8_t>>(std::move(pcm));
+
+    auto found = Index.find(sample);
+
+    if (found != Index.end()) {
+        Remove(found->second);
+    }
+
+    if (data->size() > MaxBytes) {
+        return data;
+    }
+
+    Trim(MaxBytes - data->size());
+
+    EntryType entry = {sample, check, data};
+    Entries.push_front(entry);
+    Index[sample] = Entries.begin();
+    Bytes += data->size();
+
+    return data;
+}
+
+void PCMCacheClass::Clear()
+{
+    Entries.clear();
+    Index.clear();
+    Bytes = 0;
+}
+
+void PCMCacheClass::Set_Limit(size_t limit)
+{
+    MaxBytes = limit;
+    Trim(limit);
+}
+
+/*
+**	A cheap fingerprint of compressed sample data: its size and a spread of words across it, not a full hash.
+*/
+uint32_t PCMCacheClass::Check(void const* data, size_t size)
+{
+    uint8_t const* bytes = static_cast<uint8_t const*>(data);
+    uint32_t check = 2166136261u ^ (uint32_t)size;
+    size_t step = size / 64 + 1;
+
+    for (size_t i = 0; i < size; i += step) {
+        check = (check ^ bytes[i]) * 16777619u;
+    }
+
+    return check;
+}
+
+void PCMCacheClass::Remove(std::list<EntryType>::iterator entry)
+{
+    Bytes -= entry->PCM->size();
+    Index.erase(entry->Sample);
+    Entries.erase(entry);
+}
+
+void PCMCacheClass::Trim(size_t limit)
+{
+    while (Bytes > limit && !Entries.empty()) {
+        Remove(std::prev(Entries.end()));
+        ++EvictCount;
+    }
+}
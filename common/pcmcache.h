@@ -0,0 +1,75 @@
+#ifndef PCMCACHE_H
+#define PCMCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/*
+**	Size bounded, least recently used cache of fully decoded sound samples. Entries are keyed by the address of the
+**	compressed sample, with a check value to catch a buffer that has been reloaded with a different sample. Data
+**	handed out stays valid for as long as the caller holds on to it, even if the entry is evicted meanwhile.
+*/
+class PCMCacheClass
+{
+public:
+    typedef std::shared_ptr<const std::vector<uint8_t>> PCMPtr;
+
+    PCMCacheClass(size_t limit);
+
+    PCMPtr Find(void const* sample, uint32_t check);
+    PCMPtr Add(void const* sample, uint32_t check, std::vector<uint8_t>&& pcm);
+    void Clear();
+    void Set_Limit(size_t limit);
+
+    size_t Size() const
+    {
+        return Bytes;
+    }
+    size_t Limit() const
+    {
+        return MaxBytes;
+    }
+    int Count() const
+    {
+        return (int)Entries.size();
+    }
+    unsigned Hits() const
+    {
+        return HitCount;
+    }
+    unsigned Misses() const
+    {
+        return MissCount;
+    }
+    unsigned Evictions() const
+    {
+        return EvictCount;
+    }
+
+    static uint32_t Check(void const* data, size_t size);
+
+private:
+    struct EntryType
+    {
+        void const* Sample;
+        uint32_t Check;
+        PCMPtr PCM;
+    };
+
+    void Remove(std::list<EntryType>::iterator entry);
+    void Trim(size_t limit);
+
+    std::list<EntryType> Entries; // Most recently used first.
+    std::unordered_map<void const*, std::list<EntryType>::iterator> Index;
+    size_t Bytes;
+    size_t MaxBytes;
+    unsigned HitCount;
+    unsigned MissCount;
+    unsigned EvictCount;
+};
+
+#endif /* PCMCACHE_H */
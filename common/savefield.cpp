@@ -0,0 +1,56 @@
+#include "savefield.h"
+
+#include <assert.h>
+
+FieldRecord::FieldRecord()
+    : Length(0)
+    , Offset(0)
+    , IsBad(false)
+{
+}
+
+/*
+**	A record with more fields than it has room for is a mistake in the code that saves it.
+*/
+void FieldRecord::Overflow()
+{
+    assert(!"FieldRecord is too small for its fields.");
+    IsBad = true;
+}
+
+void FieldRecord::Write(Pipe& file) const
+{
+    assert(!IsBad);
+
+    unsigned char length = (unsigned char)Length;
+    file.Put(&length, sizeof(length));
+    file.Put(Buffer, Length);
+}
+
+/*
+**	Reads a record written by Write, ready for its fields to be got in the order they were put.
+*/
+bool FieldRecord::Read(Straw& file)
+{
+    unsigned char length = 0;
+
+    Length = 0;
+    Offset = 0;
+    IsBad = false;
+
+    if (file.Get(&length, sizeof(length)) != sizeof(length) || file.Get(Buffer, length) != length) {
+        IsBad = true;
+        return false;
+    }
+
+    Length = length;
+    return true;
+}
+
+/*
+**	True when every field got was in the record and the whole record was used.
+*/
+bool FieldRecord::Is_Done() const
+{
+    return !IsBad && Offset == Length;
+}
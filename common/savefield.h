@@ -0,0 +1,124 @@
+#ifndef SAVEFIELD_H
+#define SAVEFIELD_H
+
+#include "pipe.h"
+#include "straw.h"
+
+#include <string.h>
+
+/*
+**	Helpers for saves that are written field by field instead of as memory images. A field is written as its own
+**	bytes, and a reference to another object as a 32-bit target, with zero for none.
+*/
+template <class T> inline void Put_Field(Pipe& file, T const& field)
+{
+    file.Put(&field, sizeof(field));
+}
+
+template <class T> inline bool Get_Field(Straw& file, T& field)
+{
+    return file.Get(&field, sizeof(field)) == sizeof(field);
+}
+
+/*
+**	A record of fields gathered in memory and written as a length byte followed by the fields, so that saving or
+**	loading an object goes through the pipe or straw chain once instead of once per field. Reading a field the
+**	record doesn't have leaves it zero and makes Is_Done fail.
+**
+**	A fixed set of slots that may each hold a reference is kept as a 16-bit mask, one bit for each slot that holds
+**	one, followed by the targets of just those slots, so empty slots cost nothing past the mask.
+*/
+class FieldRecord
+{
+public:
+    enum
+    {
+        MAX_LENGTH = 255,
+        MAX_SLOTS = 16,
+    };
+
+    FieldRecord();
+
+    /*
+    **	Kept inline so each field is a copy of a known size rather than a call.
+    */
+    template <class T> void Put(T const& field)
+    {
+        if (Length + (int)sizeof(field) > MAX_LENGTH) {
+            Overflow();
+            return;
+        }
+        memcpy(&Buffer[Length], &field, sizeof(field));
+        Length += sizeof(field);
+    }
+
+    template <class T> void Get(T& field)
+    {
+        if (Offset + (int)sizeof(field) > Length) {
+            memset(&field, 0, sizeof(field));
+            IsBad = true;
+            return;
+        }
+        memcpy(&field, &Buffer[Offset], sizeof(field));
+        Offset += sizeof(field);
+    }
+
+    /*
+    **	Puts the mask for the slots that hold a target, then those targets in slot order.
+    */
+    template <int N> void Put_Target_Slots(int const (&targets)[N])
+    {
+        static_assert(N <= MAX_SLOTS, "Every slot needs a bit in the mask.");
+
+        unsigned short mask = 0;
+        for (int index = 0; index < N; index++) {
+            if (targets[index] != 0) {
+                mask |= 1 << index;
+            }
+        }
+
+        Put(mask);
+        for (int index = 0; index < N; index++) {
+            if (mask & (1 << index)) {
+                Put(targets[index]);
+            }
+        }
+    }
+
+    /*
+    **	Gets slots put by Put_Target_Slots, leaving zero in the empty ones. A mask with bits for slots past the end
+    **	marks the record bad.
+    */
+    template <int N> void Get_Target_Slots(int (&targets)[N])
+    {
+        static_assert(N <= MAX_SLOTS, "Every slot needs a bit in the mask.");
+
+        unsigned short mask = 0;
+        Get(mask);
+        if ((mask >> N) != 0) {
+            IsBad = true;
+            mask = 0;
+        }
+
+        for (int index = 0; index < N; index++) {
+            targets[index] = 0;
+            if (mask & (1 << index)) {
+                Get(targets[index]);
+            }
+        }
+    }
+
+    void Write(Pipe& file) const;
+    bool Read(Straw& file);
+    bool Is_Done() const;
+
+private:
+    void Overflow();
+
+    unsigned char Buffer[MAX_LENGTH];
+    int Length;
+    int Offset;
+    bool IsBad;
+};
+
+#endif /* SAVEFIELD_H */
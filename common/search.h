@@ -638,4 +638,238 @@ template <class T> typename IndexClass<T>::NodeElement const* IndexClass<T>::Sea
     return ((NodeElement const*)bsearch(&node, &IndexTable[0], IndexCount, sizeof(IndexTable[0]), search_compfunc));
 }
 
+/*
+**	This is an index handler with the same interface as IndexClass, but it keeps its nodes in an
+**	open addressed hash table. Additions are immediately searchable so there is no sorting pass
+**	after a batch of insertions, which suits indexes that are built once and then searched heavily
+**	such as the sections and entries of an INI file. The identifier numbers should already be well
+**	distributed (a CRC is ideal). The data object "T" has the same requirements as for IndexClass.
+*/
+template <class T> class HashIndexClass
+{
+public:
+    HashIndexClass(void);
+    ~HashIndexClass(void);
+
+    bool Add_Index(int id, T data);
+    bool Remove_Index(int id);
+    bool Is_Present(int id) const;
+    int Count(void) const;
+    T Fetch_Index(int id) const;
+    void Clear(void);
+
+private:
+    struct NodeElement
+    {
+        int ID;     // ID number assigned to this slot.
+        T Data;     // Data element assigned to this ID number.
+        bool InUse; // Is this slot occupied?
+    };
+
+    /*
+    **	The table of slots. The table size is always a power of two and is kept at most
+    **	three quarters full so that probe sequences stay short.
+    */
+    NodeElement* HashTable;
+    int HashSize;
+    int HashCount;
+
+    HashIndexClass(HashIndexClass const& rvalue);
+    HashIndexClass* operator=(HashIndexClass const& rvalue);
+
+    int Home_Slot(int id) const
+    {
+        return (int)(((unsigned)id * 0x9E3779B1u) >> 7) & (HashSize - 1);
+    }
+    int Search_For_Slot(int id) const;
+    bool Increase_Table_Size(void);
+};
+
+template <class T>
+HashIndexClass<T>::HashIndexClass(void)
+    : HashTable(0)
+    , HashSize(0)
+    , HashCount(0)
+{
+}
+
+template <class T> HashIndexClass<T>::~HashIndexClass(void)
+{
+    Clear();
+}
+
+template <class T> void HashIndexClass<T>::Clear(void)
+{
+    delete[] HashTable;
+    HashTable = 0;
+    HashSize = 0;
+    HashCount = 0;
+}
+
+template <class T> int HashIndexClass<T>::Count(void) const
+{
+    return (HashCount);
+}
+
+/***********************************************************************************************
+ * HashIndexClass<T>::Search_For_Slot -- Find the slot holding the specified ID.               *
+ *                                                                                             *
+ *    Probes linearly from the ID's home slot until the ID or an empty slot is found.          *
+ *                                                                                             *
+ * INPUT:   id -- The index ID to search for.                                                  *
+ *                                                                                             *
+ * OUTPUT:  Returns with the slot number holding the ID or -1 if it isn't present.             *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *=============================================================================================*/
+template <class T> int HashIndexClass<T>::Search_For_Slot(int id) const
+{
+    if (HashCount == 0) {
+        return (-1);
+    }
+
+    for (int slot = Home_Slot(id);; slot = (slot + 1) & (HashSize - 1)) {
+        if (!HashTable[slot].InUse) {
+            return (-1);
+        }
+        if (HashTable[slot].ID == id) {
+            return (slot);
+        }
+    }
+}
+
+/***********************************************************************************************
+ * HashIndexClass<T>::Increase_Table_Size -- Double the table and rehash every node.           *
+ *                                                                                             *
+ * INPUT:   none                                                                               *
+ *                                                                                             *
+ * OUTPUT:  bool; Was the table resized?                                                       *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *=============================================================================================*/
+template <class T> bool HashIndexClass<T>::Increase_Table_Size(void)
+{
+    int newsize = HashSize ? HashSize * 2 : 16;
+    NodeElement* newtable = new NodeElement[newsize];
+    if (newtable == 0) {
+        return (false);
+    }
+    for (int index = 0; index < newsize; index++) {
+        newtable[index].InUse = false;
+    }
+
+    NodeElement* oldtable = HashTable;
+    int oldsize = HashSize;
+    HashTable = newtable;
+    HashSize = newsize;
+
+    for (int index = 0; index < oldsize; index++) {
+        if (oldtable[index].InUse) {
+            int slot = Home_Slot(oldtable[index].ID);
+            while (HashTable[slot].InUse) {
+                slot = (slot + 1) & (HashSize - 1);
+            }
+            HashTable[slot] = oldtable[index];
+        }
+    }
+    delete[] oldtable;
+    return (true);
+}
+
+/***********************************************************************************************
+ * HashIndexClass<T>::Add_Index -- Add element to index tracking system.                       *
+ *                                                                                             *
+ *    As with IndexClass, it is up to the caller to avoid adding an ID that is already         *
+ *    present. A duplicate ID replaces the data of the existing node.                          *
+ *                                                                                             *
+ * INPUT:   id    -- The unique ID number to assign to this data element.                      *
+ *                                                                                             *
+ *          data  -- The data element to assign to this ID.                                    *
+ *                                                                                             *
+ * OUTPUT:  bool; Was the element added successfully?                                          *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *=============================================================================================*/
+template <class T> bool HashIndexClass<T>::Add_Index(int id, T data)
+{
+    if ((HashCount + 1) * 4 > HashSize * 3) {
+        if (!Increase_Table_Size()) {
+            return (false);
+        }
+    }
+
+    int slot = Home_Slot(id);
+    while (HashTable[slot].InUse && HashTable[slot].ID != id) {
+        slot = (slot + 1) & (HashSize - 1);
+    }
+    if (!HashTable[slot].InUse) {
+        HashCount++;
+    }
+    HashTable[slot].ID = id;
+    HashTable[slot].Data = data;
+    HashTable[slot].InUse = true;
+    return (true);
+}
+
+/***********************************************************************************************
+ * HashIndexClass<T>::Remove_Index -- Find matching index and remove it from system.           *
+ *                                                                                             *
+ *    The nodes following the removed one in its probe sequence are shifted back so that no   *
+ *    tombstone markers are needed.                                                            *
+ *                                                                                             *
+ * INPUT:   id -- The index ID to search for and remove.                                       *
+ *                                                                                             *
+ * OUTPUT:  bool; Was the index element found and removed?                                     *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *=============================================================================================*/
+template <class T> bool HashIndexClass<T>::Remove_Index(int id)
+{
+    int slot = Search_For_Slot(id);
+    if (slot == -1) {
+        return (false);
+    }
+
+    int mask = HashSize - 1;
+    int hole = slot;
+    for (int next = (hole + 1) & mask; HashTable[next].InUse; next = (next + 1) & mask) {
+
+        /*
+        **	A node may fill the hole only if the hole lies on the path from its home slot.
+        */
+        int home = Home_Slot(HashTable[next].ID);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            HashTable[hole] = HashTable[next];
+            hole = next;
+        }
+    }
+    HashTable[hole].InUse = false;
+    HashCount--;
+    return (true);
+}
+
+template <class T> bool HashIndexClass<T>::Is_Present(int id) const
+{
+    return (Search_For_Slot(id) != -1);
+}
+
+/***********************************************************************************************
+ * HashIndexClass<T>::Fetch_Index -- Fetch data from specified index.                          *
+ *                                                                                             *
+ * INPUT:   id -- The index ID to search for.                                                  *
+ *                                                                                             *
+ * OUTPUT:  Returns with the data value associated with the index value, or a default          *
+ *          constructed "T" if there is no such index.                                         *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *=============================================================================================*/
+template <class T> T HashIndexClass<T>::Fetch_Index(int id) const
+{
+    int slot = Search_For_Slot(id);
+    if (slot != -1) {
+        return (HashTable[slot].Data);
+    }
+    return (T());
+}
+
 #endif
@@ -0,0 +1,335 @@
+#include "slaballoc.h"
+#include "memflag.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+enum
+{
+    SLAB_CHUNK = 64 * 1024,   // Chunks are this big and aligned to it, so a block's chunk is found by masking.
+    SLAB_HEADER = 16,         // Start of a chunk that holds its size class, before the first block.
+    SLAB_TABLE_BITS = 15,     // Chunk table has room for twice SLAB_MAX_CHUNKS.
+    SLAB_MAX_CHUNKS = 1 << 14 // 1gb of chunks before it gives up and lets malloc have them.
+};
+
+#ifdef MEM_CHECK
+enum
+{
+    SLAB_GUARD_HEAD = 16, // Check word and size in front of the block.
+    SLAB_GUARD_TAIL = sizeof(uintptr_t),
+};
+#endif
+
+static unsigned short const SlabSizes[SLAB_CLASSES] =
+    {16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512};
+
+struct ChunkType
+{
+    int Class;
+    int Tag;
+};
+
+struct FreeBlockType
+{
+    FreeBlockType* Next;
+};
+
+/*
+**	Everything here is zero initialised static data with no constructors, so new can be called from other static
+**	constructors before this file's have run.
+*/
+struct SlabClassType
+{
+    std::atomic<int> Lock;
+    FreeBlockType* FreeList;
+    char* Next; // Unused part of the newest chunk.
+    char* End;
+    unsigned long Allocs;
+    unsigned long Frees;
+    unsigned long InUse;
+    unsigned long Peak;
+    unsigned long Chunks;
+};
+
+static SlabClassType Classes[MEM_TAG_COUNT][SLAB_CLASSES];
+static std::atomic<uintptr_t> ChunkTable[1 << SLAB_TABLE_BITS];
+static std::atomic<int> ChunkCount;
+
+static void Lock(SlabClassType& slab)
+{
+    while (slab.Lock.exchange(1, std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+static void Unlock(SlabClassType& slab)
+{
+    slab.Lock.store(0, std::memory_order_release);
+}
+
+/*
+**	16 byte steps up to 128, then 32 up to 256, then 64 up to 512.
+*/
+static int Class_Of(size_t size)
+{
+    int units = (int)((size + 15) >> 4);
+
+    if (units <= 8) {
+        return units ? units - 1 : 0;
+    }
+    if (units <= 16) {
+        return 8 + ((units - 9) >> 1);
+    }
+    return 12 + ((units - 17) >> 2);
+}
+
+static unsigned Chunk_Hash(uintptr_t base)
+{
+    return ((uint32_t)(base / SLAB_CHUNK) * 2654435761u) >> (32 - SLAB_TABLE_BITS);
+}
+
+static bool Register_Chunk(uintptr_t base)
+{
+    if (ChunkCount.fetch_add(1) >= SLAB_MAX_CHUNKS) {
+        ChunkCount.fetch_sub(1);
+        return false;
+    }
+
+    for (unsigned i = Chunk_Hash(base);; i = (i + 1) & ((1 << SLAB_TABLE_BITS) - 1)) {
+        uintptr_t empty = 0;
+        if (ChunkTable[i].compare_exchange_strong(empty, base)) {
+            return true;
+        }
+    }
+}
+
+/*
+**	Starts a new chunk for a class. Called with the class locked.
+*/
+static bool New_Chunk(SlabClassType& slab, int index, int tag)
+{
+    void* chunk;
+
+#ifdef _WIN32
+    chunk = _aligned_malloc(SLAB_CHUNK, SLAB_CHUNK);
+#else
+    if (posix_memalign(&chunk, SLAB_CHUNK, SLAB_CHUNK) != 0) {
+        chunk = NULL;
+    }
+#endif
+
+    if (chunk == NULL) {
+        return false;
+    }
+
+    if (!Register_Chunk((uintptr_t)chunk)) {
+#ifdef _WIN32
+        _aligned_free(chunk);
+#else
+        free(chunk);
+#endif
+        return false;
+    }
+
+    ((ChunkType*)chunk)->Class = index;
+    ((ChunkType*)chunk)->Tag = tag;
+    slab.Next = (char*)chunk + SLAB_HEADER;
+    slab.End = (char*)chunk + SLAB_CHUNK;
+    slab.Chunks++;
+
+    return true;
+}
+
+#ifdef MEM_CHECK
+static void Slab_Error(char const* message)
+{
+    if (Memory_Error_Exit != NULL) {
+        Memory_Error_Exit((char*)message);
+    }
+    abort();
+}
+#endif
+
+void* Slab_Alloc(size_t size, MemoryTagType tag)
+{
+#ifdef MEM_CHECK
+    size_t requested = size;
+    size += SLAB_GUARD_HEAD + SLAB_GUARD_TAIL;
+#endif
+
+    if (size > SLAB_MAX_SIZE) {
+        return NULL;
+    }
+
+    if (tag < 0 || tag >= MEM_TAG_COUNT) {
+        tag = MEM_TAG_OTHER;
+    }
+
+    int index = Class_Of(size);
+    int block_size = SlabSizes[index];
+    SlabClassType& slab = Classes[tag][index];
+    char* block;
+
+    Lock(slab);
+
+    if (slab.FreeList != NULL) {
+        block = (char*)slab.FreeList;
+        slab.FreeList = slab.FreeList->Next;
+    } else {
+        if (slab.End - slab.Next < block_size && !New_Chunk(slab, index, tag)) {
+            Unlock(slab);
+            return NULL;
+        }
+        block = slab.Next;
+        slab.Next += block_size;
+    }
+
+    slab.Allocs++;
+    if (++slab.InUse > slab.Peak) {
+        slab.Peak = slab.InUse;
+    }
+
+    Unlock(slab);
+
+#ifdef MEM_CHECK
+    char* pointer = block + SLAB_GUARD_HEAD;
+    uintptr_t check = (uintptr_t)pointer ^ (uintptr_t)0x5AB5AB5A;
+
+    memcpy(block, &check, sizeof(check));
+    memcpy(block + sizeof(check), &requested, sizeof(requested));
+    memcpy(pointer + requested, &check, sizeof(check));
+    block = pointer;
+#endif
+
+    return block;
+}
+
+bool Slab_Free(void* pointer)
+{
+    if (!Slab_Owns(pointer)) {
+        return false;
+    }
+
+    char* base = (char*)((uintptr_t)pointer & ~(uintptr_t)(SLAB_CHUNK - 1));
+    int index = ((ChunkType*)base)->Class;
+    SlabClassType& slab = Classes[((ChunkType*)base)->Tag][index];
+    char* block = (char*)pointer;
+
+#ifdef MEM_CHECK
+    uintptr_t check = (uintptr_t)pointer ^ (uintptr_t)0x5AB5AB5A;
+    uintptr_t head;
+    uintptr_t tail;
+    size_t requested;
+
+    block -= SLAB_GUARD_HEAD;
+
+    if (block < base + SLAB_HEADER || (block - base - SLAB_HEADER) % SlabSizes[index] != 0) {
+        Slab_Error("Slab_Free: pointer is not the start of a block.");
+    }
+
+    memcpy(&head, block, sizeof(head));
+    memcpy(&requested, block + sizeof(head), sizeof(requested));
+
+    if (head != check || requested > SlabSizes[index] - SLAB_GUARD_HEAD - SLAB_GUARD_TAIL) {
+        Slab_Error("Slab_Free: block header overwritten or freed twice.");
+    }
+
+    memcpy(&tail, (char*)pointer + requested, sizeof(tail));
+
+    if (tail != check) {
+        Slab_Error("Slab_Free: block overrun.");
+    }
+
+    head = 0;
+    memcpy(block, &head, sizeof(head));
+#endif
+
+    Lock(slab);
+
+    ((FreeBlockType*)block)->Next = slab.FreeList;
+    slab.FreeList = (FreeBlockType*)block;
+    slab.Frees++;
+    slab.InUse--;
+
+    Unlock(slab);
+
+    return true;
+}
+
+/*
+**	Whether a pointer is in one of the chunks. Doesn't look at the memory the pointer is in, so it's safe to call
+**	with anything malloc returned.
+*/
+bool Slab_Owns(void const* pointer)
+{
+    if (pointer == NULL || ChunkCount.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    uintptr_t base = (uintptr_t)pointer & ~(uintptr_t)(SLAB_CHUNK - 1);
+
+    for (unsigned i = Chunk_Hash(base);; i = (i + 1) & ((1 << SLAB_TABLE_BITS) - 1)) {
+        uintptr_t entry = ChunkTable[i].load(std::memory_order_acquire);
+        if (entry == base) {
+            return true;
+        }
+        if (entry == 0) {
+            return false;
+        }
+    }
+}
+
+/*
+**	The usable size of a block and the tag it was allocated under, or false for a pointer the pools don't own.
+*/
+bool Slab_Info(void const* pointer, size_t& size, MemoryTagType& tag)
+{
+    if (!Slab_Owns(pointer)) {
+        return false;
+    }
+
+    ChunkType const* chunk = (ChunkType const*)((uintptr_t)pointer & ~(uintptr_t)(SLAB_CHUNK - 1));
+
+#ifdef MEM_CHECK
+    memcpy(&size, (char const*)pointer - SLAB_GUARD_HEAD + sizeof(uintptr_t), sizeof(size));
+#else
+    size = SlabSizes[chunk->Class];
+#endif
+    tag = (MemoryTagType)chunk->Tag;
+
+    return true;
+}
+
+/*
+**	Counts for a size class, summed over the chunks of every tag. Peak is the sum of each tag's peak, so it can
+**	be more than were ever in use at once.
+*/
+void Slab_Stats(int index, SlabStatsType& stats)
+{
+    memset(&stats, 0, sizeof(stats));
+
+    if (index < 0 || index >= SLAB_CLASSES) {
+        return;
+    }
+
+    stats.Size = SlabSizes[index];
+
+    for (int tag = 0; tag < MEM_TAG_COUNT; ++tag) {
+        SlabClassType& slab = Classes[tag][index];
+
+        Lock(slab);
+        stats.Allocs += slab.Allocs;
+        stats.Frees += slab.Frees;
+        stats.InUse += slab.InUse;
+        stats.Peak += slab.Peak;
+        stats.Chunks += slab.Chunks;
+        Unlock(slab);
+    }
+}
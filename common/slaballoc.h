@@ -0,0 +1,45 @@
+#ifndef SLABALLOC_H
+#define SLABALLOC_H
+
+#include "memflag.h"
+
+#include <stddef.h>
+
+/*
+**	Size class pools for small allocations. Blocks of up to SLAB_MAX_SIZE bytes are carved out of 64k chunks, one
+**	size class per chunk, and freed blocks go on a list for their class to be handed out again. Chunks are kept
+**	once allocated, so a phase that frees what an earlier one made gets it back without going to malloc.
+**
+**	Each memory tag has its own set of chunks, so Slab_Info can tell which subsystem a block was accounted to.
+**	With SLAB_ALLOC defined, Alloc takes MEM_NEW requests from here and Free and Resize_Alloc recognise the
+**	blocks, so the tag counts and Memory_Calls cover them like any other block.
+**
+**	Each class has its own lock so threads other than the main one can allocate too. Slab_Alloc returns NULL
+**	when a request is too big or no chunk can be had, and Slab_Free returns false for a pointer it doesn't own;
+**	either way the caller should fall back to malloc and free.
+**
+**	With MEM_CHECK defined every block is wrapped in guard words that are checked when it's freed, as Alloc does.
+*/
+enum
+{
+    SLAB_MAX_SIZE = 512,
+    SLAB_CLASSES = 16,
+};
+
+struct SlabStatsType
+{
+    size_t Size;          // Block size of the class.
+    unsigned long Allocs; // Blocks handed out.
+    unsigned long Frees;  // Blocks given back.
+    unsigned long InUse;  // Blocks handed out right now.
+    unsigned long Peak;   // Sum over the tags of the most in use at once.
+    unsigned long Chunks; // Chunks taken from the system.
+};
+
+void* Slab_Alloc(size_t size, MemoryTagType tag = MEM_TAG_OTHER);
+bool Slab_Free(void* pointer);
+bool Slab_Owns(void const* pointer);
+bool Slab_Info(void const* pointer, size_t& size, MemoryTagType& tag);
+void Slab_Stats(int index, SlabStatsType& stats);
+
+#endif /* SLABALLOC_H */
@@ -33,181 +33,224 @@ void sosCODECInitStream(_SOS_COMPRESS_INFO* stream)
     stream->dwSampleIndex2 = 0;
 }
 
-//
-// decompress data from a 4:1 ADPCM compressed file.  the number of
-// bytes decompressed is returned.
-//
-unsigned long sosCODECDecompressData(_SOS_COMPRESS_INFO* stream, unsigned long bytes)
+// Decoder table entry for one step index and code nybble: the signed difference the nybble adds to the prediction
+// and the step index that follows it.
+struct SOSDecodeEntry
 {
-    short current_nybble;
-    unsigned step;
-    int sample;
-    unsigned full_length;
+    int Delta;
+    int Next;
+};
 
-    full_length = bytes;
-    stream->dwSampleIndex = 0;
-    stream->dwSampleIndex2 = 0;
-
-    if (stream->wBitSize == 16) {
-        bytes /= 2;
-    }
-
-    char* src = stream->lpSource;
-    short* dst = (short*)(stream->lpDest);
-
-    // Handle stereo.
-    if (stream->wChannels == 2) {
-        current_nybble = 0;
-        for (int i = bytes; i > 0; i -= 2) {
-            if ((stream->dwSampleIndex & 1) != 0) {
-                current_nybble = stream->wCodeBuf >> 4;
-                stream->wCode = current_nybble;
-            } else {
-                stream->wCodeBuf = *src;
-                // Stereo is interleaved so skip a byte for this channel.
-                src += 2;
-                current_nybble = stream->wCodeBuf & 0xF;
-                stream->wCode = current_nybble;
-            }
+struct SOSDecodeTable
+{
+    SOSDecodeEntry Entry[89][16];
 
-            step = stream->wStep;
-            stream->dwDifference = step >> 3;
+    SOSDecodeTable()
+    {
+        for (int index = 0; index < 89; ++index) {
+            unsigned step = wCODECStepTab[index];
 
-            if ((current_nybble & 4) != 0) {
-                stream->dwDifference += step;
-            }
+            for (int code = 0; code < 16; ++code) {
+                int delta = step >> 3;
 
-            if ((current_nybble & 2) != 0) {
-                stream->dwDifference += step >> 1;
-            }
+                if ((code & 4) != 0) {
+                    delta += step;
+                }
 
-            if ((current_nybble & 1) != 0) {
-                stream->dwDifference += step >> 2;
-            }
+                if ((code & 2) != 0) {
+                    delta += step >> 1;
+                }
 
-            if ((current_nybble & 8) != 0) {
-                stream->dwDifference = -stream->dwDifference;
-            }
+                if ((code & 1) != 0) {
+                    delta += step >> 2;
+                }
 
-            sample = clamp(stream->dwDifference + stream->dwPredicted, -32768, 32767);
-            stream->dwPredicted = sample;
+                if ((code & 8) != 0) {
+                    delta = -delta;
+                }
 
-            if (stream->wBitSize == 16) {
-                *dst = sample;
-                // Stereo is interleaved so skip a sample for this channel.
-                dst += 2;
-            } else {
-                *dst++ = ((sample & 0xFF00) >> 8) ^ 0x80;
+                Entry[index][code].Delta = delta;
+                Entry[index][code].Next = clamp(index + wCODECIndexTab[code & 0x7], 0, 88);
             }
-
-            stream->wIndex += wCODECIndexTab[stream->wCode & 0x7];
-            stream->wIndex = clamp(stream->wIndex, 0, 88);
-            ++stream->dwSampleIndex;
-            stream->wStep = wCODECStepTab[stream->wIndex];
         }
+    }
+};
 
-        src = stream->lpSource + 1;
-        dst = (short*)(stream->lpDest + 1);
+// Built on first use, the audio and movie loader threads can both get here first.
+static SOSDecodeEntry const (*SOS_Decode_Table())[16]
+{
+    static SOSDecodeTable const table;
+    return table.Entry;
+}
 
-        if (stream->wBitSize == 16) {
-            dst = (short*)(stream->lpDest) + 1;
-        }
+// Per channel decoder state, kept in locals while a block is decoded.
+struct SOSChannel
+{
+    int Index;
+    int Predicted;
+    SOSDecodeEntry const* Last;
+};
 
-        for (int i = bytes; i > 0; i -= 2) {
-            if ((stream->dwSampleIndex2 & 1) != 0) {
-                current_nybble = stream->wCodeBuf2 >> 4;
-                stream->wCode2 = current_nybble;
-            } else {
-                stream->wCodeBuf2 = *src;
-                // Stereo is interleaved so skip a byte for this channel.
-                src += 2;
-                current_nybble = stream->wCodeBuf2 & 0xF;
-                stream->wCode2 = current_nybble;
-            }
+static inline int SOS_Decode_Nybble(SOSDecodeEntry const (*table)[16], SOSChannel& chan, unsigned code)
+{
+    chan.Last = &table[chan.Index][code];
+    chan.Index = chan.Last->Next;
+    chan.Predicted = clamp(chan.Predicted + chan.Last->Delta, -32768, 32767);
+    return chan.Predicted;
+}
 
-            step = stream->wStep2;
-            stream->dwDifference2 = step >> 3;
+static inline void SOS_Output(short* dst, int sample)
+{
+    *dst = sample;
+}
 
-            if ((current_nybble & 4) != 0) {
-                stream->dwDifference2 += step;
-            }
+static inline void SOS_Output(char* dst, int sample)
+{
+    *dst = ((sample & 0xFF00) >> 8) ^ 0x80;
+}
 
-            if ((current_nybble & 2) != 0) {
-                stream->dwDifference2 += step >> 1;
-            }
+static inline void SOS_Load_Channel(SOSChannel& chan, short index, long predicted)
+{
+    chan.Index = index;
+    chan.Predicted = predicted;
+    chan.Last = nullptr;
+}
 
-            if ((current_nybble & 1) != 0) {
-                stream->dwDifference2 += step >> 2;
-            }
+// Writes back the state the nybble at a time decoder leaves behind. The code byte is sign extended as it was read
+// through a char pointer, last_byte is only looked at if anything was decoded.
+static inline void SOS_Store_Channel(SOSChannel const& chan,
+                                     unsigned count,
+                                     unsigned char const* last_byte,
+                                     short& code_buf,
+                                     short& code,
+                                     short& index,
+                                     short& step,
+                                     long& predicted,
+                                     long& difference,
+                                     unsigned long& sample_index)
+{
+    sample_index = count;
 
-            if ((current_nybble & 8) != 0) {
-                stream->dwDifference2 = -stream->dwDifference2;
-            }
+    if (count == 0) {
+        return;
+    }
 
-            sample = clamp(stream->dwDifference2 + stream->dwPredicted2, -32768, 32767);
-            stream->dwPredicted2 = sample;
+    code_buf = (signed char)*last_byte;
+    code = (count & 1) != 0 ? code_buf & 0xF : code_buf >> 4;
+    index = chan.Index;
+    step = wCODECStepTab[chan.Index];
+    predicted = chan.Predicted;
+    difference = chan.Last->Delta;
+}
 
-            if (stream->wBitSize == 16) {
-                *dst = sample;
-                // Stereo is interleaved so skip a sample for this channel.
-                dst += 2;
-            } else {
-                *dst++ = ((sample & 0xFF00) >> 8) ^ 0x80;
-            }
+// Mono stream, each code byte holds two samples, low nybble first.
+template <typename T> static void SOS_Decode_Mono(_SOS_COMPRESS_INFO* stream, unsigned count)
+{
+    SOSDecodeEntry const(*table)[16] = SOS_Decode_Table();
+    unsigned char const* src = (unsigned char const*)(stream->lpSource);
+    T* dst = (T*)(stream->lpDest);
+    SOSChannel chan;
 
-            stream->wIndex2 += wCODECIndexTab[stream->wCode2 & 0x7];
-            stream->wIndex2 = clamp(stream->wIndex2, 0, 88);
-            ++stream->dwSampleIndex2;
-            stream->wStep2 = wCODECStepTab[stream->wIndex2];
-        }
-    } else {
-        for (int i = bytes; i > 0; --i) {
-            if ((stream->dwSampleIndex & 1) != 0) {
-                current_nybble = stream->wCodeBuf >> 4;
-                stream->wCode = current_nybble;
-            } else {
-                stream->wCodeBuf = *src++;
-                current_nybble = stream->wCodeBuf & 0xF;
-                stream->wCode = current_nybble;
-            }
+    SOS_Load_Channel(chan, stream->wIndex, stream->dwPredicted);
 
-            step = stream->wStep;
-            stream->dwDifference = step >> 3;
+    for (unsigned i = count / 2; i > 0; --i) {
+        unsigned code = *src++;
+        SOS_Output(dst++, SOS_Decode_Nybble(table, chan, code & 0xF));
+        SOS_Output(dst++, SOS_Decode_Nybble(table, chan, code >> 4));
+    }
 
-            if ((current_nybble & 4) != 0) {
-                stream->dwDifference += step;
-            }
+    if ((count & 1) != 0) {
+        SOS_Output(dst, SOS_Decode_Nybble(table, chan, *src++ & 0xF));
+    }
 
-            if ((current_nybble & 2) != 0) {
-                stream->dwDifference += step >> 1;
-            }
+    SOS_Store_Channel(chan,
+                      count,
+                      src - 1,
+                      stream->wCodeBuf,
+                      stream->wCode,
+                      stream->wIndex,
+                      stream->wStep,
+                      stream->dwPredicted,
+                      stream->dwDifference,
+                      stream->dwSampleIndex);
+}
 
-            if ((current_nybble & 1) != 0) {
-                stream->dwDifference += step >> 2;
-            }
+// Stereo stream, code bytes alternate between the channels. Both channels are decoded in the same loop so their
+// independent prediction chains overlap instead of running one after the other.
+template <typename T> static void SOS_Decode_Stereo(_SOS_COMPRESS_INFO* stream, unsigned count)
+{
+    SOSDecodeEntry const(*table)[16] = SOS_Decode_Table();
+    unsigned char const* src = (unsigned char const*)(stream->lpSource);
+    T* dst = (T*)(stream->lpDest);
+    SOSChannel left;
+    SOSChannel right;
+
+    SOS_Load_Channel(left, stream->wIndex, stream->dwPredicted);
+    SOS_Load_Channel(right, stream->wIndex2, stream->dwPredicted2);
+
+    for (unsigned i = count / 2; i > 0; --i) {
+        unsigned lcode = src[0];
+        unsigned rcode = src[1];
+        src += 2;
+        SOS_Output(&dst[0], SOS_Decode_Nybble(table, left, lcode & 0xF));
+        SOS_Output(&dst[1], SOS_Decode_Nybble(table, right, rcode & 0xF));
+        SOS_Output(&dst[2], SOS_Decode_Nybble(table, left, lcode >> 4));
+        SOS_Output(&dst[3], SOS_Decode_Nybble(table, right, rcode >> 4));
+        dst += 4;
+    }
 
-            if ((current_nybble & 8) != 0) {
-                stream->dwDifference = -stream->dwDifference;
-            }
+    if ((count & 1) != 0) {
+        SOS_Output(&dst[0], SOS_Decode_Nybble(table, left, src[0] & 0xF));
+        SOS_Output(&dst[1], SOS_Decode_Nybble(table, right, src[1] & 0xF));
+        src += 2;
+    }
 
-            sample = clamp(stream->dwDifference + stream->dwPredicted, -32768, 32767);
-            stream->dwPredicted = sample;
+    SOS_Store_Channel(left,
+                      count,
+                      src - 2,
+                      stream->wCodeBuf,
+                      stream->wCode,
+                      stream->wIndex,
+                      stream->wStep,
+                      stream->dwPredicted,
+                      stream->dwDifference,
+                      stream->dwSampleIndex);
+    SOS_Store_Channel(right,
+                      count,
+                      src - 1,
+                      stream->wCodeBuf2,
+                      stream->wCode2,
+                      stream->wIndex2,
+                      stream->wStep2,
+                      stream->dwPredicted2,
+                      stream->dwDifference2,
+                      stream->dwSampleIndex2);
+}
 
-            if (stream->wBitSize == 16) {
-                *dst++ = sample;
-            } else {
-                *dst = ((sample & 0xFF00) >> 8) ^ 0x80;
-                dst = (short*)((char*)(dst) + 1);
-            }
+//
+// decompress data from a 4:1 ADPCM compressed file.  the number of
+// bytes decompressed is returned.
+//
+unsigned long sosCODECDecompressData(_SOS_COMPRESS_INFO* stream, unsigned long bytes)
+{
+    unsigned samples = stream->wBitSize == 16 ? bytes / 2 : bytes;
 
-            stream->wIndex += wCODECIndexTab[stream->wCode & 0x7];
-            stream->wIndex = clamp(stream->wIndex, 0, 88);
-            ++stream->dwSampleIndex;
-            stream->wStep = wCODECStepTab[stream->wIndex];
-        };
+    if (stream->wChannels == 2) {
+        // Sample count per channel, an odd total still decodes a final pair.
+        samples = (samples + 1) / 2;
+
+        if (stream->wBitSize == 16) {
+            SOS_Decode_Stereo<short>(stream, samples);
+        } else {
+            SOS_Decode_Stereo<char>(stream, samples);
+        }
+    } else if (stream->wBitSize == 16) {
+        SOS_Decode_Mono<short>(stream, samples);
+    } else {
+        SOS_Decode_Mono<char>(stream, samples);
     }
 
-    return full_length;
+    return bytes;
 }
 
 //
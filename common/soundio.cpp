@@ -488,7 +488,8 @@ int File_Stream_Sample_Vol(const char* filename, int volume, bool real_time_star
     }
 
     if (FileStreamBuffer == nullptr) {
-        FileStreamBuffer = malloc((unsigned long)(LockedData.StreamBufferSize * LockedData.StreamBufferCount));
+        FileStreamBuffer = Alloc((unsigned long)(LockedData.StreamBufferSize * LockedData.StreamBufferCount),
+                                 Memory_Tag_Flag(MEM_TAG_AUDIO));
 
         for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
             LockedData.SampleTracker[i].FileBuffer = FileStreamBuffer;
@@ -585,7 +586,7 @@ void* Load_Sample(char const* filename)
 
     if (handle != INVALID_FILE_HANDLE) {
         int data_size = File_Size(handle) + sizeof(AUDHeaderType);
-        data = malloc(data_size);
+        data = Alloc(data_size, Memory_Tag_Flag(MEM_TAG_AUDIO));
 
         if (data != nullptr) {
             Sample_Read(handle, data, data_size);
@@ -636,8 +637,7 @@ long Sample_Read(int fh, void* buffer, long size)
 void Free_Sample(void const* sample)
 {
     if (sample != nullptr) {
-        //Free(sample);
-        free((void*)sample);
+        Free(sample);
     }
 }
 
@@ -800,7 +800,7 @@ bool Audio_Init(int bits_per_sample, bool stereo, int rate, bool reverse_channel
 
     BufferDesc.lpwfxFormat = &DsBuffFormat;
 
-    LockedData.UncompBuffer = malloc(UNCOMP_BUFFER_SIZE);
+    LockedData.UncompBuffer = Alloc(UNCOMP_BUFFER_SIZE, Memory_Tag_Flag(MEM_TAG_AUDIO));
 
     if (LockedData.UncompBuffer == nullptr) {
         //CCDebugString("Audio_Init - Failed to allocate UncompBuffer.");
@@ -848,8 +848,7 @@ void Sound_End()
     }
 
     if (FileStreamBuffer != nullptr) {
-        //Free(FileStreamBuffer);
-        free((void*)FileStreamBuffer);
+        Free(FileStreamBuffer);
         FileStreamBuffer = nullptr;
     }
 
@@ -865,8 +864,7 @@ void Sound_End()
     }
 
     if (LockedData.UncompBuffer != nullptr) {
-        //Free(LockedData.UncompBuffer);
-        free((void*)LockedData.UncompBuffer);
+        Free(LockedData.UncompBuffer);
         LockedData.UncompBuffer = nullptr;
     }
 
@@ -1378,6 +1376,14 @@ int Get_Digi_Handle()
     return LockedData.DigiHandle;
 }
 
+/*
+**	DirectSound mixes on the game thread and its timer, there is no audio thread to report on.
+*/
+void Get_Sound_Statistics(SoundStatisticsType* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
 unsigned Sample_Length(void* sample)
 {
     if (sample == nullptr) {
@@ -13,11 +13,17 @@
 #include "auduncmp.h"
 #include "file.h"
 #include "memflag.h"
+#include "pcmcache.h"
 #include "soscomp.h"
 #include "sound.h"
 #include <al.h>
 #include <alc.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 enum
 {
@@ -37,6 +43,11 @@ enum
     INVALID_AUDIO_HANDLE = -1,
     INVALID_FILE_HANDLE = -1,
     OPENAL_BUFFER_COUNT = 2,
+    AUDIO_QUEUE_SIZE = 64, // Commands the game thread can have in flight to the audio thread.
+    PCM_CACHE_BYTES = 4 * 1024 * 1024, // Decoded sound effects kept for replay.
+    PCM_CACHE_MAX_SAMPLE = 256 * 1024, // Largest decoded sample worth caching, anything longer is streamed.
+    VOICE_COALESCE_MS = 60, // Repeats of a sample started within about a game frame join the voice already playing.
+    VOICE_CULL_VOLUME = 8,  // Sound effects quieter than this at the current sound volume are never started.
 };
 
 /*
@@ -187,6 +198,12 @@ struct SampleTrackerType
 
     // A set of buffers
     ALuint AudioBuffers[OPENAL_BUFFER_COUNT];
+
+    // The play request this tracker is serving, reported back to the game thread when it ends.
+    unsigned PlayId;
+
+    // Decoded data from the sample cache, held while it plays in case the cache evicts it.
+    PCMCacheClass::PCMPtr CachedPCM;
 };
 
 struct LockedDataType
@@ -198,11 +215,84 @@ struct LockedDataType
     long StreamBufferSize;   // = (2*SECONDARY_BUFFER_SIZE)+128;
     short StreamBufferCount; // = 32;
     SampleTrackerType SampleTracker[MAX_SAMPLE_TRACKERS];
-    unsigned SoundVolume;
-    unsigned ScoreVolume;
+    std::atomic<unsigned> SoundVolume;
+    std::atomic<unsigned> ScoreVolume;
     int VolumeLock;
 } LockedData;
 
+/*
+**	The game thread's view of each sample tracker. The trackers themselves belong to the audio thread, which only
+**	reports back through DoneId, so the game can pick and query handles without waiting on it.
+*/
+struct SampleHandleType
+{
+    const void* Original;
+    int Priority;
+    int Volume;
+    bool IsScore;
+    bool OffScreen;               // Started with a pan position, the game only pans sounds outside the tactical view.
+    unsigned Started;             // Voice_Clock time the current play was queued.
+    unsigned PlayId;              // Bumped for every play queued on this handle.
+    std::atomic<unsigned> DoneId; // Last play the audio thread has finished with.
+};
+
+static SampleHandleType SampleHandles[MAX_SAMPLE_TRACKERS];
+
+enum AudioCommandEnum
+{
+    AUDIO_CMD_PLAY,
+    AUDIO_CMD_STREAM,
+    AUDIO_CMD_STOP,
+    AUDIO_CMD_FADE,
+    AUDIO_CMD_SCORE_VOLUME,
+    AUDIO_CMD_VOLUME,
+};
+
+struct AudioCommandType
+{
+    AudioCommandEnum Command;
+    int Index;
+    unsigned PlayId;
+    const void* Sample;
+    int Volume;
+    int Ticks;
+    int FileHandle;
+    bool IsScore;
+    bool RealTime;
+};
+
+/*
+**	Commands from the game thread to the audio thread. Only the game thread writes AudioQueueHead and only the
+**	audio thread writes AudioQueueTail, so neither side ever takes a lock to pass a command.
+*/
+static AudioCommandType AudioQueue[AUDIO_QUEUE_SIZE];
+static std::atomic<unsigned> AudioQueueHead;
+static std::atomic<unsigned> AudioQueueTail;
+
+// Never destroyed while running, so a game exiting without Sound_End doesn't trip std::thread's destructor.
+static std::thread* AudioThread;
+static std::atomic<bool> AudioThreadQuit;
+static std::mutex AudioWakeMutex;
+static std::condition_variable AudioWake;
+
+static std::atomic<unsigned> AudioUnderruns;
+static std::atomic<unsigned> AudioQueueStalls;
+static std::atomic<unsigned> AudioCommands;
+
+// Only used by the audio thread, which copies its counters out for Get_Sound_Statistics.
+static PCMCacheClass SampleCache(PCM_CACHE_BYTES);
+static std::atomic<unsigned> AudioCacheHits;
+static std::atomic<unsigned> AudioCacheMisses;
+static std::atomic<unsigned> AudioCacheEvictions;
+static std::atomic<unsigned> AudioCacheBytes;
+static std::atomic<unsigned> AudioCacheCount;
+
+// Voice allocation happens on the game thread, so these need no synchronisation.
+static unsigned VoiceStarts;
+static unsigned VoiceCoalesced;
+static unsigned VoiceCulls;
+static unsigned VoiceSteals;
+
 void (*Audio_Focus_Loss_Function)() = nullptr;
 
 SFX_Type SoundType;
@@ -219,6 +309,7 @@ unsigned int SoundTimerHandle;
 
 bool Any_Locked(); // From each games winstub.cpp at the moment.
 void Maintenance_Callback();
+static int Find_Voice(int priority, bool offscreen);
 
 static ALenum Get_OpenAL_Format(int bits, int channels)
 {
@@ -278,6 +369,73 @@ static void Init_Locked_Data()
     LockedData.StreamBufferCount = STREAM_BUFFER_COUNT;
     LockedData.SoundVolume = VOLUME_MAX;
     LockedData.ScoreVolume = VOLUME_MAX;
+
+    for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
+        LockedData.SampleTracker[i].FileHandle = INVALID_FILE_HANDLE;
+        SampleHandles[i].Original = nullptr;
+        SampleHandles[i].Priority = 0;
+        SampleHandles[i].Volume = 0;
+        SampleHandles[i].IsScore = false;
+        SampleHandles[i].OffScreen = false;
+        SampleHandles[i].Started = 0;
+        SampleHandles[i].PlayId = 0;
+        SampleHandles[i].DoneId = 0;
+    }
+}
+
+/*
+**	Called on the game thread to hand a command to the audio thread.
+*/
+static void Queue_Audio_Command(AudioCommandType const& command)
+{
+    if (AudioThread == nullptr) {
+        return;
+    }
+
+    unsigned head = AudioQueueHead.load(std::memory_order_relaxed);
+
+    // Wait for room rather than drop a command, the audio thread drains the queue every time it wakes.
+    if (head - AudioQueueTail.load(std::memory_order_acquire) >= AUDIO_QUEUE_SIZE) {
+        ++AudioQueueStalls;
+
+        while (head - AudioQueueTail.load(std::memory_order_acquire) >= AUDIO_QUEUE_SIZE) {
+            AudioWake.notify_one();
+            std::this_thread::yield();
+        }
+    }
+
+    AudioQueue[head % AUDIO_QUEUE_SIZE] = command;
+    AudioQueueHead.store(head + 1, std::memory_order_release);
+    AudioWake.notify_one();
+}
+
+/*
+**	Is the handle still busy with a play the game thread has asked for?
+*/
+static bool Handle_Busy(int index)
+{
+    return SampleHandles[index].DoneId.load(std::memory_order_acquire) != SampleHandles[index].PlayId;
+}
+
+static unsigned Voice_Clock()
+{
+    return (unsigned)std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/*
+**	Called on the audio thread when a tracker is done with the play it was serving.
+*/
+static void Finish_Play(int index)
+{
+    unsigned id = LockedData.SampleTracker[index].PlayId;
+    unsigned done = SampleHandles[index].DoneId.load(std::memory_order_relaxed);
+
+    // Play ids only grow, never report an older play as finishing a newer one.
+    while ((int)(id - done) > 0
+           && !SampleHandles[index].DoneId.compare_exchange_weak(done, id, std::memory_order_release)) {
+    }
 }
 
 int Simple_Copy(void** source, int* ssize, void** alternate, int* altsize, void** dest, int size)
@@ -401,6 +559,13 @@ int File_Stream_Sample(const char* filename, bool real_time_start)
     return File_Stream_Sample_Vol(filename, VOLUME_MAX, real_time_start);
 }
 
+static int Start_Sample(const void* sample, int volume, int id, bool cache);
+static void Stop_Tracker(int index);
+static void Audio_Thread_Main();
+
+/*
+**	Everything from here to Maintenance_Callback runs on the audio thread.
+*/
 int Stream_Sample_Vol(void* buffer, int size, bool (*callback)(short, short*, void**, int*), int volume, int handle)
 {
     if (AudioDone || buffer == nullptr || size == 0 || LockedData.DigiHandle == INVALID_AUDIO_HANDLE) {
@@ -412,7 +577,7 @@ int Stream_Sample_Vol(void* buffer, int size, bool (*callback)(short, short*, vo
     int oldsize = header.Size;
     header.Size = size - sizeof(header);
     memcpy(buffer, &header, sizeof(header));
-    int playid = Play_Sample_Handle(buffer, PRIORITY_MAX, volume, 0, handle);
+    int playid = Start_Sample(buffer, volume, handle, false);
     header.Size = oldsize;
     memcpy(buffer, &header, sizeof(header));
 
@@ -521,16 +686,9 @@ void File_Stream_Preload(int index)
     Maintenance_Callback();
 
     if (LockedData.StreamBufferSize > st->FilePendingSize || i == maxnum) {
-        int old_vol = LockedData.SoundVolume;
-
         int stream_size = st->FilePending == 1 ? st->FilePendingSize : LockedData.StreamBufferSize;
 
-        LockedData.SoundVolume = LockedData.ScoreVolume;
-        StartingFileStream = true;
         Stream_Sample_Vol(st->FileBuffer, stream_size, File_Callback, st->Volume, index);
-        StartingFileStream = false;
-
-        LockedData.SoundVolume = old_vol;
 
         st->Loading = false;
         --st->FilePending;
@@ -542,6 +700,7 @@ void File_Stream_Preload(int index)
             st->FilePendingSize = 0;
             st->Callback = nullptr;
             Close_File(st->FileHandle);
+            st->FileHandle = INVALID_FILE_HANDLE;
         } else {
             st->Odd = 2;
             --st->FilePending;
@@ -557,21 +716,21 @@ void File_Stream_Preload(int index)
     }
 }
 
+/*
+**	Called on the game thread. The file is opened here but read from the audio thread, which owns it from then on.
+*/
 int File_Stream_Sample_Vol(char const* filename, int volume, bool real_time_start)
 {
-    if (LockedData.DigiHandle == INVALID_AUDIO_HANDLE || filename == nullptr || !Find_File(filename)) {
+    if (AudioDone || LockedData.DigiHandle == INVALID_AUDIO_HANDLE || filename == nullptr || !Find_File(filename)) {
         return INVALID_AUDIO_HANDLE;
     }
 
     if (FileStreamBuffer == nullptr) {
-        FileStreamBuffer = malloc((unsigned long)(LockedData.StreamBufferSize * LockedData.StreamBufferCount));
-
-        for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
-            LockedData.SampleTracker[i].FileBuffer = FileStreamBuffer;
-        }
+        FileStreamBuffer = Alloc((unsigned long)(LockedData.StreamBufferSize * LockedData.StreamBufferCount),
+                                 Memory_Tag_Flag(MEM_TAG_AUDIO));
     }
 
-    if (FileStreamBuffer == nullptr) {
+    if (FileStreamBuffer == nullptr || !Start_Primary_Sound_Buffer(false)) {
         return INVALID_AUDIO_HANDLE;
     }
 
@@ -583,73 +742,107 @@ int File_Stream_Sample_Vol(char const* filename, int volume, bool real_time_star
 
     int handle = Get_Free_Sample_Handle(PRIORITY_MAX);
 
-    if (handle < MAX_SAMPLE_TRACKERS) {
-        SampleTrackerType* st = &LockedData.SampleTracker[handle];
-        st->IsScore = true;
-        st->FilePending = 0;
-        st->FilePendingSize = 0;
-        st->Loading = real_time_start;
-        st->Volume = volume;
-        st->FileHandle = fh;
-        File_Stream_Preload(handle);
+    if (handle != INVALID_AUDIO_HANDLE) {
+        SampleHandleType* sh = &SampleHandles[handle];
+        sh->Original = FileStreamBuffer;
+        sh->Priority = PRIORITY_MAX;
+        sh->Volume = volume;
+        sh->IsScore = true;
+        sh->OffScreen = false;
+        sh->Started = Voice_Clock();
+        StartingFileStream = false;
+
+        AudioCommandType command = {
+            AUDIO_CMD_STREAM, handle, ++sh->PlayId, FileStreamBuffer, volume, 0, fh, true, real_time_start};
+        Queue_Audio_Command(command);
+
         return handle;
     }
 
+    Close_File(fh);
+
     return INVALID_AUDIO_HANDLE;
 };
 
-void Sound_Callback()
+/*
+**	Runs on the audio thread each time it wakes, after any queued commands.
+*/
+static void Audio_Service()
 {
-    if (!AudioDone && LockedData.DigiHandle != INVALID_AUDIO_HANDLE) {
-        Maintenance_Callback();
+    if (AudioDone || LockedData.DigiHandle == INVALID_AUDIO_HANDLE) {
+        return;
+    }
 
-        for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
-            SampleTrackerType* st = &LockedData.SampleTracker[i];
+    Maintenance_Callback();
 
-            // Is a load pending?
-            if (st->Loading) {
-                File_Stream_Preload(i);
-                // We are done with this sample.
-                continue;
-            }
+    for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
+        SampleTrackerType* st = &LockedData.SampleTracker[i];
 
-            // Is this sample inactive?
-            if (!st->Active) {
-                // If so, we close the handle.
-                if (st->FileHandle != INVALID_FILE_HANDLE) {
-                    Close_File(st->FileHandle);
-                    st->FileHandle = INVALID_FILE_HANDLE;
-                }
-                // We are done with this sample.
-                continue;
+        // Is a load pending?
+        if (st->Loading) {
+            File_Stream_Preload(i);
+            // We are done with this sample.
+            continue;
+        }
+
+        // Is this sample inactive?
+        if (!st->Active) {
+            // If so, we close the handle.
+            if (st->FileHandle != INVALID_FILE_HANDLE) {
+                Close_File(st->FileHandle);
+                st->FileHandle = INVALID_FILE_HANDLE;
             }
 
-            // Has it been faded Is the volume 0?
-            if (st->Reducer && !st->Volume) {
-                // If so stop it.
-                Stop_Sample(i);
+            // Let the game thread know the handle is free again.
+            Finish_Play(i);
 
-                // We are done with this sample.
-                continue;
-            }
+            // We are done with this sample.
+            continue;
+        }
 
-            // Process pending files.
-            if (st->QueueBuffer == nullptr
-                || st->FileHandle != INVALID_FILE_HANDLE && LockedData.StreamBufferCount - 3 > st->FilePending) {
-                if (st->Callback != nullptr) {
-                    if (!st->Callback(i, &st->Odd, &st->QueueBuffer, &st->QueueSize)) {
-                        // No files are pending so pending file callback not needed anymore.
-                        st->Callback = nullptr;
-                    }
-                }
+        // Has it been faded Is the volume 0?
+        if (st->Reducer && !st->Volume) {
+            // If so stop it.
+            Stop_Tracker(i);
 
-                // We are done with this sample.
-                continue;
+            // We are done with this sample.
+            continue;
+        }
+
+        // Process pending files.
+        if (st->QueueBuffer == nullptr
+            || st->FileHandle != INVALID_FILE_HANDLE && LockedData.StreamBufferCount - 3 > st->FilePending) {
+            if (st->Callback != nullptr) {
+                if (!st->Callback(i, &st->Odd, &st->QueueBuffer, &st->QueueSize)) {
+                    // No files are pending so pending file callback not needed anymore.
+                    st->Callback = nullptr;
+                }
             }
+
+            // We are done with this sample.
+            continue;
         }
     }
+}
+
+/*
+**	Called on the game thread. The audio thread services the trackers by itself, this just wakes it early.
+*/
+void Sound_Callback()
+{
+    if (!AudioDone && LockedData.DigiHandle != INVALID_AUDIO_HANDLE) {
+        AudioWake.notify_one();
+    }
 };
 
+/*
+**	Does a stream still have data on the way, so that running short of it now is an underrun and not the end?
+*/
+static bool Stream_Pending(SampleTrackerType* st)
+{
+    return st->Callback != nullptr || st->QueueBuffer != nullptr || st->FilePending > 0;
+}
+
 void Maintenance_Callback()
 {
     if (AudioDone) {
@@ -681,24 +874,55 @@ void Maintenance_Callback()
                                                        nullptr);
 
                         if (bytes_copied != BUFFER_CHUNK_SIZE) {
-                            st->MoreSource = false;
+                            st->MoreSource = Stream_Pending(st);
                         }
 
-                        if (bytes_copied > 0) {
-                            ALuint buffer;
-                            alSourceUnqueueBuffers(st->OpenALSource, 1, &buffer);
-                            alBufferData(buffer, st->Format, ChunkBuffer, bytes_copied, st->Frequency);
-                            alSourceQueueBuffers(st->OpenALSource, 1, &buffer);
-                            --processed_buffers;
+                        // Nothing to hand over until the stream catches up.
+                        if (bytes_copied <= 0) {
+                            break;
                         }
+
+                        ALuint buffer;
+                        alSourceUnqueueBuffers(st->OpenALSource, 1, &buffer);
+                        alBufferData(buffer, st->Format, ChunkBuffer, bytes_copied, st->Frequency);
+                        alSourceQueueBuffers(st->OpenALSource, 1, &buffer);
+                        --processed_buffers;
+                    }
+
+                    /*
+                    **	A stream that played out its buffers before more data arrived has stopped. Pick it up
+                    **	again once every buffer holds new data, so nothing already heard is replayed.
+                    */
+                    ALint source_status;
+                    alGetSourcei(st->OpenALSource, AL_SOURCE_STATE, &source_status);
+
+                    if (source_status == AL_STOPPED && processed_buffers == 0) {
+                        ++AudioUnderruns;
+                        alSourcePlay(st->OpenALSource);
                     }
                 } else {
                     ALint source_status;
                     alGetSourcei(st->OpenALSource, AL_SOURCE_STATE, &source_status);
 
                     if (source_status != AL_PLAYING) {
-                        st->Service = 0;
-                        Stop_Sample(i);
+                        ALint queued_buffers;
+                        ALint processed_buffers;
+                        alGetSourcei(st->OpenALSource, AL_BUFFERS_QUEUED, &queued_buffers);
+                        alGetSourcei(st->OpenALSource, AL_BUFFERS_PROCESSED, &processed_buffers);
+
+                        if (queued_buffers > processed_buffers) {
+                            // The last of a stream arrived after it ran dry, drop what was heard and play the rest.
+                            while (processed_buffers-- > 0) {
+                                ALuint tmp;
+                                alSourceUnqueueBuffers(st->OpenALSource, 1, &tmp);
+                            }
+
+                            ++AudioUnderruns;
+                            alSourcePlay(st->OpenALSource);
+                        } else {
+                            st->Service = 0;
+                            Stop_Tracker(i);
+                        }
                     }
                 }
             }
@@ -758,7 +982,7 @@ void* Load_Sample(char const* filename)
 
     if (handle != INVALID_FILE_HANDLE) {
         int data_size = File_Size(handle) + sizeof(AUDHeaderType);
-        data = malloc(data_size);
+        data = Alloc(data_size, Memory_Tag_Flag(MEM_TAG_AUDIO));
 
         if (data != nullptr) {
             Sample_Read(handle, data, data_size);
@@ -809,7 +1033,7 @@ long Sample_Read(int fh, void* buffer, long size)
 void Free_Sample(const void* sample)
 {
     if (sample != nullptr) {
-        free((void*)sample);
+        Free(sample);
     }
 };
 
@@ -836,7 +1060,7 @@ bool Audio_Init(int bits_per_sample, bool stereo, int rate, bool reverse_channel
 
     LockedData.DigiHandle = 1;
 
-    LockedData.UncompBuffer = malloc(UNCOMP_BUFFER_SIZE);
+    LockedData.UncompBuffer = Alloc(UNCOMP_BUFFER_SIZE, Memory_Tag_Flag(MEM_TAG_AUDIO));
 
     if (LockedData.UncompBuffer == nullptr) {
         //CCDebugString("Audio_Init - Failed to allocate UncompBuffer.");
@@ -870,20 +1094,38 @@ bool Audio_Init(int bits_per_sample, bool stereo, int rate, bool reverse_channel
     SampleType = SAMPLE_SB;
     AudioDone = false;
 
+    // From here on the trackers belong to the audio thread.
+    if (AudioThread == nullptr) {
+        AudioQueueHead = 0;
+        AudioQueueTail = 0;
+        AudioThreadQuit = false;
+        AudioThread = new std::thread(Audio_Thread_Main);
+    }
+
     return true;
 };
 
 void Sound_End()
 {
-    if (OpenALContext == nullptr) {
+    if (AudioThread != nullptr) {
+        AudioThreadQuit = true;
+        AudioWake.notify_one();
+        AudioThread->join();
+        delete AudioThread;
+        AudioThread = nullptr;
+    }
+
+    SampleCache.Clear();
+
+    if (OpenALContext != nullptr) {
         for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
-            Stop_Sample(i);
+            Stop_Tracker(i);
             alDeleteSources(1, &LockedData.SampleTracker[i].OpenALSource);
         }
     }
 
     if (FileStreamBuffer != nullptr) {
-        free((void*)FileStreamBuffer);
+        Free(FileStreamBuffer);
         FileStreamBuffer = nullptr;
     }
 
@@ -894,14 +1136,17 @@ void Sound_End()
     alcCloseDevice(device);
 
     if (LockedData.UncompBuffer != nullptr) {
-        free((void*)LockedData.UncompBuffer);
+        Free(LockedData.UncompBuffer);
         LockedData.UncompBuffer = nullptr;
     }
 
     AudioDone = true;
 };
 
-void Stop_Sample(int index)
+/*
+**	Runs on the audio thread.
+*/
+static void Stop_Tracker(int index)
 {
     if (LockedData.DigiHandle != INVALID_AUDIO_HANDLE && index < MAX_SAMPLE_TRACKERS && !AudioDone) {
         SampleTrackerType* st = &LockedData.SampleTracker[index];
@@ -937,6 +1182,27 @@ void Stop_Sample(int index)
 
             st->QueueBuffer = nullptr;
         }
+
+        st->CachedPCM.reset();
+        Finish_Play(index);
+    }
+}
+
+void Stop_Sample(int index)
+{
+    if (LockedData.DigiHandle != INVALID_AUDIO_HANDLE && index >= 0 && index < MAX_SAMPLE_TRACKERS && !AudioDone) {
+        SampleHandleType* sh = &SampleHandles[index];
+
+        if (Handle_Busy(index)) {
+            if (!sh->IsScore) {
+                sh->Original = nullptr;
+            }
+
+            sh->Priority = 0;
+
+            AudioCommandType command = {AUDIO_CMD_STOP, index, sh->PlayId};
+            Queue_Audio_Command(command);
+        }
     }
 };
 
@@ -954,20 +1220,8 @@ bool Sample_Status(int index)
         return false;
     }
 
-    SampleTrackerType* st = &LockedData.SampleTracker[index];
-
-    if (st->Loading) {
-        return true;
-    }
-
-    if (!st->Active) {
-        return false;
-    }
-
-    ALint val;
-    alGetSourcei(st->OpenALSource, AL_SOURCE_STATE, &val);
-
-    return val == AL_PLAYING;
+    // Still loading, playing or not yet started by the audio thread.
+    return Handle_Busy(index);
 };
 
 bool Is_Sample_Playing(const void* sample)
@@ -977,7 +1231,7 @@ bool Is_Sample_Playing(const void* sample)
     }
 
     for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
-        if (sample == LockedData.SampleTracker[i].Original && Sample_Status(i)) {
+        if (sample == SampleHandles[i].Original && Sample_Status(i)) {
             return true;
         }
     }
@@ -989,7 +1243,7 @@ void Stop_Sample_Playing(const void* sample)
 {
     if (sample != nullptr) {
         for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
-            if (LockedData.SampleTracker[i].Original == sample) {
+            if (SampleHandles[i].Original == sample) {
                 Stop_Sample(i);
                 break;
             }
@@ -997,9 +1251,51 @@ void Stop_Sample_Playing(const void* sample)
     }
 };
 
+/*
+**	Sound effects go through a few checks on the game thread before anything reaches the audio thread, so sounds
+**	that would never be heard, or be stolen straight away, cost neither a decode nor a buffer upload. A sound the
+**	player couldn't hear is culled, a repeat of a sample that has only just started joins the voice already playing
+**	it, and a sound outside the tactical view won't steal a voice from one inside it.
+*/
 int Play_Sample(const void* sample, int priority, int volume, signed short panloc)
 {
-    return Play_Sample_Handle(sample, priority, volume, panloc, Get_Free_Sample_Handle(priority));
+    if (AudioDone || sample == nullptr) {
+        return INVALID_AUDIO_HANDLE;
+    }
+
+    if (volume * (int)LockedData.SoundVolume < VOICE_CULL_VOLUME * VOLUME_MAX) {
+        ++VoiceCulls;
+        return INVALID_AUDIO_HANDLE;
+    }
+
+    unsigned now = Voice_Clock();
+
+    for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
+        SampleHandleType* sh = &SampleHandles[i];
+
+        if (sh->Original == sample && !sh->IsScore && Handle_Busy(i) && now - sh->Started < VOICE_COALESCE_MS) {
+            // The louder of the two requests wins, the nearer explosion is the one the player should hear.
+            if (volume > sh->Volume) {
+                sh->Volume = volume;
+                AudioCommandType command = {AUDIO_CMD_VOLUME, i, sh->PlayId, nullptr, volume};
+                Queue_Audio_Command(command);
+            }
+
+            sh->Priority = std::max(sh->Priority, priority);
+            sh->OffScreen = sh->OffScreen && panloc != 0;
+            ++VoiceCoalesced;
+            return i;
+        }
+    }
+
+    int handle = Find_Voice(priority, panloc != 0);
+
+    if (handle == INVALID_AUDIO_HANDLE) {
+        ++VoiceCulls;
+        return INVALID_AUDIO_HANDLE;
+    }
+
+    return Play_Sample_Handle(sample, priority, volume, panloc, handle);
 };
 
 int Attempt_To_Play_Buffer(int id)
@@ -1014,156 +1310,325 @@ int Attempt_To_Play_Buffer(int id)
     return id;
 }
 
-int Play_Sample_Handle(const void* sample, int priority, int volume, signed short panloc, int id)
+/*
+**	Runs on the audio thread, decoding the whole of a sample from where the tracker is set up to start.
+*/
+static std::vector<uint8_t> Decode_Sample(SampleTrackerType* st, int size)
 {
-    if (Any_Locked()) {
-        return INVALID_AUDIO_HANDLE;
+    MemoryTagClass tag(MEM_TAG_AUDIO);
+    std::vector<uint8_t> pcm;
+    void* source = st->Source;
+    int remainder = st->Remainder;
+    void* alternate = nullptr;
+    int altsize = 0;
+
+    pcm.reserve(size);
+
+    for (;;) {
+        size_t offset = pcm.size();
+        pcm.resize(offset + BUFFER_CHUNK_SIZE);
+
+        int bytes = Sample_Copy(st,
+                                &source,
+                                &remainder,
+                                &alternate,
+                                &altsize,
+                                &pcm[offset],
+                                BUFFER_CHUNK_SIZE,
+                                st->Compression,
+                                nullptr,
+                                nullptr);
+
+        pcm.resize(offset + std::max(bytes, 0));
+
+        if (bytes != BUFFER_CHUNK_SIZE) {
+            break;
+        }
     }
 
-    if (!AudioDone) {
-        if (sample == nullptr || LockedData.DigiHandle == INVALID_AUDIO_HANDLE) {
-            return INVALID_AUDIO_HANDLE;
-        }
+    return pcm;
+}
 
-        if (id == INVALID_AUDIO_HANDLE) {
-            return INVALID_AUDIO_HANDLE;
-        }
+/*
+**	Runs on the audio thread, decoding the first buffers of the sample and starting the source. Cacheable samples
+**	are decoded whole the first time and played straight from the cache after that.
+*/
+static int Start_Sample(const void* sample, int volume, int id, bool cache)
+{
+    SampleTrackerType* st = &LockedData.SampleTracker[id];
 
-        SampleTrackerType* st = &LockedData.SampleTracker[id];
+    // Read in the sample's header.
+    AUDHeaderType raw_header;
+    memcpy(&raw_header, sample, sizeof(raw_header));
 
-        // Read in the sample's header.
-        AUDHeaderType raw_header;
-        memcpy(&raw_header, sample, sizeof(raw_header));
+    // We don't support anything lower than 20000 hz.
+    if (raw_header.Rate < 24000 && raw_header.Rate > 20000) {
+        raw_header.Rate = 22050;
+    }
 
-        // We don't support anything lower than 20000 hz.
-        if (raw_header.Rate < 24000 && raw_header.Rate > 20000) {
-            raw_header.Rate = 22050;
+    // Set up basic sample tracker info.
+    st->Compression = SCompressType(raw_header.Compression);
+    st->Original = sample;
+    st->Odd = 0;
+    st->Reducer = 0;
+    st->Restart = false;
+    st->QueueBuffer = nullptr;
+    st->QueueSize = 0;
+    st->OriginalSize = raw_header.Size + sizeof(AUDHeaderType);
+    st->Service = 0;
+    st->Remainder = raw_header.Size;
+    st->Source = Add_Long_To_Pointer(sample, sizeof(AUDHeaderType));
+
+    // Compression is ADPCM so we need to init it's stream info.
+    if (st->Compression == SCOMP_SOS) {
+        st->sosinfo.wChannels = (raw_header.Flags & 1) + 1;
+        st->sosinfo.wBitSize = raw_header.Flags & 2 ? 16 : 8;
+        st->sosinfo.dwCompSize = raw_header.Size;
+        st->sosinfo.dwUnCompSize = raw_header.Size * (st->sosinfo.wBitSize / 4);
+        sosCODECInitStream(&st->sosinfo);
+    }
+
+    st->CachedPCM.reset();
+
+    if (cache && (st->Compression == SCOMP_WESTWOOD || st->Compression == SCOMP_SOS) && raw_header.Size > 0
+        && raw_header.UncompSize <= PCM_CACHE_MAX_SAMPLE) {
+        uint32_t check = PCMCacheClass::Check(st->Source, raw_header.Size);
+        PCMCacheClass::PCMPtr pcm = SampleCache.Find(sample, check);
+
+        if (pcm == nullptr) {
+            pcm = SampleCache.Add(sample, check, Decode_Sample(st, raw_header.UncompSize));
         }
 
-        // Set up basic sample tracker info.
-        st->Compression = SCompressType(raw_header.Compression);
-        st->Original = sample;
-        st->Odd = 0;
-        st->Reducer = 0;
-        st->Restart = false;
-        st->QueueBuffer = nullptr;
-        st->QueueSize = 0;
-        st->OriginalSize = raw_header.Size + sizeof(AUDHeaderType);
-        st->Priority = priority;
+        st->CachedPCM = pcm;
+        st->Compression = SCOMP_NONE;
+        st->Source = const_cast<uint8_t*>(pcm->data());
+        st->Remainder = (int)pcm->size();
+
+        AudioCacheHits = SampleCache.Hits();
+        AudioCacheMisses = SampleCache.Misses();
+        AudioCacheEvictions = SampleCache.Evictions();
+        AudioCacheBytes = (unsigned)SampleCache.Size();
+        AudioCacheCount = SampleCache.Count();
+    }
+
+    // If the loaded sample doesn't match the sample tracker we need to adjust the tracker.
+    if (raw_header.Rate != st->Frequency
+        || Get_OpenAL_Format((raw_header.Flags & 2) ? 16 : 8, (raw_header.Flags & 1) ? 2 : 1) != st->Format) {
+        st->Active = false;
         st->Service = 0;
-        st->Remainder = raw_header.Size;
-        st->Source = Add_Long_To_Pointer(sample, sizeof(AUDHeaderType));
-
-        // Compression is ADPCM so we need to init it's stream info.
-        if (st->Compression == SCOMP_SOS) {
-            st->sosinfo.wChannels = (raw_header.Flags & 1) + 1;
-            st->sosinfo.wBitSize = raw_header.Flags & 2 ? 16 : 8;
-            st->sosinfo.dwCompSize = raw_header.Size;
-            st->sosinfo.dwUnCompSize = raw_header.Size * (st->sosinfo.wBitSize / 4);
-            sosCODECInitStream(&st->sosinfo);
-        }
+        st->MoreSource = false;
 
-        // If the loaded sample doesn't match the sample tracker we need to adjust the tracker.
-        if (raw_header.Rate != st->Frequency
-            || Get_OpenAL_Format((raw_header.Flags & 2) ? 16 : 8, (raw_header.Flags & 1) ? 2 : 1) != st->Format) {
-            st->Active = false;
-            st->Service = 0;
-            st->MoreSource = false;
+        // Set the new sample info.
+        st->Frequency = raw_header.Rate;
+        st->Format = Get_OpenAL_Format((raw_header.Flags & 2) ? 16 : 8, (raw_header.Flags & 1) ? 2 : 1);
+    }
+
+    ALint source_status;
+    alGetSourcei(st->OpenALSource, AL_SOURCE_STATE, &source_status);
+
+    // If the sample is already playing stop it.
+    if (source_status != AL_STOPPED) {
+        st->Active = false;
+        st->Service = 0;
+        st->MoreSource = false;
+
+        ALint processed_count = -1;
+        alSourceStop(st->OpenALSource);
+        alGetSourcei(st->OpenALSource, AL_BUFFERS_PROCESSED, &processed_count);
 
-            // Set the new sample info.
-            st->Frequency = raw_header.Rate;
-            st->Format = Get_OpenAL_Format((raw_header.Flags & 2) ? 16 : 8, (raw_header.Flags & 1) ? 2 : 1);
+        while (processed_count-- > 0) {
+            ALuint tmp;
+            alSourceUnqueueBuffers(st->OpenALSource, 1, &tmp);
         }
 
-        ALint source_status;
-        alGetSourcei(st->OpenALSource, AL_SOURCE_STATE, &source_status);
+        alDeleteBuffers(OPENAL_BUFFER_COUNT, st->AudioBuffers);
+    }
 
-        // If the sample is already playing stop it.
-        if (source_status != AL_STOPPED) {
-            st->Active = false;
-            st->Service = 0;
-            st->MoreSource = false;
+    alGenBuffers(OPENAL_BUFFER_COUNT, st->AudioBuffers);
+    int buffer_index = 0;
 
-            ALint processed_count = -1;
-            alSourceStop(st->OpenALSource);
-            alGetSourcei(st->OpenALSource, AL_BUFFERS_PROCESSED, &processed_count);
+    while (buffer_index < OPENAL_BUFFER_COUNT) {
 
-            while (processed_count-- > 0) {
-                ALuint tmp;
-                alSourceUnqueueBuffers(st->OpenALSource, 1, &tmp);
-            }
+        int bytes_read = Sample_Copy(st,
+                                     &st->Source,
+                                     &st->Remainder,
+                                     &st->QueueBuffer,
+                                     &st->QueueSize,
+                                     ChunkBuffer,
+                                     BUFFER_CHUNK_SIZE,
+                                     st->Compression,
+                                     nullptr,
+                                     nullptr);
 
-            alDeleteBuffers(OPENAL_BUFFER_COUNT, st->AudioBuffers);
+        if (bytes_read > 0) {
+            alBufferData(st->AudioBuffers[buffer_index++], st->Format, ChunkBuffer, bytes_read, st->Frequency);
         }
 
-        alGenBuffers(OPENAL_BUFFER_COUNT, st->AudioBuffers);
-        int buffer_index = 0;
+        if (bytes_read == BUFFER_CHUNK_SIZE) {
+            st->MoreSource = true;
+            st->OneShot = false;
+        } else {
+            st->MoreSource = false;
+            st->OneShot = true;
+            break;
+        }
+    }
 
-        while (buffer_index < OPENAL_BUFFER_COUNT) {
+    alSourceQueueBuffers(st->OpenALSource, buffer_index, st->AudioBuffers);
+    st->Service = 1;
 
-            int bytes_read = Sample_Copy(st,
-                                         &st->Source,
-                                         &st->Remainder,
-                                         &st->QueueBuffer,
-                                         &st->QueueSize,
-                                         ChunkBuffer,
-                                         BUFFER_CHUNK_SIZE,
-                                         st->Compression,
-                                         nullptr,
-                                         nullptr);
+    st->Volume = volume;
 
-            if (bytes_read > 0) {
-                alBufferData(st->AudioBuffers[buffer_index++], st->Format, ChunkBuffer, bytes_read, st->Frequency);
-            }
+    unsigned master = st->IsScore ? LockedData.ScoreVolume : LockedData.SoundVolume;
+    alSourcef(st->OpenALSource, AL_GAIN, ((master * st->Volume) / 256) / 256.0f);
 
-            if (bytes_read == BUFFER_CHUNK_SIZE) {
-                st->MoreSource = true;
-                st->OneShot = false;
-            } else {
-                st->MoreSource = false;
-                st->OneShot = true;
-                break;
-            }
-        }
+    return Attempt_To_Play_Buffer(id);
+}
 
-        alSourceQueueBuffers(st->OpenALSource, buffer_index, st->AudioBuffers);
-        st->Service = 1;
+/*
+**	Called on the game thread. The handle is reserved straight away and the audio thread starts the sample.
+*/
+int Play_Sample_Handle(const void* sample, int priority, int volume, signed short panloc, int id)
+{
+    if (Any_Locked()) {
+        return INVALID_AUDIO_HANDLE;
+    }
 
-        st->Volume = volume;
+    if (!AudioDone) {
+        if (sample == nullptr || LockedData.DigiHandle == INVALID_AUDIO_HANDLE) {
+            return INVALID_AUDIO_HANDLE;
+        }
 
-        alSourcef(st->OpenALSource, AL_GAIN, ((LockedData.SoundVolume * st->Volume) / 256) / 256.0f);
+        if (id < 0 || id >= MAX_SAMPLE_TRACKERS) {
+            return INVALID_AUDIO_HANDLE;
+        }
 
         if (!Start_Primary_Sound_Buffer(false)) {
             //CCDebugString("Play_Sample_Handle - Can't start primary buffer!");
             return INVALID_AUDIO_HANDLE;
         }
 
-        return Attempt_To_Play_Buffer(id);
+        SampleHandleType* sh = &SampleHandles[id];
+        sh->Original = sample;
+        sh->Priority = priority;
+        sh->Volume = volume;
+        sh->OffScreen = panloc != 0;
+        sh->Started = Voice_Clock();
+        ++VoiceStarts;
+
+        AudioCommandType command = {
+            AUDIO_CMD_PLAY, id, ++sh->PlayId, sample, volume, 0, INVALID_FILE_HANDLE, sh->IsScore};
+        Queue_Audio_Command(command);
+
+        return id;
     }
 
     return INVALID_AUDIO_HANDLE;
 };
 
-int Set_Sound_Vol(int volume)
+/*
+**	Runs on the audio thread.
+*/
+static void Run_Audio_Command(AudioCommandType const& command)
 {
+    SampleTrackerType* st = &LockedData.SampleTracker[command.Index];
 
-    int oldvol = LockedData.SoundVolume;
-    LockedData.SoundVolume = volume;
-    return oldvol;
-};
+    switch (command.Command) {
+    case AUDIO_CMD_PLAY:
+        Stop_Tracker(command.Index);
+        st->PlayId = command.PlayId;
+        st->IsScore = command.IsScore;
 
-int Set_Score_Vol(int volume)
-{
-    int old = LockedData.ScoreVolume;
-    LockedData.ScoreVolume = volume;
+        if (Start_Sample(command.Sample, command.Volume, command.Index, true) == INVALID_AUDIO_HANDLE) {
+            Finish_Play(command.Index);
+        }
+        break;
 
-    for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
-        SampleTrackerType* st = &LockedData.SampleTracker[i];
+    case AUDIO_CMD_STREAM:
+        Stop_Tracker(command.Index);
+        st->PlayId = command.PlayId;
+        st->IsScore = true;
+        st->FileBuffer = FileStreamBuffer;
+        st->FilePending = 0;
+        st->FilePendingSize = 0;
+        st->Loading = command.RealTime;
+        st->Volume = command.Volume;
+        st->FileHandle = command.FileHandle;
+        File_Stream_Preload(command.Index);
+        break;
+
+    case AUDIO_CMD_STOP:
+        Stop_Tracker(command.Index);
+        break;
+
+    case AUDIO_CMD_FADE:
+        if (st->Active && !st->Loading) {
+            st->Reducer = ((st->Volume / command.Ticks) + 1);
+        } else {
+            Stop_Tracker(command.Index);
+        }
+        break;
+
+    case AUDIO_CMD_VOLUME:
+        if (st->PlayId == command.PlayId && st->Active) {
+            unsigned master = st->IsScore ? LockedData.ScoreVolume : LockedData.SoundVolume;
+            st->Volume = command.Volume;
+            alSourcef(st->OpenALSource, AL_GAIN, ((master * st->Volume) / 256) / 256.0f);
+        }
+        break;
+
+    case AUDIO_CMD_SCORE_VOLUME:
+        for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
+            SampleTrackerType* score = &LockedData.SampleTracker[i];
+
+            if (score->IsScore && score->Active) {
+                alSourcef(
+                    score->OpenALSource, AL_GAIN, ((LockedData.ScoreVolume * score->Volume) / 256) / 256.0f);
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
 
-        if (st->IsScore & st->Active) {
-            alSourcef(st->OpenALSource, AL_GAIN, ((LockedData.ScoreVolume * st->Volume) / 256) / 256.0f);
+/*
+**	The audio thread: takes commands from the game thread, then refills, restarts and retires samples. It wakes
+**	when a command is queued and otherwise often enough that streams never wait long for their next buffer.
+*/
+static void Audio_Thread_Main()
+{
+    while (!AudioThreadQuit) {
+        unsigned tail = AudioQueueTail.load(std::memory_order_relaxed);
+
+        while (tail != AudioQueueHead.load(std::memory_order_acquire)) {
+            AudioCommandType command = AudioQueue[tail % AUDIO_QUEUE_SIZE];
+            AudioQueueTail.store(++tail, std::memory_order_release);
+            Run_Audio_Command(command);
+            ++AudioCommands;
         }
+
+        Audio_Service();
+
+        std::unique_lock<std::mutex> lock(AudioWakeMutex);
+        AudioWake.wait_for(lock, std::chrono::milliseconds(TIMER_TARGET_RESOLUTION), [] {
+            return AudioThreadQuit || AudioQueueTail.load() != AudioQueueHead.load();
+        });
     }
+}
+
+int Set_Sound_Vol(int volume)
+{
+    return LockedData.SoundVolume.exchange(volume);
+};
+
+int Set_Score_Vol(int volume)
+{
+    int old = LockedData.ScoreVolume.exchange(volume);
+
+    AudioCommandType command = {AUDIO_CMD_SCORE_VOLUME, 0};
+    Queue_Audio_Command(command);
 
     return old;
 };
@@ -1171,23 +1636,27 @@ int Set_Score_Vol(int volume)
 void Fade_Sample(int index, int ticks)
 {
     if (Sample_Status(index)) {
-        SampleTrackerType* st = &LockedData.SampleTracker[index];
-
-        if (ticks > 0 && !st->Loading) {
-            st->Reducer = ((st->Volume / ticks) + 1);
+        if (ticks > 0) {
+            AudioCommandType command = {AUDIO_CMD_FADE, index, SampleHandles[index].PlayId, nullptr, 0, ticks};
+            Queue_Audio_Command(command);
         } else {
             Stop_Sample(index);
         }
     }
 };
 
-int Get_Free_Sample_Handle(int priority)
+/*
+**	Finds a handle for a new play, stopping the voice it takes over if none are free. The voice stolen is the least
+**	important one the new sound outranks, the oldest of those if several tie. Sounds outside the tactical view only
+**	take voices from other such sounds or from ones they strictly outrank.
+*/
+static int Find_Voice(int priority, bool offscreen)
 {
     int index = 0;
 
     for (index = MAX_SAMPLE_TRACKERS - 1; index >= 0; --index) {
-        if (!LockedData.SampleTracker[index].Active && !LockedData.SampleTracker[index].Loading) {
-            if (StartingFileStream || !LockedData.SampleTracker[index].IsScore) {
+        if (!Handle_Busy(index)) {
+            if (StartingFileStream || !SampleHandles[index].IsScore) {
                 break;
             }
 
@@ -1196,34 +1665,48 @@ int Get_Free_Sample_Handle(int priority)
     }
 
     if (index < 0) {
-        for (index = 0; index < MAX_SAMPLE_TRACKERS && LockedData.SampleTracker[index].Priority > priority; ++index) {
-            ;
+        unsigned now = Voice_Clock();
+
+        for (int i = 0; i < MAX_SAMPLE_TRACKERS; ++i) {
+            SampleHandleType const* sh = &SampleHandles[i];
+
+            if (sh->Priority > priority || (offscreen && !sh->OffScreen && sh->Priority == priority)) {
+                continue;
+            }
+
+            if (index < 0 || sh->Priority < SampleHandles[index].Priority
+                || (sh->Priority == SampleHandles[index].Priority
+                    && now - sh->Started > now - SampleHandles[index].Started)) {
+                index = i;
+            }
         }
 
-        if (index == MAX_SAMPLE_TRACKERS) {
+        if (index < 0) {
             return INVALID_AUDIO_HANDLE;
         }
 
         Stop_Sample(index);
+        ++VoiceSteals;
     }
 
     if (index == INVALID_AUDIO_HANDLE) {
         return INVALID_AUDIO_HANDLE;
     }
 
-    if (LockedData.SampleTracker[index].FileHandle != INVALID_FILE_HANDLE) {
-        Close_File(LockedData.SampleTracker[index].FileHandle);
-        LockedData.SampleTracker[index].FileHandle = INVALID_FILE_HANDLE;
-    }
-
-    if (LockedData.SampleTracker[index].Original) {
-        if (!LockedData.SampleTracker[index].IsScore) {
-            LockedData.SampleTracker[index].Original = 0;
+    // Any stream file still open on the tracker is closed by the audio thread when it starts the next sample.
+    if (SampleHandles[index].Original) {
+        if (!SampleHandles[index].IsScore) {
+            SampleHandles[index].Original = 0;
         }
     }
 
-    LockedData.SampleTracker[index].IsScore = false;
+    SampleHandles[index].IsScore = false;
     return index;
+}
+
+int Get_Free_Sample_Handle(int priority)
+{
+    return Find_Voice(priority, false);
 };
 
 int Get_Digi_Handle()
@@ -1231,6 +1714,22 @@ int Get_Digi_Handle()
     return LockedData.DigiHandle;
 }
 
+void Get_Sound_Statistics(SoundStatisticsType* stats)
+{
+    stats->Underruns = AudioUnderruns;
+    stats->QueueStalls = AudioQueueStalls;
+    stats->Commands = AudioCommands;
+    stats->CacheHits = AudioCacheHits;
+    stats->CacheMisses = AudioCacheMisses;
+    stats->CacheEvictions = AudioCacheEvictions;
+    stats->CacheBytes = AudioCacheBytes;
+    stats->CacheCount = AudioCacheCount;
+    stats->VoiceStarts = VoiceStarts;
+    stats->VoiceCoalesced = VoiceCoalesced;
+    stats->VoiceCulls = VoiceCulls;
+    stats->VoiceSteals = VoiceSteals;
+}
+
 long Sample_Length(const void* sample)
 {
     if (sample == nullptr) {
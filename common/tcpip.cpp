@@ -62,7 +62,7 @@ extern WWKeyboardClass* Keyboard;
 
 using std::min;
 
-#ifdef NETWORKING
+#if defined(NETWORKING) && defined(_WIN32)
 
 /*
 ** Nasty globals
@@ -54,7 +54,7 @@
 
 #include "tcpip.h"
 
-#ifndef NETWORKING
+#if !defined(NETWORKING) || !defined(_WIN32)
 
 /*
 ** Nasty globals
@@ -0,0 +1,286 @@
+#include "udpsock.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+UDPSocketClass::UDPSocketClass()
+    : Socket(-1)
+    , BoundPort(0)
+    , SentCount(0)
+    , ReceivedCount(0)
+    , ErrorCount(0)
+    , CallCount(0)
+{
+}
+
+UDPSocketClass::~UDPSocketClass()
+{
+    Close();
+}
+
+/*
+**	Binds to the first free port of the span starting at port, so several copies of the game on one machine can
+**	each have a socket near the well known port. A port of zero takes any free port.
+*/
+bool UDPSocketClass::Open(uint16_t port, int span)
+{
+    Close();
+
+    Socket = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (Socket < 0) {
+        return false;
+    }
+
+    int on = 1;
+    setsockopt(Socket, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+    fcntl(Socket, F_SETFL, fcntl(Socket, F_GETFL) | O_NONBLOCK);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    bool bound = false;
+
+    for (int i = 0; i < (port == 0 ? 1 : span) && !bound; ++i) {
+        addr.sin_port = htons((uint16_t)(port + i));
+        bound = bind(Socket, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+    }
+
+    socklen_t len = sizeof(addr);
+
+    if (!bound || getsockname(Socket, (struct sockaddr*)&addr, &len) != 0) {
+        Close();
+        return false;
+    }
+
+    BoundPort = addr.sin_port;
+    Find_Local_Addresses();
+
+    return true;
+}
+
+void UDPSocketClass::Close()
+{
+    if (Socket >= 0) {
+        close(Socket);
+        Socket = -1;
+    }
+
+    BoundPort = 0;
+}
+
+/*
+**	Blocks until a packet arrives or the timeout, in milliseconds, runs out.
+*/
+bool UDPSocketClass::Wait(int timeout_ms)
+{
+    if (Socket < 0) {
+        return false;
+    }
+
+    struct pollfd fd;
+    fd.fd = Socket;
+    fd.events = POLLIN;
+    fd.revents = 0;
+
+    return poll(&fd, 1, timeout_ms) > 0 && (fd.revents & POLLIN) != 0;
+}
+
+/*
+**	Takes up to count waiting packets without blocking. Returns how many were read.
+*/
+int UDPSocketClass::Receive(PacketType* packets, int count)
+{
+    if (Socket < 0 || count <= 0) {
+        return 0;
+    }
+
+    if (count > MAX_BATCH) {
+        count = MAX_BATCH;
+    }
+
+    struct sockaddr_in addrs[MAX_BATCH];
+    int received = 0;
+
+#ifdef __linux__
+    struct mmsghdr msgs[MAX_BATCH];
+    struct iovec iovs[MAX_BATCH];
+
+    for (int i = 0; i < count; ++i) {
+        iovs[i].iov_base = packets[i].Data;
+        iovs[i].iov_len = sizeof(packets[i].Data);
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    ++CallCount;
+    int rc = recvmmsg(Socket, msgs, count, MSG_DONTWAIT, nullptr);
+
+    if (rc > 0) {
+        received = rc;
+
+        for (int i = 0; i < received; ++i) {
+            packets[i].Length = (int)msgs[i].msg_len;
+        }
+    }
+#else
+    while (received < count) {
+        socklen_t len = sizeof(addrs[received]);
+        ++CallCount;
+        ssize_t rc = recvfrom(Socket,
+                              packets[received].Data,
+                              sizeof(packets[received].Data),
+                              MSG_DONTWAIT,
+                              (struct sockaddr*)&addrs[received],
+                              &len);
+
+        if (rc < 0) {
+            break;
+        }
+
+        packets[received++].Length = (int)rc;
+    }
+#endif
+
+    for (int i = 0; i < received; ++i) {
+        packets[i].Address = addrs[i].sin_addr.s_addr;
+        packets[i].Port = addrs[i].sin_port;
+    }
+
+    ReceivedCount += received;
+    return received;
+}
+
+/*
+**	Sends packets in order until the socket would block. Returns how many the caller can drop, which includes any
+**	the network refused outright, as there is no point offering those again.
+*/
+int UDPSocketClass::Send(PacketType const* packets, int count)
+{
+    if (Socket < 0) {
+        return 0;
+    }
+
+    struct sockaddr_in addrs[MAX_BATCH];
+    int done = 0;
+
+    while (done < count) {
+        int batch = count - done < MAX_BATCH ? count - done : MAX_BATCH;
+
+        for (int i = 0; i < batch; ++i) {
+            memset(&addrs[i], 0, sizeof(addrs[i]));
+            addrs[i].sin_family = AF_INET;
+            addrs[i].sin_addr.s_addr = packets[done + i].Address;
+            addrs[i].sin_port = packets[done + i].Port;
+        }
+
+#ifdef __linux__
+        struct mmsghdr msgs[MAX_BATCH];
+        struct iovec iovs[MAX_BATCH];
+
+        for (int i = 0; i < batch; ++i) {
+            iovs[i].iov_base = const_cast<unsigned char*>(packets[done + i].Data);
+            iovs[i].iov_len = packets[done + i].Length;
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_name = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        ++CallCount;
+        int rc = sendmmsg(Socket, msgs, batch, MSG_DONTWAIT);
+#else
+        int rc = 0;
+
+        while (rc < batch) {
+            ++CallCount;
+            if (sendto(Socket,
+                       packets[done + rc].Data,
+                       packets[done + rc].Length,
+                       MSG_DONTWAIT,
+                       (struct sockaddr*)&addrs[rc],
+                       sizeof(addrs[rc]))
+                < 0) {
+                rc = rc == 0 ? -1 : rc;
+                break;
+            }
+            ++rc;
+        }
+#endif
+
+        if (rc > 0) {
+            done += rc;
+            SentCount += rc;
+            continue;
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS || errno == EINTR) {
+            break;
+        }
+
+        // Unreachable or refused, drop the packet at the front and carry on with the rest.
+        ++done;
+        ++ErrorCount;
+    }
+
+    return done;
+}
+
+/*
+**	Did a packet from this address come from this socket? Broadcasts are heard by their sender too.
+*/
+bool UDPSocketClass::Is_Local(uint32_t address, uint16_t port) const
+{
+    if (port != BoundPort) {
+        return false;
+    }
+
+    for (size_t i = 0; i < LocalAddresses.size(); ++i) {
+        if (LocalAddresses[i] == address) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void UDPSocketClass::Set_Buffer_Size(int size)
+{
+    if (Socket >= 0) {
+        setsockopt(Socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        setsockopt(Socket, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    }
+}
+
+void UDPSocketClass::Find_Local_Addresses()
+{
+    struct ifaddrs* list = nullptr;
+
+    LocalAddresses.clear();
+    LocalAddresses.push_back(htonl(INADDR_LOOPBACK));
+
+    if (getifaddrs(&list) != 0) {
+        return;
+    }
+
+    for (struct ifaddrs* ifa = list; ifa != nullptr; ifa = ifa->ifa_next) {
+        if (ifa->ifa_addr != nullptr && ifa->ifa_addr->sa_family == AF_INET) {
+            LocalAddresses.push_back(((struct sockaddr_in*)ifa->ifa_addr)->sin_addr.s_addr);
+        }
+    }
+
+    freeifaddrs(list);
+}
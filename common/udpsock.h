@@ -0,0 +1,81 @@
+#ifndef UDPSOCK_H
+#define UDPSOCK_H
+
+#include <stdint.h>
+#include <vector>
+
+/*
+**	Non-blocking UDP socket for POSIX systems. Packets move in batches, one system call per batch where the
+**	platform has recvmmsg and sendmmsg. Addresses and ports are kept in network byte order, as they are on the
+**	wire, so they can be copied straight in and out of the game's address structures.
+*/
+class UDPSocketClass
+{
+public:
+    enum
+    {
+        MAX_PACKET_SIZE = 1024,
+        MAX_BATCH = 32,
+    };
+
+    struct PacketType
+    {
+        uint32_t Address;
+        uint16_t Port;
+        int Length;
+        unsigned char Data[MAX_PACKET_SIZE];
+    };
+
+    UDPSocketClass();
+    ~UDPSocketClass();
+
+    bool Open(uint16_t port, int span = 1);
+    void Close();
+    bool Wait(int timeout_ms);
+    int Receive(PacketType* packets, int count);
+    int Send(PacketType const* packets, int count);
+    bool Is_Local(uint32_t address, uint16_t port) const;
+    void Set_Buffer_Size(int size);
+
+    bool Is_Open() const
+    {
+        return Socket >= 0;
+    }
+    int Handle() const
+    {
+        return Socket;
+    }
+    uint16_t Port() const
+    {
+        return BoundPort;
+    }
+    unsigned Packets_Sent() const
+    {
+        return SentCount;
+    }
+    unsigned Packets_Received() const
+    {
+        return ReceivedCount;
+    }
+    unsigned Send_Errors() const
+    {
+        return ErrorCount;
+    }
+    unsigned System_Calls() const
+    {
+        return CallCount;
+    }
+
+private:
+    void Find_Local_Addresses();
+
+    int Socket;
+    uint16_t BoundPort;                   // Network order.
+    std::vector<uint32_t> LocalAddresses; // Every IPv4 address of this host, network order.
+    unsigned SentCount;
+    unsigned ReceivedCount;
+    unsigned ErrorCount;
+    unsigned CallCount;
+};
+
+#endif /* UDPSOCK_H */
@@ -10,13 +10,19 @@
 // GNU General Public License along with permitted additional restrictions
 // with this program. If not, see https://github.com/electronicarts/CnC_Remastered_Collection
 #include "unvqbuff.h"
+#include <string.h>
 
-void UnVQ_4x2(uint8_t* codebook,
-              uint8_t* pointers,
-              uint8_t* buffer,
-              unsigned blocks_per_row,
-              unsigned num_rows,
-              unsigned buff_width)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UNVQ_SSE2
+#endif
+
+void UnVQ_4x2_Scalar(uint8_t* codebook,
+                     uint8_t* pointers,
+                     uint8_t* buffer,
+                     unsigned blocks_per_row,
+                     unsigned num_rows,
+                     unsigned buff_width)
 {
     uint32_t* cb_offset = (uint32_t*)codebook;
     uint32_t blocks_per_row_left = 0;
@@ -62,12 +68,12 @@ void UnVQ_4x2(uint8_t* codebook,
     }
 }
 
-void UnVQ_4x4(uint8_t* codebook,
-              uint8_t* pointers,
-              uint8_t* buffer,
-              unsigned blocks_per_row,
-              unsigned num_rows,
-              unsigned buff_width)
+void UnVQ_4x4_Scalar(uint8_t* codebook,
+                     uint8_t* pointers,
+                     uint8_t* buffer,
+                     unsigned blocks_per_row,
+                     unsigned num_rows,
+                     unsigned buff_width)
 {
     uint32_t* cb_offset = (uint32_t*)codebook;
     uint32_t blocks_per_row_left = 0;
@@ -117,6 +123,178 @@ void UnVQ_4x4(uint8_t* codebook,
     }
 }
 
+#ifdef UNVQ_SSE2
+// Number of blocks expanded per vector step.
+#define UNVQ_LANES 8
+
+// Codebook indices of eight blocks, with solid blocks masked to entry 0 so the gather stays inside the codebook.
+static inline void UnVQ_Indices(uint8_t const* lo,
+                                uint8_t const* hi,
+                                uint8_t marker,
+                                uint16_t* index,
+                                __m128i* solid,
+                                __m128i* lo16)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i hi16 = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const*)hi), zero);
+    *lo16 = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const*)lo), zero);
+    *solid = _mm_cmpeq_epi16(hi16, _mm_set1_epi16(marker));
+    _mm_storeu_si128((__m128i*)index, _mm_andnot_si128(*solid, _mm_or_si128(*lo16, _mm_slli_epi16(hi16, 8))));
+}
+
+// Widens four 16 bit lanes of solid mask and colour index to the 32 bit fill pattern of each block.
+static inline void UnVQ_Solid(__m128i mask16, __m128i lo16, __m128i* mask, __m128i* fill)
+{
+    __m128i color = _mm_unpacklo_epi16(lo16, _mm_setzero_si128());
+    color = _mm_or_si128(color, _mm_slli_epi32(color, 8));
+    *fill = _mm_or_si128(color, _mm_slli_epi32(color, 16));
+    *mask = _mm_unpacklo_epi16(mask16, mask16);
+}
+
+static inline __m128i UnVQ_Blend(__m128i mask, __m128i fill, __m128i row)
+{
+    return _mm_or_si128(_mm_and_si128(mask, fill), _mm_andnot_si128(mask, row));
+}
+#endif
+
+void UnVQ_4x2(uint8_t* codebook,
+              uint8_t* pointers,
+              uint8_t* buffer,
+              unsigned blocks_per_row,
+              unsigned num_rows,
+              unsigned buff_width)
+{
+#ifdef UNVQ_SSE2
+    unsigned num_blocks = blocks_per_row * num_rows;
+
+    for (unsigned row = 0; row < num_rows; ++row) {
+        uint8_t const* lo = &pointers[row * blocks_per_row];
+        uint8_t const* hi = lo + num_blocks;
+        uint8_t* dst = &buffer[row * 2 * buff_width];
+        unsigned block = 0;
+
+        for (; block + UNVQ_LANES <= blocks_per_row; block += UNVQ_LANES) {
+            uint16_t index[UNVQ_LANES];
+            __m128i solid;
+            __m128i lo16;
+            UnVQ_Indices(&lo[block], &hi[block], 15, index, &solid, &lo16);
+
+            for (int half = 0; half < 2; ++half) {
+                int i = half * 4;
+
+                // Gather four 8 byte entries as (row 0, row 1) pairs, then split them into the two output rows.
+                __m128i e01 = _mm_unpacklo_epi64(_mm_loadl_epi64((__m128i const*)&codebook[8 * index[i + 0]]),
+                                                 _mm_loadl_epi64((__m128i const*)&codebook[8 * index[i + 1]]));
+                __m128i e23 = _mm_unpacklo_epi64(_mm_loadl_epi64((__m128i const*)&codebook[8 * index[i + 2]]),
+                                                 _mm_loadl_epi64((__m128i const*)&codebook[8 * index[i + 3]]));
+                e01 = _mm_shuffle_epi32(e01, _MM_SHUFFLE(3, 1, 2, 0));
+                e23 = _mm_shuffle_epi32(e23, _MM_SHUFFLE(3, 1, 2, 0));
+
+                if (half) {
+                    solid = _mm_srli_si128(solid, 8);
+                    lo16 = _mm_srli_si128(lo16, 8);
+                }
+
+                __m128i mask;
+                __m128i fill;
+                UnVQ_Solid(solid, lo16, &mask, &fill);
+
+                uint8_t* out = &dst[(block + i) * 4];
+                _mm_storeu_si128((__m128i*)out, UnVQ_Blend(mask, fill, _mm_unpacklo_epi64(e01, e23)));
+                _mm_storeu_si128((__m128i*)&out[buff_width], UnVQ_Blend(mask, fill, _mm_unpackhi_epi64(e01, e23)));
+            }
+        }
+
+        // Expand whatever is left of the row a block at a time.
+        for (; block < blocks_per_row; ++block) {
+            uint32_t rows[2];
+
+            if (hi[block] == 15) {
+                rows[0] = rows[1] = lo[block] * 0x01010101u;
+            } else {
+                memcpy(rows, &codebook[8 * (lo[block] | (hi[block] << 8))], sizeof(rows));
+            }
+
+            memcpy(&dst[block * 4], &rows[0], 4);
+            memcpy(&dst[block * 4 + buff_width], &rows[1], 4);
+        }
+    }
+#else
+    UnVQ_4x2_Scalar(codebook, pointers, buffer, blocks_per_row, num_rows, buff_width);
+#endif
+}
+
+void UnVQ_4x4(uint8_t* codebook,
+              uint8_t* pointers,
+              uint8_t* buffer,
+              unsigned blocks_per_row,
+              unsigned num_rows,
+              unsigned buff_width)
+{
+#ifdef UNVQ_SSE2
+    unsigned num_blocks = blocks_per_row * num_rows;
+
+    for (unsigned row = 0; row < num_rows; ++row) {
+        uint8_t const* lo = &pointers[row * blocks_per_row];
+        uint8_t const* hi = lo + num_blocks;
+        uint8_t* dst = &buffer[row * 4 * buff_width];
+        unsigned block = 0;
+
+        for (; block + UNVQ_LANES <= blocks_per_row; block += UNVQ_LANES) {
+            uint16_t index[UNVQ_LANES];
+            __m128i solid;
+            __m128i lo16;
+            UnVQ_Indices(&lo[block], &hi[block], 255, index, &solid, &lo16);
+
+            for (int half = 0; half < 2; ++half) {
+                int i = half * 4;
+
+                // Gather four 16 byte entries, one block per register, and transpose them into output rows.
+                __m128i e0 = _mm_loadu_si128((__m128i const*)&codebook[16 * index[i + 0]]);
+                __m128i e1 = _mm_loadu_si128((__m128i const*)&codebook[16 * index[i + 1]]);
+                __m128i e2 = _mm_loadu_si128((__m128i const*)&codebook[16 * index[i + 2]]);
+                __m128i e3 = _mm_loadu_si128((__m128i const*)&codebook[16 * index[i + 3]]);
+                __m128i t0 = _mm_unpacklo_epi32(e0, e1);
+                __m128i t1 = _mm_unpacklo_epi32(e2, e3);
+                __m128i t2 = _mm_unpackhi_epi32(e0, e1);
+                __m128i t3 = _mm_unpackhi_epi32(e2, e3);
+
+                if (half) {
+                    solid = _mm_srli_si128(solid, 8);
+                    lo16 = _mm_srli_si128(lo16, 8);
+                }
+
+                __m128i mask;
+                __m128i fill;
+                UnVQ_Solid(solid, lo16, &mask, &fill);
+
+                uint8_t* out = &dst[(block + i) * 4];
+                _mm_storeu_si128((__m128i*)out, UnVQ_Blend(mask, fill, _mm_unpacklo_epi64(t0, t1)));
+                _mm_storeu_si128((__m128i*)&out[buff_width], UnVQ_Blend(mask, fill, _mm_unpackhi_epi64(t0, t1)));
+                _mm_storeu_si128((__m128i*)&out[2 * buff_width], UnVQ_Blend(mask, fill, _mm_unpacklo_epi64(t2, t3)));
+                _mm_storeu_si128((__m128i*)&out[3 * buff_width], UnVQ_Blend(mask, fill, _mm_unpackhi_epi64(t2, t3)));
+            }
+        }
+
+        for (; block < blocks_per_row; ++block) {
+            uint32_t rows[4];
+
+            if (hi[block] == 255) {
+                rows[0] = rows[1] = rows[2] = rows[3] = lo[block] * 0x01010101u;
+            } else {
+                memcpy(rows, &codebook[16 * (lo[block] | (hi[block] << 8))], sizeof(rows));
+            }
+
+            for (int y = 0; y < 4; ++y) {
+                memcpy(&dst[block * 4 + y * buff_width], &rows[y], 4);
+            }
+        }
+    }
+#else
+    UnVQ_4x4_Scalar(codebook, pointers, buffer, blocks_per_row, num_rows, buff_width);
+#endif
+}
+
 void UnVQ_Nop(uint8_t* codebook,
               uint8_t* pointers,
               uint8_t* buffer,
@@ -26,6 +26,20 @@ void UnVQ_4x4(uint8_t* codebook,
               unsigned blocks_per_row,
               unsigned num_rows,
               unsigned buff_width);
+
+// Block at a time versions the vector expanders above fall back to when SSE2 isn't available.
+void UnVQ_4x2_Scalar(uint8_t* codebook,
+                     uint8_t* pointers,
+                     uint8_t* buffer,
+                     unsigned blocks_per_row,
+                     unsigned num_rows,
+                     unsigned buff_width);
+void UnVQ_4x4_Scalar(uint8_t* codebook,
+                     uint8_t* pointers,
+                     uint8_t* buffer,
+                     unsigned blocks_per_row,
+                     unsigned num_rows,
+                     unsigned buff_width);
 void UnVQ_Nop(uint8_t* codebook,
               uint8_t* pointers,
               uint8_t* buffer,
@@ -109,6 +109,7 @@ void VQA_PauseAudio();
 void VQA_ResumeAudio();
 
 int VQA_CopyAudio(VQAHandle* handle);
+void VQA_QueueAudio(VQAHandle* handle); // Feeds the device from the playing thread while the loader runs apart.
 
 void VQA_SetTimer(VQAHandle* handle, int time, int method);
 unsigned VQA_GetTime(VQAHandle* handle);
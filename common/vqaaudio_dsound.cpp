@@ -481,6 +481,11 @@ int VQA_CopyAudio(VQAHandle* handle)
     return 0;
 }
 
+// The multimedia timer feeds the sound buffer, so there is nothing to do here.
+void VQA_QueueAudio(VQAHandle* handle)
+{
+}
+
 void VQA_SetTimer(VQAHandle* handle, int time, int method)
 {
     if (method == -1) {
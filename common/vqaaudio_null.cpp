@@ -61,6 +61,10 @@ int VQA_CopyAudio(VQAHandle* handle)
     return 0;
 }
 
+void VQA_QueueAudio(VQAHandle* handle)
+{
+}
+
 void VQA_SetTimer(VQAHandle* handle, int time, int method)
 {
     timer.Set(0);
@@ -18,6 +18,7 @@
 #include <alc.h>
 #include <algorithm>
 #include <chrono>
+#include <mutex>
 
 int AudioFlags;
 int TimerIntCount;
@@ -34,6 +35,12 @@ VQAHandle* AudioVQAHandle;
 #define TIMER_RESOLUTION  1
 #define TARGET_RESOLUTION 10 // 10-millisecond target resolution
 
+/*
+**	Guards the audio ring while VQA_Play loads frames on another thread. The loader fills the ring in
+**	VQA_CopyAudio and the playing thread drains it into OpenAL in VQA_QueueAudio.
+*/
+static std::mutex AudioBufferLock;
+
 static ALenum Get_OpenAL_Format(int bits, int channels)
 {
     switch (bits) {
@@ -275,8 +282,12 @@ int VQA_StartAudio(VQAHandle* handle)
     audio->field_B0 = 0;
     audio->field_B4 = 0;
 
-    for (unsigned i = 0; i < OPENAL_BUFFER_COUNT; ++i) {
-        Queue_Audio(audio->AudioBuffers[i]);
+    {
+        std::lock_guard<std::mutex> lock(AudioBufferLock);
+
+        for (unsigned i = 0; i < OPENAL_BUFFER_COUNT; ++i) {
+            Queue_Audio(audio->AudioBuffers[i]);
+        }
     }
 
     alSourcef(audio->OpenALSource, AL_GAIN, config->Volume / 256.0f);
@@ -360,7 +371,14 @@ int VQA_CopyAudio(VQAHandle* handle)
     VQAData* data = handle->VQABuf;
     VQAAudio* audio = &data->Audio;
 
-    VQA_AudioCallback();
+    std::lock_guard<std::mutex> lock(AudioBufferLock);
+
+    /*
+    **	On the loader thread, leave the OpenAL queue and the draw flags to the thread that plays.
+    */
+    if (data->Prefetch == nullptr) {
+        VQA_AudioCallback();
+    }
 
     if (config->OptionFlags & 1) {
         if (audio->Buffer != nullptr) {
@@ -407,6 +425,12 @@ int VQA_CopyAudio(VQAHandle* handle)
     return 0;
 }
 
+void VQA_QueueAudio(VQAHandle* handle)
+{
+    std::lock_guard<std::mutex> lock(AudioBufferLock);
+    VQA_AudioCallback();
+}
+
 void VQA_SetTimer(VQAHandle* handle, int time, int method)
 {
     if (method == -1) {
@@ -38,6 +38,8 @@ enum VQAOptionEnum
     VQAOPTF_CAPTIONS = 1 << 7,
     VQAOPTF_EVA = 1 << 8,
     VQA_OPTION_512 = 1 << 9,
+    VQAOPTF_PREFETCH = 1 << 10,  // Load frames on a worker thread during VQA_Play. Off by default.
+    VQAOPTF_SEEKINDEX = 1 << 11, // Index every frame on open so VQA_SeekFrame can go straight to it.
 };
 
 enum VQALanguageType
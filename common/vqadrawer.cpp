@@ -252,9 +252,21 @@ int VQA_SelectFrame(VQAHandle* handle)
 
     if (!(curframe->Flags & 1)) {
         ++vqabuf->Drawer.WaitsOnLoader;
+
+        /*
+        **	Count each stall once, and only when the next frame is already due.
+        */
+        if (!vqabuf->Drawer.IsStarved && !(vqabuf->Flags & VQA_DATA_FLAG_VIDEO_MEMORY_SET)
+            && (int)(handle->Config.DrawRate * VQA_GetTime(handle) / 60) > vqabuf->Drawer.LastFrame) {
+            vqabuf->Drawer.IsStarved = 1;
+            ++vqabuf->Drawer.Underruns;
+        }
+
         return VQAERR_NOBUFFER;
     }
 
+    vqabuf->Drawer.IsStarved = 0;
+
     if (handle->Config.OptionFlags & 2) {
         vqabuf->Drawer.LastFrame = curframe->FrameNum;
         return VQAERR_NONE;
@@ -56,6 +56,8 @@ typedef struct
     int NumSkipped;
     int WaitsOnFlipper;
     int WaitsOnLoader;
+    int Underruns; // Frames that were due before the loader had them ready.
+    int IsStarved; // Waiting on the loader for a frame that is already due.
 } VQADrawer;
 
 uint8_t* VQA_GetPalette(VQAHandle* handle);
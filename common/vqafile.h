@@ -15,6 +15,7 @@
 #include "vqaaudio.h"
 #include "vqaconfig.h"
 #include "vqadrawer.h"
+#include <atomic>
 
 typedef struct _CaptionInfo CaptionInfo;
 
@@ -99,7 +100,7 @@ typedef struct _VQAFrameNode
     VQACBNode* Codebook;
     uint8_t* Palette;
     struct _VQAFrameNode* Next;
-    unsigned Flags;
+    std::atomic<unsigned> Flags; // FRAMENODE_FRAME_LOADED hands the node between loader and drawer threads.
     int FrameNum;
     int PtrOffset;
     int PalOffset;
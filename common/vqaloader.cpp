@@ -15,9 +15,13 @@
 #include "file.h"
 #include "endianness.h"
 #include "lcw.h"
+#include "memflag.h"
 #include "misc.h"
 #include "vqacaption.h"
 #include "vqaconfig.h"
+#include "vqapalette.h"
+#include "vqatask.h"
+#include <new>
 #include <stdlib.h>
 #include <string.h>
 
@@ -515,6 +519,207 @@ int VQA_Load_VQF(VQAHandle* handle, unsigned frame_iffsize)
     return VQAERR_NONE;
 }
 
+enum
+{
+    VQA_WALK_CODEBOOK = 1,
+    VQA_WALK_PALETTE = 2,
+};
+
+/*
+**	Codebook and palette state tracked while indexing a movie, mirroring what VQA_LoadFrame does with the same chunks.
+*/
+typedef struct _VQASeekScan
+{
+    int Frame;
+    int CBFrame;
+    int PartialFrame;
+    int NumPartialCB;
+    int PalFrame;
+} VQASeekScan;
+
+/*
+**	Walks the chunks of the frame at the stream position and stops after the chunk that completes it, as
+**	VQA_LoadFrame does. Codebook and palette chunks are loaded when asked for and noted in the scan state when one
+**	is given, everything else is skipped.
+*/
+static int VQA_WalkFrame(VQAHandle* handle, unsigned* pos, int load, VQASeekScan* scan)
+{
+    VQAData* data = handle->VQABuf;
+    VQADrawer* drawer = &data->Drawer;
+    VQAFrameNode* curframe = data->Loader.CurFrame;
+    VQAChunkHeader chunk;
+    unsigned frame_end = 0;
+
+    while (frame_end == 0 || *pos < frame_end) {
+        if (handle->StreamHandler(handle, VQACMD_READ, &chunk, sizeof(chunk))) {
+            return VQAERR_READ;
+        }
+
+        unsigned iffsize = be32toh(chunk.Size);
+        unsigned padsize = (iffsize + 1) & (~1);
+        bool last = false;
+        bool loaded = false;
+        int rc = VQAERR_NONE;
+
+        *pos += sizeof(chunk);
+
+        switch (chunk.ID) {
+        case CHUNK_VQFR:
+        case CHUNK_VQFK:
+        case CHUNK_VQFL:
+
+            // Step into the frame chunk, the frame is complete at its end.
+            if (frame_end == 0) {
+                frame_end = *pos + padsize;
+                continue;
+            }
+
+            break;
+
+        case CHUNK_VPT0:
+        case CHUNK_VPTZ:
+        case CHUNK_VPTD:
+        case CHUNK_VPTK:
+        case CHUNK_VPTR:
+        case CHUNK_VPRZ:
+
+            last = frame_end == 0;
+            break;
+
+        case CHUNK_CBF0:
+        case CHUNK_CBFZ:
+
+            if (scan != nullptr) {
+                scan->CBFrame = scan->Frame;
+                scan->PartialFrame = -1;
+                scan->NumPartialCB = 0;
+            }
+
+            if (load & VQA_WALK_CODEBOOK) {
+                rc = chunk.ID == CHUNK_CBF0 ? VQA_Load_CBF0(handle, iffsize) : VQA_Load_CBFZ(handle, iffsize);
+                loaded = true;
+            }
+
+            break;
+
+        case CHUNK_CBP0:
+        case CHUNK_CBPZ:
+
+            if (scan != nullptr) {
+                if (scan->NumPartialCB++ == 0) {
+                    scan->PartialFrame = scan->Frame;
+                }
+
+                if (scan->NumPartialCB == handle->Header.Groupsize) {
+                    scan->CBFrame = scan->PartialFrame;
+                    scan->PartialFrame = -1;
+                    scan->NumPartialCB = 0;
+                }
+            }
+
+            if (load & VQA_WALK_CODEBOOK) {
+                rc = chunk.ID == CHUNK_CBP0 ? VQA_Load_CBP0(handle, iffsize) : VQA_Load_CBPZ(handle, iffsize);
+                loaded = true;
+            }
+
+            break;
+
+        case CHUNK_CPL0:
+        case CHUNK_CPLZ:
+
+            if (scan != nullptr) {
+                scan->PalFrame = scan->Frame;
+            }
+
+            if (load & VQA_WALK_PALETTE) {
+                loaded = true;
+
+                if (chunk.ID == CHUNK_CPL0) {
+                    rc = VQA_Load_CPL0(handle, iffsize);
+
+                    if (rc == VQAERR_NONE) {
+                        drawer->CurPalSize = curframe->PaletteSize < (int)sizeof(drawer->Palette)
+                                                 ? curframe->PaletteSize
+                                                 : (int)sizeof(drawer->Palette);
+                        memcpy(drawer->Palette, curframe->Palette, drawer->CurPalSize);
+                    }
+                } else {
+                    rc = VQA_Load_CPLZ(handle, iffsize);
+
+                    if (rc == VQAERR_NONE) {
+                        drawer->CurPalSize = LCW_Uncompress(
+                            (curframe->PalOffset + curframe->Palette), drawer->Palette, sizeof(drawer->Palette));
+                    }
+                }
+            }
+
+            break;
+
+        default:
+            break;
+        }
+
+        if (rc != VQAERR_NONE) {
+            return VQAERR_READ;
+        }
+
+        if (!loaded && handle->StreamHandler(handle, VQACMD_SEEK, (void*)SEEK_CUR, padsize)) {
+            return VQAERR_SEEK;
+        }
+
+        *pos += padsize;
+
+        if (last) {
+            break;
+        }
+    }
+
+    return VQAERR_NONE;
+}
+
+/*
+**	Scans every frame from the given file offset, recording where each starts and what has to be replayed to pick
+**	up the codebook and palette in effect there. The stream is returned to the start offset afterwards. A movie that
+**	can't be indexed is left without an index and seeks the old way.
+*/
+static int VQA_BuildSeekIndex(VQAHandle* handle, unsigned start)
+{
+    VQAData* data = handle->VQABuf;
+    VQASeekScan scan = {0, -1, -1, 0, -1};
+    unsigned pos = start;
+    VQASeekEntry* index = (VQASeekEntry*)malloc(handle->Header.Frames * sizeof(VQASeekEntry));
+
+    if (index == nullptr) {
+        return VQAERR_NOMEM;
+    }
+
+    for (scan.Frame = 0; scan.Frame < handle->Header.Frames; ++scan.Frame) {
+        VQASeekEntry* entry = &index[scan.Frame];
+        entry->Offset = pos;
+        entry->CBFrame = scan.CBFrame >= 0 ? scan.CBFrame : scan.PartialFrame;
+        entry->PalFrame = scan.PalFrame;
+
+        if (VQA_WalkFrame(handle, &pos, 0, &scan) != VQAERR_NONE) {
+            free(index);
+            index = nullptr;
+            break;
+        }
+    }
+
+    if (handle->StreamHandler(handle, VQACMD_SEEK, nullptr, start)) {
+        free(index);
+        return VQAERR_SEEK;
+    }
+
+    if (index != nullptr) {
+        data->SeekIndex = index;
+        data->MemUsed += handle->Header.Frames * sizeof(VQASeekEntry);
+        Memory_Tag_Add(MEM_TAG_VQA, handle->Header.Frames * sizeof(VQASeekEntry));
+    }
+
+    return VQAERR_NONE;
+}
+
 int VQA_Open(VQAHandle* handle, const char* filename, VQAConfig* config)
 {
     VQAHeader* header = &handle->Header;
@@ -552,6 +757,10 @@ int VQA_Open(VQAHandle* handle, const char* filename, VQAConfig* config)
 
     bool frame_info_found = false;
 
+    // File offset tracked for the seek index, given up on around chunks that aren't read whole.
+    unsigned pos = sizeof(chunk) + sizeof(chunk.ID);
+    bool pos_known = true;
+
     while (!frame_info_found) {
         if (handle->StreamHandler(handle, VQACMD_READ, &chunk, sizeof(chunk))) {
             VQA_Close(handle);
@@ -559,6 +768,7 @@ int VQA_Open(VQAHandle* handle, const char* filename, VQAConfig* config)
         }
 
         int chunk_size = be32toh(chunk.Size);
+        pos += sizeof(chunk);
 
         switch (chunk.ID) {
         case CHUNK_VQHD:
@@ -573,6 +783,8 @@ int VQA_Open(VQAHandle* handle, const char* filename, VQAConfig* config)
                 return VQAERR_READ;
             }
 
+            pos += sizeof(*header);
+
             // in LOLG VQAs Groupsize is 0 because it only has one codebook chunk so forcing it to common default here,
             // allows LOLG VQAs to be played
             if (header->Groupsize == 0) {
@@ -610,10 +822,14 @@ int VQA_Open(VQAHandle* handle, const char* filename, VQAConfig* config)
                 return VQAERR_NOMEM;
             }
 
+            // The buffers come from malloc, so they're accounted here as one block.
+            Memory_Tag_Add(MEM_TAG_VQA, handle->VQABuf->MemUsed);
+
             break;
 
         // TODO: Needs confirming with a 'Poly VQA file.
         case CHUNK_NAME: {
+            pos_known = false;
 
             if (handle->StreamHandler(handle, VQACMD_READ, &chunk, sizeof(VQAChunkHeader))) {
                 VQA_Close(handle);
@@ -631,6 +847,7 @@ int VQA_Open(VQAHandle* handle, const char* filename, VQAConfig* config)
             break;
         }
         case CHUNK_EVA0:
+            pos_known = false;
 
             if (config->EVAFont && config->OptionFlags & VQAOPTF_CAPTIONS) {
                 // TODO
@@ -639,6 +856,7 @@ int VQA_Open(VQAHandle* handle, const char* filename, VQAConfig* config)
             break;
 
         case CHUNK_CAP0:
+            pos_known = false;
 
             if (config->CapFont && config->OptionFlags & VQAOPTF_AUDIO) {
                 short v78 = 0;
@@ -668,6 +886,7 @@ int VQA_Open(VQAHandle* handle, const char* filename, VQAConfig* config)
                 VQA_Close(handle);
                 return VQAERR_READ;
             }
+            pos += (chunk_size + 1) & ~1;
             frame_info_found = true;
             break;
 
@@ -678,6 +897,8 @@ int VQA_Open(VQAHandle* handle, const char* filename, VQAConfig* config)
                 return VQAERR_SEEK;
             }
 
+            pos += (chunk_size + 1) & ~1;
+
             break;
         };
     }
@@ -685,7 +906,7 @@ int VQA_Open(VQAHandle* handle, const char* filename, VQAConfig* config)
     if (frame_info_found) {
 
         if (!(header->Flags & 1)) {
-            handle->Config.OptionFlags &= VQAOPTF_AUDIO;
+            handle->Config.OptionFlags &= ~VQAOPTF_AUDIO;
         }
 
         if (handle->Config.OptionFlags & VQAOPTF_AUDIO) {
@@ -722,6 +943,13 @@ int VQA_Open(VQAHandle* handle, const char* filename, VQAConfig* config)
             }
         }
 
+        if ((handle->Config.OptionFlags & VQAOPTF_SEEKINDEX) && pos_known) {
+            if (VQA_BuildSeekIndex(handle, pos) == VQAERR_SEEK) {
+                VQA_Close(handle);
+                return VQAERR_SEEK;
+            }
+        }
+
         if (VQA_PrimeBuffers(handle)) {
             VQA_Close(handle);
             return VQAERR_READ;
@@ -740,6 +968,12 @@ void VQA_Close(VQAHandle* handle)
     }
 
     if (handle->VQABuf) {
+        long seek_size = handle->VQABuf->SeekIndex != nullptr ? handle->Header.Frames * sizeof(VQASeekEntry) : 0;
+
+        if (seek_size != 0) {
+            Memory_Tag_Add(MEM_TAG_VQA, -seek_size);
+        }
+        Memory_Tag_Add(MEM_TAG_VQA, seek_size - handle->VQABuf->MemUsed);
         VQA_FreeBuffers(handle->VQABuf, &handle->Config, &handle->Header);
     }
 
@@ -958,7 +1192,7 @@ int VQA_LoadFrame(VQAHandle* handle)
                     return VQAERR_SLEEPING;
                 }
 
-                handle->VQABuf->Flags &= 0xFB;
+                handle->VQABuf->Flags &= ~4u;
                 if (VQA_Load_SND0(handle, iffsize)) {
                     return VQAERR_READ;
                 }
@@ -974,7 +1208,7 @@ int VQA_LoadFrame(VQAHandle* handle)
                     return VQAERR_SLEEPING;
                 }
 
-                handle->VQABuf->Flags &= 0xFB;
+                handle->VQABuf->Flags &= ~4u;
 
                 if (VQA_Load_SND0(handle, iffsize)) {
                     return VQAERR_READ;
@@ -1000,7 +1234,7 @@ int VQA_LoadFrame(VQAHandle* handle)
                     return VQAERR_SLEEPING;
                 }
 
-                handle->VQABuf->Flags &= 0xFB;
+                handle->VQABuf->Flags &= ~4u;
 
                 if (VQA_Load_SND1(handle, iffsize)) {
                     return VQAERR_READ;
@@ -1017,7 +1251,7 @@ int VQA_LoadFrame(VQAHandle* handle)
                     return VQAERR_SLEEPING;
                 }
 
-                handle->VQABuf->Flags &= 0xFB;
+                handle->VQABuf->Flags &= ~4u;
 
                 if (VQA_Load_SND1(handle, iffsize)) {
                     return VQAERR_READ;
@@ -1042,7 +1276,7 @@ int VQA_LoadFrame(VQAHandle* handle)
                     return VQAERR_SLEEPING;
                 }
 
-                handle->VQABuf->Flags &= 0xFB;
+                handle->VQABuf->Flags &= ~4u;
 
                 if (VQA_Load_SND2(handle, iffsize)) {
                     return VQAERR_READ;
@@ -1059,7 +1293,7 @@ int VQA_LoadFrame(VQAHandle* handle)
                     return VQAERR_SLEEPING;
                 }
 
-                handle->VQABuf->Flags &= 0xFB;
+                handle->VQABuf->Flags &= ~4u;
 
                 if (VQA_Load_SND2(handle, iffsize)) {
                     return VQAERR_READ;
@@ -1095,6 +1329,76 @@ int VQA_LoadFrame(VQAHandle* handle)
     return VQAERR_NONE;
 }
 
+/*
+**	Seeks using the index built on open. Only the codebook chunks since the last complete codebook and the last
+**	palette before the target are read, rather than decoding forward from the start of a group.
+*/
+static int VQA_SeekIndexed(VQAHandle* handle, int framenum)
+{
+    VQAData* data = handle->VQABuf;
+    VQALoader* loader = &data->Loader;
+    VQASeekEntry* entry = &data->SeekIndex[framenum];
+    unsigned pos = 0;
+    bool pos_known = false;
+
+    loader->NumPartialCB = 0;
+    loader->PartialCBSize = 0;
+    loader->FullCB = data->CBData;
+    loader->CurCB = data->CBData;
+
+    for (VQAFrameNode* frame = loader->CurFrame->Next; frame != loader->CurFrame; frame = frame->Next) {
+        frame->Flags = 0;
+    }
+
+    loader->CurFrame->Flags = 0;
+
+    // Codebook chunks take effect from the frame after the one carrying them, so stop short of the target.
+    for (int i = entry->CBFrame; i >= 0 && i < framenum; ++i) {
+        if (!pos_known || pos != data->SeekIndex[i].Offset) {
+            pos = data->SeekIndex[i].Offset;
+            pos_known = true;
+
+            if (handle->StreamHandler(handle, VQACMD_SEEK, nullptr, pos)) {
+                return VQAERR_SEEK;
+            }
+        }
+
+        if (VQA_WalkFrame(handle, &pos, VQA_WALK_CODEBOOK, nullptr) != VQAERR_NONE) {
+            return VQAERR_ERROR;
+        }
+    }
+
+    if (entry->PalFrame >= 0) {
+        pos = data->SeekIndex[entry->PalFrame].Offset;
+
+        if (handle->StreamHandler(handle, VQACMD_SEEK, nullptr, pos)) {
+            return VQAERR_SEEK;
+        }
+
+        if (VQA_WalkFrame(handle, &pos, VQA_WALK_PALETTE, nullptr) != VQAERR_NONE) {
+            return VQAERR_ERROR;
+        }
+
+        loader->CurFrame->Flags = 0;
+        VQA_Flag_To_Set_Palette(data->Drawer.Palette,
+                                data->Drawer.CurPalSize,
+                                (handle->Config.OptionFlags & VQAOPTF_SLOWPAL) != 0);
+    }
+
+    if (handle->StreamHandler(handle, VQACMD_SEEK, nullptr, entry->Offset)) {
+        return VQAERR_SEEK;
+    }
+
+    loader->CurFrameNum = framenum;
+
+    return VQAERR_NONE;
+}
+
+/*
+**	Positions the movie so the next frame loaded is framenum. Uses the seek index when the movie was opened with
+**	VQAOPTF_SEEKINDEX, otherwise decodes forward from the group start recorded in the FINF chunk. Must not be called
+**	while VQA_Play is running.
+*/
 int VQA_SeekFrame(VQAHandle* handle, int framenum, int fromwhere)
 {
     VQAErrorType rc = VQAERR_ERROR;
@@ -1105,55 +1409,69 @@ int VQA_SeekFrame(VQAHandle* handle, int framenum, int fromwhere)
         VQA_StopAudio(handle);
     }
 
-    if (handle->Header.Frames <= framenum) {
+    if (framenum < 0 || handle->Header.Frames <= framenum) {
         return rc;
     }
 
-    if (!data->Foff) {
-        return rc;
-    }
+    if (data->SeekIndex != nullptr) {
+        rc = (VQAErrorType)VQA_SeekIndexed(handle, framenum);
 
-    int group = framenum / handle->Header.Groupsize * handle->Header.Groupsize;
+        if (rc) {
+            return rc;
+        }
+    } else {
+        if (!data->Foff) {
+            return rc;
+        }
 
-    if (group >= handle->Header.Groupsize) {
-        group -= handle->Header.Groupsize;
-    }
+        int group = framenum / handle->Header.Groupsize * handle->Header.Groupsize;
 
-    if (handle->StreamHandler(handle, VQACMD_SEEK, nullptr, 2 * ((data->Foff[group]) & 0xFFFFFFF))) {
-        return VQAERR_SEEK;
-    }
+        if (group >= handle->Header.Groupsize) {
+            group -= handle->Header.Groupsize;
+        }
 
-    data->Loader.NumPartialCB = 0;
-    data->Loader.PartialCBSize = 0;
-    data->Loader.FullCB = data->CBData;
-    data->Loader.CurCB = data->CBData;
-    data->Loader.CurFrameNum = group;
+        if (handle->StreamHandler(handle, VQACMD_SEEK, nullptr, 2 * ((data->Foff[group]) & 0xFFFFFFF))) {
+            return VQAERR_SEEK;
+        }
 
-    for (int i = 0; i < framenum - group; ++i) {
-        data->Loader.CurFrame->Flags = 0;
-        rc = (VQAErrorType)VQA_LoadFrame(handle);
+        data->Loader.NumPartialCB = 0;
+        data->Loader.PartialCBSize = 0;
+        data->Loader.FullCB = data->CBData;
+        data->Loader.CurCB = data->CBData;
+        data->Loader.CurFrameNum = group;
+        rc = VQAERR_NONE;
+
+        for (int i = 0; i < framenum - group; ++i) {
+            data->Loader.CurFrame->Flags = 0;
+            rc = (VQAErrorType)VQA_LoadFrame(handle);
+
+            if (rc) {
+                if (rc != VQAERR_NOBUFFER && rc != VQAERR_SLEEPING) {
+                    rc = VQAERR_ERROR;
+                    break;
+                }
 
-        if (rc) {
-            if (rc != VQAERR_NOBUFFER && rc != VQAERR_SLEEPING) {
-                rc = VQAERR_ERROR;
-                break;
+                rc = VQAERR_NONE;
             }
-
-            rc = VQAERR_NONE;
         }
-    }
 
-    if (rc) {
-        return rc;
-    }
+        if (rc) {
+            return rc;
+        }
 
-    data->Loader.CurFrame->Flags = 0;
+        data->Loader.CurFrame->Flags = 0;
 
-    for (VQAFrameNode* frame = data->Loader.CurFrame->Next; frame != data->Loader.CurFrame; frame = frame->Next) {
-        frame->Flags = 0;
+        for (VQAFrameNode* frame = data->Loader.CurFrame->Next; frame != data->Loader.CurFrame;
+             frame = frame->Next) {
+            frame->Flags = 0;
+        }
     }
 
     data->Drawer.CurFrame = data->Loader.CurFrame;
+    data->Drawer.LastFrame = framenum - 1;
+    VQAMovieDone = false;
+    data->Flags &= ~(VQA_DATA_FLAG_REPEAT_SAME_TAG | VQA_DATA_FLAG_2 | VQA_DATA_FLAG_4 | VQA_DATA_FLAG_8
+                     | VQA_DATA_FLAG_VIDEO_MEMORY_SET);
 
     if (VQA_PrimeBuffers(handle)) {
         rc = VQAERR_ERROR;
@@ -1161,6 +1479,12 @@ int VQA_SeekFrame(VQAHandle* handle, int framenum, int fromwhere)
         rc = (VQAErrorType)framenum;
     }
 
+    // Playback already under way picks up its clock from the new position.
+    if (data->Flags & VQA_DATA_FLAG_32) {
+        data->EndTime = 60 * framenum / handle->Config.DrawRate;
+        VQA_SetTimer(handle, data->EndTime, handle->Config.TimerMethod);
+    }
+
     if (audio->Flags & 0x40) {
         VQA_StartAudio(handle);
     }
@@ -1185,7 +1509,12 @@ VQAData* VQA_AllocBuffers(VQAHeader* header, VQAConfig* config)
         return nullptr;
     }
 
-    memset(data, 0, sizeof(VQAData));
+    /*
+    **	The block comes from malloc, so the atomic members need constructing before first use.
+    */
+    memset((void*)data, 0, sizeof(VQAData));
+    new (&data->Flags) std::atomic<unsigned>(0);
+    new (&data->LoadedFrames) std::atomic<int>(0);
     data->MemUsed = sizeof(VQAData);
     data->Drawer.LastTime = -60;
     data->MaxCBSize = (header->BlockHeight * header->BlockWidth * header->CBentries + 250) & 0xFFFC;
@@ -1240,6 +1569,7 @@ VQAData* VQA_AllocBuffers(VQAHeader* header, VQAConfig* config)
         }
 
         data->MemUsed += data->MaxPalSize + data->MaxPtrSize + sizeof(VQAFrameNode);
+        new (&framenode->Flags) std::atomic<unsigned>(0);
         framenode->Pointers = reinterpret_cast<uint8_t*>(&framenode[1]);
         framenode->Palette = reinterpret_cast<uint8_t*>(&framenode[1]) + data->MaxPtrSize;
         framenode->Codebook = data->CBData;
@@ -1373,6 +1703,10 @@ void VQA_FreeBuffers(VQAData* data, VQAConfig* config, VQAHeader* header)
         free(data->Foff);
     }
 
+    if (data->SeekIndex != nullptr) {
+        free(data->SeekIndex);
+    }
+
     if (config->AudioBuf == nullptr) {
         if (data->Audio.Buffer != nullptr) {
             free(data->Audio.Buffer);
@@ -1419,7 +1753,9 @@ int VQA_PrimeBuffers(VQAHandle* handle)
 {
     VQAData* data = handle->VQABuf;
 
-    for (int index = 0; index < handle->Config.NumFrameBufs; ++index) {
+    // Stop at the end of the movie, it may have fewer frames left than there are buffers.
+    for (int index = 0; index < handle->Config.NumFrameBufs && data->Loader.CurFrameNum < handle->Header.Frames;
+         ++index) {
         VQAErrorType result = (VQAErrorType)VQA_LoadFrame(handle);
 
         if (result) {
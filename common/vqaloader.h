@@ -24,6 +24,7 @@ typedef struct _VQAHandle VQAHandle;
 typedef struct _VQAConfig VQAConfig;
 typedef struct _VQACBNode VQACBNode;
 typedef struct _VQAFrameNode VQAFrameNode;
+typedef struct _VQAPrefetch VQAPrefetch;
 
 typedef int (*DrawFrameFuncPtr)(VQAHandle*);
 typedef int (*PageFlipFuncPtr)(VQAHandle*);
@@ -167,6 +168,16 @@ typedef struct _VQALoader
     int MaxFrameSize;
 } VQALoader;
 
+/*
+**	Per frame entry of the seek index built by VQA_Open with VQAOPTF_SEEKINDEX.
+*/
+typedef struct _VQASeekEntry
+{
+    unsigned Offset; // File offset of the frame's first chunk.
+    int CBFrame;     // First frame whose codebook chunks rebuild the loader's codebook state here, -1 if none.
+    int PalFrame;    // Last earlier frame carrying a palette, -1 if none.
+} VQASeekEntry;
+
 typedef struct _VQAData
 {
     DrawFrameFuncPtr Draw_Frame;
@@ -179,13 +190,15 @@ typedef struct _VQAData
     VQAChunkHeader Chunk;
     VQADrawer Drawer;
     VQAFlipper Flipper;
-    unsigned Flags; // VQADataFlagEnum
+    VQAPrefetch* Prefetch;       // Loader thread state while VQA_Play runs with VQAOPTF_PREFETCH.
+    std::atomic<unsigned> Flags; // VQADataFlagEnum
     int* Foff;
+    VQASeekEntry* SeekIndex;
     int VBIBit;
     int MaxCBSize;
     int MaxPalSize;
     int MaxPtrSize;
-    int LoadedFrames;
+    std::atomic<int> LoadedFrames; // Counted by the loader thread while VQA_Play runs with VQAOPTF_PREFETCH.
     int DrawnFrames;
     int StartTime;
     int EndTime;
@@ -16,9 +16,94 @@
 #include "vqafile.h"
 #include "vqaloader.h"
 #include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 bool VQAMovieDone = false;
 
+/*
+**	While VQA_Play runs with VQAOPTF_PREFETCH, file reads, audio copies and frame loading run on this
+**	thread so the main thread only selects, draws and flips frames and queues audio on the device.
+**	Ownership of each frame node passes between the two through its FRAMENODE_FRAME_LOADED flag, exactly
+**	as it does when both run in turn. The audio ring is shared under a lock in the audio backend.
+*/
+struct _VQAPrefetch
+{
+    std::thread Thread;
+    std::mutex Lock;
+    std::condition_variable Wake;
+    bool Stop;
+    std::atomic<bool> Done; // Set once the loader has read the last frame or hit an error.
+};
+
+static void VQA_PrefetchThread(VQAHandle* handle)
+{
+    VQAData* data = handle->VQABuf;
+    VQAPrefetch* prefetch = data->Prefetch;
+
+    while (true) {
+        int rc = VQA_LoadFrame(handle);
+
+        if (rc == VQAERR_NONE) {
+            ++data->LoadedFrames;
+        } else if (rc != VQAERR_NOBUFFER && rc != VQAERR_SLEEPING) {
+            prefetch->Done = true;
+            return;
+        }
+
+        /*
+        **	Check for a stop request. When the frame ring or the audio buffer is full, also wait a
+        **	little for the drawer to free some space.
+        */
+        std::unique_lock<std::mutex> lock(prefetch->Lock);
+
+        if (rc != VQAERR_NONE) {
+            prefetch->Wake.wait_for(lock, std::chrono::milliseconds(2), [prefetch] { return prefetch->Stop; });
+        }
+
+        if (prefetch->Stop) {
+            return;
+        }
+    }
+}
+
+static void VQA_StartPrefetch(VQAHandle* handle)
+{
+    VQAData* data = handle->VQABuf;
+
+    if (data->Prefetch != nullptr || (data->Flags & VQA_DATA_FLAG_VIDEO_MEMORY_SET)) {
+        return;
+    }
+
+    data->Prefetch = new VQAPrefetch;
+    data->Prefetch->Stop = false;
+    data->Prefetch->Done = false;
+    data->Prefetch->Thread = std::thread(VQA_PrefetchThread, handle);
+}
+
+static void VQA_StopPrefetch(VQAHandle* handle)
+{
+    VQAData* data = handle->VQABuf;
+    VQAPrefetch* prefetch = data->Prefetch;
+
+    if (prefetch == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(prefetch->Lock);
+        prefetch->Stop = true;
+    }
+
+    prefetch->Wake.notify_one();
+    prefetch->Thread.join();
+    delete prefetch;
+    data->Prefetch = nullptr;
+}
+
 VQAHandle* VQA_Alloc(void)
 {
     VQAHandle* handle = (VQAHandle*)malloc(sizeof(VQAHandle));
@@ -78,6 +163,7 @@ VQAErrorType VQA_Play(VQAHandle* handle, VQAPlayMode mode)
     VQADrawer* drawer = &data->Drawer;
 
     if (!(data->Flags & VQA_DATA_FLAG_32)) {
+        VQAMovieDone = false;
         VQA_ConfigureDrawer(handle);
 
         // RA code
@@ -111,19 +197,35 @@ VQAErrorType VQA_Play(VQAHandle* handle, VQAPlayMode mode)
             VQA_SetTimer(handle, data->EndTime, config->TimerMethod);
         }
 
+        if (mode != 1 && (config->OptionFlags & VQAOPTF_PREFETCH)) {
+            VQA_StartPrefetch(handle);
+        }
+
         while (mode != 1) {
             if (data->Flags & (VQA_DATA_FLAG_VIDEO_MEMORY_SET | VQA_DATA_FLAG_8)) {
                 break;
             }
 
+            /*
+            **	The loader can finish several frames ahead of the drawer, so only end the movie once
+            **	the frames still in the ring have been shown.
+            */
             if (data->Flags & VQA_DATA_FLAG_VIDEO_MEMORY_SET) {
                 ++VQAMovieDone;
+            } else if (data->Prefetch != nullptr) {
+                VQA_QueueAudio(handle);
+
+                if (data->Prefetch->Done && !(drawer->CurFrame->Flags & FRAMENODE_FRAME_LOADED)) {
+                    data->Flags |= VQA_DATA_FLAG_VIDEO_MEMORY_SET;
+                }
             } else {
                 rc = (VQAErrorType)VQA_LoadFrame(handle);
 
                 if (rc != VQAERR_NONE) {
                     if (rc != VQAERR_NOBUFFER && rc != VQAERR_SLEEPING) {
-                        data->Flags |= VQA_DATA_FLAG_VIDEO_MEMORY_SET;
+                        if (!(drawer->CurFrame->Flags & FRAMENODE_FRAME_LOADED)) {
+                            data->Flags |= VQA_DATA_FLAG_VIDEO_MEMORY_SET;
+                        }
                         rc = VQAERR_NONE;
                     }
 
@@ -148,6 +250,13 @@ VQAErrorType VQA_Play(VQAHandle* handle, VQAPlayMode mode)
                     if (data->Flags & VQA_DATA_FLAG_VIDEO_MEMORY_SET && rc == VQAERR_NOBUFFER) {
                         data->Flags |= VQA_DATA_FLAG_8;
                     }
+
+                    /*
+                    **	Don't spin while the loader thread works on the frame, it may need this core.
+                    */
+                    if (rc == VQAERR_NOBUFFER && data->Prefetch != nullptr) {
+                        std::this_thread::yield();
+                    }
                 } else {
                     ++data->DrawnFrames;
 
@@ -163,6 +272,8 @@ VQAErrorType VQA_Play(VQAHandle* handle, VQAPlayMode mode)
                 // VQA_UpdateMono(handle);
             }
         }
+
+        VQA_StopPrefetch(handle);
     } else {
         if (!(data->Flags & VQA_DATA_FLAG_64)) {
             data->Flags |= VQA_DATA_FLAG_64;
@@ -243,6 +354,8 @@ void VQA_GetStats(VQAHandle* handle, VQAStatistics* stats)
     stats->FramesSkipped = data->Drawer.NumSkipped;
     stats->MaxFrameSize = data->Loader.MaxFrameSize;
     stats->SamplesPlayed = data->Audio.SamplesPlayed;
+    stats->Underruns = data->Drawer.Underruns;
+    stats->AudioUnderruns = data->Audio.NumSkipped;
 }
 
 // Function found in BR, appears its only use there is to force BH,BW and CM to 0;
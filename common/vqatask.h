@@ -28,10 +28,12 @@ typedef struct _VQAStatistics
     int EndTime;
     int FramesLoaded;
     int FramesDrawn;
-    int FramesSkipped;
+    int FramesSkipped; // Frames dropped to catch up with the timer.
     int MaxFrameSize;
     unsigned SamplesPlayed;
     unsigned MemUsed;
+    int Underruns;           // Frames that were due before the loader had them ready.
+    unsigned AudioUnderruns; // Audio blocks that were due before they were loaded.
 } VQAStatistics;
 
 typedef enum
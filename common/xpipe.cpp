@@ -31,6 +31,7 @@
  *---------------------------------------------------------------------------------------------*
  * Functions:                                                                                  *
  *   BufferPipe::Put -- Submit data to the buffered pipe segment.                              *
+ *   MemoryPipe::Put -- Submit data to the memory pipe segment.                                *
  *   FilePipe::Put -- Submit a block of data to the pipe.                                      *
  *   FilePipe::End -- End the file pipe handler.                                               *
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
@@ -85,6 +86,34 @@ int BufferPipe::Put(void const* source, int slen)
     return (total);
 }
 
+//---------------------------------------------------------------------------------------------------------
+// MemoryPipe
+//---------------------------------------------------------------------------------------------------------
+
+/***********************************************************************************************
+ * MemoryPipe::Put -- Submit data to the memory pipe segment.                                  *
+ *                                                                                             *
+ *    The memory pipe is a pipe terminator. The data is appended to the memory it holds, which *
+ *    grows as needed.                                                                         *
+ *                                                                                             *
+ * INPUT:   source   -- Pointer to the data to submit.                                         *
+ *                                                                                             *
+ *          length   -- The number of bytes to be submitted.                                   *
+ *                                                                                             *
+ * OUTPUT:  Returns with the number of bytes stored.                                           *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *=============================================================================================*/
+int MemoryPipe::Put(void const* source, int slen)
+{
+    if (source == NULL || slen <= 0) {
+        return (0);
+    }
+
+    Data.insert(Data.end(), (char const*)source, (char const*)source + slen);
+    return (slen);
+}
+
 //---------------------------------------------------------------------------------------------------------
 // FilePipe
 //---------------------------------------------------------------------------------------------------------
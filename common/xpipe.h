@@ -39,6 +39,8 @@
 #include "wwfile.h"
 #include "buff.h"
 
+#include <vector>
+
 /*
 **	This is a simple store-into-buffer pipe terminator. Use it as the final link in a pipe process
 **	that needs to store the data into a memory buffer. This can only serve as the final
@@ -74,6 +76,35 @@ private:
     BufferPipe& operator=(BufferPipe const& pipe);
 };
 
+/*
+**	This is a store-into-memory pipe terminator that grows to hold whatever is sent to it. Use it
+**	to capture the output of a pipe process when the final size isn't known in advance.
+*/
+class MemoryPipe : public Pipe
+{
+public:
+    MemoryPipe(int reserve = 0)
+    {
+        Data.reserve(reserve);
+    }
+    virtual int Put(void const* source, int slen);
+
+    void const* Get_Buffer(void) const
+    {
+        return (Data.data());
+    }
+    int Get_Length(void) const
+    {
+        return ((int)Data.size());
+    }
+
+private:
+    std::vector<char> Data;
+
+    MemoryPipe(MemoryPipe& rvalue);
+    MemoryPipe& operator=(MemoryPipe const& pipe);
+};
+
 /*
 **	This is a store-to-file pipe terminator. Use it as the final link in a pipe process that
 **	needs to store the data to a file. This can only serve as the last link in the chain
@@ -316,7 +316,6 @@ public:
     bool Should_Save(void) const;
     bool Save(Pipe& file) const;
     bool Load(Straw& file);
-    void Code_Pointers(void);
     void Decode_Pointers(void);
 
     /*
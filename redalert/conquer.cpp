@@ -400,6 +400,9 @@ void Main_Game(int argc, char* argv[])
         ** (Skip this step if we're in playback mode; the modem or net won't have
         ** been initialized in that case.)
         */
+        if (Session.Record) {
+            Queue_Record_Close(Session.RecordFile);
+        }
         if (Session.Record || Session.Play) {
             Session.RecordFile.Close();
         }
@@ -1683,9 +1686,12 @@ FacingType KN_To_Facing(int input)
 static void Sync_Delay(void)
 {
     /*
-    ** Slow down with frame limiter first.
+    ** Slow down with frame limiter first. Playback frames that aren't shown
+    ** neither present nor wait.
     */
-    Frame_Limiter();
+    if (Queue_Playback_Shown()) {
+        Frame_Limiter();
+    }
 
     /*
     **	Accumulate the number of 'spare' ticks that are frittered away here.
@@ -1796,7 +1802,7 @@ bool Main_Loop()
     **	Setup the timer so that the Main_Loop function processes at the correct rate.
     */
     if (Session.Type != GAME_NORMAL && Session.Type != GAME_SKIRMISH
-        && Session.CommProtocol == COMM_PROTOCOL_MULTI_E_COMP) {
+        && Session.CommProtocol >= COMM_PROTOCOL_MULTI_E_COMP) {
 
         //
         // In playback mode, run as fast as possible.
@@ -1820,6 +1826,14 @@ bool Main_Loop()
         }
     }
 
+    /*
+    **	Frames that playback runs through without showing aren't waited for,
+    **	and nothing is at the fastest playback speed.
+    */
+    if (Session.Play && !Queue_Playback_Frame()) {
+        FrameTimer = 0;
+    }
+
     /*
     **	Update the display, unless we're inside a dialog.
     */
@@ -2190,16 +2204,17 @@ long MixFileHandler(VQAHandle* vqa, long action, void* buffer, long nbytes)
         break;
 
     /*
-    **	VQACMD_SEEK asks that you perform a seek relative to the current
-    ** position. NBytes is a signed number, indicating seek direction
-    ** (positive for forward, negative for backward). Buffer has no meaning
-    ** here.
+    **	VQACMD_SEEK asks that you perform a seek. Buffer holds the origin:
+    ** SEEK_CUR for a seek relative to the current position, where NBytes
+    ** is a signed number indicating seek direction (positive for forward,
+    ** negative for backward), or NULL for an absolute seek to NBytes from
+    ** the start of the file.
     **
     ** Any error code returned will be remapped by VQA library into
     ** VQAERR_SEEK.
     */
     case VQACMD_SEEK:
-        error = (file->Seek(nbytes, SEEK_CUR) == -1);
+        error = (file->Seek(nbytes, buffer == NULL ? SEEK_SET : SEEK_CUR) == -1);
         break;
 
     /*
@@ -4480,6 +4495,14 @@ static void Do_Record_Playback(void)
     */
     if (Session.Play) {
 
+        /*
+        **	The keyframe index follows the last recorded frame.
+        */
+        if (Queue_Playback_Ended()) {
+            GameActive = false;
+            return;
+        }
+
         /*
         **	Read & set the map's location.
         */
@@ -4542,9 +4565,12 @@ static void Do_Record_Playback(void)
         Session.RecordFile.Read(&FormMaxSpeed, sizeof(FormMaxSpeed));
 
         /*
-        **	The map isn't drawn in playback mode, so draw it here.
+        **	The map isn't drawn in playback mode, so draw it here, unless this
+        **	frame is only being run through.
         */
-        Map.Render();
+        if (Queue_Playback_Shown()) {
+            Map.Render();
+        }
     }
 }
 
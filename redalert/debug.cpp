@@ -129,6 +129,12 @@ void Debug_Key(unsigned input)
             }
         } break;
 
+        case KN_Y: {
+            char report[1024];
+            Memory_Report(report, sizeof(report));
+            DBG_INFO("Memory use by subsystem:\n%s", report);
+        } break;
+
         case KN_I: {
             Map.Flash_Power();
             Map.Flash_Money();
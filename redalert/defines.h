@@ -3594,6 +3594,22 @@ typedef struct
     int Distance;
 } FireDataType;
 
+/****************************************************************************
+**	Layouts the map part of a save game can have. The image format holds the
+**	map cells and the layers as memory images with their pointers coded in
+**	place, so they need a fixup pass after loading. The map fields format
+**	writes them field by field with objects as targets, resolved as they are
+**	read. In both, the object heaps are memory images with coded pointers.
+*/
+typedef enum SaveFormatType : char
+{
+    SAVEFORMAT_IMAGE,
+    SAVEFORMAT_MAP_FIELDS,
+
+    SAVEFORMAT_COUNT,
+    SAVEFORMAT_CURRENT = SAVEFORMAT_COUNT - 1
+} SaveFormatType;
+
 #define size_of(typ, id) sizeof(((typ*)0)->id)
 
 #define MAX_LOG_LEVEL 10
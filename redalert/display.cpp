@@ -1622,6 +1622,7 @@ bool DisplayClass::Map_Cell(CELL cell, HouseClass* house, bool check_radar_spied
     */
     // Set per player. ST - 8/6/2019 10:18AM
     cellptr->Set_Mapped(house);
+    Flag_Shroud_Changed(cell);
     cellptr->Redraw_Objects();
     if (Cell_Shadow(cell, house) == -1) {
         cellptr->Set_Visible(house);
@@ -4624,6 +4625,7 @@ void DisplayClass::Shroud_Cell(CELL cell, HouseClass* house)
 
         cellptr->Set_Mapped(house, false);
         cellptr->Set_Visible(house, false);
+        Flag_Shroud_Changed(cell);
         cellptr->Redraw_Objects();
 
         /*
@@ -239,6 +239,7 @@ public:
     static void Set_Content_Directory(const char* dir);
 
     static bool Get_Layer_State(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size);
+    static bool Get_Layer_State_Delta(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size);
     static bool Get_Sidebar_State(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size);
     static bool Start_Construction(uint64 player_id, int buildable_type, int buildable_id);
     static bool Hold_Construction(uint64 player_id, int buildable_type, int buildable_id);
@@ -299,6 +300,10 @@ public:
     static bool Get_Dynamic_Map_State(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size);
     static bool Get_Shroud_State(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size);
     static bool Get_Occupier_State(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size);
+    static bool Get_Shroud_Packed_State(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size);
+    static bool Get_Occupier_Packed_State(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size);
+    static void Apply_Mobile_Gap_Generators(void);
+    static void Unapply_Mobile_Gap_Generators(void);
     static bool Get_Player_Info_State(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size);
 
     static void Set_Event_Callback(CNC_Event_Callback_Type event_callback)
@@ -438,6 +443,19 @@ private:
 
     static unsigned char SpecialKeyFlags[MAX_PLAYERS];
 
+    /*
+    ** Last object list sent to each player as a layer delta, and the scratch list the next one is built in
+    */
+    struct LayerSnapshotType
+    {
+        uint64 PlayerID;
+        unsigned int ID;
+        std::vector<CNCObjectStruct> Objects;
+    };
+    static LayerSnapshotType LayerSnapshots[MAX_PLAYERS];
+    static unsigned int LayerSnapshotID;
+    static std::vector<unsigned char> LayerScratch;
+
     /*
     ** Mod directories
     */
@@ -464,6 +482,9 @@ CELL DLLExportClass::MultiplayerStartPositions[MAX_PLAYERS];
 BuildingTypeClass* DLLExportClass::PlacementType[MAX_PLAYERS];
 unsigned char DLLExportClass::PlacementDistance[MAX_PLAYERS][MAP_CELL_TOTAL];
 unsigned char DLLExportClass::SpecialKeyFlags[MAX_PLAYERS] = {0U};
+DLLExportClass::LayerSnapshotType DLLExportClass::LayerSnapshots[MAX_PLAYERS];
+unsigned int DLLExportClass::LayerSnapshotID = 0;
+std::vector<unsigned char> DLLExportClass::LayerScratch;
 DynamicVectorClass<char*> DLLExportClass::ModSearchPaths;
 std::set<int64> DLLExportClass::MessagesSent;
 bool DLLExportClass::GameOver = false;
@@ -2253,6 +2274,9 @@ void DLLExportClass::Init(void)
 {
     for (int i = 0; i < MAX_PLAYERS; i++) {
         GlyphxPlayerIDs[i] = 0xffffffffull;
+        LayerSnapshots[i].PlayerID = 0xffffffffull;
+        LayerSnapshots[i].ID = 0;
+        LayerSnapshots[i].Objects.clear();
     }
 
     CurrentLocalPlayerIndex = 0;
@@ -3181,6 +3205,11 @@ extern "C" __declspec(dllexport) bool __cdecl CNC_Get_Game_State(GameStateReques
         break;
     }
 
+    case GAME_STATE_LAYERS_DELTA: {
+        got_state = DLLExportClass::Get_Layer_State_Delta(player_id, buffer_in, buffer_size);
+        break;
+    }
+
     case GAME_STATE_SIDEBAR: {
         got_state = DLLExportClass::Get_Sidebar_State(player_id, buffer_in, buffer_size);
         break;
@@ -3207,6 +3236,14 @@ extern "C" __declspec(dllexport) bool __cdecl CNC_Get_Game_State(GameStateReques
         got_state = DLLExportClass::Get_Player_Info_State(player_id, buffer_in, buffer_size);
         break;
 
+    case GAME_STATE_SHROUD_PACKED:
+        got_state = DLLExportClass::Get_Shroud_Packed_State(player_id, buffer_in, buffer_size);
+        break;
+
+    case GAME_STATE_OCCUPIER_PACKED:
+        got_state = DLLExportClass::Get_Occupier_Packed_State(player_id, buffer_in, buffer_size);
+        break;
+
     case GAME_STATE_STATIC_MAP: {
         if (buffer_size < sizeof(CNCMapDataStruct)) {
             got_state = false;
@@ -3905,6 +3942,218 @@ bool DLLExportClass::Get_Layer_State(uint64 player_id, unsigned char* buffer_in,
     return false;
 }
 
+/*
+** Where each CNCObjectFieldEnum group starts in CNCObjectStruct, with the end of the struct last
+*/
+static const unsigned int ObjectFieldOffsets[OBJECT_FIELD_COUNT + 1] = {
+    offsetof(CNCObjectStruct, CNCInternalObjectPointer),
+    offsetof(CNCObjectStruct, PositionX),
+    offsetof(CNCObjectStruct, SortOrder),
+    offsetof(CNCObjectStruct, Scale),
+    offsetof(CNCObjectStruct, MaxStrength),
+    offsetof(CNCObjectStruct, ShapeIndex),
+    offsetof(CNCObjectStruct, CellX),
+    offsetof(CNCObjectStruct, DimensionX),
+    offsetof(CNCObjectStruct, Owner),
+    offsetof(CNCObjectStruct, IsRepairing),
+    offsetof(CNCObjectStruct, OccupyList),
+    offsetof(CNCObjectStruct, Pips),
+    offsetof(CNCObjectStruct, Lines),
+    offsetof(CNCObjectStruct, RecentlyCreated),
+    offsetof(CNCObjectStruct, VisibleFlags),
+    offsetof(CNCObjectStruct, ProductionAssetName),
+    offsetof(CNCObjectStruct, ActionWithSelected),
+    sizeof(CNCObjectStruct),
+};
+
+/*
+** List entry sorted by object pointer, then by position in the list
+*/
+struct ObjectDeltaKeyType
+{
+    void* Pointer;
+    int Ordinal;
+    int Index;
+};
+
+static int Sort_Delta_Key(const void* a, const void* b)
+{
+    const ObjectDeltaKeyType* key_a = (const ObjectDeltaKeyType*)a;
+    const ObjectDeltaKeyType* key_b = (const ObjectDeltaKeyType*)b;
+    if (key_a->Pointer != key_b->Pointer) {
+        return (key_a->Pointer < key_b->Pointer) ? -1 : 1;
+    }
+    return key_a->Index - key_b->Index;
+}
+
+static void Sort_Delta_Keys(const CNCObjectStruct* objects, int count, std::vector<ObjectDeltaKeyType>& keys)
+{
+    keys.resize(count);
+    for (int i = 0; i < count; i++) {
+        keys[i].Pointer = objects[i].CNCInternalObjectPointer;
+        keys[i].Index = i;
+    }
+    if (count > 1) {
+        qsort(keys.data(), count, sizeof(ObjectDeltaKeyType), Sort_Delta_Key);
+    }
+    for (int i = 0; i < count; i++) {
+        keys[i].Ordinal = (i > 0 && keys[i - 1].Pointer == keys[i].Pointer) ? keys[i - 1].Ordinal + 1 : 0;
+    }
+}
+
+static int Compare_Delta_Keys(const ObjectDeltaKeyType& a, const ObjectDeltaKeyType& b)
+{
+    if (a.Pointer != b.Pointer) {
+        return (a.Pointer < b.Pointer) ? -1 : 1;
+    }
+    return a.Ordinal - b.Ordinal;
+}
+
+/**************************************************************************************************
+ * DLLExportClass::Get_Layer_State_Delta -- Get the changes to the layer objects since a snapshot
+ *
+ * In:   Player perspective
+ *       Buffer holding a CNCObjectDeltaStruct with the snapshot the caller last applied
+ *       Size of buffer
+ *
+ * Out:  Objects added, removed and changed since that snapshot, or all of them if it isn't the one
+ *       retained for the player
+ *
+ * The full list is built exactly as for GAME_STATE_LAYERS and then compared with a copy of the
+ * last one sent, so a buffer that holds the full list is needed for scratch either way.
+ **************************************************************************************************/
+bool DLLExportClass::Get_Layer_State_Delta(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size)
+{
+    if (buffer_size < sizeof(CNCObjectDeltaStruct)) {
+        return false;
+    }
+
+    CNCObjectDeltaStruct* delta = (CNCObjectDeltaStruct*)buffer_in;
+
+    if (LayerScratch.size() < buffer_size) {
+        LayerScratch.resize(buffer_size);
+    }
+    CNCObjectListStruct* list = (CNCObjectListStruct*)&LayerScratch[0];
+    list->Count = -1;
+    Get_Layer_State(player_id, &LayerScratch[0], buffer_size);
+    if (list->Count < 0) {
+        return false;
+    }
+
+    /*
+    ** Find the player's snapshot, or give them the oldest one.
+    */
+    LayerSnapshotType* snapshot = &LayerSnapshots[0];
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        if (LayerSnapshots[i].PlayerID == player_id) {
+            snapshot = &LayerSnapshots[i];
+            break;
+        }
+        if (LayerSnapshots[i].ID < snapshot->ID) {
+            snapshot = &LayerSnapshots[i];
+        }
+    }
+
+    bool full = snapshot->PlayerID != player_id || snapshot->ID == 0 || delta->AckSnapshotID != snapshot->ID;
+    const CNCObjectStruct* old_objects = full ? NULL : snapshot->Objects.data();
+    int old_count = full ? 0 : (int)snapshot->Objects.size();
+
+    static std::vector<ObjectDeltaKeyType> old_keys;
+    static std::vector<ObjectDeltaKeyType> new_keys;
+    Sort_Delta_Keys(old_objects, old_count, old_keys);
+    Sort_Delta_Keys(list->Objects, list->Count, new_keys);
+
+    unsigned char* out = buffer_in + sizeof(CNCObjectDeltaStruct);
+    unsigned char* out_end = buffer_in + buffer_size;
+    int count = 0;
+
+    /*
+    ** Walk both lists in key order. Keys only in the old list were removed and keys only in the new one were added.
+    */
+    int o = 0;
+    int n = 0;
+    while (o < old_count || n < list->Count) {
+        int compare = (o == old_count) ? 1 : ((n == list->Count) ? -1 : Compare_Delta_Keys(old_keys[o], new_keys[n]));
+
+        CNCObjectDeltaEntryStruct entry;
+        entry.FieldMask = 0;
+        const CNCObjectStruct* old_object = NULL;
+        const CNCObjectStruct* new_object = NULL;
+        unsigned int size = 0;
+
+        if (compare < 0) {
+            entry.Change = DELTA_REMOVE;
+            entry.Ordinal = (unsigned short)old_keys[o].Ordinal;
+            entry.CNCInternalObjectPointer = old_keys[o].Pointer;
+            o++;
+        } else if (compare > 0) {
+            new_object = &list->Objects[new_keys[n].Index];
+            entry.Change = DELTA_ADD;
+            entry.Ordinal = (unsigned short)new_keys[n].Ordinal;
+            entry.CNCInternalObjectPointer = new_keys[n].Pointer;
+            size = sizeof(CNCObjectStruct);
+            n++;
+        } else {
+            old_object = &old_objects[old_keys[o].Index];
+            new_object = &list->Objects[new_keys[n].Index];
+            entry.Change = DELTA_CHANGE;
+            entry.Ordinal = (unsigned short)new_keys[n].Ordinal;
+            entry.CNCInternalObjectPointer = new_keys[n].Pointer;
+            for (int field = 0; field < OBJECT_FIELD_COUNT; field++) {
+                unsigned int start = ObjectFieldOffsets[field];
+                unsigned int length = ObjectFieldOffsets[field + 1] - start;
+                if (memcmp((const char*)old_object + start, (const char*)new_object + start, length) != 0) {
+                    entry.FieldMask |= 1 << field;
+                    size += length;
+                }
+            }
+            o++;
+            n++;
+            if (entry.FieldMask == 0) {
+                continue;
+            }
+        }
+
+        if ((unsigned int)(out_end - out) < sizeof(entry) + size) {
+            return false;
+        }
+        memcpy(out, &entry, sizeof(entry));
+        out += sizeof(entry);
+
+        if (entry.Change == DELTA_ADD) {
+            memcpy(out, new_object, sizeof(CNCObjectStruct));
+            out += sizeof(CNCObjectStruct);
+        } else if (entry.Change == DELTA_CHANGE) {
+            for (int field = 0; field < OBJECT_FIELD_COUNT; field++) {
+                if (entry.FieldMask & (1 << field)) {
+                    unsigned int start = ObjectFieldOffsets[field];
+                    unsigned int length = ObjectFieldOffsets[field + 1] - start;
+                    memcpy(out, (const char*)new_object + start, length);
+                    out += length;
+                }
+            }
+        }
+        count++;
+    }
+
+    /*
+    ** The list just sent becomes the player's snapshot. IDs never repeat, so a stale acknowledgement can't match.
+    */
+    if (++LayerSnapshotID == 0) {
+        LayerSnapshotID = 1;
+    }
+    snapshot->PlayerID = player_id;
+    snapshot->ID = LayerSnapshotID;
+    snapshot->Objects.assign(list->Objects, list->Objects + list->Count);
+
+    delta->SnapshotID = snapshot->ID;
+    delta->BaseSnapshotID = full ? 0 : delta->AckSnapshotID;
+    delta->Count = count;
+    delta->Size = (int)(out - (buffer_in + sizeof(CNCObjectDeltaStruct)));
+
+    return true;
+}
+
 void DLLExportClass::Convert_Type(const ObjectClass* object, CNCObjectStruct& object_out)
 {
     object_out.Type = UNKNOWN;
@@ -6046,21 +6295,7 @@ bool DLLExportClass::Get_Shroud_State(uint64 player_id, unsigned char* buffer_in
         return false;
     }
 
-    /*
-    ** Apply mobile gap generators
-    */
-    static unsigned int _shroud_bits[UNIT_MAX];
-
-    if (GAME_TO_PLAY == GAME_GLYPHX_MULTIPLAYER) {
-        for (int index = 0; index < Units.Count(); index++) {
-            UnitClass* obj = Units.Ptr(index);
-            if (obj->Class->IsGapper && obj->IsActive && obj->Strength) {
-                if (!obj->House->Is_Ally(PlayerPtr)) {
-                    _shroud_bits[index] = obj->Apply_Temporary_Jamming_Shroud(PlayerPtr);
-                }
-            }
-        }
-    }
+    Apply_Mobile_Gap_Generators();
 
     CNCShroudStruct* shroud = (CNCShroudStruct*)buffer_in;
 
@@ -6105,6 +6340,7 @@ bool DLLExportClass::Get_Shroud_State(uint64 player_id, unsigned char* buffer_in
 
             memory_needed += sizeof(CNCShroudEntryStruct);
             if (memory_needed >= buffer_size) {
+                Unapply_Mobile_Gap_Generators();
                 return false;
             }
 
@@ -6136,17 +6372,321 @@ bool DLLExportClass::Get_Shroud_State(uint64 player_id, unsigned char* buffer_in
 
     shroud->Count = entry_index;
 
+    Unapply_Mobile_Gap_Generators();
+
+    return true;
+}
+
+/*
+** Cells jammed for the current player by each mobile gap generator while the shroud is exported
+*/
+static unsigned int MobileGapShroudBits[UNIT_MAX];
+
+/**************************************************************************************************
+ * DLLExportClass::Apply_Mobile_Gap_Generators -- Jam around enemy mobile gap generators
+ *
+ * In:
+ *
+ * Out:
+ *
+ * Mobile gap generators only shroud while the shroud is being exported for the current player.
+ * Must be followed by Unapply_Mobile_Gap_Generators once the export is done.
+ **************************************************************************************************/
+void DLLExportClass::Apply_Mobile_Gap_Generators(void)
+{
+    if (GAME_TO_PLAY == GAME_GLYPHX_MULTIPLAYER) {
+        for (int index = 0; index < Units.Count(); index++) {
+            UnitClass* obj = Units.Ptr(index);
+            if (obj->Class->IsGapper && obj->IsActive && obj->Strength) {
+                if (!obj->House->Is_Ally(PlayerPtr)) {
+                    MobileGapShroudBits[index] = obj->Apply_Temporary_Jamming_Shroud(PlayerPtr);
+                }
+            }
+        }
+    }
+}
+
+/**************************************************************************************************
+ * DLLExportClass::Unapply_Mobile_Gap_Generators -- Undo Apply_Mobile_Gap_Generators
+ *
+ * In:
+ *
+ * Out:
+ **************************************************************************************************/
+void DLLExportClass::Unapply_Mobile_Gap_Generators(void)
+{
     if (GAME_TO_PLAY == GAME_GLYPHX_MULTIPLAYER) {
         for (int index = 0; index < Units.Count(); index++) {
             UnitClass* obj = Units.Ptr(index);
             if (obj->Class->IsGapper && obj->IsActive && obj->Strength) {
                 if (!obj->House->Is_Ally(PlayerPtr)) {
-                    obj->Unapply_Temporary_Jamming_Shroud(PlayerPtr, _shroud_bits[index]);
+                    obj->Unapply_Temporary_Jamming_Shroud(PlayerPtr, MobileGapShroudBits[index]);
+                }
+            }
+        }
+    }
+}
+
+/*
+** The cells the shroud and occupier state covers: the map, plus a cell of border where there is room
+*/
+static void Get_Export_Cell_Rect(int& map_cell_x, int& map_cell_y, int& map_cell_width, int& map_cell_height)
+{
+    map_cell_x = Map.MapCellX;
+    map_cell_y = Map.MapCellY;
+    map_cell_width = Map.MapCellWidth;
+    map_cell_height = Map.MapCellHeight;
+
+    if (map_cell_x > 0) {
+        map_cell_x--;
+        map_cell_width++;
+    }
+
+    if (map_cell_width < MAP_MAX_CELL_WIDTH) {
+        map_cell_width++;
+    }
+
+    if (map_cell_y > 0) {
+        map_cell_y--;
+        map_cell_height++;
+    }
+
+    if (map_cell_height < MAP_MAX_CELL_HEIGHT) {
+        map_cell_height++;
+    }
+}
+
+/*
+** Lists the parts of the export rectangle in blocks changed after the since generation, merging blocks that are next
+** to each other in a row. A since below zero gives the whole rectangle.
+*/
+static int Get_Changed_Regions(const long* changed, int since, CNCMapRegionStruct* regions)
+{
+    int map_cell_x, map_cell_y, map_cell_width, map_cell_height;
+    Get_Export_Cell_Rect(map_cell_x, map_cell_y, map_cell_width, map_cell_height);
+
+    if (since < 0) {
+        regions[0].CellX = (unsigned short)map_cell_x;
+        regions[0].CellY = (unsigned short)map_cell_y;
+        regions[0].Width = (unsigned short)map_cell_width;
+        regions[0].Height = (unsigned short)map_cell_height;
+        return 1;
+    }
+
+    int count = 0;
+    int right = map_cell_x + map_cell_width;
+    int bottom = map_cell_y + map_cell_height;
+
+    for (int by = 0; by < MapClass::CHANGE_BLOCK_H; by++) {
+        int y1 = max(by << MapClass::CHANGE_BLOCK_SHIFT, map_cell_y);
+        int y2 = min((by + 1) << MapClass::CHANGE_BLOCK_SHIFT, bottom);
+        if (y1 >= y2) {
+            continue;
+        }
+
+        const long* row = changed + by * MapClass::CHANGE_BLOCK_W;
+        for (int bx = 0; bx < MapClass::CHANGE_BLOCK_W; bx++) {
+            if (row[bx] <= since) {
+                continue;
+            }
+
+            int run = bx;
+            while (run + 1 < MapClass::CHANGE_BLOCK_W && row[run + 1] > since) {
+                run++;
+            }
+
+            int x1 = max(bx << MapClass::CHANGE_BLOCK_SHIFT, map_cell_x);
+            int x2 = min((run + 1) << MapClass::CHANGE_BLOCK_SHIFT, right);
+            if (x1 < x2) {
+                regions[count].CellX = (unsigned short)x1;
+                regions[count].CellY = (unsigned short)y1;
+                regions[count].Width = (unsigned short)(x2 - x1);
+                regions[count].Height = (unsigned short)(y2 - y1);
+                count++;
+            }
+            bx = run;
+        }
+    }
+
+    return count;
+}
+
+/**************************************************************************************************
+ * DLLExportClass::Get_Shroud_Packed_State -- Get the shroud for the given player as bitmaps
+ *
+ * In:   Player perspective
+ *       Buffer holding a CNCPackedMapStruct with the generation of the caller's last reply
+ *       Size of buffer
+ *
+ * Out:  Shroud for the regions of the map that may have changed since that generation
+ **************************************************************************************************/
+bool DLLExportClass::Get_Shroud_Packed_State(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size)
+{
+    if (buffer_size < sizeof(CNCPackedMapStruct)) {
+        return false;
+    }
+
+    if (!DLLExportClass::Set_Player_Context(player_id)) {
+        return false;
+    }
+
+    CNCPackedMapStruct* packed = (CNCPackedMapStruct*)buffer_in;
+
+    Apply_Mobile_Gap_Generators();
+
+    static CNCMapRegionStruct _regions[MapClass::CHANGE_BLOCK_COUNT];
+    int region_count = Get_Changed_Regions(MapClass::ShroudChanged, packed->Since, _regions);
+
+    unsigned char* out = buffer_in + sizeof(CNCPackedMapStruct);
+    unsigned char* out_end = buffer_in + buffer_size;
+    bool fits = true;
+
+    for (int r = 0; r < region_count && fits; r++) {
+        CNCMapRegionStruct& region = _regions[r];
+        int cells = region.Width * region.Height;
+        int state_bytes = (cells + 3) / 4;
+        int jam_bytes = (cells + 7) / 8;
+
+        if (out_end - out < (int)sizeof(CNCMapRegionStruct) + state_bytes + jam_bytes) {
+            fits = false;
+            break;
+        }
+
+        unsigned char* state = out + sizeof(CNCMapRegionStruct);
+        unsigned char* jam = state + state_bytes;
+        unsigned char* shadow = jam + jam_bytes;
+        memset(state, 0, state_bytes + jam_bytes);
+        region.ShadowCount = 0;
+
+        for (int index = 0; index < cells; index++) {
+            CELL cell = XY_Cell(region.CellX + (index % region.Width), region.CellY + (index / region.Width));
+            CellClass* cellptr = &Map[cell];
+
+            bool is_mapped = cellptr->Is_Mapped(PlayerPtr);
+            bool is_visible = cellptr->Is_Visible(PlayerPtr);
+
+            state[index >> 2] |= ((is_mapped ? 1 : 0) | (is_visible ? 2 : 0)) << ((index & 3) * 2);
+            if (cellptr->Is_Jamming(PlayerPtr)) {
+                jam[index >> 3] |= 1 << (index & 7);
+            }
+
+            if (is_mapped && !is_visible) {
+                char shadow_index = (char)Map.Cell_Shadow(cell, PlayerPtr);
+                if (shadow_index != -1) {
+                    if (out_end - shadow < (int)sizeof(CNCPackedShadowStruct)) {
+                        fits = false;
+                        break;
+                    }
+                    CNCPackedShadowStruct entry;
+                    entry.Index = (unsigned short)index;
+                    entry.ShadowIndex = shadow_index;
+                    memcpy(shadow, &entry, sizeof(entry));
+                    shadow += sizeof(entry);
+                    region.ShadowCount++;
                 }
             }
         }
+
+        region.Size = (int)(shadow - state);
+        memcpy(out, &region, sizeof(region));
+        out = shadow;
+    }
+
+    /*
+    ** The gap generator jamming comes off again in the next generation, so the blocks it covered are sent again on
+    ** the next request.
+    */
+    packed->Generation = (int)MapClass::Next_Change_Generation();
+    Unapply_Mobile_Gap_Generators();
+
+    if (!fits) {
+        return false;
+    }
+
+    packed->Count = region_count;
+
+    return true;
+}
+
+/**************************************************************************************************
+ * DLLExportClass::Get_Occupier_Packed_State -- Get the occupiers as a bitmap and a list of the occupied cells
+ *
+ * In:   Player perspective
+ *       Buffer holding a CNCPackedMapStruct with the generation of the caller's last reply
+ *       Size of buffer
+ *
+ * Out:  Occupiers for the regions of the map that may have changed since that generation
+ **************************************************************************************************/
+bool DLLExportClass::Get_Occupier_Packed_State(uint64 player_id, unsigned char* buffer_in, unsigned int buffer_size)
+{
+    UNREFERENCED_PARAMETER(player_id);
+
+    if (buffer_size < sizeof(CNCPackedMapStruct)) {
+        return false;
+    }
+
+    CNCPackedMapStruct* packed = (CNCPackedMapStruct*)buffer_in;
+
+    static CNCMapRegionStruct _regions[MapClass::CHANGE_BLOCK_COUNT];
+    int region_count = Get_Changed_Regions(MapClass::OccupierChanged, packed->Since, _regions);
+
+    unsigned char* out = buffer_in + sizeof(CNCPackedMapStruct);
+    unsigned char* out_end = buffer_in + buffer_size;
+
+    for (int r = 0; r < region_count; r++) {
+        CNCMapRegionStruct& region = _regions[r];
+        int cells = region.Width * region.Height;
+        int occupied_bytes = (cells + 7) / 8;
+
+        if (out_end - out < (int)sizeof(CNCMapRegionStruct) + occupied_bytes) {
+            return false;
+        }
+
+        unsigned char* occupied = out + sizeof(CNCMapRegionStruct);
+        unsigned char* entry = occupied + occupied_bytes;
+        memset(occupied, 0, occupied_bytes);
+
+        for (int index = 0; index < cells; index++) {
+            CELL cell = XY_Cell(region.CellX + (index % region.Width), region.CellY + (index / region.Width));
+            ObjectClass* optr = Map[cell].Cell_Occupier();
+            if (optr == NULL) {
+                continue;
+            }
+
+            occupied[index >> 3] |= 1 << (index & 7);
+
+            CNCOccupierEntryHeaderStruct header;
+            header.Count = 0;
+            for (ObjectClass* next = optr; next != NULL; next = next->Next) {
+                header.Count++;
+            }
+
+            if (out_end - entry < (int)(sizeof(header) + header.Count * sizeof(CNCOccupierObjectStruct))) {
+                return false;
+            }
+            memcpy(entry, &header, sizeof(header));
+            entry += sizeof(header);
+
+            for (; optr != NULL; optr = optr->Next) {
+                CNCObjectStruct object;
+                Convert_Type(optr, object);
+                CNCOccupierObjectStruct occupier;
+                occupier.Type = object.Type;
+                occupier.ID = object.ID;
+                memcpy(entry, &occupier, sizeof(occupier));
+                entry += sizeof(occupier);
+            }
+        }
+
+        region.ShadowCount = 0;
+        region.Size = (int)(entry - occupied);
+        memcpy(out, &region, sizeof(region));
+        out = entry;
     }
 
+    packed->Generation = (int)MapClass::Next_Change_Generation();
+    packed->Count = region_count;
+
     return true;
 }
 
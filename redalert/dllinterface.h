@@ -62,7 +62,10 @@ enum GameStateRequestEnum
     GAME_STATE_PLACEMENT,
     GAME_STATE_SHROUD,
     GAME_STATE_OCCUPIER,
-    GAME_STATE_PLAYER_INFO
+    GAME_STATE_PLAYER_INFO,
+    GAME_STATE_LAYERS_DELTA,
+    GAME_STATE_SHROUD_PACKED,
+    GAME_STATE_OCCUPIER_PACKED
 };
 
 /**************************************************************************************
@@ -271,6 +274,70 @@ struct CNCObjectListStruct
     CNCObjectStruct Objects[1]; // Variable length
 };
 
+/**************************************************************************************
+**
+**  Object list delta
+**
+**  Returned for GAME_STATE_LAYERS_DELTA. The caller puts the ID of the last snapshot it applied in AckSnapshotID
+**  (0 for none). If that is the snapshot retained for the player, only the objects added, removed or changed since
+**  then are returned; otherwise BaseSnapshotID is 0 and every object comes back as an add.
+**
+**  An object is keyed by its CNCInternalObjectPointer and Ordinal, the position among the list entries that share
+**  that pointer (a base object and its sub-objects). Entries follow the header back to back:
+**
+**    DELTA_ADD     - the whole CNCObjectStruct
+**    DELTA_REMOVE  - nothing
+**    DELTA_CHANGE  - the field groups set in FieldMask, in increasing bit order
+**
+**  Each field group is the run of CNCObjectStruct bytes from the first field named below up to the first field of
+**  the next group.
+*/
+enum CNCObjectDeltaEnum
+{
+    DELTA_ADD,
+    DELTA_REMOVE,
+    DELTA_CHANGE
+};
+
+enum CNCObjectFieldEnum
+{
+    OBJECT_FIELD_IDENTITY,   // CNCInternalObjectPointer
+    OBJECT_FIELD_POSITION,   // PositionX
+    OBJECT_FIELD_SORT_ORDER, // SortOrder
+    OBJECT_FIELD_DRAW,       // Scale
+    OBJECT_FIELD_STRENGTH,   // MaxStrength
+    OBJECT_FIELD_SHAPE,      // ShapeIndex
+    OBJECT_FIELD_CELL,       // CellX
+    OBJECT_FIELD_DIMENSION,  // DimensionX
+    OBJECT_FIELD_OWNER,      // Owner
+    OBJECT_FIELD_STATUS,     // IsRepairing
+    OBJECT_FIELD_OCCUPY,     // OccupyList
+    OBJECT_FIELD_PIPS,       // Pips
+    OBJECT_FIELD_LINES,      // Lines
+    OBJECT_FIELD_FLAGS,      // RecentlyCreated
+    OBJECT_FIELD_VISIBILITY, // VisibleFlags
+    OBJECT_FIELD_PRODUCTION, // ProductionAssetName
+    OBJECT_FIELD_ACTIONS,    // ActionWithSelected
+    OBJECT_FIELD_COUNT
+};
+
+struct CNCObjectDeltaEntryStruct
+{
+    unsigned char Change; // CNCObjectDeltaEnum
+    unsigned short Ordinal;
+    void* CNCInternalObjectPointer;
+    unsigned int FieldMask; // 1 << CNCObjectFieldEnum for each group that follows
+};
+
+struct CNCObjectDeltaStruct
+{
+    unsigned int AckSnapshotID;  // In: last snapshot applied by the caller
+    unsigned int SnapshotID;     // Out: snapshot to acknowledge on the next request
+    unsigned int BaseSnapshotID; // Out: snapshot the entries apply to, or 0 for a full list
+    int Count;                   // Out: number of entries
+    int Size;                    // Out: bytes of entry data following the header
+};
+
 /**************************************************************************************
 **
 **  Placement validity data
@@ -883,6 +950,47 @@ struct CNCOccupierHeaderStruct
     int Count;
 };
 
+/**************************************************************************************
+**
+**  Packed shroud and occupier data.
+**
+**  Returned for GAME_STATE_SHROUD_PACKED and GAME_STATE_OCCUPIER_PACKED. The caller puts the Generation from its
+**  last reply of the same kind in Since, or -1 for everything. The reply is Count regions of the map that may have
+**  changed since then, each a CNCMapRegionStruct followed by Size bytes covering its cells row by row. Generations
+**  only go up, so a reply from before a restart, a load or a seek still gets everything that changed.
+**
+**  Shroud region data:
+**    2 bits per cell, four cells to a byte from the low bits up; bit 0 is mapped and bit 1 is visible
+**    1 bit per cell, eight cells to a byte from the low bit up; set if jamming
+**    ShadowCount CNCPackedShadowStruct for the cells with a shadow index other than -1
+**
+**  Occupier region data:
+**    1 bit per cell, eight cells to a byte from the low bit up; set if occupied
+**    For each occupied cell in turn, a CNCOccupierEntryHeaderStruct and its CNCOccupierObjectStructs
+*/
+struct CNCPackedMapStruct
+{
+    int Since;      // In: generation from the last reply, or -1
+    int Generation; // Out: pass back as Since on the next request
+    int Count;      // Out: number of regions
+};
+
+struct CNCMapRegionStruct
+{
+    unsigned short CellX;
+    unsigned short CellY;
+    unsigned short Width;
+    unsigned short Height;
+    int ShadowCount;
+    int Size;
+};
+
+struct CNCPackedShadowStruct
+{
+    unsigned short Index; // Cell within the region
+    char ShadowIndex;
+};
+
 /**************************************************************************************
 **
 **  Carryover object.
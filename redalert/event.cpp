@@ -859,7 +859,8 @@ void EventClass::Execute(void)
         break;
 
     /*
-    **	Save a multiplayer game (this event is only generated in multiplayer mode)
+    **	Save a multiplayer game (this event is only generated in multiplayer mode). The file is
+    **	written in the background so the game doesn't stall on it.
     */
     case SAVEGAME:
         /*
@@ -873,7 +874,7 @@ void EventClass::Execute(void)
 
             WWMessageBox().Process(TXT_SAVING_GAME, TXT_NONE);
 
-            Save_Game(-1, (char*)Text_String(TXT_MULTIPLAYER_GAME));
+            Save_Game(NET_SAVE_FILE_NAME, Text_String(TXT_MULTIPLAYER_GAME), true);
 
             while (timer > 0) {
                 Call_Back();
@@ -883,7 +884,7 @@ void EventClass::Execute(void)
             Map.Flag_To_Redraw(true);
             Map.Render();
         } else {
-            Save_Game(-1, (char*)Text_String(TXT_MULTIPLAYER_GAME));
+            Save_Game(NET_SAVE_FILE_NAME, Text_String(TXT_MULTIPLAYER_GAME), true);
         }
         break;
 
@@ -45,6 +45,7 @@
 #include "goptions.h"
 #include "vortex.h"
 #include "common/vqaconfig.h"
+#include "common/arena.h"
 #include "logic.h"
 #include "base.h"
 #include "scenario.h"
@@ -76,6 +77,7 @@ typedef MixFileClass<CCFileClass> MFCD;
 
 extern bool IsVQ640;
 extern unsigned long GameVersion;
+extern SaveFormatType SaveFormat;
 extern bool Debug_MotionCapture;
 extern bool Debug_Rotate;
 extern bool Debug_Quiet;
@@ -94,6 +96,7 @@ extern bool Debug_Check_Map;
 extern bool Debug_Playtest;
 
 extern bool Debug_Heap_Dump;
+extern bool Debug_Memory_Report;
 extern bool Debug_Smart_Print;
 extern bool Debug_Trap_Check_Heap;
 extern bool Debug_Modem_Dump;
@@ -163,6 +166,7 @@ extern RandomStraw CryptRandom;
 extern RandomClass NonCriticalRandomNumber;
 extern CarryoverClass* Carryover;
 extern ScenarioClass Scen;
+extern ArenaClass ScenarioArena;
 extern RemapControlType ColorRemaps[PCOLOR_COUNT];
 extern RemapControlType MetalScheme;
 extern RemapControlType GreyScheme;
@@ -345,6 +349,8 @@ extern CELL CurrentCell;
 extern SessionClass Session;
 // extern NullModemClass 			NullModem;
 extern IPXManagerClass Ipx;
+class LinkSimClass;
+extern LinkSimClass* LinkSim;
 
 #if (TIMING_FIX)
 extern int NewMaxAheadFrame1;
@@ -474,6 +474,15 @@ bool Queue_Mission(TargetClass whom,
 bool Queue_Options(void);
 bool Queue_Exit(void);
 void Queue_AI(void);
+void Queue_Record_Header(CCFileClass& file);
+void Queue_Record_Close(CCFileClass& file);
+void Queue_Playback_Header(CCFileClass& file);
+void Queue_Playback_Seek(long frame);
+bool Queue_Playback_Seeking(void);
+void Queue_Playback_Speed(int speed);
+bool Queue_Playback_Frame(void);
+bool Queue_Playback_Shown(void);
+bool Queue_Playback_Ended(void);
 void Add_CRC(unsigned long* crc, unsigned long val);
 
 /*
@@ -512,7 +521,10 @@ bool Load_Game(const char* file_name);
 // Read_Object prototype. ST - 9/17/2019 12:50PM
 bool Read_Object(void* ptr, int class_size, FileClass& file, bool has_vtable);
 bool Save_Game(int id, char const* descr, bool bargraph = false);
-bool Save_Game(const char* file_name, const char* descr);
+bool Save_Game(const char* file_name, const char* descr, bool background = false);
+void Save_Game_Wait(void);
+void Save_Keyframe(Pipe& pipe);
+bool Load_Keyframe(Straw& straw);
 bool Write_Object(void* ptr, int class_size, FileClass& file);
 void Code_All_Pointers(void);
 void Decode_All_Pointers(void);
@@ -35,6 +35,7 @@
 
 bool IsVQ640 = false;
 unsigned long GameVersion = 0;
+SaveFormatType SaveFormat = SAVEFORMAT_CURRENT;
 bool Debug_MotionCapture = false;
 bool Debug_Quiet = false;
 bool Debug_Cheat = false;
@@ -52,6 +53,7 @@ bool Debug_Check_Map = false; // true = validate the map each frame
 bool Debug_Playtest = false;
 
 bool Debug_Heap_Dump = false;       // true = print the Heap Dump
+bool Debug_Memory_Report = false;   // true = write memory.txt on exit
 bool Debug_Smart_Print = false;     // true = print everything that calls Smart_Printf
 bool Debug_Trap_Check_Heap = false; // true = check the Heap
 bool Debug_Modem_Dump = false;      // true = print the Modem Stuff
@@ -301,6 +303,12 @@ bool SlowPalette = false;    // Slow palette flag set?
 */
 ScenarioClass Scen;
 
+/***************************************************************************
+**	Data that lives exactly as long as the current scenario is allocated from
+** here. It is reset in one go by Clear_Scenario.
+*/
+ArenaClass ScenarioArena;
+
 /***************************************************************************
 **	This is the pending speech sample to play. This sample will be played
 **	at the first opportunity.
@@ -606,6 +614,13 @@ IPXManagerClass Ipx(MAX(sizeof(GlobalPacketType), sizeof(RemoteFileTransferType)
                     VIRGIN_SOCKET,                             // Socket ID #
                     IPXGlobalConnClass::COMMAND_AND_CONQUER0); // Product ID #
 
+/***************************************************************************
+**	When set, multiplayer games run over this simulated link instead of the
+** IPX manager, so several instances can play on one machine under
+** repeatable network conditions.  Whoever creates it owns it.
+*/
+LinkSimClass* LinkSim = NULL;
+
 /***************************************************************************
 **	This is the random-number seed; it's synchronized between systems for
 ** multiplayer games.
@@ -38,6 +38,7 @@
  *   FixedHeapClass::ID -- Converts a pointer to a sub-block index number.                     *
  *   FixedHeapClass::Set_Heap -- Assigns a memory block for this heap manager.                 *
  *   FixedHeapClass::~FixedHeapClass -- Destructor for the heap manager class.                 *
+ *   FixedIHeapClass::Activate -- Adds a block to the end of the active list.                  *
  *   FixedIHeapClass::Allocate -- Allocate an object from the heap.                            *
  *   FixedIHeapClass::Clear -- Clears the fixed heap of all entries.                           *
  *   FixedIHeapClass::Free -- Frees an object in the heap.                                     *
@@ -180,11 +181,11 @@ int FixedHeapClass::Set_Heap(int count, void* buffer)
     **	Initialize the free boolean vector and the buffer for the actual
     **	allocation objects.
     */
-    if (FreeFlag.Resize(count)) {
+    if (FreeSlots.Resize(count)) {
         if (!buffer) {
-            buffer = new char[count * Size];
+            buffer = new (Memory_Tag_Flag(MEM_TAG_HEAP)) char[count * Size];
             if (!buffer) {
-                FreeFlag.Clear();
+                FreeSlots.Clear();
                 return (false);
             }
             IsAllocated = true;
@@ -215,11 +216,11 @@ int FixedHeapClass::Set_Heap(int count, void* buffer)
 void* FixedHeapClass::Allocate(void)
 {
     if (ActiveCount < TotalCount) {
-        int index = FreeFlag.First_False();
+        int index = FreeSlots.First_Free();
 
         if (index != -1) {
             ActiveCount++;
-            FreeFlag[index] = true;
+            FreeSlots.Take(index);
             return ((*this)[index]);
         }
     }
@@ -247,10 +248,10 @@ int FixedHeapClass::Free(void* pointer)
     if (pointer && ActiveCount) {
         int index = ID(pointer);
 
-        if (index < TotalCount) {
-            if (FreeFlag[index]) {
+        if (index >= 0 && index < TotalCount) {
+            if (!FreeSlots.Is_Free(index)) {
                 ActiveCount--;
-                FreeFlag[index] = false;
+                FreeSlots.Give(index);
                 return (true);
             }
         }
@@ -311,7 +312,7 @@ void FixedHeapClass::Clear(void)
     IsAllocated = false;
     ActiveCount = 0;
     TotalCount = 0;
-    FreeFlag.Clear();
+    FreeSlots.Clear();
 }
 
 /***********************************************************************************************
@@ -332,7 +333,7 @@ void FixedHeapClass::Clear(void)
 int FixedHeapClass::Free_All(void)
 {
     ActiveCount = 0;
-    FreeFlag.Reset();
+    FreeSlots.Reset();
     return (true);
 }
 
@@ -355,7 +356,7 @@ int FixedHeapClass::Free_All(void)
  *=============================================================================================*/
 int FixedIHeapClass::Free_All(void)
 {
-    ActivePointers.Delete_All();
+    ActiveList.Reset();
     return (FixedHeapClass::Free_All());
 }
 
@@ -378,7 +379,7 @@ int FixedIHeapClass::Free_All(void)
 void FixedIHeapClass::Clear(void)
 {
     FixedHeapClass::Clear();
-    ActivePointers.Clear();
+    ActiveList.Clear();
 }
 
 /***********************************************************************************************
@@ -403,7 +404,7 @@ int FixedIHeapClass::Set_Heap(int count, void* buffer)
 {
     Clear();
     if (FixedHeapClass::Set_Heap(count, buffer)) {
-        ActivePointers.Resize(count);
+        ActiveList.Resize(count);
         return (true);
     }
     return (false);
@@ -428,7 +429,7 @@ void* FixedIHeapClass::Allocate(void)
 {
     void* ptr = FixedHeapClass::Allocate();
     if (ptr) {
-        ActivePointers.Add(ptr);
+        Activate(ID(ptr));
         memset(ptr, 0, Size);
     }
     return (ptr);
@@ -453,11 +454,34 @@ void* FixedIHeapClass::Allocate(void)
 int FixedIHeapClass::Free(void* pointer)
 {
     if (FixedHeapClass::Free(pointer)) {
-        ActivePointers.Delete(pointer);
+        /*
+        **	The last active block moves into the hole left by this one. The order
+        **	of the active blocks only depends on the order they were allocated
+        **	and freed in, so it stays the same on every machine in a game.
+        */
+        ActiveList.Remove(ID(pointer));
     }
     return (false);
 }
 
+/***********************************************************************************************
+ * FixedIHeapClass::Activate -- Adds a block to the end of the active list.                    *
+ *                                                                                             *
+ *    This routine records a block that has just been taken from the free list as active, so   *
+ *    that it will be included in iteration through the active objects.                        *
+ *                                                                                             *
+ * INPUT:   index -- The index number of the block to activate.                                *
+ *                                                                                             *
+ * OUTPUT:  none                                                                               *
+ *                                                                                             *
+ * WARNINGS:   The block must not already be in the active list.                               *
+ *                                                                                             *
+ *=============================================================================================*/
+void FixedIHeapClass::Activate(int index)
+{
+    ActiveList.Add(index, (*this)[index]);
+}
+
 /***********************************************************************************************
  * FixedIHeapClass::Logical_ID -- Fetches the logical ID number.                               *
  *                                                                                             *
@@ -471,7 +495,7 @@ int FixedIHeapClass::Free(void* pointer)
  *          be used as a regular index into the heap until such time as the heap has been      *
  *          compacted (by some means or another) without modifying the block order.            *
  *                                                                                             *
- * WARNINGS:   Runs in linear time.                                                            *
+ * WARNINGS:   none                                                                            *
  *                                                                                             *
  * HISTORY:                                                                                    *
  *   05/06/1996 JLB : Created.                                                                 *
@@ -479,11 +503,7 @@ int FixedIHeapClass::Free(void* pointer)
 int FixedIHeapClass::Logical_ID(void const* pointer) const
 {
     if (pointer != NULL) {
-        for (int index = 0; index < Count(); index++) {
-            if (Active_Ptr(index) == pointer) {
-                return (index);
-            }
-        }
+        return (ActiveList.Position(ID(pointer)));
     }
     return (-1);
 }
@@ -576,10 +596,13 @@ template <class T> int TFixedIHeapClass<T>::Load(Straw& file)
         /*
         ** Get a pointer to the object, activate that object
         */
+        if (idx < 0 || idx >= TotalCount || !FreeSlots.Is_Free(idx)) {
+            return (false);
+        }
         ptr = (T*)(*this)[idx];
-        FreeFlag[idx] = true;
+        FreeSlots.Take(idx);
         ActiveCount++;
-        ActivePointers.Add(ptr);
+        Activate(idx);
 
         /*
         ** Load the object
@@ -36,6 +36,8 @@
 #define HEAP_H
 
 #include "vector.h"
+#include "freeslot.h"
+#include "activelist.h"
 #include "pipe.h"
 #include "straw.h"
 
@@ -110,9 +112,10 @@ protected:
     void* Buffer;
 
     /*
-    **	This is a boolean vector array of allocation flag bits.
+    **	This is a bit array of the free blocks. It hands out the lowest numbered
+    **	free block without examining every flag.
     */
-    BooleanVectorClass FreeFlag;
+    FreeSlotClass FreeSlots;
 
 private:
     // The assignment operator is not supported.
@@ -160,8 +163,9 @@ public:
 /**************************************************************************
 **	This is a derivative of the fixed heap class. This class adds the
 **	ability to quickly iterate through the active (allocated) objects. Since the
-**	active array is a sequence of pointers, the overhead of this class
-**	is 4 bytes per potential allocated object (be warned).
+**	active array is a sequence of pointers, along with the position of each
+**	block in that array, the overhead of this class is a pointer and two
+**	integers per potential allocated object (be warned).
 */
 class FixedIHeapClass : public FixedHeapClass
 {
@@ -183,20 +187,22 @@ public:
 
     virtual void* Active_Ptr(int index)
     {
-        return ActivePointers[index];
+        return ActiveList[index];
     };
     virtual void const* Active_Ptr(int index) const
     {
-        return ActivePointers[index];
+        return ActiveList[index];
     };
 
+protected:
+    void Activate(int index);
+
     /*
-    **	This is an array of pointers to allocated objects. Using this array
-    **	to control iteration through the objects ensures a minimum of processing.
-    **	It also allows access to this array so that custom sorting can be
-    **	performed.
+    **	The allocated objects in iteration order. Using this list to control
+    **	iteration through the objects ensures a minimum of processing, and it
+    **	knows where each block is in the order so freeing one doesn't search.
     */
-    DynamicVectorClass<void*> ActivePointers;
+    ActiveListClass ActiveList;
 };
 
 /**************************************************************************
@@ -243,7 +249,7 @@ public:
 
     virtual T* Ptr(int index) const
     {
-        return (T*)FixedIHeapClass::ActivePointers[index];
+        return (T*)FixedIHeapClass::ActiveList[index];
     };
     virtual T* Raw_Ptr(int index)
     {
@@ -1540,6 +1540,23 @@ bool Parse_Command_Line(int argc, char* argv[])
             continue;
         }
 
+        /*
+        **	Write the memory accounting to memory.txt on exit.
+        */
+        if (stricmp(string, "-MEMREPORT") == 0) {
+            Debug_Memory_Report = true;
+            continue;
+        }
+
+        /*
+        **	Playback speed for a recording: 1 is as recorded, higher runs that many
+        **	frames for each one shown, and 0 runs as fast as possible.
+        */
+        if (strstr(string, "-PLAYSPEED:")) {
+            Queue_Playback_Speed(atoi(string + strlen("-PLAYSPEED:")));
+            continue;
+        }
+
 #ifdef CHEAT_KEYS
         /*
         **	Specify the random number seed (for debugging)
@@ -2795,6 +2812,7 @@ static void Init_Keys(void)
  *=========================================================================*/
 bool Save_Recording_Values(CCFileClass& file)
 {
+    Queue_Record_Header(file);
     Session.Save(file);
     file.Write(&BuildLevel, sizeof(BuildLevel));
     file.Write(&Debug_Unshroud, sizeof(Debug_Unshroud));
@@ -2825,6 +2843,7 @@ bool Save_Recording_Values(CCFileClass& file)
  *=========================================================================*/
 bool Load_Recording_Values(CCFileClass& file)
 {
+    Queue_Playback_Header(file);
     Session.Load(file);
     file.Read(&BuildLevel, sizeof(BuildLevel));
     file.Read(&Debug_Unshroud, sizeof(Debug_Unshroud));
@@ -32,7 +32,6 @@
  * All map-related loading/saving routines should go in this module, so it can be overlayed.   *
  *---------------------------------------------------------------------------------------------*
  * Functions:                                                                                  *
- *   CellClass::Code_Pointers -- codes class's pointers for load/save                          *
  *   CellClass::Decode_Pointers -- decodes pointers for load/save                              *
  *   CellClass::Load -- Reads from a save game file.                                           *
  *   CellClass::Save -- Write to a save game file.                                             *
@@ -46,6 +45,7 @@
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 #include "function.h"
+#include "common/savefield.h"
 
 /***********************************************************************************************
  * CellClass::Should_Save -- Should the cell be written to disk?                               *
@@ -83,7 +83,70 @@ bool CellClass::Should_Save(void) const
  *=============================================================================================*/
 bool CellClass::Load(Straw& file)
 {
-    file.Get(this, sizeof(*this));
+    if (SaveFormat == SAVEFORMAT_IMAGE) {
+        file.Get(this, sizeof(*this));
+        return (true);
+    }
+
+    unsigned char flags = 0;
+    int trigger = 0;
+    int occupier = TARGET_NONE;
+    int overlappers[ARRAY_SIZE(Overlapper)];
+    int flag = TARGET_NONE;
+
+    FieldRecord record;
+    if (!record.Read(file)) {
+        return (false);
+    }
+
+    record.Get(flags);
+    record.Get(Zones);
+    record.Get(Jammed);
+    record.Get(trigger);
+    record.Get(TType);
+    record.Get(TIcon);
+    record.Get(Overlay);
+    record.Get(OverlayData);
+    record.Get(Smudge);
+    record.Get(SmudgeData);
+    record.Get(Owner);
+    record.Get(InfType);
+    record.Get(IsMappedByPlayerMask);
+    record.Get(IsVisibleByPlayerMask);
+    record.Get(Flag.Composite);
+    record.Get(Land);
+    record.Get(OverrideLand);
+    record.Get(occupier);
+    record.Get_Target_Slots(overlappers);
+    record.Get(flag);
+
+    if (!record.Is_Done()) {
+        return (false);
+    }
+
+    IsPlot = (flags & 0x01) != 0;
+    IsCursorHere = (flags & 0x02) != 0;
+    IsMapped = (flags & 0x04) != 0;
+    IsVisible = (flags & 0x08) != 0;
+    IsWaypoint = (flags & 0x10) != 0;
+    IsRadarCursor = (flags & 0x20) != 0;
+    IsFlagged = (flags & 0x40) != 0;
+    IsToShroud = (flags & 0x80) != 0;
+
+    Trigger.Set_Raw(trigger);
+
+    /*
+    **	The map is loaded before the object heaps, so the objects themselves aren't there yet. A target only names
+    **	a heap slot though, and As_Object without the active check just works out the slot's address, which stays
+    **	the same once the heaps have loaded. Nothing about the object may be looked at here.
+    */
+    OccupierPtr = (occupier != TARGET_NONE) ? As_Object(occupier, false) : NULL;
+
+    for (int index = 0; index < ARRAY_SIZE(Overlapper); index++) {
+        Overlapper[index] = (overlappers[index] != TARGET_NONE) ? As_Object(overlappers[index], false) : NULL;
+    }
+
+    CTFFlag = (flag != TARGET_NONE) ? As_Animation(flag, false) : NULL;
     return (true);
 }
 
@@ -101,45 +164,50 @@ bool CellClass::Load(Straw& file)
  *=============================================================================================*/
 bool CellClass::Save(Pipe& file) const
 {
-    file.Put(this, sizeof(*this));
-    return (true);
-}
-
-/***********************************************************************************************
- * CellClass::Code_Pointers -- codes class's pointers for load/save                            *
- *                                                                                             *
- * This routine "codes" the pointers in the class by converting them to a number               *
- * that still represents the object pointed to, but isn't actually a pointer.  This            *
- * allows a saved game to properly load without relying on the games data still                *
- * being in the exact same location.                                                           *
- *                                                                                             *
- * INPUT:                                                                                      *
- *      none.                                                                                  *
- *                                                                                             *
- * OUTPUT:                                                                                     *
- *      none.                                                                                  *
- *                                                                                             *
- * WARNINGS:                                                                                   *
- *      none.                                                                                  *
- *                                                                                             *
- * HISTORY:                                                                                    *
- *   01/02/1995 BR : Created.                                                                  *
- *=============================================================================================*/
-void CellClass::Code_Pointers(void)
-{
-    if (Cell_Occupier() != NULL) {
-        OccupierPtr = (ObjectClass*)OccupierPtr->As_Target();
-    }
+    unsigned char flags = IsPlot | (IsCursorHere << 1) | (IsMapped << 2) | (IsVisible << 3) | (IsWaypoint << 4)
+                          | (IsRadarCursor << 5) | (IsFlagged << 6) | (IsToShroud << 7);
+    int trigger = (int)Trigger.Raw();
+    int occupier = (Cell_Occupier() != NULL) ? Cell_Occupier()->As_Target() : TARGET_NONE;
 
+    /*
+    **	Only overlappers still in play are kept.
+    */
+    int overlappers[ARRAY_SIZE(Overlapper)];
     for (int index = 0; index < ARRAY_SIZE(Overlapper); index++) {
-        if (Overlapper[index] != NULL && Overlapper[index]->IsActive) {
-            Overlapper[index] = (ObjectClass*)Overlapper[index]->As_Target();
-        } else {
-            Overlapper[index] = NULL;
-        }
+        overlappers[index] = (Overlapper[index] != NULL && Overlapper[index]->IsActive)
+                                 ? (int)Overlapper[index]->As_Target()
+                                 : TARGET_NONE;
     }
 
-    assert(CTFFlag == NULL);
+    /*
+    **	The flag animation is kept too, so saving doesn't have to take the flag down and let the house put it back.
+    */
+    int flag = (CTFFlag != NULL) ? (int)CTFFlag->As_Target() : TARGET_NONE;
+
+    FieldRecord record;
+    record.Put(flags);
+    record.Put(Zones);
+    record.Put(Jammed);
+    record.Put(trigger);
+    record.Put(TType);
+    record.Put(TIcon);
+    record.Put(Overlay);
+    record.Put(OverlayData);
+    record.Put(Smudge);
+    record.Put(SmudgeData);
+    record.Put(Owner);
+    record.Put(InfType);
+    record.Put(IsMappedByPlayerMask);
+    record.Put(IsVisibleByPlayerMask);
+    record.Put(Flag.Composite);
+    record.Put(Land);
+    record.Put(OverrideLand);
+    record.Put(occupier);
+    record.Put_Target_Slots(overlappers);
+    record.Put(flag);
+    record.Write(file);
+
+    return (true);
 }
 
 /***********************************************************************************************
@@ -471,17 +539,10 @@ void DisplayClass::Decode_Pointers(void)
  *=============================================================================================*/
 void MapClass::Code_Pointers(void)
 {
-    CELL cell;
-
-    for (cell = 0; cell < MAP_CELL_TOTAL; cell++) {
-        (*this)[cell].Flag_Destroy();
-    }
-
-    CellClass* cellptr = &(*this)[(CELL)0];
-    for (cell = 0; cell < MAP_CELL_TOTAL; cell++) {
-        cellptr->Code_Pointers();
-        cellptr++;
-    }
+    /*
+    **	The cells write their objects and flags as targets when they are saved, so
+    **	there is nothing to code here.
+    */
 }
 
 /***********************************************************************************************
@@ -504,6 +565,13 @@ void MapClass::Code_Pointers(void)
  *=============================================================================================*/
 void MapClass::Decode_Pointers(void)
 {
+    /*
+    **	Only cells loaded as memory images hold coded pointers.
+    */
+    if (SaveFormat != SAVEFORMAT_IMAGE) {
+        return;
+    }
+
     CellClass* cellptr = &(*this)[(CELL)0];
     for (CELL cell = 0; cell < MAP_CELL_TOTAL; cell++) {
         cellptr->Decode_Pointers();
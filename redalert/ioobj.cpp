@@ -40,7 +40,6 @@
  *   FootClass::Decode_Pointers -- decodes pointers for load/save                              *
  *   HouseClass::Code_Pointers -- codes class's pointers for load/save                         *
  *   HouseClass::Decode_Pointers -- decodes pointers for load/save                             *
- *   LayerClass::Code_Pointers -- codes class's pointers for load/save                         *
  *   LayerClass::Decode_Pointers -- decodes pointers for load/save                             *
  *   LayerClass::Load -- Reads from a save game file.                                          *
  *   LayerClass::Save -- Write to a save game file.                                            *
@@ -64,6 +63,7 @@
 
 #include "function.h"
 #include "factory.h"
+#include "common/savefield.h"
 
 /***********************************************************************************************
  * TeamTypeClass::Code_Pointers -- codes class's pointers for load/save                        *
@@ -393,12 +393,22 @@ bool LayerClass::Load(Straw& file)
     Clear();
 
     /*
-    **	Read in all array elements
+    **	Read in all array elements. Older saves hold coded pointers that are decoded later,
+    **	newer ones hold targets for objects that are already loaded.
     */
     for (int index = 0; index < count; index++) {
         ObjectClass* ptr;
-        if (file.Get(&ptr, sizeof(ObjectClass*)) != sizeof(ObjectClass*)) {
-            return (false);
+        if (SaveFormat == SAVEFORMAT_IMAGE) {
+            if (file.Get(&ptr, sizeof(ObjectClass*)) != sizeof(ObjectClass*)) {
+                return (false);
+            }
+        } else {
+            int target;
+            if (!Get_Field(file, target)) {
+                return (false);
+            }
+            ptr = As_Object(target, false);
+            assert(ptr != NULL);
         }
         Add(ptr);
     }
@@ -430,42 +440,13 @@ bool LayerClass::Save(Pipe& file) const
     **	Save all elements
     */
     for (int index = 0; index < count; index++) {
-        ObjectClass* ptr = (*this)[index];
-        file.Put(&ptr, sizeof(ObjectClass*));
+        int target = (*this)[index]->As_Target();
+        Put_Field(file, target);
     }
 
     return (true);
 }
 
-/***********************************************************************************************
- * LayerClass::Code_Pointers -- codes class's pointers for load/save                           *
- *                                                                                             *
- * This routine "codes" the pointers in the class by converting them to a number               *
- * that still represents the object pointed to, but isn't actually a pointer.  This            *
- * allows a saved game to properly load without relying on the games data still                *
- * being in the exact same location.                                                           *
- *                                                                                             *
- * INPUT:                                                                                      *
- *      none.                                                                                  *
- *                                                                                             *
- * OUTPUT:                                                                                     *
- *      none.                                                                                  *
- *                                                                                             *
- * WARNINGS:                                                                                   *
- *      none.                                                                                  *
- *                                                                                             *
- * HISTORY:                                                                                    *
- *   01/02/1995 BR : Created.                                                                  *
- *=============================================================================================*/
-void LayerClass::Code_Pointers(void)
-{
-    for (int index = 0; index < Count(); index++) {
-        ObjectClass* obj = (*this)[index];
-        assert(obj != NULL);
-        (*this)[index] = (ObjectClass*)(obj->As_Target());
-    }
-}
-
 /***********************************************************************************************
  * LayerClass::Decode_Pointers -- decodes pointers for load/save                               *
  *                                                                                             *
@@ -486,6 +467,10 @@ void LayerClass::Code_Pointers(void)
  *=============================================================================================*/
 void LayerClass::Decode_Pointers(void)
 {
+    if (SaveFormat != SAVEFORMAT_IMAGE) {
+        return;
+    }
+
     for (int index = 0; index < Count(); index++) {
         TARGET target = (TARGET)(*this)[index];
         (*this)[index] = (ObjectClass*)As_Object(target, false);
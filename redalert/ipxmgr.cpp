@@ -56,6 +56,8 @@
  *   IPXManagerClass::Set_Bridge -- prepares to cross a bridge             *
  *   IPXManagerClass::Set_Socket -- sets socket ID for all connections		*
  *   IPXManagerClass::Response_Time -- Returns largest Avg Response Time   *
+ *   IPXManagerClass::Response_Time_Percentile -- Largest percentile time  *
+ *   IPXManagerClass::Response_Jitter -- Largest response time jitter      *
  *   IPXManagerClass::Global_Response_Time -- Returns Avg Response Time    *
  *   IPXManagerClass::Reset_Response_Time -- Reset response time 				*
  *   IPXManagerClass::Oldest_Send -- gets ptr to oldest send buf           *
@@ -1422,6 +1424,68 @@ unsigned long IPXManagerClass::Response_Time(void)
 
 } /* end of Response_Time */
 
+/***************************************************************************
+ * IPXManagerClass::Response_Time_Percentile -- Largest percentile time    *
+ *                                                                         *
+ * Like Response_Time, but uses the given percentile of each connection's	*
+ * recent response times instead of its average, so occasional slow 		*
+ * packets aren't averaged away.															*
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		percent		percentile to use, 1-100											*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		largest response time at that percentile										*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *=========================================================================*/
+unsigned long IPXManagerClass::Response_Time_Percentile(int percent)
+{
+    unsigned long resp;
+    unsigned long maxresp = 0;
+    int i;
+
+    for (i = 0; i < NumConnections; i++) {
+        resp = Connection[i]->Queue->Response_Time_Percentile(percent);
+        if (resp > maxresp) {
+            maxresp = resp;
+        }
+    }
+
+    return (maxresp);
+
+} /* end of Response_Time_Percentile */
+
+/***************************************************************************
+ * IPXManagerClass::Response_Jitter -- Largest response time jitter        *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		percent		percentile of the change between successive times			*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		largest jitter of any connection													*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *=========================================================================*/
+unsigned long IPXManagerClass::Response_Jitter(int percent)
+{
+    unsigned long jitter;
+    unsigned long maxjitter = 0;
+    int i;
+
+    for (i = 0; i < NumConnections; i++) {
+        jitter = Connection[i]->Queue->Response_Jitter(percent);
+        if (jitter > maxjitter) {
+            maxjitter = jitter;
+        }
+    }
+
+    return (maxjitter);
+
+} /* end of Response_Jitter */
+
 /***************************************************************************
  * IPXManagerClass::Global_Response_Time -- Returns Avg Response Time      *
  *                                                                         *
@@ -224,6 +224,8 @@ public:
     reset the response time for all queues.
     .....................................................................*/
     virtual unsigned long Response_Time(void);
+    virtual unsigned long Response_Time_Percentile(int percent);
+    virtual unsigned long Response_Jitter(int percent);
     unsigned long Global_Response_Time(void);
     virtual void Reset_Response_Time(void);
 
@@ -58,7 +58,6 @@ public:
     */
     bool Load(Straw& file);
     bool Save(Pipe& file) const;
-    virtual void Code_Pointers(void);
     virtual void Decode_Pointers(void);
 };
 
@@ -35,12 +35,16 @@
  *   MapClass::Cell_Threat -- Gets a houses threat value for a cell                            *
  *   MapClass::Close_Object -- Finds a clickable close object to the specified coordinate.     *
  *   MapClass::Destroy_Bridge_At -- Destroyes the bridge at location specified.                *
+ *   MapClass::Flag_All_Changed -- Marks the whole map as changed.                             *
+ *   MapClass::Flag_Occupier_Changed -- Records that the occupiers of a cell changed.          *
+ *   MapClass::Flag_Shroud_Changed -- Records that the shroud over a cell changed.             *
  *   MapClass::Detach -- Remove specified object from map references.                          *
  *   MapClass::In_Radar -- Is specified cell in the radar map?                                 *
  *   MapClass::Init -- clears all cells                                                        *
  *   MapClass::Intact_Bridge_Count -- Determine the number of intact bridges.                  *
  *   MapClass::Logic -- Handles map related logic functions.                                   *
  *   MapClass::Nearby_Location -- Finds a generally clear location near a specified cell.      *
+ *   MapClass::Next_Change_Generation -- Ends the current change generation.                   *
  *   MapClass::One_Time -- Performs special one time initializations for the map.              *
  *   MapClass::Overlap_Down -- computes & marks object's overlap cells                         *
  *   MapClass::Overlap_Up -- Computes & clears object's overlap cells                          *
@@ -380,6 +384,10 @@ int const MapClass::RadiusCount[11] = {1, 9, 21, 37, 61, 89, 121, 161, 205, 253,
 
 CellClass* BlubCell;
 
+long MapClass::ChangeGeneration = 0;
+long MapClass::ShroudChanged[CHANGE_BLOCK_COUNT];
+long MapClass::OccupierChanged[CHANGE_BLOCK_COUNT];
+
 /***********************************************************************************************
  * MapClass::One_Time -- Performs special one time initializations for the map.                *
  *                                                                                             *
@@ -430,6 +438,7 @@ void MapClass::Init_Clear(void)
 {
     GScreenClass::Init_Clear();
     Init_Cells();
+    Flag_All_Changed();
     TiberiumScan = 0;
     TiberiumGrowthCount = 0;
     TiberiumGrowthExcess = 0;
@@ -465,6 +474,8 @@ void MapClass::Alloc_Cells(void)
     **	(it may have been loaded from a save-game file), so zero it out first.
     */
     new (&Array) VectorClass<CellClass>;
+
+    MemoryTagClass tag(MEM_TAG_MAP);
     Array.Resize(Size);
 }
 
@@ -1017,6 +1028,7 @@ void MapClass::Place_Down(CELL cell, ObjectClass* object)
             CELL newcell = cell + *list++;
             if ((unsigned)newcell < MAP_CELL_TOTAL) {
                 (*this)[newcell].Occupy_Down(object);
+                Flag_Occupier_Changed(newcell);
                 (*this)[newcell].Recalc_Attributes();
                 (*this)[newcell].Redraw_Objects();
             }
@@ -1065,6 +1077,7 @@ void MapClass::Pick_Up(CELL cell, ObjectClass* object)
             CELL newcell = cell + *list++;
             if ((unsigned)newcell < MAP_CELL_TOTAL) {
                 (*this)[newcell].Occupy_Up(object);
+                Flag_Occupier_Changed(newcell);
                 (*this)[newcell].Recalc_Attributes();
                 (*this)[newcell].Redraw_Objects();
             }
@@ -1082,6 +1095,90 @@ void MapClass::Pick_Up(CELL cell, ObjectClass* object)
     }
 }
 
+/***********************************************************************************************
+ * MapClass::Flag_Shroud_Changed -- Records that the shroud over a cell changed.               *
+ *                                                                                             *
+ *    The block holding the cell is stamped with the current generation. A cell's shadow      *
+ *    piece depends on the cells around it, so the blocks holding those are stamped as well.   *
+ *                                                                                             *
+ * INPUT:   cell  -- The cell that was mapped, shrouded, jammed or unjammed.                   *
+ *                                                                                             *
+ * OUTPUT:  none                                                                               *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *                                                                                             *
+ *=============================================================================================*/
+void MapClass::Flag_Shroud_Changed(CELL cell)
+{
+    int x1 = max(Cell_X(cell) - 1, 0) >> CHANGE_BLOCK_SHIFT;
+    int x2 = min(Cell_X(cell) + 1, MAP_CELL_W - 1) >> CHANGE_BLOCK_SHIFT;
+    int y1 = max(Cell_Y(cell) - 1, 0) >> CHANGE_BLOCK_SHIFT;
+    int y2 = min(Cell_Y(cell) + 1, MAP_CELL_H - 1) >> CHANGE_BLOCK_SHIFT;
+
+    for (int y = y1; y <= y2; y++) {
+        for (int x = x1; x <= x2; x++) {
+            ShroudChanged[y * CHANGE_BLOCK_W + x] = ChangeGeneration;
+        }
+    }
+}
+
+/***********************************************************************************************
+ * MapClass::Flag_Occupier_Changed -- Records that the occupiers of a cell changed.            *
+ *                                                                                             *
+ * INPUT:   cell  -- The cell that an object was placed on or picked up from.                  *
+ *                                                                                             *
+ * OUTPUT:  none                                                                               *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *                                                                                             *
+ *=============================================================================================*/
+void MapClass::Flag_Occupier_Changed(CELL cell)
+{
+    OccupierChanged[(Cell_Y(cell) >> CHANGE_BLOCK_SHIFT) * CHANGE_BLOCK_W + (Cell_X(cell) >> CHANGE_BLOCK_SHIFT)] =
+        ChangeGeneration;
+}
+
+/***********************************************************************************************
+ * MapClass::Flag_All_Changed -- Marks the whole map as changed.                               *
+ *                                                                                             *
+ *    Used when the map is cleared for a new scenario, when a game is loaded and when the      *
+ *    whole map is shrouded at once. Every block is stamped with the current generation, which *
+ *    is newer than any reply already handed out.                                              *
+ *                                                                                             *
+ * INPUT:   none                                                                               *
+ *                                                                                             *
+ * OUTPUT:  none                                                                               *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *                                                                                             *
+ *=============================================================================================*/
+void MapClass::Flag_All_Changed(void)
+{
+    for (int index = 0; index < CHANGE_BLOCK_COUNT; index++) {
+        ShroudChanged[index] = ChangeGeneration;
+        OccupierChanged[index] = ChangeGeneration;
+    }
+}
+
+/***********************************************************************************************
+ * MapClass::Next_Change_Generation -- Ends the current change generation.                     *
+ *                                                                                             *
+ *    An export calls this once it has read the changed blocks. Changes made after this are    *
+ *    stamped with a later generation, so the next export asking for changes after the         *
+ *    returned one will get them.                                                              *
+ *                                                                                             *
+ * INPUT:   none                                                                               *
+ *                                                                                             *
+ * OUTPUT:  Returns with the generation that has just ended.                                   *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *                                                                                             *
+ *=============================================================================================*/
+long MapClass::Next_Change_Generation(void)
+{
+    return (ChangeGeneration++);
+}
+
 /***********************************************************************************************
  * MapClass::Overlap_Down -- computes & marks object's overlap cells                           *
  *                                                                                             *
@@ -2547,6 +2644,7 @@ void MapClass::Shroud_The_Map(HouseClass* house)
             }
         }
     }
+    Flag_All_Changed();
     for (int obj_index = 0; obj_index < DisplayClass::Layer[LAYER_GROUND].Count(); obj_index++) {
         ObjectClass* layer_object = DisplayClass::Layer[LAYER_GROUND][obj_index];
         if (layer_object && layer_object->Is_Techno() && ((TechnoClass*)layer_object)->House == house) {
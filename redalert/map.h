@@ -95,6 +95,27 @@ public:
     void Detach(TARGET target, bool all = true);
     void Shroud_The_Map(HouseClass* house);
 
+    /*
+    **	Records the change generation that the shroud or the occupiers last changed in for each block of cells, so
+    **	that exports can send only the parts of the map that changed. The generation only ever goes up, even when
+    **	the map is cleared, a game is loaded or playback seeks back, so a reply from before any of those still
+    **	compares correctly. These are kept outside the map object so they don't become part of its saved image.
+    */
+    enum ChangeBlockEnum
+    {
+        CHANGE_BLOCK_SHIFT = 4,
+        CHANGE_BLOCK_W = MAP_CELL_W >> CHANGE_BLOCK_SHIFT,
+        CHANGE_BLOCK_H = MAP_CELL_H >> CHANGE_BLOCK_SHIFT,
+        CHANGE_BLOCK_COUNT = CHANGE_BLOCK_W * CHANGE_BLOCK_H
+    };
+    static void Flag_Shroud_Changed(CELL cell);
+    static void Flag_Occupier_Changed(CELL cell);
+    static void Flag_All_Changed(void);
+    static long Next_Change_Generation(void);
+    static long ChangeGeneration;
+    static long ShroudChanged[CHANGE_BLOCK_COUNT];
+    static long OccupierChanged[CHANGE_BLOCK_COUNT];
+
     long Overpass(void);
 
     virtual void Logic(void);
@@ -58,6 +58,10 @@
  *   Breakup_Receive_Packet -- Splits a big packet into little ones.			*
  *   Extract_Uncompressed_Events -- extracts events from a packet				*
  *   Extract_Compressed_Events -- extracts events from a packet            *
+ *   Event_Data -- returns the part of an event that goes on the wire      *
+ *   Add_Packed_Events -- adds bit packed events to a packet               *
+ *   Extract_Packed_Header -- reads the FRAMEINFO header of a packet       *
+ *   Extract_Packed_Events -- extracts bit packed events from a packet     *
  *                                                                         *
  * DoList Management:																		*
  *   Execute_DoList -- Executes commands from the DoList                   *
@@ -76,6 +80,17 @@
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 #include "function.h"
 #include "msgbox.h"
+#include "common/eventpack.h"
+#include "common/lcwpipe.h"
+#include "common/lcwstraw.h"
+#include "common/xpipe.h"
+#include "common/xstraw.h"
+#include "common/latency.h"
+#include "common/linksim.h"
+
+#if defined(NETWORKING) && !defined(_WIN32)
+#include "wsproto.h"
+#endif
 
 #ifdef WOLAPI_INTEGRATION
 //#include "WolDebug.h"
@@ -109,6 +124,94 @@ int NetMonoMode = 1;
 int NewMonoMode = 1;
 static int IsMono = 0;
 
+//...........................................................................
+// Packet statistics, logged when the game stops:
+// PacketBytesSent: total size of the meta-packets we've built
+// PacketBytesReceived: total size of the meta-packets we've been sent
+// PacketStartFrame: frame the first packet went out on
+//...........................................................................
+static unsigned long PacketBytesSent = 0;
+static unsigned long PacketBytesReceived = 0;
+static long PacketStartFrame = -1;
+
+//...........................................................................
+// Frame delay control, for the game host:
+// FrameDelay: picks 'MaxAhead' from the 95th percentile response time and
+//   the median jitter; evaluated every 32 frames, published in a TIMING event
+//   whenever it changes and every 128 frames regardless.
+//...........................................................................
+static FrameDelayClass FrameDelay;
+
+//...........................................................................
+// Recording keyframes:
+// A recording that starts with RECORD_KEYFRAME_ID holds the whole game state,
+// LCW compressed, in front of the events of every KEYFRAME_RATE'th recorded
+// frame, so playback can jump to one and run on from there. The header also
+// has room for the file position of an index of the keyframes, which is
+// written at the end of the file when recording stops.
+// KeyframeRate: frames between keyframes; 0 if the file has none
+// NextKeyframe: the first frame the next keyframe can be on
+// KeyframeIndexPos: where the index position goes in the header
+// PlaybackEnd: file position the recorded frames stop at; 0 = end of file
+// SeekTarget: frame playback is running forward to as fast as it can
+// SeekFrame: frame a seek has been asked for, done at the next keyframe point
+//...........................................................................
+#define RECORD_KEYFRAME_ID  0x464B4152 // "RAKF"
+#define KEYFRAME_RATE       (TICKS_PER_MINUTE)
+#define KEYFRAME_BLOCK_SIZE 4096
+
+typedef struct KeyframeHeaderType
+{
+    int Frame;
+    unsigned int CRC; // Game CRC on the keyframe's frame.
+    int Size;         // Compressed bytes that follow.
+    int Length;       // Bytes of game state once expanded.
+} KeyframeHeaderType;
+
+struct KeyframeIndexType
+{
+    int Frame;
+    int Offset; // File position of the keyframe's header.
+
+    bool operator==(KeyframeIndexType const& entry) const
+    {
+        return (Frame == entry.Frame && Offset == entry.Offset);
+    }
+    bool operator!=(KeyframeIndexType const& entry) const
+    {
+        return (!(*this == entry));
+    }
+};
+
+static int KeyframeRate = 0;
+static long NextKeyframe = 0;
+static long KeyframeIndexPos = 0;
+static long PlaybackEnd = 0;
+static long SeekTarget = -1;
+static long SeekFrame = -1;
+static DynamicVectorClass<KeyframeIndexType> Keyframes;
+
+//...........................................................................
+// Playback speed:
+// PlaybackSpeed: 1 = the recorded speed, N = N frames run for each one shown,
+//   0 = as fast as possible, showing a frame every PLAYBACK_SHOW_TICKS
+// PlaybackShown: whether the frame being run is drawn and waited for
+// PlaybackSkipped: frames run since the last one shown
+// PlaybackShownTime: TickCount when a frame was last shown
+// PlaybackReportFrames, PlaybackReportTime: frames run since the simulated
+//   frame rate was last reported, and when that was
+//...........................................................................
+#define PLAYBACK_SPEED_MAX    64
+#define PLAYBACK_SHOW_TICKS   (TIMER_SECOND / 20)
+#define PLAYBACK_REPORT_TICKS (TIMER_SECOND * 5)
+
+static int PlaybackSpeed = 1;
+static bool PlaybackShown = true;
+static int PlaybackSkipped = 0;
+static long PlaybackShownTime = 0;
+static long PlaybackReportFrames = 0;
+static long PlaybackReportTime = 0;
+
 //---------------------------------------------------------------------------
 // Several routines return various codes; here's an enum for all of them.
 //---------------------------------------------------------------------------
@@ -146,7 +249,7 @@ static RetcodeType Wait_For_Players(int first_time,
                                     unsigned short* their_sent,
                                     unsigned short* their_recv);
 static void Generate_Timing_Event(ConnManClass* net, int my_sent);
-static void Generate_Real_Timing_Event(ConnManClass* net, int my_sent);
+static void Generate_Real_Timing_Event(ConnManClass* net, int my_sent, int heartbeat);
 static void Generate_Process_Time_Event(ConnManClass* net);
 static int Process_Send_Period(ConnManClass* net); //, int init);
 static int Send_Packets(ConnManClass* net, char* multi_packet_buf, int multi_packet_max, int max_ahead, int my_sent);
@@ -181,6 +284,10 @@ static int Add_Compressed_Events(void* buf, int bufsize, int frame_delay, int si
 static int Breakup_Receive_Packet(void* buf, int bufsize);
 static int Extract_Uncompressed_Events(void* buf, int bufsize);
 static int Extract_Compressed_Events(void* buf, int bufsize);
+static void* Event_Data(EventClass& event);
+static int Add_Packed_Events(void* buf, int bufsize, int frame_delay, int cap);
+static bool Extract_Packed_Header(EventUnpackClass& unpack, EventClass& header);
+static int Extract_Packed_Events(void* buf, int bufsize);
 
 //...........................................................................
 // DoList management:
@@ -196,6 +303,9 @@ static int Execute_DoList(int max_houses,
 static void Clean_DoList(ConnManClass* net);
 static void Queue_Record(void);
 static void Queue_Playback(void);
+static void Write_Keyframe(CCFileClass& file);
+static bool Read_Keyframe(CCFileClass& file, bool load);
+static bool Seek_Keyframe(CCFileClass& file, long frame);
 
 //...........................................................................
 // Debugging:
@@ -514,6 +624,12 @@ static void Queue_AI_Normal(void)
  *   'n * 2', to give both sides some "breathing" room in case a FRAMEINFO	*
  *   packet gets missed.																	*
  *                                                                         *
+ * COMM_PROTOCOL_MULTI_E_PACK, used when every system supports it, sends   *
+ * the same events, but bit packs them: the FRAMEINFO header & each event  *
+ * are delta coded against the last event of their type in the packet, so  *
+ * repeated targets, missions & houses cost a bit or two instead of bytes. *
+ * See common/eventpack.cpp for the layout.                                *
+ *                                                                         *
  * Note:  For synchronization-waiting loops (like waiting to hear from all *
  * other players, waiting to advance to the next frame, etc), use 			*
  * Net.Num_Connections() rather than Session.NumPlayers; this reflects the *
@@ -554,6 +670,27 @@ static void Queue_AI_Multiplayer(void)
     if (Session.Type == GAME_SKIRMISH)
         return;
 
+#if defined(NETWORKING) && !defined(_WIN32)
+    /*
+    ** There are no socket messages to wake us up, so move whatever the network has for us once a frame.
+    */
+    if (PacketTransport != NULL && (Session.Type == GAME_IPX || Session.Type == GAME_INTERNET)) {
+        PacketTransport->Service();
+    }
+#endif
+
+    //------------------------------------------------------------------------
+    //	With a simulated link set up, move its packets along & log this
+    // frame's CRC, so the logs of two instances show the first frame they
+    // went out of sync.
+    //------------------------------------------------------------------------
+    if (LinkSim != NULL && (Session.Type == GAME_IPX || Session.Type == GAME_INTERNET)) {
+        LinkSim->Service();
+        Compute_Game_CRC();
+        CRC[Frame & 0x001f] = GameCRC;
+        LinkSim->Log_Frame_CRC(Frame, GameCRC);
+    }
+
     return;
 #if (0) // PG
     //........................................................................
@@ -613,6 +750,15 @@ static void Queue_AI_Multiplayer(void)
     }
 #endif
 
+    //------------------------------------------------------------------------
+    //	A simulated link stands in for the network when one has been set up.
+    //------------------------------------------------------------------------
+    if (LinkSim != NULL && (Session.Type == GAME_IPX || Session.Type == GAME_INTERNET)) {
+        multi_packet_buf = Session.MetaPacket;
+        multi_packet_max = Session.MetaSize;
+        net = LinkSim;
+    }
+
     //------------------------------------------------------------------------
     //	Debug stuff
     //------------------------------------------------------------------------
@@ -710,11 +856,12 @@ static void Queue_AI_Multiplayer(void)
         // deceptively large values).
         //.....................................................................
         net->Reset_Response_Time();
+        FrameDelay.Reset(Session.MaxAhead);
 
         //.....................................................................
         // Initialize the frame timers
         //.....................................................................
-        if (Session.CommProtocol == COMM_PROTOCOL_MULTI_E_COMP) {
+        if (Session.CommProtocol >= COMM_PROTOCOL_MULTI_E_COMP) {
             Process_Send_Period(net); //, 1);
         }
 
@@ -729,40 +876,44 @@ static void Queue_AI_Multiplayer(void)
     } // end of Frame 0 wait
 
     //------------------------------------------------------------------------
-    // Adjust connection timing parameters every 128 frames.
+    // Adjust connection timing parameters every 128 frames; the host checks
+    // its frame delay every 32, so it can react to a slowing connection
+    // before players start waiting on it.
     //------------------------------------------------------------------------
 
-    else if ((Frame & 0x007f) == 0) {
+    else if ((Frame & 0x001f) == 0 && Session.CommProtocol >= COMM_PROTOCOL_MULTI_E_COMP) {
         //
         // If we're using the new spiffy protocol, do proper timing handling.
         // If we're the net "master", compute our desired frame rate & new
         // 'MaxAhead' value.
         //
-        if (Session.CommProtocol == COMM_PROTOCOL_MULTI_E_COMP) {
+        if ((Frame & 0x007f) == 0) {
 
             //
             // All systems will transmit their required process time.
             //
             Generate_Process_Time_Event(net);
+        }
 
-            //
-            // The game "host" will transmit timing adjustment events.
-            //
-            if (Session.Am_I_Master()) {
-                Generate_Real_Timing_Event(net, my_sent);
-            }
-        } else {
-            //
-            // For the older protocols, do the old broken timing handling.
-            //
-            Generate_Timing_Event(net, my_sent);
+        //
+        // The game "host" will transmit timing adjustment events.
+        //
+        if (Session.Am_I_Master()) {
+            Generate_Real_Timing_Event(net, my_sent, (Frame & 0x007f) == 0);
         }
     }
 
+    else if ((Frame & 0x007f) == 0 && Session.CommProtocol < COMM_PROTOCOL_MULTI_E_COMP) {
+        //
+        // For the older protocols, do the old broken timing handling.
+        //
+        Generate_Timing_Event(net, my_sent);
+    }
+
     //------------------------------------------------------------------------
     // Only process every 'FrameSendRate' frames
     //------------------------------------------------------------------------
-    if (Session.CommProtocol == COMM_PROTOCOL_MULTI_E_COMP) {
+    if (Session.CommProtocol >= COMM_PROTOCOL_MULTI_E_COMP) {
         if (!Process_Send_Period(net)) { //, 0)) {
             if (IsMono) {
                 MonoClass::Disable();
@@ -1307,7 +1458,7 @@ static void Generate_Timing_Event(ConnManClass* net, int my_sent)
             // For multi-frame compressed events, the MaxAhead must be an even
             // multiple of the FrameSendRate.
             //..................................................................
-            if (Session.CommProtocol == COMM_PROTOCOL_MULTI_E_COMP) {
+            if (Session.CommProtocol >= COMM_PROTOCOL_MULTI_E_COMP) {
                 ev.Data.FrameInfo.Delay = max(
                     ((((resp_time / 8) + (Session.FrameSendRate - 1)) / Session.FrameSendRate) * Session.FrameSendRate),
                     (Session.FrameSendRate * 2));
@@ -1332,9 +1483,15 @@ static void Generate_Timing_Event(ConnManClass* net, int my_sent)
 /***************************************************************************
  * Generate_Real_Timing_Event -- Generates a TIMING event                  *
  *                                                                         *
+ * The new 'MaxAhead' comes from FrameDelay, which looks at the spread of	*
+ * recent response times rather than their average: it raises the delay	*
+ * as soon as slow packets would arrive too late, and only lowers it			*
+ * after the link has stayed quick for a while.										*
+ *                                                                         *
  * INPUT:                                                                  *
  *		net			ptr to connection manager											*
  *		my_sent		# commands I've sent out so far									*
+ *		heartbeat	true = send the event even if nothing has changed			*
  *                                                                         *
  * OUTPUT:                                                                 *
  *		none.																						*
@@ -1345,13 +1502,17 @@ static void Generate_Timing_Event(ConnManClass* net, int my_sent)
  * HISTORY:                                                                *
  *   07/02/1996 BRR : Created.                                             *
  *=========================================================================*/
-static void Generate_Real_Timing_Event(ConnManClass* net, int my_sent)
+static void Generate_Real_Timing_Event(ConnManClass* net, int my_sent, int heartbeat)
 {
     unsigned long resp_time; // connection response time, in ticks
+    unsigned long resp_pct;  // response time at FrameDelay's percentile
+    unsigned long jitter;    // change between successive response times
     EventClass ev;
     int highest_ticks;
     int i;
     int specified_frame_rate;
+    int old_frame_rate;
+    int old_maxahead;
     int maxahead;
 
     //
@@ -1384,6 +1545,7 @@ static void Generate_Real_Timing_Event(ConnManClass* net, int my_sent)
     // - What the user has dialed into the options screen
     // - What we're really able to run at
     //
+    old_frame_rate = Session.DesiredFrameRate;
     if (highest_ticks == 0) {
         Session.DesiredFrameRate = 60;
     } else {
@@ -1405,26 +1567,37 @@ static void Generate_Real_Timing_Event(ConnManClass* net, int my_sent)
     // frames, ....uh....
     //
     resp_time = net->Response_Time();
+    resp_pct = net->Response_Time_Percentile(FrameDelay.Percentile());
+    jitter = net->Response_Jitter(50);
 
     //
     // Compute our new 'MaxAhead' value, based upon the response time of our
     // connection and our desired frame rate.
     // 'MaxAhead' in frames is:
     //
-    // (resp_time / 2 ticks) * (1 sec/60 ticks) * (n Frames / sec)
+    // ((resp_pct + jitter) / 2 ticks) * (1 sec/60 ticks) * (n Frames / sec)
     //
-    // resp_time is divided by 2 because, as reported, it represents a round-
-    // trip, and we only want to use a one-way trip.
+    // resp_pct is divided by 2 because, as reported, it represents a round-
+    // trip, and we only want to use a one-way trip.  The typical (median)
+    // jitter is a margin for slow packets the sample window hasn't seen;
+    // the 95th percentile already covers most of them.  FrameDelay rounds this
+    // to an even multiple of our send rate, at least thrice the FrameSendRate
+    // (isn't "thrice" a cool word?), and smooths out the decreases.
     //
-    maxahead = (resp_time * Session.DesiredFrameRate) / (2 * 60);
-
-    //
-    // Now, we have to round 'maxahead' so it's an even multiple of our
-    // send rate.  It also must be at least thrice the FrameSendRate.
-    // (Isn't "thrice" a cool word?)
-    //
-    maxahead = ((maxahead + Session.FrameSendRate - 1) / Session.FrameSendRate) * Session.FrameSendRate;
-    maxahead = MAX(maxahead, (int)Session.FrameSendRate * 3);
+    old_maxahead = FrameDelay.Delay();
+    maxahead = FrameDelay.Update(resp_pct, jitter, Session.DesiredFrameRate, Session.FrameSendRate);
+
+    if (maxahead != old_maxahead) {
+        DBG_INFO("MaxAhead %d -> %d on frame %d (response %lu/%lu ticks, jitter %lu)",
+                 old_maxahead,
+                 maxahead,
+                 Frame,
+                 resp_time,
+                 resp_pct,
+                 jitter);
+    } else if (!heartbeat && Session.DesiredFrameRate == old_frame_rate) {
+        return;
+    }
 
     ev.Type = EventClass::TIMING;
     ev.Data.Timing.DesiredFrameRate = Session.DesiredFrameRate;
@@ -1654,6 +1827,11 @@ static int Send_Packets(ConnManClass* net, char* multi_packet_buf, int multi_pac
         packetlen = Build_Send_Packet(multi_packet_buf, multi_packet_max, max_ahead, my_sent, cap);
         net->Send_Private_Message(multi_packet_buf, packetlen, ack_req);
 
+        if (PacketStartFrame == -1) {
+            PacketStartFrame = Frame;
+        }
+        PacketBytesSent += packetlen;
+
         //.....................................................................
         //	Call Service() to actually send the packet
         //.....................................................................
@@ -1702,7 +1880,7 @@ static void Send_FrameSync(ConnManClass* net, int cmd_count)
     // games compare scenario CRC's on startup.
     //------------------------------------------------------------------------
     packet.Type = EventClass::FRAMESYNC;
-    if (Session.CommProtocol == COMM_PROTOCOL_MULTI_E_COMP) {
+    if (Session.CommProtocol >= COMM_PROTOCOL_MULTI_E_COMP) {
         packet.Frame =
             ((Frame + Session.MaxAhead + (Session.FrameSendRate - 1)) / Session.FrameSendRate) * Session.FrameSendRate;
     } else {
@@ -1767,15 +1945,27 @@ static RetcodeType Process_Receive_Packet(ConnManClass* net,
                                           unsigned short* their_recv)
 {
     EventClass* event;
+    EventClass header;
     int index;
     RetcodeType retcode = RC_NORMAL;
     int i;
 
     //------------------------------------------------------------------------
-    //	Get an event ptr to the incoming message
+    //	Get an event ptr to the incoming message.  A packed FRAMEINFO has to be
+    //	unpacked first; FRAMESYNC packets are never packed.
     //------------------------------------------------------------------------
     event = (EventClass*)multi_packet_buf;
 
+    if (Session.CommProtocol == COMM_PROTOCOL_MULTI_E_PACK && event->Type == EventClass::FRAMEINFO) {
+        EventUnpackClass unpack(multi_packet_buf, packetlen, EventClass::EventLength, EventClass::LAST_EVENT);
+        if (!Extract_Packed_Header(unpack, header)) {
+            return (RC_NORMAL);
+        }
+        event = &header;
+    }
+
+    PacketBytesReceived += packetlen;
+
     //------------------------------------------------------------------------
     //	Get the index of the sender
     //------------------------------------------------------------------------
@@ -2277,6 +2467,19 @@ static int Handle_Timeout(ConnManClass* net, long* their_frame, unsigned short*
  *=========================================================================*/
 static void Stop_Game(void)
 {
+    if (PacketStartFrame != -1 && Frame > PacketStartFrame) {
+        int frames = Frame - PacketStartFrame;
+        int others = Session.NumPlayers > 1 ? Session.NumPlayers - 1 : 1;
+
+        DBG_INFO("Packets: sent %.1f bytes per frame, received %.1f bytes per frame per player over %d frames",
+                 (double)PacketBytesSent / frames,
+                 (double)PacketBytesReceived / frames / others,
+                 frames);
+    }
+    PacketBytesSent = 0;
+    PacketBytesReceived = 0;
+    PacketStartFrame = -1;
+
     Session.LoadGame = false;
     Session.EmergencySave = false;
     GameActive = false;
@@ -2335,7 +2538,7 @@ static int Build_Send_Packet(void* buf, int bufsize, int frame_delay, int num_cm
     //........................................................................
     // Set the frame to execute this event on; this is protocol-specific
     //........................................................................
-    if (Session.CommProtocol == COMM_PROTOCOL_MULTI_E_COMP) {
+    if (Session.CommProtocol >= COMM_PROTOCOL_MULTI_E_COMP) {
         finfo->Frame =
             ((Frame + frame_delay + (Session.FrameSendRate - 1)) / Session.FrameSendRate) * Session.FrameSendRate;
     } else {
@@ -2384,6 +2587,15 @@ static int Build_Send_Packet(void* buf, int bufsize, int frame_delay, int num_cm
         size = Add_Compressed_Events(buf, bufsize, frame_delay, size, cap);
         break;
 
+    //.....................................................................
+    // COMM_PROTOCOL_MULTI_E_PACK:
+    //   As above, but the FRAMEINFO we just built & the events are bit
+    //   packed into the send buffer.
+    //.....................................................................
+    case (COMM_PROTOCOL_MULTI_E_PACK):
+        size = Add_Packed_Events(buf, bufsize, frame_delay, cap);
+        break;
+
     //.....................................................................
     // Default: We have no idea what to do, so do nothing.
     //.....................................................................
@@ -2653,7 +2865,7 @@ static int Add_Compressed_Events(void* buf, int bufsize, int frame_delay, int si
         //.....................................................................
         // Set the event's frame delay (this is protocol-dependent)
         //.....................................................................
-        if (Session.CommProtocol == COMM_PROTOCOL_MULTI_E_COMP) {
+        if (Session.CommProtocol >= COMM_PROTOCOL_MULTI_E_COMP) {
             OutList.First().Frame =
                 ((Frame + frame_delay + (Session.FrameSendRate - 1)) / Session.FrameSendRate) * Session.FrameSendRate;
         } else {
@@ -2810,6 +3022,10 @@ static int Breakup_Receive_Packet(void* buf, int bufsize)
         count = Extract_Uncompressed_Events(buf, bufsize);
         break;
 
+    case (COMM_PROTOCOL_MULTI_E_PACK):
+        count = Extract_Packed_Events(buf, bufsize);
+        break;
+
     default:
         count = Extract_Compressed_Events(buf, bufsize);
         break;
@@ -3081,6 +3297,245 @@ static int Extract_Compressed_Events(void* buf, int bufsize)
 
 } // end of Extract_Compressed_Events
 
+/***************************************************************************
+ * Event_Data -- returns the part of an event that goes on the wire        *
+ *                                                                         *
+ * Only EventLength[] bytes of an event's Data union are transmitted; for	*
+ * most events they start at the top of the union, but not for all.			*
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		event			event to look at														*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		ptr to the first transmitted byte of the event's data					*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *                                                                         *
+ *=========================================================================*/
+static void* Event_Data(EventClass& event)
+{
+    switch (event.Type) {
+    case (EventClass::RESPONSE_TIME):
+        return (&event.Data.FrameInfo.Delay);
+
+    case (EventClass::ADDPLAYER):
+        return (&event.Data.Variable.Size);
+
+    default:
+        return (&event.Data);
+    }
+}
+
+// The packer keeps the last event of each type, so every type & its data must fit in its tables.
+static_assert(EventClass::LAST_EVENT <= EVENTPACK_MAX_TYPES, "Too many event types to pack");
+static_assert(sizeof(EventClass::Data) <= EVENTPACK_MAX_DATA, "Event data too large to pack");
+
+/***************************************************************************
+ * Add_Packed_Events -- adds bit packed events to a packet                 *
+ *                                                                         *
+ * The FRAMEINFO header & the events are packed by EventPackClass; see		*
+ * common/eventpack.cpp for the layout.  ADDPLAYER's variable-sized data	*
+ * follows its event.																		*
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		buf				buffer to store packet in; must start with the 			*
+ *						FRAMEINFO event built by Build_Send_Packet					*
+ *		bufsize			max size of buffer												*
+ *		frame_delay		desired frame delay to attach to all outgoing packets	*
+ *		cap				max # events to process											*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		new size value																			*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		This routine MUST check to be sure it doesn't overflow the buffer.	*
+ *                                                                         *
+ *=========================================================================*/
+static int Add_Packed_Events(void* buf, int bufsize, int frame_delay, int cap)
+{
+    int num = 0;                           // # of events processed
+    EventClass header = *(EventClass*)buf; // FRAMEINFO to pack
+    void const* extra;                     // variable-sized data to send
+    int extrasize;                         // size of variable-sized data
+
+    EventPackClass pack(buf, bufsize, EventClass::EventLength);
+
+    //------------------------------------------------------------------------
+    // Pack the header
+    //------------------------------------------------------------------------
+    pack.Put_Header(EventClass::FRAMEINFO, header.Frame, header.ID, &header.Data.FrameInfo);
+
+    //------------------------------------------------------------------------
+    // Loop until there are no more events, we've processed our max # of
+    // events, or the buffer is full.
+    //------------------------------------------------------------------------
+    while (OutList.Count && (num < cap)) {
+
+        Keyboard->Check();
+
+        EventClass& event = OutList.First();
+
+        //.....................................................................
+        // Set the event's frame delay & ID, as Add_Compressed_Events does
+        //.....................................................................
+        event.Frame =
+            ((Frame + frame_delay + (Session.FrameSendRate - 1)) / Session.FrameSendRate) * Session.FrameSendRate;
+        event.ID = PlayerPtr->ID;
+
+        extra = NULL;
+        extrasize = 0;
+        if (event.Type == EventClass::ADDPLAYER) {
+            extra = event.Data.Variable.Pointer;
+            extrasize = event.Data.Variable.Size;
+        }
+
+        //.....................................................................
+        // Stop packing if the event won't fit
+        //.....................................................................
+        if (!pack.Put_Event(event.Type, event.Frame, event.ID, Event_Data(event), extra, extrasize)) {
+            break;
+        }
+
+        //.....................................................................
+        // Transfer the event in OutList to DoList, un-queue the OutList event.
+        // If the DoList is full, stop transferring immediately.
+        //.....................................................................
+        event.IsExecuted = 0;
+        if (!DoList.Add(event)) {
+            pack.Take_Back();
+            break;
+        }
+#ifdef MIRROR_QUEUE
+        MirrorList.Add(event);
+#endif
+
+        num++;
+        OutList.Next();
+    }
+
+    return (pack.Finish());
+
+} // end of Add_Packed_Events
+
+/***************************************************************************
+ * Extract_Packed_Header -- reads the FRAMEINFO header of a packet         *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		unpack		event reader, positioned at the start of the packet		*
+ *		header		event to fill in														*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		true = header read, false = packet is too short or isn't packed		*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *                                                                         *
+ *=========================================================================*/
+static bool Extract_Packed_Header(EventUnpackClass& unpack, EventClass& header)
+{
+    uint32_t frame;
+    int id;
+
+    memset(&header, 0, sizeof(header));
+    header.Type = EventClass::FRAMEINFO;
+
+    if (!unpack.Get_Header(EventClass::FRAMEINFO, frame, id, &header.Data.FrameInfo)) {
+        return (false);
+    }
+
+    header.Frame = frame;
+    header.ID = id;
+
+    return (true);
+
+} // end of Extract_Packed_Header
+
+/***************************************************************************
+ * Extract_Packed_Events -- extracts bit packed events from a packet       *
+ *                                                                         *
+ * Reverses Add_Packed_Events.  The events are added to the DoList exactly	*
+ * as Extract_Compressed_Events would add the same events.						*
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		buf			buffer containing events to extract								*
+ *		bufsize		length of 'buf'														*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		# events extracted, including the FRAMEINFO; -1 if DoList is full		*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		A damaged packet is extracted up to the point of damage.				*
+ *                                                                         *
+ *=========================================================================*/
+static int Extract_Packed_Events(void* buf, int bufsize)
+{
+    int count = 0;          // # events processed
+    EventClass header;      // FRAMEINFO header
+    EventClass eventdata{}; // event being built
+    uint32_t frame;         // event's frame
+    int id;                 // event's house ID
+    int type;               // event's type
+    void const* data;       // event's data, as unpacked
+
+    EventUnpackClass unpack(buf, bufsize, EventClass::EventLength, EventClass::LAST_EVENT);
+
+    if (!Extract_Packed_Header(unpack, header)) {
+        return (0);
+    }
+
+    if (!DoList.Add(header)) {
+        return (-1);
+    }
+#ifdef MIRROR_QUEUE
+    MirrorList.Add(header);
+#endif
+    count++;
+
+    //------------------------------------------------------------------------
+    // Loop through the events until the end of the packet
+    //------------------------------------------------------------------------
+    while ((type = unpack.Get_Event(frame, id, data)) != -1) {
+
+        Keyboard->Check();
+
+        memset(&eventdata.Data, 0, sizeof(eventdata.Data));
+        eventdata.Type = (EventClass::EventType)type;
+        eventdata.Frame = frame;
+        eventdata.ID = id;
+        memcpy(Event_Data(eventdata), data, EventClass::EventLength[type]);
+
+        //.....................................................................
+        // Special processing for variable-sized events
+        //.....................................................................
+        if (eventdata.Type == EventClass::ADDPLAYER) {
+            if (eventdata.Data.Variable.Size * 8 > (unsigned long)unpack.Remaining()) {
+                return (count);
+            }
+            eventdata.Data.Variable.Pointer = new char[eventdata.Data.Variable.Size];
+            unpack.Get_Bytes(eventdata.Data.Variable.Pointer, eventdata.Data.Variable.Size);
+        }
+
+        if (!DoList.Add(eventdata)) {
+            if (eventdata.Type == EventClass::ADDPLAYER) {
+                delete[] eventdata.Data.Variable.Pointer;
+            }
+            return (-1);
+        }
+#ifdef MIRROR_QUEUE
+        MirrorList.Add(eventdata);
+#endif
+
+        //.....................................................................
+        // Keep count of how many events we add to the queue
+        //.....................................................................
+        count++;
+    }
+
+    return (count);
+
+} // end of Extract_Packed_Events
+
 /***************************************************************************
  * Execute_DoList -- Executes commands from the DoList                     *
  *                                                                         *
@@ -3409,6 +3864,14 @@ static void Queue_Record(void)
 {
     int i, j;
 
+    //------------------------------------------------------------------------
+    //	Put a keyframe in front of this frame's events if one is due.
+    //------------------------------------------------------------------------
+    if (KeyframeRate && Frame >= NextKeyframe) {
+        Write_Keyframe(Session.RecordFile);
+        NextKeyframe = Frame + KeyframeRate;
+    }
+
     //------------------------------------------------------------------------
     //	Compute # of events to save this frame
     //------------------------------------------------------------------------
@@ -3475,6 +3938,29 @@ static void Queue_Playback(void)
             GameActive = false;
             return;
         }
+
+        //.....................................................................
+        //	Page Up & Page Down jump a keyframe's worth back or forward.
+        //.....................................................................
+        if (KeyframeRate && key == KN_PGUP) {
+            Queue_Playback_Seek(MAX(Frame - KeyframeRate, 0L));
+        }
+        if (KeyframeRate && key == KN_PGDN) {
+            Queue_Playback_Seek(Frame + KeyframeRate);
+        }
+
+        //.....................................................................
+        //	Plus & minus double or halve the playback speed; past the top it
+        //	runs as fast as it can.
+        //.....................................................................
+        if (key == KN_KEYPAD_PLUS || key == KN_EQUAL) {
+            if (PlaybackSpeed != 0) {
+                Queue_Playback_Speed(PlaybackSpeed < PLAYBACK_SPEED_MAX ? PlaybackSpeed * 2 : 0);
+            }
+        }
+        if (key == KN_KEYPAD_MINUS || key == KN_MINUS) {
+            Queue_Playback_Speed(PlaybackSpeed == 0 ? PLAYBACK_SPEED_MAX : MAX(PlaybackSpeed / 2, 1));
+        }
     }
 
     //------------------------------------------------------------------------
@@ -3517,12 +4003,35 @@ static void Queue_Playback(void)
     //------------------------------------------------------------------------
     testframe = ((Frame + (Session.FrameSendRate - 1)) / Session.FrameSendRate) * Session.FrameSendRate;
     if ((Session.Type != GAME_NORMAL && Session.Type != GAME_SKIRMISH)
-        && Session.CommProtocol == COMM_PROTOCOL_MULTI_E_COMP) {
+        && Session.CommProtocol >= COMM_PROTOCOL_MULTI_E_COMP) {
         if (Frame != testframe) {
             return;
         }
     }
 
+    //------------------------------------------------------------------------
+    //	Keyframes come in front of the events for their frame. Jump to one if
+    //	a seek is waiting, otherwise check the game still matches the next one.
+    //------------------------------------------------------------------------
+    if (SeekFrame != -1) {
+        long frame = SeekFrame;
+        SeekFrame = -1;
+        if (!Seek_Keyframe(Session.RecordFile, frame)) {
+            GameActive = false;
+            return;
+        }
+    } else if (KeyframeRate && Frame >= NextKeyframe) {
+        if (!Read_Keyframe(Session.RecordFile, false)) {
+            GameActive = false;
+            return;
+        }
+    }
+
+    if (Queue_Playback_Ended()) {
+        GameActive = false;
+        return;
+    }
+
     //------------------------------------------------------------------------
     //	Read the DoList from disk
     //------------------------------------------------------------------------
@@ -3571,6 +4080,461 @@ static void Queue_Playback(void)
 
 } /* end of Queue_Playback */
 
+/***************************************************************************
+ * Queue_Record_Header -- Starts a recording with keyframes                *
+ *                                                                         *
+ * This writes the ID that marks a recording as having keyframes, the      *
+ * keyframe rate, and a place for the index position to be filled in by    *
+ * Queue_Record_Close.                                                     *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		file		recording file, open for writing at its start					*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		none.																						*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *=========================================================================*/
+void Queue_Record_Header(CCFileClass& file)
+{
+    unsigned int id = RECORD_KEYFRAME_ID;
+    int index = 0;
+
+    KeyframeRate = KEYFRAME_RATE;
+    NextKeyframe = 0;
+    Keyframes.Clear();
+
+    file.Write(&id, sizeof(id));
+    file.Write(&KeyframeRate, sizeof(KeyframeRate));
+    KeyframeIndexPos = file.Seek(0, SEEK_CUR);
+    file.Write(&index, sizeof(index));
+
+} /* end of Queue_Record_Header */
+
+/***************************************************************************
+ * Queue_Record_Close -- Finishes a recording with its keyframe index      *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		file		recording file, still open											*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		none.																						*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		The file must be closed by the caller.										*
+ *=========================================================================*/
+void Queue_Record_Close(CCFileClass& file)
+{
+    if (!KeyframeRate || !file.Is_Open()) {
+        return;
+    }
+
+    int index = file.Seek(0, SEEK_END);
+    int count = Keyframes.Count();
+    file.Write(&count, sizeof(count));
+    for (int i = 0; i < count; i++) {
+        file.Write(&Keyframes[i], sizeof(KeyframeIndexType));
+    }
+
+    file.Seek(KeyframeIndexPos, SEEK_SET);
+    file.Write(&index, sizeof(index));
+    KeyframeRate = 0;
+
+} /* end of Queue_Record_Close */
+
+/***************************************************************************
+ * Queue_Playback_Header -- Reads the keyframe header of a recording       *
+ *                                                                         *
+ * Recordings made before there were keyframes don't start with the ID;    *
+ * they are played back from the start with no seeking. A recording that   *
+ * wasn't closed has no index, so keyframes are only found as playback     *
+ * passes them.                                                            *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		file		recording file, open for reading at its start					*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		none.																						*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *=========================================================================*/
+void Queue_Playback_Header(CCFileClass& file)
+{
+    unsigned int id = 0;
+    int index = 0;
+
+    KeyframeRate = 0;
+    NextKeyframe = 0;
+    PlaybackEnd = 0;
+    SeekTarget = -1;
+    SeekFrame = -1;
+    Keyframes.Clear();
+    PlaybackShown = true;
+    PlaybackSkipped = 0;
+    PlaybackReportTime = 0;
+
+    if (file.Read(&id, sizeof(id)) != sizeof(id) || id != RECORD_KEYFRAME_ID) {
+        file.Seek(0, SEEK_SET);
+        return;
+    }
+
+    file.Read(&KeyframeRate, sizeof(KeyframeRate));
+    file.Read(&index, sizeof(index));
+
+    if (index > 0) {
+        long pos = file.Seek(0, SEEK_CUR);
+        int count = 0;
+
+        file.Seek(index, SEEK_SET);
+        file.Read(&count, sizeof(count));
+        for (int i = 0; i < count; i++) {
+            KeyframeIndexType entry;
+            if (file.Read(&entry, sizeof(entry)) != sizeof(entry)) {
+                break;
+            }
+            Keyframes.Add(entry);
+        }
+
+        PlaybackEnd = index;
+        file.Seek(pos, SEEK_SET);
+    }
+
+} /* end of Queue_Playback_Header */
+
+/***************************************************************************
+ * Queue_Playback_Seek -- Asks for playback to jump to a frame             *
+ *                                                                         *
+ * The jump happens at the next point playback reads events. It loads the  *
+ * last keyframe at or before the frame, unless running on from where the  *
+ * game already is gets there sooner, and then runs forward to the frame   *
+ * as fast as it can.                                                      *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		frame		frame to jump to															*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		none.																						*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *=========================================================================*/
+void Queue_Playback_Seek(long frame)
+{
+    if (Session.Play && KeyframeRate) {
+        SeekFrame = frame;
+    }
+
+} /* end of Queue_Playback_Seek */
+
+/***************************************************************************
+ * Queue_Playback_Seeking -- Is playback running forward to a seek frame?  *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		none.																						*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		true = frames are being run without being shown						*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *=========================================================================*/
+bool Queue_Playback_Seeking(void)
+{
+    if (SeekTarget != -1 && Frame >= SeekTarget) {
+        SeekTarget = -1;
+        Map.Flag_To_Redraw(true);
+    }
+    return (Session.Play && SeekTarget != -1);
+
+} /* end of Queue_Playback_Seeking */
+
+/***************************************************************************
+ * Queue_Playback_Speed -- Sets how fast a recording plays back            *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		speed		1 = as recorded, N = N times that, 0 = as fast as possible	*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		none.																						*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		The game runs exactly the same frames at any speed; only how many	*
+ *		of them are drawn and waited for changes.									*
+ *=========================================================================*/
+void Queue_Playback_Speed(int speed)
+{
+    PlaybackSpeed = MAX(speed, 0);
+    PlaybackSkipped = 0;
+
+    if (PlaybackSpeed == 0) {
+        DBG_INFO("Playback speed: as fast as possible");
+    } else {
+        DBG_INFO("Playback speed: %dx", PlaybackSpeed);
+    }
+
+} /* end of Queue_Playback_Speed */
+
+/***************************************************************************
+ * Queue_Playback_Frame -- Decides whether the coming frame is shown       *
+ *                                                                         *
+ * Frames being run through to reach a seek are never shown. Otherwise a   *
+ * frame is shown every PlaybackSpeed frames, or at the fastest speed when *
+ * PLAYBACK_SHOW_TICKS have gone by since the last one. This also reports  *
+ * how many frames a second are being run.                                 *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		none.																						*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		true = wait out the frame at the game speed								*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		Call this once at the start of each frame played back.				*
+ *=========================================================================*/
+bool Queue_Playback_Frame(void)
+{
+    long now = TickCount;
+
+    if (Queue_Playback_Seeking()) {
+        PlaybackShown = false;
+    } else if (PlaybackSpeed == 0) {
+        PlaybackShown = (now - PlaybackShownTime >= PLAYBACK_SHOW_TICKS);
+    } else {
+        PlaybackShown = (PlaybackSkipped + 1 >= PlaybackSpeed);
+    }
+
+    if (PlaybackShown) {
+        PlaybackSkipped = 0;
+        PlaybackShownTime = now;
+    } else {
+        PlaybackSkipped++;
+    }
+
+    PlaybackReportFrames++;
+    if (now - PlaybackReportTime >= PLAYBACK_REPORT_TICKS) {
+        if (PlaybackReportTime != 0) {
+            DBG_INFO("Playback ran %.1f frames per second at frame %ld",
+                     (double)PlaybackReportFrames * TIMER_SECOND / (now - PlaybackReportTime),
+                     Frame);
+        }
+        PlaybackReportFrames = 0;
+        PlaybackReportTime = now;
+    }
+
+    return (PlaybackShown && PlaybackSpeed != 0);
+
+} /* end of Queue_Playback_Frame */
+
+/***************************************************************************
+ * Queue_Playback_Shown -- Is the current frame drawn and waited for?      *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		none.																						*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		true = draw this frame; always true outside playback					*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *=========================================================================*/
+bool Queue_Playback_Shown(void)
+{
+    return (!Session.Play || PlaybackShown);
+
+} /* end of Queue_Playback_Shown */
+
+/***************************************************************************
+ * Queue_Playback_Ended -- Has playback reached the end of the recording?  *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		none.																						*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		true = there are no more recorded frames								*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		Recordings without an index just run out of data instead.			*
+ *=========================================================================*/
+bool Queue_Playback_Ended(void)
+{
+    return (PlaybackEnd != 0 && Session.RecordFile.Seek(0, SEEK_CUR) >= PlaybackEnd);
+
+} /* end of Queue_Playback_Ended */
+
+/***************************************************************************
+ * Write_Keyframe -- Writes the game state into a recording                *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		file		recording file															*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		none.																						*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *=========================================================================*/
+static void Write_Keyframe(CCFileClass& file)
+{
+    static int _length = 0;
+    KeyframeHeaderType header;
+    KeyframeIndexType entry;
+
+    //------------------------------------------------------------------------
+    //	Writing the keyframe must leave the game as it was, or this machine
+    //	would go out of sync with the others and with playback. Check the CRC
+    //	is the same afterwards.
+    //------------------------------------------------------------------------
+    unsigned long crc = GameCRC;
+    Compute_Game_CRC();
+    header.Frame = Frame;
+    header.CRC = GameCRC;
+
+    MemoryPipe state(_length);
+    Save_Keyframe(state);
+    _length = state.Get_Length();
+
+    Compute_Game_CRC();
+    if (GameCRC != header.CRC) {
+        DBG_WARN("Writing the keyframe for frame %d changed the game (CRC %08lx, was %08x)",
+                 header.Frame,
+                 GameCRC,
+                 header.CRC);
+    }
+    GameCRC = crc;
+
+    MemoryPipe packed(_length / 2);
+    LCWPipe lcw(LCWPipe::COMPRESS, KEYFRAME_BLOCK_SIZE);
+    lcw.Put_To(packed);
+    lcw.Put(state.Get_Buffer(), state.Get_Length());
+    lcw.Flush();
+
+    header.Size = packed.Get_Length();
+    header.Length = state.Get_Length();
+
+    entry.Frame = Frame;
+    entry.Offset = file.Seek(0, SEEK_CUR);
+    Keyframes.Add(entry);
+
+    file.Write(&header, sizeof(header));
+    file.Write(packed.Get_Buffer(), packed.Get_Length());
+
+} /* end of Write_Keyframe */
+
+/***************************************************************************
+ * Read_Keyframe -- Reads a keyframe from a recording                      *
+ *                                                                         *
+ * A keyframe that isn't loaded is skipped over, after checking that the   *
+ * game being played back still has the CRC it had when it was recorded.   *
+ * A loaded one replaces the game with its state, which is then checked    *
+ * against the CRC the same way.                                           *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		file		recording file, at the keyframe's header							*
+ *		load		true = load the game state, false = skip over it				*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		true = OK, false = the keyframe couldn't be read						*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *=========================================================================*/
+static bool Read_Keyframe(CCFileClass& file, bool load)
+{
+    KeyframeHeaderType header;
+    KeyframeIndexType entry;
+
+    entry.Offset = file.Seek(0, SEEK_CUR);
+    if (file.Read(&header, sizeof(header)) != sizeof(header) || header.Size <= 0 || header.Length <= 0) {
+        return (false);
+    }
+    entry.Frame = header.Frame;
+
+    //------------------------------------------------------------------------
+    //	Remember keyframes that weren't in the index, so they can be jumped
+    //	back to later.
+    //------------------------------------------------------------------------
+    if (Keyframes.Count() == 0 || Keyframes[Keyframes.Count() - 1].Frame < entry.Frame) {
+        Keyframes.Add(entry);
+    }
+
+    if (!load) {
+        file.Seek(header.Size, SEEK_CUR);
+    } else {
+        char* packed = new char[header.Size];
+        if (file.Read(packed, header.Size) != header.Size) {
+            delete[] packed;
+            return (false);
+        }
+
+        BufferStraw source(packed, header.Size);
+        LCWStraw lcw(LCWStraw::DECOMPRESS, KEYFRAME_BLOCK_SIZE);
+        lcw.Get_From(source);
+        bool ok = Load_Keyframe(lcw);
+        delete[] packed;
+        if (!ok || Frame != header.Frame) {
+            return (false);
+        }
+        DoList.Init();
+    }
+
+    unsigned long crc = GameCRC;
+    Compute_Game_CRC();
+    if (GameCRC != header.CRC || Frame != header.Frame) {
+        DBG_WARN("Playback doesn't match the recording's keyframe for frame %d (CRC %08lx, recorded %08x)",
+                 header.Frame,
+                 GameCRC,
+                 header.CRC);
+    }
+    GameCRC = crc;
+    NextKeyframe = Frame + KeyframeRate;
+    return (true);
+
+} /* end of Read_Keyframe */
+
+/***************************************************************************
+ * Seek_Keyframe -- Jumps playback to a frame                              *
+ *                                                                         *
+ * INPUT:                                                                  *
+ *		file		recording file, at the point the current frame's keyframe	*
+ *					would be																		*
+ *		frame		frame to jump to															*
+ *                                                                         *
+ * OUTPUT:                                                                 *
+ *		true = OK, false = a keyframe couldn't be loaded						*
+ *                                                                         *
+ * WARNINGS:                                                               *
+ *		none.																						*
+ *=========================================================================*/
+static bool Seek_Keyframe(CCFileClass& file, long frame)
+{
+    int best = -1;
+    for (int i = 0; i < Keyframes.Count() && Keyframes[i].Frame <= frame; i++) {
+        best = i;
+    }
+
+    //------------------------------------------------------------------------
+    //	Running on is the only way forward past the last known keyframe, and
+    //	the quickest way to a frame before the next one. With no keyframe
+    //	before it, a frame already gone by can't be reached at all.
+    //------------------------------------------------------------------------
+    if (best == -1 || (frame >= Frame && Keyframes[best].Frame <= Frame)) {
+        if (frame >= Frame) {
+            SeekTarget = frame;
+        }
+        if (KeyframeRate && Frame >= NextKeyframe) {
+            return (Read_Keyframe(file, false));
+        }
+        return (true);
+    }
+
+    SeekTarget = frame;
+    file.Seek(Keyframes[best].Offset, SEEK_SET);
+    return (Read_Keyframe(file, true));
+
+} /* end of Seek_Keyframe */
+
 /***************************************************************************
  * Compute_Game_CRC -- Computes a CRC value of the entire game.				*
  *                                                                         *
@@ -1330,6 +1330,7 @@ bool RadarClass::Jam_Cell(CELL cell, HouseClass* house /*KO, bool shadeit*/)
 {
     unsigned short jam = 1 << house->Class->House;
     (*this)[cell].Jammed |= jam;
+    Flag_Shroud_Changed(cell);
 
     /*
     ** Updated for client/server multiplayer. ST - 8/12/2019 11:00AM
@@ -1373,6 +1374,7 @@ bool RadarClass::UnJam_Cell(CELL cell, HouseClass* house)
     unsigned short jam = 1 << house->Class->House;
     (*this)[cell].Redraw_Objects();
     (*this)[cell].Jammed &= (0xFFFF - jam);
+    Flag_Shroud_Changed(cell);
     Radar_Pixel(cell);
     return (true);
 }
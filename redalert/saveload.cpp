@@ -40,8 +40,10 @@
  *   Put_All -- Store all save game data to the pipe.                                          *
  *   Reconcile_Players -- Reconciles loaded data with the 'Players' vector							  *
  *   Save_Game -- saves a game to disk                                                         *
+ *   Save_Game_Wait -- Waits for a background save to finish writing.                          *
  *   Save_MPlayer_Values -- Saves multiplayer-specific values                                  *
  *   Save_Misc_Values -- saves miscellaneous variables                                         *
+ *   Write_Save -- Writes out a save game file.                                                *
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
 
 #include "function.h"
@@ -55,6 +57,10 @@
 #include "carry.h"
 #include "common/tcpip.h"
 
+#include <chrono>
+#include <string>
+#include <thread>
+
 #ifdef REMASTER_BUILD
 extern bool DLLSave(Pipe& file);
 extern bool DLLLoad(Straw& file);
@@ -80,6 +86,13 @@ extern bool DLLLoad(Straw& file);
         + sizeof(ScenarioClass) + sizeof(ChronalVortexClass)))
 //										sizeof(Waypoint)))
 
+/*
+**	The top bits of the saved version word hold the SaveFormatType the map was written in. Saves from before
+**	there were formats leave them clear, which reads as SAVEFORMAT_IMAGE.
+*/
+#define SAVEGAME_FORMAT_SHIFT 28
+#define SAVEGAME_VERSION_MASK ((1UL << SAVEGAME_FORMAT_SHIFT) - 1)
+
 static int Reconcile_Players(void);
 extern bool Is_Mission_Counterstrike(char* file_name);
 #ifdef FIXIT_CSII //	checked - ajw 9/28/98
@@ -94,6 +107,11 @@ extern bool Is_Mission_Aftermath(char* file_name);
  *                                                                                             *
  * INPUT:   pipe  -- Reference to the pipe that will receive the save game data.               *
  *                                                                                             *
+ *          save_net -- Should the multiplayer values be saved too?                            *
+ *                                                                                             *
+ *          call_back -- Should the network be kept alive between sections? This is never      *
+ *                       done for multiplayer saves.                                           *
+ *                                                                                             *
  * OUTPUT:  none                                                                               *
  *                                                                                             *
  * WARNINGS:   none                                                                            *
@@ -101,8 +119,10 @@ extern bool Is_Mission_Aftermath(char* file_name);
  * HISTORY:                                                                                    *
  *   07/08/1996 JLB : Created.                                                                 *
  *=============================================================================================*/
-static void Put_All(Pipe& pipe, int save_net)
+static void Put_All(Pipe& pipe, int save_net, bool call_back = true)
 {
+    call_back = call_back && !save_net;
+
     /*
     **	Save the scenario global information.
     */
@@ -111,11 +131,11 @@ static void Put_All(Pipe& pipe, int save_net)
     /*
     **	Save the map.  The map must be saved first, since it saves the Theater.
     */
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Map.Save(pipe);
 
-    if (!save_net)
+    if (call_back)
         Call_Back();
 
     /*
@@ -123,58 +143,58 @@ static void Put_All(Pipe& pipe, int save_net)
     **	TFixedIHeap class.
     */
     Houses.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     TeamTypes.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Teams.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     TriggerTypes.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Triggers.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Aircraft.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Anims.Save(pipe);
 
-    if (!save_net)
+    if (call_back)
         Call_Back();
 
     Buildings.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Bullets.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Infantry.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Overlays.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Smudges.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Templates.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Terrains.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Units.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Factories.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
     Vessels.Save(pipe);
 
-    if (!save_net)
+    if (call_back)
         Call_Back();
 
     /*
@@ -189,7 +209,7 @@ static void Put_All(Pipe& pipe, int save_net)
         TARGET target = MapTriggers[index]->As_Target();
         pipe.Put(&target, sizeof(target));
     }
-    if (!save_net)
+    if (call_back)
         Call_Back();
     count = LogicTriggers.Count();
     pipe.Put(&count, sizeof(count));
@@ -197,7 +217,7 @@ static void Put_All(Pipe& pipe, int save_net)
         TARGET target = LogicTriggers[index]->As_Target();
         pipe.Put(&target, sizeof(target));
     }
-    if (!save_net)
+    if (call_back)
         Call_Back();
     for (HousesType h = HOUSE_FIRST; h < HOUSE_COUNT; h++) {
         count = HouseTriggers[h].Count();
@@ -207,28 +227,28 @@ static void Put_All(Pipe& pipe, int save_net)
             pipe.Put(&target, sizeof(target));
         }
     }
-    if (!save_net)
+    if (call_back)
         Call_Back();
 
     for (int i = 0; i < LAYER_COUNT; i++) {
         Map.Layer[i].Save(pipe);
     }
 
-    if (!save_net)
+    if (call_back)
         Call_Back();
 
     /*
     **	Save the Score
     */
     pipe.Put(&Score, sizeof(Score));
-    if (!save_net)
+    if (call_back)
         Call_Back();
 
     /*
     **	Save the AI Base
     */
     Base.Save(pipe);
-    if (!save_net)
+    if (call_back)
         Call_Back();
 
     /*
@@ -242,14 +262,14 @@ static void Put_All(Pipe& pipe, int save_net)
         cptr = (CarryoverClass const*)cptr->Get_Next();
     }
 
-    if (!save_net)
+    if (call_back)
         Call_Back();
 
     /*
     **	Save out the number of objects in the list.
     */
     pipe.Put(&carry_count, sizeof(carry_count));
-    if (!save_net)
+    if (call_back)
         Call_Back();
 
     /*
@@ -260,7 +280,7 @@ static void Put_All(Pipe& pipe, int save_net)
         pipe.Put(object_to_write, sizeof(*object_to_write));
         object_to_write = (CarryoverClass const*)object_to_write->Get_Next();
     }
-    if (!save_net)
+    if (call_back)
         Call_Back();
 
     /*
@@ -268,7 +288,7 @@ static void Put_All(Pipe& pipe, int save_net)
     */
     Save_Misc_Values(pipe);
 
-    if (!save_net)
+    if (call_back)
         Call_Back();
 
     /*
@@ -283,6 +303,176 @@ static void Put_All(Pipe& pipe, int save_net)
     pipe.Flush();
 }
 
+/***********************************************************************************************
+ * Get_All -- Loads all game data from the straw specified.                                    *
+ *                                                                                             *
+ *    This is the counterpart of Put_All. It reads everything after the scenario globals,      *
+ *    decodes the pointers and fixes up the data that is inferred from what was loaded.        *
+ *                                                                                             *
+ * INPUT:   straw -- Reference to the straw that will supply the game data.                    *
+ *                                                                                             *
+ * OUTPUT:  Returns with whether the multiplayer values were in the data.                      *
+ *                                                                                             *
+ * WARNINGS:   The scenario must have been cleared and Scen loaded before this is called.      *
+ *=============================================================================================*/
+static int Get_All(Straw& straw)
+{
+    /*
+    **	Load the map.  The map comes first, since it loads the Theater & init's
+    **	mixfiles.  The map calls all the type-class's Init routines, telling them
+    **	what the Theater is; this must be done before any objects are created, so
+    **	they'll be properly created.
+    */
+    Map.Load(straw);
+
+    Call_Back();
+
+    /*
+    **	Load the object data.
+    */
+    Houses.Load(straw);
+    TeamTypes.Load(straw);
+    Teams.Load(straw);
+    TriggerTypes.Load(straw);
+    Triggers.Load(straw);
+    Aircraft.Load(straw);
+    Anims.Load(straw);
+    Buildings.Load(straw);
+    Bullets.Load(straw);
+
+    Call_Back();
+
+    Infantry.Load(straw);
+    Overlays.Load(straw);
+    Smudges.Load(straw);
+    Templates.Load(straw);
+    Terrains.Load(straw);
+    Units.Load(straw);
+    Factories.Load(straw);
+    Vessels.Load(straw);
+
+    /*
+    **	Load the Logic & Map Layers
+    */
+    Logic.Load(straw);
+
+    int count;
+    straw.Get(&count, sizeof(count));
+    MapTriggers.Clear();
+    int index;
+    for (index = 0; index < count; index++) {
+        TARGET target;
+        straw.Get(&target, sizeof(target));
+        MapTriggers.Add(As_Trigger(target));
+    }
+
+    straw.Get(&count, sizeof(count));
+    LogicTriggers.Clear();
+    for (index = 0; index < count; index++) {
+        TARGET target;
+        straw.Get(&target, sizeof(target));
+        LogicTriggers.Add(As_Trigger(target));
+    }
+
+    for (HousesType h = HOUSE_FIRST; h < HOUSE_COUNT; h++) {
+        straw.Get(&count, sizeof(count));
+        HouseTriggers[h].Clear();
+        for (index = 0; index < count; index++) {
+            TARGET target;
+            straw.Get(&target, sizeof(target));
+            HouseTriggers[h].Add(As_Trigger(target));
+        }
+    }
+
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        Map.Layer[i].Load(straw);
+    }
+
+    Call_Back();
+
+    /*
+    **	Load the Score
+    */
+    straw.Get(&Score, sizeof(Score));
+    new (&Score) ScoreClass(NoInitClass());
+
+    /*
+    **	Load the AI Base
+    */
+    Base.Load(straw);
+
+    /*
+    **	Delete any carryover pseudo-saved game list.
+    */
+    while (Carryover != NULL) {
+        CarryoverClass* cptr = (CarryoverClass*)Carryover->Get_Next();
+        Carryover->Remove();
+        delete Carryover;
+        Carryover = cptr;
+    }
+
+    /*
+    **	Load any carryover pseudo-saved game list.
+    */
+    int carry_count = 0;
+    straw.Get(&carry_count, sizeof(carry_count));
+    while (carry_count) {
+        CarryoverClass* cptr = new CarryoverClass;
+        assert(cptr != NULL);
+
+        straw.Get(cptr, sizeof(CarryoverClass));
+        new (cptr) CarryoverClass(NoInitClass());
+        cptr->Zap();
+
+        if (!Carryover) {
+            Carryover = cptr;
+        } else {
+            cptr->Add_Tail(*Carryover);
+        }
+        carry_count--;
+    }
+
+    Call_Back();
+
+    /*
+    **	Load miscellaneous variables, including the map size & the Theater
+    */
+    Load_Misc_Values(straw);
+
+    /*
+    **	Load multiplayer values
+    */
+    int load_net = 0;
+    straw.Get(&load_net, sizeof(load_net));
+    if (load_net) {
+        Load_MPlayer_Values(straw);
+    }
+
+    Decode_All_Pointers();
+    SaveFormat = SAVEFORMAT_CURRENT;
+    Map.Init_IO();
+    Map.Flag_To_Redraw(true);
+    Map.Flag_All_Changed();
+
+    /*
+    **	Fixup any expediency data that can be inferred from the physical
+    **	data loaded.
+    */
+    Post_Load_Game(load_net);
+
+    /*
+    ** Re-init unit trackers. They will be garbage pointers after the load
+    */
+    for (HousesType house = HOUSE_FIRST; house < HOUSE_COUNT; house++) {
+        HouseClass* hptr = HouseClass::As_Pointer(house);
+        if (hptr && hptr->IsActive) {
+            hptr->Init_Unit_Trackers();
+        }
+    }
+
+    return (load_net);
+}
+
 /***************************************************************************
  * Save_Game -- saves a game to disk                                       *
  *                                                                         *
@@ -290,17 +480,20 @@ static void Put_All(Pipe& pipe, int save_net)
  *     DisplayClass::Save() invokes CellClass's Write() for every cell     *
  *     that needs to be saved.  A cell needs to be saved if it contains    *
  *     any special data at all, such as a TIcon, or an Occupier.           *
- *   The cell saves its own CellTrigger pointer, converted to a TARGET.    *
+ *   The cell saves its objects and CellTrigger pointer as TARGETs.        *
  *                                                                         *
  * Saving game objects:                                                    *
  *   - Any object stored in an ArrayOf class needs to be saved.  The ArrayOf*
  *     Save() routine invokes each object's Write() routine, if that       *
  *     object's IsActive is set.                                           *
+ *   - Objects are written as memory images. Their pointers are            *
+ *     coded by Code_All_Pointers first and decoded after loading; only    *
+ *     the map cells and the layers hold TARGETs in the file.              *
  *                                                                         *
  * Saving the layers:                                                      *
  *   The Map's Layers (Ground, Air, etc) of things that are on the map,    *
  *     and the Logic's Layer of things to process both need to be saved.   *
- *     LayerClass::Save() writes the entire layer array to disk            *
+ *     LayerClass::Save() writes each object in the layer as a TARGET      *
  *                                                                         *
  * Saving the houses:                                                      *
  *   Each house needs to be saved, to record its Credits, Power, etc.      *
@@ -340,31 +533,36 @@ bool Save_Game(int id, char const* descr, bool)
     return Save_Game(name, descr);
 }
 
-/*
-** Version that takes file name. ST - 9/9/2019 11:10AM
-*/
-bool NowSavingGame = false; // TEMP MBL: Need to discuss better solution with Steve
-bool Save_Game(const char* file_name, const char* descr)
+/***********************************************************************************************
+ * Write_Save -- Writes out a save game file.                                                  *
+ *                                                                                             *
+ *    Writes the header, then the game data compressed and encrypted, then goes back and       *
+ *    fills in the message digest of what was written.                                         *
+ *                                                                                             *
+ * INPUT:   file_name   -- The file to write.                                                  *
+ *                                                                                             *
+ *          descr_buf   -- The description, DESCRIP_MAX bytes long.                            *
+ *                                                                                             *
+ *          scenario    -- The scenario number to record in the header.                        *
+ *                                                                                             *
+ *          house       -- The player's house to record in the header.                         *
+ *                                                                                             *
+ *          snapshot    -- The game data as already captured by Put_All, or NULL to have       *
+ *                         Put_All send it straight to the file.                               *
+ *                                                                                             *
+ *          save_net    -- Passed on to Put_All when there is no snapshot.                     *
+ *                                                                                             *
+ * OUTPUT:  none                                                                               *
+ *                                                                                             *
+ * WARNINGS:   Without a snapshot, all pointers must be coded.                                 *
+ *=============================================================================================*/
+static void Write_Save(char const* file_name,
+                       char const* descr_buf,
+                       unsigned scenario,
+                       HousesType house,
+                       MemoryPipe const* snapshot,
+                       int save_net)
 {
-    NowSavingGame = true; // TEMP MBL: Need to discuss better solution with Steve
-
-    int save_net = 0; // 1 = save network/modem game
-
-    if (Session.Type == GAME_GLYPHX_MULTIPLAYER) {
-        save_net = 1;
-    }
-
-    unsigned scenario;
-    HousesType house;
-
-    scenario = Scen.Scenario;        // get current scenario #
-    house = PlayerPtr->Class->House; // get current house
-
-    /*
-    **	Code everybody's pointers
-    */
-    Code_All_Pointers();
-
     /*
     **	Open the file
     */
@@ -388,10 +586,6 @@ bool Save_Game(const char* file_name, const char* descr)
     **	which may or may not be a HousesType number; so, saving 'house'
     **	here ensures we can always pull out the house for this file.)
     */
-    char descr_buf[DESCRIP_MAX];
-    memset(descr_buf, '\0', sizeof(descr_buf));
-    sprintf(descr_buf, "%s\r\n", descr); // put CR-LF after text
-    // descr_buf[strlen(descr_buf) + 1] = 26;		// put CTRL-Z after NULL
     fpipe.Put(descr_buf, DESCRIP_MAX);
 
     fpipe.Put(&scenario, sizeof(scenario));
@@ -405,6 +599,7 @@ bool Save_Game(const char* file_name, const char* descr)
 #ifdef FIXIT_CSII //	checked - ajw 9/28/98
     version++;
 #endif
+    version |= (unsigned long)SAVEFORMAT_CURRENT << SAVEGAME_FORMAT_SHIFT;
     fpipe.Put(&version, sizeof(version));
 
     int pos = file.Seek(0, SEEK_CUR);
@@ -428,7 +623,11 @@ bool Save_Game(const char* file_name, const char* descr)
     sha.Put_To(fpipe);
     bpipe.Put_To(sha);
     pipe.Put_To(bpipe);
-    Put_All(pipe, save_net);
+    if (snapshot != NULL) {
+        pipe.Put(snapshot->Get_Buffer(), snapshot->Get_Length());
+    } else {
+        Put_All(pipe, save_net);
+    }
 
     /*
     **	Output the real final message digest. This is the one that is of
@@ -440,9 +639,142 @@ bool Save_Game(const char* file_name, const char* descr)
     fpipe.Put(digest, sizeof(digest));
 
     pipe.End();
+}
+
+/*
+**	A save whose game data has been captured and is waiting to be written out by the worker
+**	thread. Only one is ever in flight; Save_Game_Wait() blocks until it is done.
+*/
+struct SaveJobType
+{
+    SaveJobType(int reserve)
+        : Snapshot(reserve)
+    {
+    }
+
+    std::string FileName;
+    char Descr[DESCRIP_MAX];
+    unsigned Scenario;
+    HousesType House;
+    MemoryPipe Snapshot;
+    double SnapshotTime;
+};
+
+static std::thread* SaveThread = NULL;
+static int LastSnapshotSize = 0;
+
+static double Milliseconds_Since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void Save_Thread_Main(SaveJobType* job)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    Write_Save(job->FileName.c_str(), job->Descr, job->Scenario, job->House, &job->Snapshot, 0);
+
+    DBG_INFO("Saved %s in the background: %d bytes, %.1f ms snapshot, %.1f ms write",
+             job->FileName.c_str(),
+             job->Snapshot.Get_Length(),
+             job->SnapshotTime,
+             Milliseconds_Since(start));
+
+    delete job;
+}
+
+/***********************************************************************************************
+ * Save_Game_Wait -- Waits for a background save to finish writing.                            *
+ *                                                                                             *
+ *    Call this before anything that reads save files or has to have the last save on disk.    *
+ *                                                                                             *
+ * INPUT:   none                                                                               *
+ *                                                                                             *
+ * OUTPUT:  none                                                                               *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *=============================================================================================*/
+void Save_Game_Wait(void)
+{
+    if (SaveThread != NULL) {
+        SaveThread->join();
+        delete SaveThread;
+        SaveThread = NULL;
+    }
+}
+
+/*
+** Version that takes file name. ST - 9/9/2019 11:10AM
+**
+** With 'background' set, the game data is only copied into memory here and a worker thread
+** compresses and writes it, so the game doesn't stall for the write. The file is the same
+** either way.
+*/
+bool NowSavingGame = false; // TEMP MBL: Need to discuss better solution with Steve
+bool Save_Game(const char* file_name, const char* descr, bool background)
+{
+    Save_Game_Wait();
+
+    NowSavingGame = true; // TEMP MBL: Need to discuss better solution with Steve
+
+    int save_net = 0; // 1 = save network/modem game
+
+    if (Session.Type == GAME_GLYPHX_MULTIPLAYER) {
+        save_net = 1;
+    }
+
+#ifdef REMASTER_BUILD
+    if (RunningAsDLL) {
+        background = false;
+    }
+#endif
+
+    unsigned scenario;
+    HousesType house;
+
+    scenario = Scen.Scenario;        // get current scenario #
+    house = PlayerPtr->Class->House; // get current house
+
+    char descr_buf[DESCRIP_MAX];
+    memset(descr_buf, '\0', sizeof(descr_buf));
+    sprintf(descr_buf, "%s\r\n", descr); // put CR-LF after text
+    // descr_buf[strlen(descr_buf) + 1] = 26;		// put CTRL-Z after NULL
+
+    /*
+    **	Code everybody's pointers. Saves are always written in the current format, so
+    **	decoding afterwards must follow it too.
+    */
+    SaveFormat = SAVEFORMAT_CURRENT;
+    Code_All_Pointers();
+
+    if (!background) {
+        Write_Save(file_name, descr_buf, scenario, house, NULL, save_net);
+        Decode_All_Pointers();
+
+        NowSavingGame = false; // TEMP MBL: Need to discuss better solution with Steve
+
+        return (true);
+    }
+
+    /*
+    **	Capture the game data while the pointers are coded, then hand it to the worker.
+    */
+    auto start = std::chrono::steady_clock::now();
+
+    SaveJobType* job = new SaveJobType(LastSnapshotSize);
+    job->FileName = file_name;
+    memcpy(job->Descr, descr_buf, sizeof(job->Descr));
+    job->Scenario = scenario;
+    job->House = house;
+
+    Put_All(job->Snapshot, save_net, false);
 
     Decode_All_Pointers();
 
+    job->SnapshotTime = Milliseconds_Since(start);
+    LastSnapshotSize = job->Snapshot.Get_Length();
+    SaveThread = new std::thread(Save_Thread_Main, job);
+
     NowSavingGame = false; // TEMP MBL: Need to discuss better solution with Steve
 
     return (true);
@@ -456,7 +788,8 @@ bool Save_Game(const char* file_name, const char* descr)
  * Loading the Map:                                                        *
  *   - DisplayClass::Load() invokes CellClass's Load() for every cell      *
  *     that was saved.                                                     *
- * - The cell loads its own CellTrigger pointer.                           *
+ * - The cell loads its own CellTrigger pointer and, in the field          *
+ *   format, resolves its objects' TARGETs as it reads them.               *
  *                                                                         *
  * Loading game objects:                                                   *
  * - IHeap's Load() routine loads the # of objects stored, and loads       *
@@ -465,7 +798,7 @@ bool Save_Game(const char* file_name, const char* descr)
  *   with a house                                                          *
  *                                                                         *
  * Loading the layers:                                                     *
- *     LayerClass::Load() reads the entire layer array to disk             *
+ *     LayerClass::Load() reads the entire layer array from disk           *
  *                                                                         *
  * Loading the houses:                                                     *
  *   Each house is loaded in its entirety.                                 *
@@ -510,12 +843,13 @@ bool Load_Game(int id)
 */
 bool Load_Game(const char* file_name)
 {
-    int i;
     unsigned scenario;
     HousesType house;
     char descr_buf[DESCRIP_MAX];
     int load_net = 0; // 1 = save network/modem game
 
+    Save_Game_Wait();
+
     /*
     **	Open the file
     */
@@ -557,6 +891,11 @@ bool Load_Game(const char* file_name)
     if (fstraw.Get(&version, sizeof(version)) != sizeof(version)) {
         return (false);
     }
+    if ((version >> SAVEGAME_FORMAT_SHIFT) >= SAVEFORMAT_COUNT) {
+        return (false);
+    }
+    SaveFormat = (SaveFormatType)(version >> SAVEGAME_FORMAT_SHIFT);
+    version &= SAVEGAME_VERSION_MASK;
     GameVersion = version;
 #ifdef FIXIT_CSII //	checked - ajw 9/28/98
     if (version != SAVEGAME_VERSION && ((version - 1) != SAVEGAME_VERSION)) {
@@ -677,156 +1016,8 @@ bool Load_Game(const char* file_name)
         }
     }
 
-    /*
-    **	Load the map.  The map comes first, since it loads the Theater & init's
-    **	mixfiles.  The map calls all the type-class's Init routines, telling them
-    **	what the Theater is; this must be done before any objects are created, so
-    **	they'll be properly created.
-    */
-    Map.Load(straw);
-
-    Call_Back();
-
-    /*
-    **	Load the object data.
-    */
-    Houses.Load(straw);
-    TeamTypes.Load(straw);
-    Teams.Load(straw);
-    TriggerTypes.Load(straw);
-    Triggers.Load(straw);
-    Aircraft.Load(straw);
-    Anims.Load(straw);
-    Buildings.Load(straw);
-    Bullets.Load(straw);
-
-    Call_Back();
-
-    Infantry.Load(straw);
-    Overlays.Load(straw);
-    Smudges.Load(straw);
-    Templates.Load(straw);
-    Terrains.Load(straw);
-    Units.Load(straw);
-    Factories.Load(straw);
-    Vessels.Load(straw);
-
-    /*
-    **	Load the Logic & Map Layers
-    */
-    Logic.Load(straw);
-
-    int count;
-    straw.Get(&count, sizeof(count));
-    MapTriggers.Clear();
-    int index;
-    for (index = 0; index < count; index++) {
-        TARGET target;
-        straw.Get(&target, sizeof(target));
-        MapTriggers.Add(As_Trigger(target));
-    }
-
-    straw.Get(&count, sizeof(count));
-    LogicTriggers.Clear();
-    for (index = 0; index < count; index++) {
-        TARGET target;
-        straw.Get(&target, sizeof(target));
-        LogicTriggers.Add(As_Trigger(target));
-    }
-
-    for (HousesType h = HOUSE_FIRST; h < HOUSE_COUNT; h++) {
-        straw.Get(&count, sizeof(count));
-        HouseTriggers[h].Clear();
-        for (index = 0; index < count; index++) {
-            TARGET target;
-            straw.Get(&target, sizeof(target));
-            HouseTriggers[h].Add(As_Trigger(target));
-        }
-    }
-
-    for (i = 0; i < LAYER_COUNT; i++) {
-        Map.Layer[i].Load(straw);
-    }
-
-    Call_Back();
-
-    /*
-    **	Load the Score
-    */
-    straw.Get(&Score, sizeof(Score));
-    new (&Score) ScoreClass(NoInitClass());
-
-    /*
-    **	Load the AI Base
-    */
-    Base.Load(straw);
-
-    /*
-    **	Delete any carryover pseudo-saved game list.
-    */
-    while (Carryover != NULL) {
-        CarryoverClass* cptr = (CarryoverClass*)Carryover->Get_Next();
-        Carryover->Remove();
-        delete Carryover;
-        Carryover = cptr;
-    }
-
-    /*
-    **	Load any carryover pseudo-saved game list.
-    */
-    int carry_count = 0;
-    straw.Get(&carry_count, sizeof(carry_count));
-    while (carry_count) {
-        CarryoverClass* cptr = new CarryoverClass;
-        assert(cptr != NULL);
-
-        straw.Get(cptr, sizeof(CarryoverClass));
-        new (cptr) CarryoverClass(NoInitClass());
-        cptr->Zap();
-
-        if (!Carryover) {
-            Carryover = cptr;
-        } else {
-            cptr->Add_Tail(*Carryover);
-        }
-        carry_count--;
-    }
-
-    Call_Back();
-
-    /*
-    **	Load miscellaneous variables, including the map size & the Theater
-    */
-    Load_Misc_Values(straw);
-
-    /*
-    **	Load multiplayer values
-    */
-    straw.Get(&load_net, sizeof(load_net));
-    if (load_net) {
-        Load_MPlayer_Values(straw);
-    }
-
+    load_net = Get_All(straw);
     file.Close();
-    Decode_All_Pointers();
-    Map.Init_IO();
-    Map.Flag_To_Redraw(true);
-
-    /*
-    **	Fixup any expediency data that can be inferred from the physical
-    **	data loaded.
-    */
-    Post_Load_Game(load_net);
-
-    /*
-    ** Re-init unit trackers. They will be garbage pointers after the load
-    */
-    for (HousesType house = HOUSE_FIRST; house < HOUSE_COUNT; house++) {
-        HouseClass* hptr = HouseClass::As_Pointer(house);
-        if (hptr && hptr->IsActive) {
-            hptr->Init_Unit_Trackers();
-        }
-    }
 
     Call_Back();
 
@@ -1026,6 +1217,48 @@ bool Load_Game(const char* file_name)
     return (true);
 }
 
+/***********************************************************************************************
+ * Save_Keyframe -- Writes the whole game state into a recording keyframe.                     *
+ *                                                                                             *
+ *    This is the save game data without its header, digest, compression or multiplayer        *
+ *    values. The recording already holds the session setup.                                   *
+ *                                                                                             *
+ * INPUT:   pipe  -- The pipe to write the game state to.                                      *
+ *                                                                                             *
+ * OUTPUT:  none                                                                               *
+ *                                                                                             *
+ * WARNINGS:   none                                                                            *
+ *=============================================================================================*/
+void Save_Keyframe(Pipe& pipe)
+{
+    SaveFormat = SAVEFORMAT_CURRENT;
+    Code_All_Pointers();
+    Put_All(pipe, 0, false);
+    Decode_All_Pointers();
+}
+
+/***********************************************************************************************
+ * Load_Keyframe -- Replaces the game state with one from a recording keyframe.                *
+ *                                                                                             *
+ * INPUT:   straw -- The straw to read the state written by Save_Keyframe from.                *
+ *                                                                                             *
+ * OUTPUT:  bool; Was the keyframe loaded?                                                     *
+ *                                                                                             *
+ * WARNINGS:   The current game is gone even if this fails.                                    *
+ *=============================================================================================*/
+bool Load_Keyframe(Straw& straw)
+{
+    Clear_Scenario();
+
+    if (straw.Get(&Scen, sizeof(Scen)) != sizeof(Scen)) {
+        return (false);
+    }
+
+    SaveFormat = SAVEFORMAT_CURRENT;
+    Get_All(straw);
+    return (true);
+}
+
 /***************************************************************************
  * Save_Misc_Values -- saves miscellaneous variables                       *
  *                                                                         *
@@ -1263,14 +1496,6 @@ void Code_All_Pointers(void)
     Factories.Code_Pointers();
     Vessels.Code_Pointers();
 
-    /*
-    **	The Layers.
-    */
-    Logic.Code_Pointers();
-    for (i = 0; i < LAYER_COUNT; i++) {
-        Map.Layer[i].Code_Pointers();
-    }
-
     /*
     **	The Score.
     */
@@ -1435,6 +1660,8 @@ bool Get_Savefile_Info(int id, char* buf, unsigned* scenp, HousesType* housep)
     unsigned long version;
     char descr_buf[DESCRIP_MAX];
 
+    Save_Game_Wait();
+
     /*
     **	Generate the filename to load
     */
@@ -1467,6 +1694,10 @@ bool Get_Savefile_Info(int id, char* buf, unsigned* scenp, HousesType* housep)
     if (straw.Get(&version, sizeof(version)) != sizeof(version)) {
         return (false);
     }
+    if ((version >> SAVEGAME_FORMAT_SHIFT) >= SAVEFORMAT_COUNT) {
+        return (false);
+    }
+    version &= SAVEGAME_VERSION_MASK;
 #ifdef FIXIT_CSII //	checked - ajw 9/28/98
     if (version != SAVEGAME_VERSION && ((version - 1 != SAVEGAME_VERSION))) {
 #else
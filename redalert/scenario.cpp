@@ -826,6 +826,16 @@ void Clear_Scenario(void)
         Scen.Waypoint[index] = -1;
     }
 
+    /*
+    **	Everything that was allocated for the scenario's lifetime goes at once.
+    */
+    if (ScenarioArena.High_Water() != 0) {
+        DBG_INFO("Scenario arena high water %lu bytes, %lu bytes reserved",
+                 ScenarioArena.High_Water(),
+                 ScenarioArena.Reserved());
+    }
+    ScenarioArena.Reset();
+
 #ifdef FIXIT_VERSION_3 //	For endgame auto-sonar pulse.
     bAutoSonarPulse = false;
 #endif
@@ -2126,6 +2136,7 @@ bool Read_Scenario_INI(char* fname, bool)
     CCINIClass ini;
     CCFileClass file(fname);
     //	file.Cache();
+    ini.Set_Arena(&ScenarioArena);
 
     int result = ini.Load(file, true);
     if (result == 0) {
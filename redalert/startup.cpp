@@ -356,6 +356,7 @@ int main(int argc, char* argv[])
         Memory_Error_Exit = Print_Error_End_Exit;
 
         Main_Game(argc, argv);
+        Save_Game_Wait();
 
         if (RunningAsDLL) { // PG
             return (EXIT_SUCCESS);
@@ -368,6 +369,13 @@ int main(int argc, char* argv[])
         Settings.Save(ini);
         ini.Save(cfile);
 
+        /*
+        ** Leave a record of where the memory went this session, if asked for with -MEMREPORT.
+        */
+        if (Debug_Memory_Report) {
+            Memory_Report_File((std::string(Paths.User_Path()) + PathsClass::SEP + "memory.txt").c_str());
+        }
+
         VisiblePage.Clear();
         HiddenPage.Clear();
         Memory_Error_Exit = Print_Error_Exit;
@@ -262,9 +262,9 @@ void TActionClass::Read_INI(void)
 
         /*
         **	Since triggers refer to other triggers, only record a copy of the trigger text
-        **	name. This will be fixed up later.
+        **	name. This will be fixed up later. The copy goes when the scenario is cleared.
         */
-        Trigger.Set_Raw((long)strdup(strtok(NULL, ",")));
+        Trigger.Set_Raw((long)ScenarioArena.Duplicate(strtok(NULL, ",")));
 
         Data.Value = atoi(strtok(NULL, ","));
         break;
@@ -2132,13 +2132,11 @@ void TriggerTypeClass::Read_INI(CCINIClass& ini)
             char* ptr = (char*)trigger->Action1.Trigger.Raw();
             if (ptr /*&& trigger->Action1.Trigger.Raw() != -1*/) {
                 trigger->Action1.Trigger = TriggerTypeClass::From_Name(ptr);
-                free(ptr);
             }
 
             ptr = (char*)trigger->Action2.Trigger.Raw();
             if (ptr /*&& trigger->Action2.Trigger.Raw() != -1*/) {
                 trigger->Action2.Trigger = TriggerTypeClass::From_Name(ptr);
-                free(ptr);
             }
         }
     }
@@ -63,9 +63,17 @@ static VersionProtocolType VersionProtocol[] = {
     {0x00001000, COMM_PROTOCOL_SINGLE_NO_COMP}, // (obsolete)
     {0x00002000, COMM_PROTOCOL_SINGLE_E_COMP},  // (obsolete)
     {0x00010000, COMM_PROTOCOL_MULTI_E_COMP},
+    {0x00030004, COMM_PROTOCOL_MULTI_E_PACK},
 };
 
 #define GAME_VERSION 0x30003
+
+//---------------------------------------------------------------------------
+// Highest version we'll negotiate up to.  Two copies of this program clip to
+// it and use the packed event protocol; against a 3.03 game the range clips
+// back to GAME_VERSION and the old compressed protocol.
+//---------------------------------------------------------------------------
+#define GAME_VERSION_PACKED 0x30004
 VersionClass VerNum;
 
 /***************************************************************************
@@ -675,7 +683,7 @@ unsigned long VersionClass::Max_Version(void)
 
     //	Note! I'm no longer using MIN_VERSION, MAX_VERSION, or VERSION_RA_300!
     //	But no time to do three full rebuilds right now, so I'm not deleting them from the header file...   ajw
-    return GAME_VERSION;
+    return GAME_VERSION_PACKED;
 
 #else
 
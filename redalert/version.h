@@ -67,6 +67,7 @@ typedef enum CommProtocolEnum
     COMM_PROTOCOL_SINGLE_NO_COMP = 0, // single frame with no compression
     COMM_PROTOCOL_SINGLE_E_COMP,      // single frame with event compression
     COMM_PROTOCOL_MULTI_E_COMP,       // multiple frame with event compression
+    COMM_PROTOCOL_MULTI_E_PACK,       // multiple frame with bit packed, delta coded events
     COMM_PROTOCOL_COUNT,
     DEFAULT_COMM_PROTOCOL = COMM_PROTOCOL_MULTI_E_COMP
 } CommProtocolType;
@@ -57,7 +57,12 @@
 
 #include <stdio.h>
 
-#ifdef NETWORKING
+#if defined(NETWORKING) && !defined(_WIN32)
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#if defined(NETWORKING) && defined(_WIN32)
 
 /***********************************************************************************************
  * WIC::WinsockInterfaceClass -- constructor for the WinsockInterfaceClass                     *
@@ -560,6 +565,163 @@ bool WinsockInterfaceClass::Set_Socket_Options(void)
     return (true);
 }
 
+#elif defined(NETWORKING)
+
+/*
+** POSIX version. There is no library to start and no window to post socket events to, so the socket is non-blocking
+** and the derived protocol class pumps it from Service, which runs whenever the game reads or writes a packet and
+** once a frame from the game loop.
+*/
+WinsockInterfaceClass::WinsockInterfaceClass(void)
+{
+    WinsockInitialised = false;
+    Socket = INVALID_SOCKET;
+}
+
+WinsockInterfaceClass::~WinsockInterfaceClass(void)
+{
+    Close();
+}
+
+void WinsockInterfaceClass::Close(void)
+{
+    if (!WinsockInitialised)
+        return;
+
+    Stop_Listening();
+    Close_Socket();
+    Discard_In_Buffers();
+    Discard_Out_Buffers();
+
+    WinsockInitialised = false;
+}
+
+void WinsockInterfaceClass::Close_Socket(void)
+{
+    if (Socket != INVALID_SOCKET) {
+        close(Socket);
+        Socket = INVALID_SOCKET;
+    }
+}
+
+bool WinsockInterfaceClass::Start_Listening(void)
+{
+    return (Socket != INVALID_SOCKET);
+}
+
+void WinsockInterfaceClass::Stop_Listening(void)
+{
+}
+
+void WinsockInterfaceClass::Discard_In_Buffers(void)
+{
+    while (InBuffers.Count()) {
+        delete InBuffers[0];
+        InBuffers.Delete(0);
+    }
+}
+
+void WinsockInterfaceClass::Discard_Out_Buffers(void)
+{
+    while (OutBuffers.Count()) {
+        delete OutBuffers[0];
+        OutBuffers.Delete(0);
+    }
+}
+
+bool WinsockInterfaceClass::Init(void)
+{
+    if (WinsockInitialised)
+        return (true);
+
+    Socket = INVALID_SOCKET;
+    Discard_In_Buffers();
+    Discard_Out_Buffers();
+
+    WinsockInitialised = true;
+    return (true);
+}
+
+int WinsockInterfaceClass::Read(void* buffer, int& buffer_len, void* address, int& address_len)
+{
+    /*
+    ** Pick up anything that has arrived since we last looked.
+    */
+    Service();
+
+    if (InBuffers.Count() == 0)
+        return (0);
+
+    WinsockBufferType* packet = InBuffers[0];
+
+    assert(buffer_len >= packet->BufferLen);
+    assert(address_len >= (int)sizeof(packet->Address));
+
+    memcpy(buffer, packet->Buffer, packet->BufferLen);
+    memcpy(address, packet->Address, sizeof(packet->Address));
+    buffer_len = packet->BufferLen;
+
+    InBuffers.Delete(0);
+    delete packet;
+
+    return (buffer_len);
+}
+
+void WinsockInterfaceClass::WriteTo(void* buffer, int buffer_len, void* address)
+{
+    WinsockBufferType* packet = new WinsockBufferType;
+
+    memcpy(packet->Buffer, buffer, buffer_len);
+    packet->BufferLen = buffer_len;
+    packet->IsBroadcast = false;
+    memcpy(packet->Address, address, sizeof(IPXAddressClass));
+
+    OutBuffers.Add(packet);
+
+    /*
+    ** Send it now if the socket will take it.
+    */
+    Service();
+}
+
+void WinsockInterfaceClass::Broadcast(void* buffer, int buffer_len)
+{
+    WinsockBufferType* packet = new WinsockBufferType;
+
+    memcpy(packet->Buffer, buffer, buffer_len);
+    packet->BufferLen = buffer_len;
+    packet->IsBroadcast = true;
+
+    OutBuffers.Add(packet);
+    Service();
+}
+
+void WinsockInterfaceClass::Clear_Socket_Error(SOCKET socket)
+{
+    int error_code = 0;
+    socklen_t length = sizeof(error_code);
+
+    /*
+    ** Reading SO_ERROR clears it.
+    */
+    getsockopt(socket, SOL_SOCKET, SO_ERROR, &error_code, &length);
+}
+
+bool WinsockInterfaceClass::Set_Socket_Options(void)
+{
+    int size = SOCKET_BUFFER_SIZE;
+
+    if (setsockopt(Socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) != 0) {
+        WWDebugString("TS: Failed to set UDP socket option SO_RCVBUF.\n");
+    }
+
+    if (setsockopt(Socket, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size)) != 0) {
+        WWDebugString("TS: Failed to set UDP socket option SO_SNDBUF.\n");
+    }
+
+    return (true);
+}
+
 #else // NETWORKING
 
 WinsockInterfaceClass::WinsockInterfaceClass(void)
@@ -39,8 +39,11 @@
 /*
 ** Include standard Winsock 1.0 header file.
 */
-#ifdef NETWORKING
+#if defined(NETWORKING) && defined(_WIN32)
 #include <winsock.h>
+#elif defined(NETWORKING)
+#define SOCKET         int
+#define INVALID_SOCKET (-1)
 #else
 #define SOCKET short
 #endif
@@ -124,6 +127,12 @@ public:
         return (false);
     };
 
+    /*
+    ** Moves packets between the socket and the in and out buffers. Windows does this from its message handler,
+    ** elsewhere it happens whenever the game reads or writes and once a frame from the game loop.
+    */
+    virtual void Service(void){};
+
 #ifdef _WIN32
     virtual long Message_Handler(HWND, UINT, UINT, LONG)
     {
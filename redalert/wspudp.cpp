@@ -124,6 +124,8 @@ void UDPInterfaceClass::Set_Broadcast_Address(void* address)
     BroadcastAddresses.Add(baddr);
 }
 
+#ifdef _WIN32
+
 /***********************************************************************************************
  * UDPInterfaceClass::Open_Socket -- Opens a socket for communications via the UDP protocol    *
  *                                                                                             *
@@ -428,4 +430,135 @@ long UDPInterfaceClass::Message_Handler(HWND, UINT message, UINT, LONG lParam)
     return (0);
 }
 
+#else // _WIN32
+
+/*
+** The POSIX version keeps the port a packet came from, or is going to, in the two spare bytes of the node address
+** after the IP address. That gives copies of the game sharing a machine distinct addresses. An address with no port,
+** as the Windows version makes, means the game port.
+*/
+#define UDP_ADDRESS_IP   4
+#define UDP_ADDRESS_PORT 8
+
+/*
+** Windows gets this from the Winsock manager in common/tcpip.cpp, which isn't built here.
+*/
+unsigned short PlanetWestwoodPortNumber = UDP_GAME_PORT;
+
+bool UDPInterfaceClass::Open_Socket(SOCKET)
+{
+    if (!WinsockInitialised) {
+        if (!Init())
+            return (false);
+    }
+
+    if (!Udp.Open((unsigned short)PlanetWestwoodPortNumber, UDP_PORT_SPAN)) {
+        return (false);
+    }
+
+    Socket = Udp.Handle();
+    WinsockInterfaceClass::Set_Socket_Options();
+
+    return (true);
+}
+
+void UDPInterfaceClass::Close_Socket(void)
+{
+    Udp.Close();
+    Socket = INVALID_SOCKET;
+}
+
+/*
+** Broadcasts go to every port a copy of the game could have taken. Without any broadcast address set they go to
+** the local network and to this machine.
+*/
+void UDPInterfaceClass::Broadcast(void* buffer, int buffer_len)
+{
+    static unsigned char const default_addresses[2][4] = {{255, 255, 255, 255}, {127, 0, 0, 1}};
+    int count = BroadcastAddresses.Count() ? BroadcastAddresses.Count() : 2;
+
+    for (int i = 0; i < count; i++) {
+        unsigned char const* ip = BroadcastAddresses.Count() ? BroadcastAddresses[i] : default_addresses[i];
+
+        for (int port = 0; port < UDP_PORT_SPAN; port++) {
+            WinsockBufferType* packet = new WinsockBufferType;
+            unsigned short port_number = hton16((unsigned short)(PlanetWestwoodPortNumber + port));
+
+            memcpy(packet->Buffer, buffer, buffer_len);
+            packet->BufferLen = buffer_len;
+            packet->IsBroadcast = true;
+            memset(packet->Address, 0, sizeof(packet->Address));
+            memcpy(packet->Address + UDP_ADDRESS_IP, ip, 4);
+            memcpy(packet->Address + UDP_ADDRESS_PORT, &port_number, 2);
+            OutBuffers.Add(packet);
+        }
+    }
+
+    Service();
+}
+
+/*
+** Drains the socket into the in buffers, then sends as much of the out buffers as the socket will take, a batch
+** at a time.
+*/
+void UDPInterfaceClass::Service(void)
+{
+    if (!Udp.Is_Open())
+        return;
+
+    int count;
+
+    do {
+        count = Udp.Receive(Batch, UDPSocketClass::MAX_BATCH);
+
+        for (int i = 0; i < count; i++) {
+            /*
+            ** Throw away our own broadcasts.
+            */
+            if (Batch[i].Length == 0 || Udp.Is_Local(Batch[i].Address, Batch[i].Port))
+                continue;
+
+            WinsockBufferType* packet = new WinsockBufferType;
+            packet->BufferLen = Batch[i].Length;
+            packet->IsBroadcast = false;
+            memcpy(packet->Buffer, Batch[i].Data, Batch[i].Length);
+            memset(packet->Address, 0, sizeof(packet->Address));
+            memcpy(packet->Address + UDP_ADDRESS_IP, &Batch[i].Address, 4);
+            memcpy(packet->Address + UDP_ADDRESS_PORT, &Batch[i].Port, 2);
+            InBuffers.Add(packet);
+        }
+    } while (count == UDPSocketClass::MAX_BATCH);
+
+    while (OutBuffers.Count()) {
+        count = MIN(OutBuffers.Count(), (int)UDPSocketClass::MAX_BATCH);
+
+        for (int i = 0; i < count; i++) {
+            WinsockBufferType* packet = OutBuffers[i];
+
+            memcpy(&Batch[i].Address, packet->Address + UDP_ADDRESS_IP, 4);
+            memcpy(&Batch[i].Port, packet->Address + UDP_ADDRESS_PORT, 2);
+            if (Batch[i].Port == 0) {
+                Batch[i].Port = hton16((unsigned short)PlanetWestwoodPortNumber);
+            }
+            Batch[i].Length = packet->BufferLen;
+            memcpy(Batch[i].Data, packet->Buffer, packet->BufferLen);
+        }
+
+        /*
+        ** Anything the socket wouldn't take yet stays queued for the next call.
+        */
+        int sent = Udp.Send(Batch, count);
+
+        for (int i = 0; i < sent; i++) {
+            delete OutBuffers[0];
+            OutBuffers.Delete(0);
+        }
+
+        if (sent < count)
+            break;
+    }
+}
+
+#endif // _WIN32
+
 #endif // NETWORKING
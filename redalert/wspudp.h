@@ -36,6 +36,21 @@
 
 #include "wsproto.h"
 
+#if defined(NETWORKING) && !defined(_WIN32)
+#include "common/udpsock.h"
+#endif
+
+/*
+** Copies of the game on one machine each take the first free port this many ports up from the game port, and
+** broadcasts go to all of them.
+*/
+#define UDP_PORT_SPAN 4
+
+/*
+** Port used when nothing else has set one.
+*/
+#define UDP_GAME_PORT 0x1001
+
 /*
 ** Class to allow access to UDP specific portions of the Winsock interface.
 **
@@ -49,6 +64,9 @@ public:
 
 #ifdef _WIN32
     virtual long Message_Handler(HWND window, UINT message, UINT wParam, LONG lParam);
+#elif defined(NETWORKING)
+    virtual void Close_Socket(void);
+    virtual void Service(void);
 #endif
     virtual bool Open_Socket(SOCKET socketnum);
     virtual void Set_Broadcast_Address(void* address);
@@ -74,6 +92,14 @@ private:
     ** List of local addresses.
     */
     DynamicVectorClass<unsigned char*> LocalAddresses;
+
+#if defined(NETWORKING) && !defined(_WIN32)
+    /*
+    ** The socket itself, and room to move a batch of packets through it at a time.
+    */
+    UDPSocketClass Udp;
+    UDPSocketClass::PacketType Batch[UDPSocketClass::MAX_BATCH];
+#endif
 };
 
 #endif
\ No newline at end of file
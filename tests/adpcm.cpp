@@ -0,0 +1,555 @@
+#include "common/auduncmp.h"
+#include "common/soscomp.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+static const short RefIndexTab[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+static const short RefStepTab[89] = {
+    7,    8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,   28,
+    31,   34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,  118,
+    130,  143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,  494,
+    544,  598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878, 2066,
+    2272, 2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845, 8630,
+    9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+static const signed char RefZapTwo[4] = {-2, -1, 0, 1};
+
+static const signed char RefZapFour[16] = {-9, -8, -6, -5, -4, -3, -2, -1, 0, 1, 2, 3, 4, 5, 6, 8};
+
+static int ref_clamp(int x, int low, int high)
+{
+    return ((x) > (high)) ? (high) : (((x) < (low)) ? (low) : (x));
+}
+
+// Straight port of the original nybble at a time decoder, used as the reference for conformance.
+static unsigned long Reference_SOS_Decompress(_SOS_COMPRESS_INFO* stream, unsigned long bytes)
+{
+    short current_nybble;
+    unsigned step;
+    int sample;
+    unsigned full_length;
+
+    full_length = bytes;
+    stream->dwSampleIndex = 0;
+    stream->dwSampleIndex2 = 0;
+
+    if (stream->wBitSize == 16) {
+        bytes /= 2;
+    }
+
+    char* src = stream->lpSource;
+    short* dst = (short*)(stream->lpDest);
+
+    // Handle stereo.
+    if (stream->wChannels == 2) {
+        current_nybble = 0;
+        for (int i = bytes; i > 0; i -= 2) {
+            if ((stream->dwSampleIndex & 1) != 0) {
+                current_nybble = stream->wCodeBuf >> 4;
+                stream->wCode = current_nybble;
+            } else {
+                stream->wCodeBuf = *src;
+                // Stereo is interleaved so skip a byte for this channel.
+                src += 2;
+                current_nybble = stream->wCodeBuf & 0xF;
+                stream->wCode = current_nybble;
+            }
+
+            step = stream->wStep;
+            stream->dwDifference = step >> 3;
+
+            if ((current_nybble & 4) != 0) {
+                stream->dwDifference += step;
+            }
+
+            if ((current_nybble & 2) != 0) {
+                stream->dwDifference += step >> 1;
+            }
+
+            if ((current_nybble & 1) != 0) {
+                stream->dwDifference += step >> 2;
+            }
+
+            if ((current_nybble & 8) != 0) {
+                stream->dwDifference = -stream->dwDifference;
+            }
+
+            sample = ref_clamp(stream->dwDifference + stream->dwPredicted, -32768, 32767);
+            stream->dwPredicted = sample;
+
+            if (stream->wBitSize == 16) {
+                *dst = sample;
+                // Stereo is interleaved so skip a sample for this channel.
+                dst += 2;
+            } else {
+                *dst++ = ((sample & 0xFF00) >> 8) ^ 0x80;
+            }
+
+            stream->wIndex += RefIndexTab[stream->wCode & 0x7];
+            stream->wIndex = ref_clamp(stream->wIndex, 0, 88);
+            ++stream->dwSampleIndex;
+            stream->wStep = RefStepTab[stream->wIndex];
+        }
+
+        src = stream->lpSource + 1;
+        dst = (short*)(stream->lpDest + 1);
+
+        if (stream->wBitSize == 16) {
+            dst = (short*)(stream->lpDest) + 1;
+        }
+
+        for (int i = bytes; i > 0; i -= 2) {
+            if ((stream->dwSampleIndex2 & 1) != 0) {
+                current_nybble = stream->wCodeBuf2 >> 4;
+                stream->wCode2 = current_nybble;
+            } else {
+                stream->wCodeBuf2 = *src;
+                // Stereo is interleaved so skip a byte for this channel.
+                src += 2;
+                current_nybble = stream->wCodeBuf2 & 0xF;
+                stream->wCode2 = current_nybble;
+            }
+
+            step = stream->wStep2;
+            stream->dwDifference2 = step >> 3;
+
+            if ((current_nybble & 4) != 0) {
+                stream->dwDifference2 += step;
+            }
+
+            if ((current_nybble & 2) != 0) {
+                stream->dwDifference2 += step >> 1;
+            }
+
+            if ((current_nybble & 1) != 0) {
+                stream->dwDifference2 += step >> 2;
+            }
+
+            if ((current_nybble & 8) != 0) {
+                stream->dwDifference2 = -stream->dwDifference2;
+            }
+
+            sample = ref_clamp(stream->dwDifference2 + stream->dwPredicted2, -32768, 32767);
+            stream->dwPredicted2 = sample;
+
+            if (stream->wBitSize == 16) {
+                *dst = sample;
+                // Stereo is interleaved so skip a sample for this channel.
+                dst += 2;
+            } else {
+                *dst++ = ((sample & 0xFF00) >> 8) ^ 0x80;
+            }
+
+            stream->wIndex2 += RefIndexTab[stream->wCode2 & 0x7];
+            stream->wIndex2 = ref_clamp(stream->wIndex2, 0, 88);
+            ++stream->dwSampleIndex2;
+            stream->wStep2 = RefStepTab[stream->wIndex2];
+        }
+    } else {
+        for (int i = bytes; i > 0; --i) {
+            if ((stream->dwSampleIndex & 1) != 0) {
+                current_nybble = stream->wCodeBuf >> 4;
+                stream->wCode = current_nybble;
+            } else {
+                stream->wCodeBuf = *src++;
+                current_nybble = stream->wCodeBuf & 0xF;
+                stream->wCode = current_nybble;
+            }
+
+            step = stream->wStep;
+            stream->dwDifference = step >> 3;
+
+            if ((current_nybble & 4) != 0) {
+                stream->dwDifference += step;
+            }
+
+            if ((current_nybble & 2) != 0) {
+                stream->dwDifference += step >> 1;
+            }
+
+            if ((current_nybble & 1) != 0) {
+                stream->dwDifference += step >> 2;
+            }
+
+            if ((current_nybble & 8) != 0) {
+                stream->dwDifference = -stream->dwDifference;
+            }
+
+            sample = ref_clamp(stream->dwDifference + stream->dwPredicted, -32768, 32767);
+            stream->dwPredicted = sample;
+
+            if (stream->wBitSize == 16) {
+                *dst++ = sample;
+            } else {
+                *dst = ((sample & 0xFF00) >> 8) ^ 0x80;
+                dst = (short*)((char*)(dst) + 1);
+            }
+
+            stream->wIndex += RefIndexTab[stream->wCode & 0x7];
+            stream->wIndex = ref_clamp(stream->wIndex, 0, 88);
+            ++stream->dwSampleIndex;
+            stream->wStep = RefStepTab[stream->wIndex];
+        };
+    }
+
+    return full_length;
+}
+
+
+// Straight port of the original Westwood decoder, used as the reference for conformance.
+static short Reference_Audio_Unzap(void* source, void* dest, short size)
+{
+    short sample;
+    unsigned char code;
+    signed char count;
+    unsigned short shifted;
+
+    sample = 0x80; //-128
+    unsigned char* src = (unsigned char*)(source);
+    unsigned char* dst = (unsigned char*)(dest);
+    unsigned short remaining = size;
+
+    while (remaining > 0) { // expecting more output
+        shifted = *src++;
+        shifted <<= 2;
+        code = (shifted & 0xFF00) >> 8;
+        count = (shifted & 0x00FF) >> 2;
+
+        switch (code) {
+        case 2: // no compression...
+            if (count & 0x20) {
+                count <<= 3;          // here it's significant that (count) is signed:
+                sample += count >> 3; // the sign bit will be copied by these shifts!
+                *dst++ = ref_clamp(sample, 0, 255);
+                remaining--; // one byte added to output
+            } else {
+                for (++count; count > 0; --count) {
+                    --remaining;
+                    *dst++ = *src++;
+                }
+
+                sample = *(src - 1); // set (sample) to the last byte sent to output
+            }
+            break;
+
+        case 1:                                 // ADPCM 8-bit -> 4-bit
+            for (++count; count > 0; --count) { // decode (count+1) bytes
+                code = *src++;
+                sample += RefZapFour[(code & 0x0F)]; // lower nibble
+                *dst++ = ref_clamp(sample, 0, 255);
+                sample += RefZapFour[(code >> 4)]; // higher nibble
+                *dst++ = ref_clamp(sample, 0, 255);
+                remaining -= 2; // two bytes added to output
+            }
+            break;
+
+        case 0:                                 // ADPCM 8-bit -> 2-bit
+            for (++count; count > 0; --count) { // decode (count+1) bytes
+                code = *src++;
+                sample += RefZapTwo[(code & 0x03)]; // lower 2 bits
+                *dst++ = ref_clamp(sample, 0, 255);
+                sample += RefZapTwo[((code >> 2) & 0x03)]; // lower middle 2 bits
+                *dst++ = ref_clamp(sample, 0, 255);
+                sample += RefZapTwo[((code >> 4) & 0x03)]; // higher middle 2 bits
+                *dst++ = ref_clamp(sample, 0, 255);
+                sample += RefZapTwo[((code >> 6) & 0x03)]; // higher 2 bits
+                *dst++ = ref_clamp(sample, 0, 255);
+                remaining -= 4; // 4 bytes sent to output
+            }
+            break;
+
+        default: // just copy (sample) (count+1) times to output
+            memset(dst, ref_clamp(sample, 0, 255), ++count);
+            remaining -= count;
+            dst += count;
+            break;
+        }
+    }
+
+    return size - remaining;
+}
+
+
+// Small deterministic generator so the corpus is identical on every run and platform.
+static uint32_t corpus_seed;
+
+static unsigned Corpus_Random(unsigned range)
+{
+    corpus_seed = corpus_seed * 1664525 + 1013904223;
+    return (corpus_seed >> 8) % range;
+}
+
+// Compresses a tone with noise on top, loud enough to reach the clamps and the top of the step table.
+static std::vector<char> Make_SOS_Stream(unsigned samples, int channels, int bits)
+{
+    std::vector<short> wave(samples);
+
+    for (unsigned i = 0; i < samples; ++i) {
+        wave[i] = (short)ref_clamp((int)(sin(i * 0.03) * 30000 + sin(i * 0.7) * 6000) + (int)Corpus_Random(4000) - 2000,
+                                   -32768,
+                                   32767);
+    }
+
+    unsigned bytes = bits == 16 ? samples * 2 : samples;
+    std::vector<char> packed(samples / 2 + 2);
+    _SOS_COMPRESS_INFO info = {};
+    info.wBitSize = bits;
+    info.wChannels = channels;
+    info.lpSource = (char*)wave.data();
+    info.lpDest = packed.data();
+    sosCODECInitStream(&info);
+    sosCODECCompressData(&info, bytes);
+
+    return packed;
+}
+
+static bool Same_State(_SOS_COMPRESS_INFO const& a, _SOS_COMPRESS_INFO const& b)
+{
+    return a.dwSampleIndex == b.dwSampleIndex && a.dwPredicted == b.dwPredicted && a.dwDifference == b.dwDifference
+           && a.wCodeBuf == b.wCodeBuf && a.wCode == b.wCode && a.wStep == b.wStep && a.wIndex == b.wIndex
+           && a.dwSampleIndex2 == b.dwSampleIndex2 && a.dwPredicted2 == b.dwPredicted2
+           && a.dwDifference2 == b.dwDifference2 && a.wCodeBuf2 == b.wCodeBuf2 && a.wCode2 == b.wCode2
+           && a.wStep2 == b.wStep2 && a.wIndex2 == b.wIndex2;
+}
+
+int test_sos_conformance()
+{
+    int ret = 0;
+
+    corpus_seed = 0x534F53;
+
+    for (int i = 0; i < 64; ++i) {
+        int channels = (i & 1) + 1;
+        int bits = (i & 2) != 0 ? 8 : 16;
+        unsigned samples = 2000 + Corpus_Random(20000);
+        std::vector<char> packed = Make_SOS_Stream(samples, channels, bits);
+
+        // Random garbage decodes too, and walks the table in ways a real stream rarely does.
+        if ((i & 4) != 0) {
+            for (unsigned j = 0; j < packed.size(); ++j) {
+                packed[j] = Corpus_Random(256);
+            }
+        }
+
+        unsigned total = bits == 16 ? samples * 2 : samples;
+        std::vector<char> expected(total + 4, 0);
+        std::vector<char> actual(total + 4, 0);
+        _SOS_COMPRESS_INFO ref = {};
+        _SOS_COMPRESS_INFO act = {};
+        ref.wBitSize = act.wBitSize = bits;
+        ref.wChannels = act.wChannels = channels;
+        sosCODECInitStream(&ref);
+        sosCODECInitStream(&act);
+
+        // Decode in blocks as the streaming code does, the odd sizes leave a nybble or a channel sample over.
+        unsigned pos = 0;
+        unsigned packed_pos = 0;
+
+        while (pos < total) {
+            unsigned block = 1 + Corpus_Random(4096);
+            if (block > total - pos) {
+                block = total - pos;
+            }
+
+            // Keep 8 bit stereo blocks channel aligned so the left and right bytes stay where the check expects them.
+            if (channels == 2 && bits == 8 && block > 1) {
+                block &= ~1u;
+            }
+
+            ref.lpSource = act.lpSource = &packed[packed_pos];
+            ref.lpDest = &expected[pos];
+            act.lpDest = &actual[pos];
+            unsigned long ref_len = Reference_SOS_Decompress(&ref, block);
+            unsigned long act_len = sosCODECDecompressData(&act, block);
+
+            if (ref_len != act_len || !Same_State(ref, act)) {
+                fprintf(stderr, "sosCODECDecompressData state differs from reference on stream %d.\n", i);
+                ret = 1;
+                break;
+            }
+
+            // Whole code bytes are consumed per call, per channel for stereo.
+            unsigned per_channel = (bits == 16 ? block / 2 : block) / channels;
+            packed_pos += (per_channel + 1) / 2 * channels;
+            pos += block;
+
+            if (packed_pos + 4096 > packed.size()) {
+                break;
+            }
+        }
+
+        // The original wrote 8 bit stereo a short at a time, so the second channel's pass zeroed every left sample
+        // after the first. Only the right channel can be held to it there.
+        bool differs = false;
+
+        for (unsigned j = 0; j < pos; ++j) {
+            if (expected[j] != actual[j] && (channels == 1 || bits == 16 || (j & 1) != 0)) {
+                differs = true;
+                break;
+            }
+        }
+
+        if (differs) {
+            fprintf(stderr,
+                    "sosCODECDecompressData differs from reference on stream %d (%d channel, %d bit).\n",
+                    i,
+                    channels,
+                    bits);
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
+
+// Builds a valid Westwood compressed stream using every command, with counts that never overrun the output.
+static std::vector<unsigned char> Make_Zap_Stream(unsigned size)
+{
+    std::vector<unsigned char> stream;
+    unsigned remaining = size;
+
+    while (remaining > 0) {
+        unsigned mode = Corpus_Random(5);
+
+        if (mode == 0 && remaining >= 4) {
+            unsigned count = Corpus_Random(remaining / 4 < 64 ? remaining / 4 : 64);
+            stream.push_back(count);
+            for (unsigned i = 0; i <= count; ++i) {
+                stream.push_back(Corpus_Random(256));
+            }
+            remaining -= (count + 1) * 4;
+        } else if (mode == 1 && remaining >= 2) {
+            unsigned count = Corpus_Random(remaining / 2 < 64 ? remaining / 2 : 64);
+            stream.push_back(0x40 | count);
+            for (unsigned i = 0; i <= count; ++i) {
+                stream.push_back(Corpus_Random(256));
+            }
+            remaining -= (count + 1) * 2;
+        } else if (mode == 2) {
+            unsigned count = Corpus_Random(remaining < 32 ? remaining : 32);
+            stream.push_back(0x80 | count);
+            for (unsigned i = 0; i <= count; ++i) {
+                stream.push_back(Corpus_Random(256));
+            }
+            remaining -= count + 1;
+        } else {
+            unsigned count = Corpus_Random(remaining < 64 ? remaining : 64);
+            stream.push_back(0xC0 | count);
+            remaining -= count + 1;
+        }
+    }
+
+    return stream;
+}
+
+int test_zap_conformance()
+{
+    int ret = 0;
+
+    corpus_seed = 0x5A4150;
+
+    for (int i = 0; i < 200; ++i) {
+        unsigned size = 1 + Corpus_Random(30000);
+        std::vector<unsigned char> stream = Make_Zap_Stream(size);
+        std::vector<unsigned char> expected(size + 64, 0);
+        std::vector<unsigned char> actual(size + 64, 0);
+
+        short ref_len = Reference_Audio_Unzap(stream.data(), expected.data(), size);
+        short act_len = Audio_Unzap(stream.data(), actual.data(), size);
+
+        if (ref_len != act_len || expected != actual) {
+            fprintf(stderr, "Audio_Unzap differs from reference on stream %d.\n", i);
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
+
+int bench_adpcm()
+{
+    corpus_seed = 0x42454E43;
+
+    for (int channels = 1; channels <= 2; ++channels) {
+        // A second of 22kHz 16 bit audio, decoded a streaming block at a time.
+        unsigned const samples = 22050 * channels;
+        unsigned const block = 8192;
+        std::vector<char> packed = Make_SOS_Stream(samples, channels, 16);
+        std::vector<char> dest(samples * 2);
+
+        for (int variant = 0; variant < 2; ++variant) {
+            static char const* names[] = {"reference", "sosCODECDecompressData"};
+            double bytes = 0;
+            double secs = 0;
+            auto start = std::chrono::steady_clock::now();
+
+            do {
+                _SOS_COMPRESS_INFO info = {};
+                info.wBitSize = 16;
+                info.wChannels = channels;
+                sosCODECInitStream(&info);
+
+                for (unsigned pos = 0; pos + block <= samples * 2; pos += block) {
+                    info.lpSource = &packed[pos / 4];
+                    info.lpDest = &dest[pos];
+                    if (variant == 0) {
+                        Reference_SOS_Decompress(&info, block);
+                    } else {
+                        sosCODECDecompressData(&info, block);
+                    }
+                    bytes += block;
+                }
+
+                secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            } while (secs < 0.1);
+
+            printf("%-7s %-24s %8.1f MB/s\n", channels == 1 ? "mono" : "stereo", names[variant], bytes / secs / 1e6);
+        }
+    }
+
+    unsigned const size = 22050;
+    std::vector<unsigned char> stream = Make_Zap_Stream(size);
+    std::vector<unsigned char> dest(size);
+
+    for (int variant = 0; variant < 2; ++variant) {
+        static char const* names[] = {"reference", "Audio_Unzap"};
+        double bytes = 0;
+        double secs = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        do {
+            if (variant == 0) {
+                Reference_Audio_Unzap(stream.data(), dest.data(), size);
+            } else {
+                Audio_Unzap(stream.data(), dest.data(), size);
+            }
+            bytes += size;
+            secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (secs < 0.1);
+
+        printf("%-7s %-24s %8.1f MB/s\n", "zap", names[variant], bytes / secs / 1e6);
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_sos_conformance();
+    ret |= test_zap_conformance();
+
+    // Benchmarks only run when asked for, e.g. "test_adpcm bench".
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        ret |= bench_adpcm();
+    }
+
+    return ret;
+}
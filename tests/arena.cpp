@@ -0,0 +1,149 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common/arena.h"
+#include "common/ini.h"
+#include "common/xstraw.h"
+
+#include <string>
+
+int test_arena()
+{
+    ArenaClass arena(1024);
+
+    char* first = (char*)arena.Alloc(10);
+    char* second = (char*)arena.Alloc(100);
+
+    if (first == NULL || second == NULL || ((uintptr_t)first | (uintptr_t)second) % (sizeof(void*) * 2) != 0) {
+        fprintf(stderr, "ArenaClass::Alloc returned unaligned memory.\n");
+        return 1;
+    }
+
+    if (second < first + 10) {
+        fprintf(stderr, "ArenaClass::Alloc returned overlapping memory.\n");
+        return 1;
+    }
+
+    // Fill a few blocks and one request too big for a block.
+    for (int i = 0; i < 40; ++i) {
+        memset(arena.Alloc(100), i, 100);
+    }
+    void* large = arena.Alloc(5000);
+    memset(large, 0xFF, 5000);
+
+    unsigned long high_water = arena.High_Water();
+    unsigned long reserved = arena.Reserved();
+
+    if (arena.Used() != high_water || high_water < 10 + 100 + 40 * 100 + 5000 || reserved < high_water) {
+        fprintf(stderr, "ArenaClass counts are wrong: %lu used, %lu reserved.\n", arena.Used(), reserved);
+        return 1;
+    }
+
+    char* copy = arena.Duplicate("Trigger name");
+    if (copy == NULL || strcmp(copy, "Trigger name") != 0) {
+        fprintf(stderr, "ArenaClass::Duplicate didn't copy the string.\n");
+        return 1;
+    }
+
+    // A reset keeps the standard blocks and starts again from the first one.
+    arena.Reset();
+
+    if (arena.Used() != 0 || arena.High_Water() != 0 || arena.Peak() < high_water) {
+        fprintf(stderr, "ArenaClass::Reset didn't clear the counts.\n");
+        return 1;
+    }
+
+    if (arena.Reserved() >= reserved || arena.Reserved() == 0) {
+        fprintf(stderr, "ArenaClass::Reset should free only the large block.\n");
+        return 1;
+    }
+
+    if (arena.Alloc(10) != first) {
+        fprintf(stderr, "ArenaClass::Reset didn't rewind to the first block.\n");
+        return 1;
+    }
+
+    static char const text[] = "[Basic]\nName=Test\n";
+    BufferStraw straw(text, sizeof(text) - 1);
+    int length = 0;
+    char* data = arena.Read(straw, length);
+
+    if (data == NULL || length != (int)sizeof(text) - 1 || memcmp(data, text, length) != 0) {
+        fprintf(stderr, "ArenaClass::Read didn't read the stream.\n");
+        return 1;
+    }
+    data[length] = '\0';
+
+    arena.Release();
+
+    if (arena.Reserved() != 0 || arena.Used() != 0) {
+        fprintf(stderr, "ArenaClass::Release didn't give the blocks back.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+** Loads a scenario's INI into a shared arena over and over the way a campaign restart does. After the first
+** round the arena should never need more than it already holds.
+*/
+int test_arena_ini()
+{
+    ArenaClass arena;
+    std::string text;
+    char line[128];
+
+    text += "[Basic]\r\nName=Restart\r\n\r\n[Units]\r\n";
+    for (int i = 0; i < 2000; ++i) {
+        snprintf(line, sizeof(line), "%d=Greece,2TNK,256,%d,64,Guard,None\r\n", i, i * 3);
+        text += line;
+    }
+
+    unsigned long reserved = 0;
+
+    for (int round = 0; round < 20; ++round) {
+        {
+            INIClass ini;
+            ini.Set_Arena(&arena);
+
+            BufferStraw straw(text.data(), (int)text.size());
+            if (!ini.Load(straw) || ini.Entry_Count("Units") != 2000) {
+                fprintf(stderr, "INIClass didn't load into a shared arena.\n");
+                return 1;
+            }
+
+            if (ini.Get_String("Basic", "Name", std::string()) != "Restart") {
+                fprintf(stderr, "INIClass read back the wrong value from a shared arena.\n");
+                return 1;
+            }
+        }
+
+        if (arena.Used() == 0) {
+            fprintf(stderr, "INIClass didn't use the shared arena.\n");
+            return 1;
+        }
+
+        arena.Reset();
+
+        if (round == 0) {
+            reserved = arena.Reserved();
+        } else if (arena.Reserved() != reserved) {
+            fprintf(stderr, "Shared arena grew from %lu to %lu bytes on round %d.\n", reserved, arena.Reserved(), round);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_arena();
+    ret |= test_arena_ini();
+
+    return ret;
+}
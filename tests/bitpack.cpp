@@ -0,0 +1,511 @@
+#include "common/bitpack.h"
+#include "common/eventpack.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+int test_bitpack()
+{
+    int ret = 0;
+    unsigned char buffer[4096];
+    BitPackClass pack(buffer, sizeof(buffer));
+    uint32_t seed = 12345;
+
+    // Every width from 1 to 32 bits, at every alignment, then varints and signed values.
+    for (int i = 0; i < 500; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        int bits = i % 32 + 1;
+        pack.Put(seed & (bits == 32 ? 0xFFFFFFFF : (1u << bits) - 1), bits);
+    }
+    for (int i = 0; i < 100; ++i) {
+        pack.Put_Varint(i * i * i * 97);
+        pack.Put_Signed(i & 1 ? -i * 1000 : i * 1000);
+    }
+
+    BitUnpackClass unpack(buffer, pack.Length());
+    seed = 12345;
+
+    for (int i = 0; i < 500; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        int bits = i % 32 + 1;
+        if (unpack.Get(bits) != (seed & (bits == 32 ? 0xFFFFFFFF : (1u << bits) - 1))) {
+            fprintf(stderr, "BitUnpackClass::Get returned the wrong %d bit value at %d.\n", bits, i);
+            return 1;
+        }
+    }
+    for (int i = 0; i < 100; ++i) {
+        uint32_t value = unpack.Get_Varint();
+        if (value != (uint32_t)(i * i * i * 97) || unpack.Get_Signed() != (i & 1 ? -i * 1000 : i * 1000)) {
+            fprintf(stderr, "BitUnpackClass::Get_Varint returned the wrong value at %d.\n", i);
+            return 1;
+        }
+    }
+
+    if (unpack.Underflowed() || unpack.Remaining() >= 8) {
+        fprintf(stderr, "BitUnpackClass read %d bits, the writer wrote %d.\n", unpack.Position(), pack.Position());
+        ret = 1;
+    }
+
+    unpack.Get(8);
+    if (!unpack.Underflowed()) {
+        fprintf(stderr, "BitUnpackClass::Get read past the end of the data.\n");
+        ret = 1;
+    }
+
+    // A write that overflows is refused, and rewinding takes back a partial record.
+    unsigned char small[3];
+    BitPackClass tight(small, sizeof(small));
+    tight.Put(0x5, 3);
+    int mark = tight.Position();
+    tight.Put(0xFFFFF, 20);
+    tight.Put(0x3, 2);
+    if (!tight.Overflowed() || tight.Position() != mark + 20) {
+        fprintf(stderr, "BitPackClass::Put wrote past the end of the buffer.\n");
+        ret = 1;
+    }
+    tight.Rewind(mark);
+    tight.Put(0x2, 2);
+    BitUnpackClass check(small, tight.Length());
+    if (tight.Overflowed() || check.Get(3) != 0x5 || check.Get(2) != 0x2 || tight.Length() != 1) {
+        fprintf(stderr, "BitPackClass::Rewind didn't take back the overflowed write.\n");
+        ret = 1;
+    }
+
+    // Deltas only carry the bytes that changed.
+    unsigned char prev[13] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13};
+    unsigned char next[13] = {1, 2, 3, 40, 5, 6, 7, 8, 9, 10, 11, 12, 130};
+    unsigned char out[13];
+    BitPackClass delta(buffer, sizeof(buffer));
+    delta.Put_Delta(next, prev, sizeof(next));
+    BitUnpackClass undelta(buffer, delta.Length());
+    undelta.Get_Delta(out, prev, sizeof(out));
+    if (delta.Position() != 13 + 16 || memcmp(out, next, sizeof(out)) != 0) {
+        fprintf(stderr, "BitPackClass::Put_Delta stored %d bits for two changed bytes.\n", delta.Position());
+        ret = 1;
+    }
+
+    return ret;
+}
+
+/*
+**	A stand in for the game's event stream, in the shape the multiplayer queue sends it: each system sends one packet
+**	per send period holding a FRAMEINFO header and the events queued since the last one. Data lengths are the
+**	EventLength[] values of a 64 bit build.
+*/
+enum
+{
+    EV_MEGAMISSION = 2,
+    EV_IDLE = 4,
+    EV_DEPLOY = 7,
+    EV_PLACE = 8,
+    EV_PRODUCE = 11,
+    EV_SELL = 19,
+    EV_FRAMEINFO = 25,
+    EV_PROCESS_TIME = 30,
+    EV_LAST = 33,
+};
+
+enum
+{
+    DATA_SIZE = 132,
+    TARGET_SIZE = 8,
+};
+
+static unsigned char const Lengths[EV_LAST] = {0, 4,  25, 27, 8, 8, 0, 0, 3,  0, 4, 5, 1, 1, 8, 6, 0,
+                                     10, 8, 8, 2, 132, 0, 0, 1, 11, 0, 16, 8, 4, 2, 0, 0};
+
+struct TestEvent
+{
+    int Type;
+    uint32_t Frame;
+    unsigned ID;
+    unsigned char Data[DATA_SIZE];
+
+    bool operator==(TestEvent const& that) const
+    {
+        return Type == that.Type && Frame == that.Frame && ID == that.ID
+               && memcmp(Data, that.Data, Lengths[Type]) == 0;
+    }
+};
+
+static void Put_Target(unsigned char* data, int rtti, int id)
+{
+    data[0] = id;
+    data[1] = id >> 8;
+    data[2] = id >> 16;
+    data[3] = rtti;
+    memset(data + 4, 0, TARGET_SIZE - 4);
+}
+
+/*
+**	One send period of a busy player: a box selection ordered somewhere, with the odd retarget, build order and sale.
+*/
+static std::vector<TestEvent> Make_Period(uint32_t& seed, unsigned frame, unsigned id)
+{
+    std::vector<TestEvent> events;
+    TestEvent event;
+    memset(&event, 0, sizeof(event));
+    event.Frame = frame;
+    event.ID = id;
+
+    seed = seed * 1664525 + 1013904223;
+    int units = (seed >> 8) % 12;
+    int target = (seed >> 4) & 0x3FFF;
+    int mission = (seed >> 20) % 20;
+
+    for (int i = 0; i < units; ++i) {
+        event.Type = EV_MEGAMISSION;
+        memset(event.Data, 0, sizeof(event.Data));
+        Put_Target(event.Data, 1 + (i & 1), id * 64 + i * 3);
+        event.Data[TARGET_SIZE] = mission;
+        Put_Target(event.Data + TARGET_SIZE + 1, 0, 0);
+        Put_Target(event.Data + TARGET_SIZE * 2 + 1, 10, target);
+        events.push_back(event);
+    }
+
+    if ((seed >> 12) % 4 == 0) {
+        event.Type = EV_PRODUCE;
+        memset(event.Data, 0, sizeof(event.Data));
+        event.Data[0] = 3;
+        event.Data[1] = (seed >> 16) % 30;
+        events.push_back(event);
+    }
+    if ((seed >> 14) % 8 == 0) {
+        event.Type = EV_PLACE;
+        memset(event.Data, 0, sizeof(event.Data));
+        event.Data[0] = 6;
+        event.Data[1] = seed >> 3;
+        event.Data[2] = (seed >> 11) & 0x3F;
+        events.push_back(event);
+    }
+    if ((seed >> 18) % 16 == 0) {
+        event.Type = EV_SELL;
+        memset(event.Data, 0, sizeof(event.Data));
+        Put_Target(event.Data, 6, id * 16 + 2);
+        events.push_back(event);
+    }
+    if ((seed >> 22) % 32 == 0) {
+        event.Type = EV_PROCESS_TIME;
+        memset(event.Data, 0, sizeof(event.Data));
+        event.Data[0] = 5;
+        events.push_back(event);
+    }
+
+    return events;
+}
+
+/*
+**	Size of the packet Add_Compressed_Events would build: the FRAMEINFO up to the end of its data, then each event as
+**	a type byte and its data, with runs of MEGAMISSIONs to the same mission, target and destination sharing one
+**	copy of those behind a rep count.
+*/
+static int Compressed_Size(std::vector<TestEvent> const& events)
+{
+    int size = 8 + Lengths[EV_FRAMEINFO];
+    TestEvent const* prev = NULL;
+
+    for (auto const& event : events) {
+        if (event.Type == EV_MEGAMISSION && prev != NULL && prev->Type == EV_MEGAMISSION
+            && memcmp(event.Data + TARGET_SIZE, prev->Data + TARGET_SIZE, TARGET_SIZE * 2 + 1) == 0) {
+            size += TARGET_SIZE;
+        } else {
+            size += 1 + Lengths[event.Type] + (event.Type == EV_MEGAMISSION ? 1 : 0);
+        }
+        prev = &event;
+    }
+
+    return size;
+}
+
+/*
+**	Packs a period the way Add_Packed_Events does, and reads it back the way Extract_Packed_Events does.
+*/
+static int Packed_Encode(unsigned char* buffer, int size, TestEvent const& header, std::vector<TestEvent> const& events)
+{
+    EventPackClass pack(buffer, size, Lengths);
+    pack.Put_Header(EV_FRAMEINFO, header.Frame, header.ID, header.Data);
+
+    for (auto const& event : events) {
+        if (!pack.Put_Event(event.Type, event.Frame, event.ID, event.Data)) {
+            return -1;
+        }
+    }
+
+    return pack.Finish();
+}
+
+static bool Packed_Decode(unsigned char const* buffer, int size, TestEvent& header, std::vector<TestEvent>& events)
+{
+    EventUnpackClass unpack(buffer, size, Lengths, EV_LAST);
+    TestEvent event;
+    void const* data;
+    int type;
+    int id;
+
+    memset(&header, 0, sizeof(header));
+    header.Type = EV_FRAMEINFO;
+    if (!unpack.Get_Header(EV_FRAMEINFO, header.Frame, id, header.Data)) {
+        return false;
+    }
+    header.ID = id;
+
+    while ((type = unpack.Get_Event(event.Frame, id, data)) != -1) {
+        memset(event.Data, 0, sizeof(event.Data));
+        event.Type = type;
+        event.ID = id;
+        memcpy(event.Data, data, Lengths[type]);
+        events.push_back(event);
+    }
+
+    // All but the padding of the last byte should have been read.
+    return unpack.Remaining() < 8;
+}
+
+int test_bitpack_events()
+{
+    int ret = 0;
+    int const players = 8;
+    int const send_rate = 3;
+    int const frames = 15 * 60 * 10;
+    unsigned char buffer[1024];
+    uint32_t seed = 1;
+    long compressed = 0;
+    long packed = 0;
+    int largest[2] = {0, 0};
+    int events_sent = 0;
+
+    for (unsigned frame = 0; frame < frames; frame += send_rate) {
+        for (int id = 0; id < players; ++id) {
+            TestEvent header;
+            memset(&header, 0, sizeof(header));
+            header.Type = EV_FRAMEINFO;
+            header.Frame = frame + 3 * send_rate;
+            header.ID = id;
+            uint32_t crc = seed * 2654435761u;
+            memcpy(header.Data, &crc, 4);
+            header.Data[8] = frame / send_rate;
+            header.Data[9] = (frame / send_rate) >> 8;
+            header.Data[10] = 3 * send_rate;
+
+            std::vector<TestEvent> events = Make_Period(seed, header.Frame, id);
+            events_sent += (int)events.size();
+
+            int csize = Compressed_Size(events);
+            int psize = Packed_Encode(buffer, sizeof(buffer), header, events);
+            compressed += csize;
+            packed += psize;
+            largest[0] = csize > largest[0] ? csize : largest[0];
+            largest[1] = psize > largest[1] ? psize : largest[1];
+
+            TestEvent got_header;
+            std::vector<TestEvent> got;
+            if (psize < 0 || !Packed_Decode(buffer, psize, got_header, got) || !(got_header == header)
+                || got.size() != events.size()) {
+                fprintf(stderr, "Packed events didn't round trip on frame %u player %d.\n", frame, id);
+                return 1;
+            }
+            for (size_t i = 0; i < got.size(); ++i) {
+                if (!(got[i] == events[i])) {
+                    fprintf(stderr, "Packed event %d changed on frame %u player %d.\n", (int)i, frame, id);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    printf("%d events from %d players over %d frames\n", events_sent, players, frames);
+    printf("Compressed events %6.2f bytes per frame per player, largest packet %d\n",
+           (double)compressed / frames / players,
+           largest[0]);
+    printf("Packed events     %6.2f bytes per frame per player, largest packet %d\n",
+           (double)packed / frames / players,
+           largest[1]);
+
+    if (packed >= compressed) {
+        fprintf(stderr, "Packed events are no smaller than compressed ones.\n");
+        ret = 1;
+    }
+
+    // Events with their own frame and house still come back as they went in.
+    TestEvent header;
+    memset(&header, 0, sizeof(header));
+    header.Type = EV_FRAMEINFO;
+    header.Frame = 1000;
+    std::vector<TestEvent> events = Make_Period(seed, 1000, 0);
+    TestEvent odd = events.empty() ? header : events[0];
+    odd.Type = EV_IDLE;
+    odd.Frame = 990;
+    odd.ID = 7;
+    events.push_back(odd);
+    events.push_back(odd);
+
+    TestEvent got_header;
+    std::vector<TestEvent> got;
+    int psize = Packed_Encode(buffer, sizeof(buffer), header, events);
+    if (!Packed_Decode(buffer, psize, got_header, got) || got.size() != events.size() || !(got.back() == odd)) {
+        fprintf(stderr, "Packed events lost an event's own frame or house.\n");
+        ret = 1;
+    }
+
+    return ret;
+}
+
+/*
+**	The parts of the codec the simulated stream doesn't reach: data attached to an event, an event taken back after it
+**	was packed, a packet that fills up and a packet cut short.
+*/
+int test_eventpack()
+{
+    int ret = 0;
+    unsigned char buffer[256];
+    uint32_t seed = 3;
+    TestEvent header;
+    memset(&header, 0, sizeof(header));
+    header.Type = EV_FRAMEINFO;
+    header.Frame = 300;
+    header.ID = 2;
+
+    std::vector<TestEvent> events = Make_Period(seed, 300, 2);
+    while (events.size() < 4) {
+        events = Make_Period(seed, 300, 2);
+    }
+
+    // The extra bytes come back between the event's data and the next event.
+    char const name[] = "Extra data";
+    EventPackClass pack(buffer, sizeof(buffer), Lengths);
+    pack.Put_Header(EV_FRAMEINFO, header.Frame, header.ID, header.Data);
+    pack.Put_Event(events[0].Type, events[0].Frame, events[0].ID, events[0].Data, name, sizeof(name));
+    pack.Put_Event(events[1].Type, events[1].Frame, events[1].ID, events[1].Data);
+    int size = pack.Finish();
+
+    EventUnpackClass unpack(buffer, size, Lengths, EV_LAST);
+    TestEvent got;
+    void const* data;
+    int id;
+    char extra[sizeof(name)];
+    bool ok = unpack.Get_Header(EV_FRAMEINFO, got.Frame, id, got.Data);
+    ok = ok && unpack.Get_Event(got.Frame, id, data) == events[0].Type;
+    ok = ok && memcmp(data, events[0].Data, Lengths[events[0].Type]) == 0;
+    unpack.Get_Bytes(extra, sizeof(extra));
+    ok = ok && memcmp(extra, name, sizeof(name)) == 0;
+    ok = ok && unpack.Get_Event(got.Frame, id, data) == events[1].Type;
+    ok = ok && memcmp(data, events[1].Data, Lengths[events[1].Type]) == 0;
+    ok = ok && unpack.Get_Event(got.Frame, id, data) == -1;
+    if (!ok) {
+        fprintf(stderr, "EventUnpackClass didn't return the data attached to an event.\n");
+        ret = 1;
+    }
+
+    // An event taken back leaves no trace, even in the data later events of its type are coded against.
+    TestEvent changed = events[2];
+    changed.Data[0] ^= 0x55;
+    std::vector<TestEvent> kept = {events[0], events[1], events[2], events[3]};
+    EventPackClass undo(buffer, sizeof(buffer), Lengths);
+    undo.Put_Header(EV_FRAMEINFO, header.Frame, header.ID, header.Data);
+    undo.Put_Event(events[0].Type, events[0].Frame, events[0].ID, events[0].Data);
+    undo.Put_Event(events[1].Type, events[1].Frame, events[1].ID, events[1].Data);
+    undo.Put_Event(changed.Type, changed.Frame, changed.ID, changed.Data);
+    undo.Take_Back();
+    undo.Put_Event(events[2].Type, events[2].Frame, events[2].ID, events[2].Data);
+    undo.Put_Event(events[3].Type, events[3].Frame, events[3].ID, events[3].Data);
+    size = undo.Finish();
+
+    TestEvent got_header;
+    std::vector<TestEvent> got_events;
+    if (!Packed_Decode(buffer, size, got_header, got_events) || got_events.size() != kept.size()
+        || !std::equal(kept.begin(), kept.end(), got_events.begin())) {
+        fprintf(stderr, "EventPackClass::Take_Back didn't take back the last event.\n");
+        ret = 1;
+    }
+
+    // A full packet refuses the event that doesn't fit and still ends cleanly.
+    int empty = Packed_Encode(buffer, sizeof(buffer), header, std::vector<TestEvent>());
+    for (int limit = empty; limit < 64; ++limit) {
+        EventPackClass full(buffer, limit, Lengths);
+        full.Put_Header(EV_FRAMEINFO, header.Frame, header.ID, header.Data);
+        size_t count = 0;
+        while (count < events.size()
+               && full.Put_Event(events[count].Type, events[count].Frame, events[count].ID, events[count].Data)) {
+            ++count;
+        }
+        size = full.Finish();
+
+        got_events.clear();
+        if (full.Overflowed() || size > limit || !Packed_Decode(buffer, size, got_header, got_events)
+            || got_events.size() != count || !std::equal(got_events.begin(), got_events.end(), events.begin())) {
+            fprintf(stderr, "EventPackClass overfilled a %d byte packet.\n", limit);
+            ret = 1;
+            break;
+        }
+    }
+
+    // A packet cut short gives back the events before the cut and then stops.
+    size = Packed_Encode(buffer, sizeof(buffer), header, events);
+    for (int cut = 1; cut < size; ++cut) {
+        got_events.clear();
+        Packed_Decode(buffer, cut, got_header, got_events);
+        if (got_events.size() > events.size()
+            || !std::equal(got_events.begin(), got_events.end(), events.begin())) {
+            fprintf(stderr, "EventUnpackClass returned a damaged event from a packet cut to %d bytes.\n", cut);
+            ret = 1;
+            break;
+        }
+    }
+
+    return ret;
+}
+
+int bench_bitpack()
+{
+    unsigned char buffer[1024];
+    uint32_t seed = 7;
+    std::vector<std::vector<TestEvent>> periods;
+    TestEvent header;
+    memset(&header, 0, sizeof(header));
+    header.Type = EV_FRAMEINFO;
+
+    for (int i = 0; i < 256; ++i) {
+        periods.push_back(Make_Period(seed, 100, 1));
+    }
+
+    int packets = 0;
+    int sum = 0;
+    double secs = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    do {
+        for (auto const& events : periods) {
+            int size = Packed_Encode(buffer, sizeof(buffer), header, events);
+            TestEvent got_header;
+            std::vector<TestEvent> got;
+            Packed_Decode(buffer, size, got_header, got);
+            sum += (int)got.size();
+            ++packets;
+        }
+        secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (secs < 0.1);
+
+    printf("Packed encode and decode %8.3f us per packet\n", secs * 1000000.0 / packets);
+
+    return sum > 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_bitpack();
+    ret |= test_bitpack_events();
+    ret |= test_eventpack();
+
+    // Benchmarks only run when asked for, e.g. "test_bitpack bench".
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        ret |= bench_bitpack();
+    }
+
+    return ret;
+}
@@ -0,0 +1,321 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common/activelist.h"
+#include "common/freeslot.h"
+
+#include <chrono>
+#include <vector>
+
+static uint32_t Next_Random(uint32_t& seed)
+{
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 8;
+}
+
+static int Reference_First_Free(std::vector<bool> const& free)
+{
+    for (size_t i = 0; i < free.size(); ++i) {
+        if (free[i]) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/*
+** Takes and gives back slots at random and checks every answer against a plain scan of flags.
+*/
+int test_freeslot_count(int count)
+{
+    FreeSlotClass slots;
+    std::vector<bool> free(count, true);
+    uint32_t seed = count;
+
+    slots.Resize(count);
+
+    if (slots.Length() != count) {
+        fprintf(stderr, "FreeSlotClass length is %d, expected %d.\n", slots.Length(), count);
+        return 1;
+    }
+
+    // Fill it up in order, then make sure nothing past the end is handed out.
+    for (int i = 0; i < count; ++i) {
+        int index = slots.First_Free();
+        if (index != i) {
+            fprintf(stderr, "FreeSlotClass(%d) filling gave slot %d, expected %d.\n", count, index, i);
+            return 1;
+        }
+        slots.Take(index);
+        free[index] = false;
+    }
+
+    if (slots.First_Free() != -1 || slots.Is_Free(count) || slots.Is_Free(-1)) {
+        fprintf(stderr, "FreeSlotClass(%d) has a free slot when full.\n", count);
+        return 1;
+    }
+
+    for (int round = 0; round < count * 2; ++round) {
+        int index = Next_Random(seed) % count;
+
+        if (free[index]) {
+            slots.Take(index);
+        } else {
+            slots.Give(index);
+        }
+        free[index] = !free[index];
+
+        if (slots.Is_Free(index) != free[index]) {
+            fprintf(stderr, "FreeSlotClass(%d) slot %d has the wrong state.\n", count, index);
+            return 1;
+        }
+
+        int expected = Reference_First_Free(free);
+        if (slots.First_Free() != expected) {
+            fprintf(stderr,
+                    "FreeSlotClass(%d) first free is %d, expected %d on round %d.\n",
+                    count,
+                    slots.First_Free(),
+                    expected,
+                    round);
+            return 1;
+        }
+    }
+
+    slots.Reset();
+
+    if (slots.First_Free() != 0 || !slots.Is_Free(count - 1)) {
+        fprintf(stderr, "FreeSlotClass(%d) reset didn't free every slot.\n", count);
+        return 1;
+    }
+
+    return 0;
+}
+
+int test_freeslot()
+{
+    static int const counts[] = {1, 31, 32, 33, 500, 1024, 1025, 1100};
+    int ret = 0;
+
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+        ret |= test_freeslot_count(counts[i]);
+    }
+
+    FreeSlotClass slots;
+
+    if (slots.First_Free() != -1 || slots.Length() != 0) {
+        fprintf(stderr, "FreeSlotClass didn't start out empty.\n");
+        ret = 1;
+    }
+
+    slots.Resize(10);
+    slots.Clear();
+
+    if (slots.First_Free() != -1 || slots.Length() != 0) {
+        fprintf(stderr, "FreeSlotClass wasn't emptied by Clear.\n");
+        ret = 1;
+    }
+
+    return ret;
+}
+
+/*
+** The block bookkeeping of FixedIHeapClass: the lowest free block is handed out and added to the end of the active
+** list, and freeing one moves the last active block into its place.
+*/
+struct TestHeap
+{
+    FreeSlotClass FreeSlots;
+    ActiveListClass ActiveList;
+    char Blocks[64][4];
+
+    TestHeap(int count)
+    {
+        FreeSlots.Resize(count);
+        ActiveList.Resize(count);
+    }
+
+    int ID(void const* pointer) const
+    {
+        return (int)(((char const*)pointer - &Blocks[0][0]) / sizeof(Blocks[0]));
+    }
+
+    void* Allocate()
+    {
+        int index = FreeSlots.First_Free();
+        if (index == -1) {
+            return NULL;
+        }
+        FreeSlots.Take(index);
+        ActiveList.Add(index, Blocks[index]);
+        return Blocks[index];
+    }
+
+    void Free(void* pointer)
+    {
+        FreeSlots.Give(ID(pointer));
+        ActiveList.Remove(ID(pointer));
+    }
+};
+
+/*
+** Checks the active list holds the given blocks in order, and that each block's position agrees with it.
+*/
+static int Check_Active(TestHeap const& heap, int const* expected, int count, char const* what)
+{
+    if (heap.ActiveList.Count() != count) {
+        fprintf(stderr, "ActiveListClass %s has %d blocks, expected %d.\n", what, heap.ActiveList.Count(), count);
+        return 1;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        int id = heap.ID(heap.ActiveList[i]);
+        if (id != expected[i] || heap.ActiveList.Position(id) != i) {
+            fprintf(stderr,
+                    "ActiveListClass %s has block %d at position %d (its position %d), expected %d.\n",
+                    what,
+                    id,
+                    i,
+                    heap.ActiveList.Position(id),
+                    expected[i]);
+            return 1;
+        }
+    }
+
+    for (int id = 0; id < 10; ++id) {
+        bool active = false;
+        for (int i = 0; i < count; ++i) {
+            active |= expected[i] == id;
+        }
+        if (!active && heap.ActiveList.Position(id) != -1) {
+            fprintf(stderr, "ActiveListClass %s still has freed block %d.\n", what, id);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int test_activelist()
+{
+    TestHeap heap(10);
+    int ret = 0;
+
+    for (int i = 0; i < 10; ++i) {
+        heap.Allocate();
+    }
+
+    static int const full[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    ret |= Check_Active(heap, full, 10, "when full");
+
+    // Freeing from the middle moves the last block into the hole.
+    heap.Free(heap.Blocks[3]);
+    static int const middle[] = {0, 1, 2, 9, 4, 5, 6, 7, 8};
+    ret |= Check_Active(heap, middle, 9, "after freeing the middle");
+
+    // Freeing the last block moves nothing.
+    heap.Free(heap.Blocks[8]);
+    static int const last[] = {0, 1, 2, 9, 4, 5, 6, 7};
+    ret |= Check_Active(heap, last, 8, "after freeing the last");
+
+    heap.Free(heap.Blocks[0]);
+    static int const first[] = {7, 1, 2, 9, 4, 5, 6};
+    ret |= Check_Active(heap, first, 7, "after freeing the first");
+
+    // The lowest free block is handed out again, at the end of the list.
+    if (heap.ID(heap.Allocate()) != 0 || heap.ID(heap.Allocate()) != 3) {
+        fprintf(stderr, "ActiveListClass heap didn't hand out the lowest free blocks.\n");
+        ret = 1;
+    }
+    static int const again[] = {7, 1, 2, 9, 4, 5, 6, 0, 3};
+    ret |= Check_Active(heap, again, 9, "after allocating again");
+
+    // Removing a block that isn't active leaves the list alone.
+    heap.ActiveList.Remove(8);
+    ret |= Check_Active(heap, again, 9, "after removing a free block");
+
+    if (heap.ActiveList.Position(-1) != -1 || heap.ActiveList.Position(10) != -1) {
+        fprintf(stderr, "ActiveListClass has a position for a block out of range.\n");
+        ret = 1;
+    }
+
+    for (int i = 8; i >= 0; --i) {
+        heap.Free(heap.ActiveList[i]);
+    }
+    ret |= Check_Active(heap, NULL, 0, "after freeing everything");
+
+    heap.Allocate();
+    heap.Allocate();
+    heap.ActiveList.Reset();
+    ret |= Check_Active(heap, NULL, 0, "after reset");
+
+    return ret;
+}
+
+/*
+** Allocation pattern of a busy unit heap: mostly full, with blocks freed and taken again near the end.
+*/
+int bench_freeslot()
+{
+    int const count = 2000;
+    int const rounds = 20000;
+    FreeSlotClass slots;
+    std::vector<bool> free(count, true);
+    uint32_t seed = 1;
+    unsigned long sum = 0;
+
+    slots.Resize(count);
+    for (int i = 0; i < count - 16; ++i) {
+        slots.Take(i);
+        free[i] = false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < rounds; ++i) {
+        int index = slots.First_Free();
+        slots.Take(index);
+        sum += index;
+        slots.Give(count - 1 - Next_Random(seed) % 64);
+        slots.Take(slots.First_Free());
+        slots.Give(index);
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < rounds; ++i) {
+        int index = Reference_First_Free(free);
+        free[index] = false;
+        sum += index;
+        free[count - 1 - Next_Random(seed) % 64] = true;
+        free[Reference_First_Free(free)] = false;
+        free[index] = true;
+    }
+
+    double scan_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("Free slot search %8.3f us per allocation, flag scan %8.3f us (%lu)\n",
+           secs * 1000000.0 / (rounds * 2),
+           scan_secs * 1000000.0 / (rounds * 2),
+           sum);
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_freeslot();
+    ret |= test_activelist();
+
+    // Benchmarks only run when asked for, e.g. "test_freeslot bench".
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        ret |= bench_freeslot();
+    }
+
+    return ret;
+}
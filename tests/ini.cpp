@@ -0,0 +1,207 @@
+#include "common/ini.h"
+#include "common/xpipe.h"
+#include "common/xstraw.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+// Exercises the awkward corners of the format: text before the first section, CR/LF mixes, comments,
+// over long lines, duplicate keys and sections, empty sections and a final line without a line feed.
+static char const test_ini[] = "; leading comment\r\n"
+                               "junk=ignored\r\n"
+                               "[General]\r\n"
+                               "Name = Red Alert ; trailing comment\r\n"
+                               "Speed=  4\r\n"
+                               "Hex=$1F\r\n"
+                               "HexH=2Ah\r\n"
+                               "Flag=yes\r\n"
+                               "Fixed=50%\r\n"
+                               "=novalue\r\n"
+                               "nokey=\r\n"
+                               "Speed=7\r\n"
+                               "no divider line\r\n"
+                               "Mid\rCR=1\r\n"
+                               "\r\n"
+                               "[Empty]\r\n"
+                               "; nothing here\r\n"
+                               "[  Spaced Name  ]  trailing\n"
+                               "LongValue=0123456789012345678901234567890123456789012345678901234567890123456789"
+                               "012345678901234567890123456789012345678901234567890123456789\n"
+                               "[general]\n"
+                               "Dup=1\n"
+                               "[Last]\n"
+                               "A=1\n"
+                               "B=2";
+
+static char const expected_ini[] = "[General]\r\n"
+                                   "Name=Red Alert\r\n"
+                                   "Speed=4\r\n"
+                                   "Hex=$1F\r\n"
+                                   "HexH=2Ah\r\n"
+                                   "Flag=yes\r\n"
+                                   "Fixed=50%\r\n"
+                                   "MidCR=1\r\n"
+                                   "\r\n"
+                                   "[Spaced Name]\r\n"
+                                   "LongValue=0123456789012345678901234567890123456789012345678901234567890123456789"
+                                   "01234567890123456789012345678901234567890123456\r\n"
+                                   "\r\n"
+                                   "[Last]\r\n"
+                                   "A=1\r\n"
+                                   "\r\n";
+
+static std::string Save_To_String(INIClass const& ini)
+{
+    static char buffer[64 * 1024];
+    BufferPipe pipe(buffer, sizeof(buffer));
+    int len = ini.Save(pipe);
+    return std::string(buffer, len);
+}
+
+int test_ini_load()
+{
+    int ret = 0;
+    INIClass ini;
+    BufferStraw straw(test_ini, sizeof(test_ini) - 1);
+
+    if (!ini.Load(straw)) {
+        fprintf(stderr, "INIClass::Load failed on the test data.\n");
+        return 1;
+    }
+
+    if (Save_To_String(ini) != expected_ini) {
+        fprintf(stderr, "INIClass::Save did not reproduce the expected data:\n%s\n", Save_To_String(ini).c_str());
+        ret = 1;
+    }
+
+    char buffer[128];
+    ini.Get_String("GENERAL", "name", "", buffer, sizeof(buffer));
+    if (strcmp(buffer, "Red Alert") != 0 || ini.Get_Int("General", "Speed") != 4
+        || ini.Get_Int("General", "Hex") != 0x1F || ini.Get_Int("General", "HexH") != 0x2A
+        || !ini.Get_Bool("General", "Flag") || ini.Section_Count() != 3 || ini.Entry_Count("General") != 7
+        || strcmp(ini.Get_Entry("General", 6), "MidCR") != 0 || ini.Is_Present("Empty")
+        || !ini.Is_Present("spaced name", "LongValue") || ini.Is_Present("Last", "B")) {
+        fprintf(stderr, "INIClass::Get_* returned unexpected values after Load.\n");
+        ret = 1;
+    }
+
+    // Replace, remove and add entries over the loaded data.
+    ini.Put_String("General", "Name", "Tiberian Dawn");
+    ini.Put_Int("General", "Speed", 5);
+    ini.Clear("General", "Hex");
+    ini.Clear("Spaced Name");
+    ini.Put_Int("New", "Value", 9);
+    ini.Get_String("General", "Name", "", buffer, sizeof(buffer));
+
+    if (strcmp(buffer, "Tiberian Dawn") != 0 || ini.Get_Int("General", "Speed") != 5
+        || ini.Is_Present("General", "Hex") || ini.Is_Present("Spaced Name") || ini.Get_Int("New", "Value") != 9) {
+        fprintf(stderr, "INIClass::Put_* did not update loaded data.\n");
+        ret = 1;
+    }
+
+    // A second load merges into the same database.
+    static char const more_ini[] = "[More]\nX=1\n";
+    BufferStraw straw2(more_ini, sizeof(more_ini) - 1);
+    ini.Load(straw2);
+
+    if (ini.Get_Int("More", "X") != 1 || ini.Get_Int("New", "Value") != 9) {
+        fprintf(stderr, "INIClass::Load did not merge into existing data.\n");
+        ret = 1;
+    }
+
+    ini.Clear();
+    if (ini.Is_Loaded() || ini.Section_Count() != 0) {
+        fprintf(stderr, "INIClass::Clear did not empty the database.\n");
+        ret = 1;
+    }
+
+    BufferStraw straw3(test_ini, sizeof(test_ini) - 1);
+    ini.Load(straw3);
+    if (Save_To_String(ini) != expected_ini) {
+        fprintf(stderr, "INIClass::Load after Clear did not reproduce the expected data.\n");
+        ret = 1;
+    }
+
+    return ret;
+}
+
+int test_ini_index()
+{
+    int ret = 0;
+    HashIndexClass<int> index;
+
+    // Add, remove and re-add enough ids to force several resizes and long probe chains.
+    for (int i = 0; i < 5000; ++i) {
+        index.Add_Index(i * 7919, i);
+    }
+    for (int i = 0; i < 5000; i += 3) {
+        index.Remove_Index(i * 7919);
+    }
+
+    for (int i = 0; i < 5000; ++i) {
+        bool present = index.Is_Present(i * 7919);
+        if (present != (i % 3 != 0) || (present && index.Fetch_Index(i * 7919) != i)) {
+            fprintf(stderr, "HashIndexClass lost track of id %d.\n", i * 7919);
+            ret = 1;
+            break;
+        }
+    }
+
+    if (index.Count() != 3333) {
+        fprintf(stderr, "HashIndexClass::Count returned %d.\n", index.Count());
+        ret = 1;
+    }
+
+    return ret;
+}
+
+int bench_ini()
+{
+    // Roughly the shape of RULES.INI: a few hundred sections of a dozen or two entries.
+    std::string text;
+    char line[128];
+    for (int s = 0; s < 400; ++s) {
+        snprintf(line, sizeof(line), "[Section%d]\r\n", s);
+        text += line;
+        for (int e = 0; e < 20; ++e) {
+            snprintf(line, sizeof(line), "Entry%d=%d,%d ; comment\r\n", e, s * e, e);
+            text += line;
+        }
+        text += "\r\n";
+    }
+
+    int loads = 0;
+    int sum = 0;
+    double secs = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    do {
+        INIClass ini;
+        BufferStraw straw(text.data(), text.size());
+        ini.Load(straw);
+        sum += ini.Get_Int("Section399", "Entry19");
+        ++loads;
+        secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (secs < 0.2);
+
+    printf("INIClass::Load %8.3f ms per %d byte file\n", secs * 1000.0 / loads, (int)text.size());
+    return sum == loads * 399 * 19 ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_ini_load();
+    ret |= test_ini_index();
+
+    // Benchmarks only run when asked for, e.g. "test_ini bench".
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        ret |= bench_ini();
+    }
+
+    return ret;
+}
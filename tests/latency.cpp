@@ -0,0 +1,317 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common/latency.h"
+#include "common/combuf.h"
+
+#include <algorithm>
+#include <chrono>
+
+int test_latency()
+{
+    LatencyClass latency;
+
+    if (latency.Count() != 0 || latency.Percentile(95) != 0 || latency.Jitter(95) != 0) {
+        fprintf(stderr, "LatencyClass didn't start out empty.\n");
+        return 1;
+    }
+
+    // Only the last WINDOW samples count: 37 to 100.
+    for (int i = 1; i <= 100; ++i) {
+        latency.Add(i);
+    }
+
+    if (latency.Count() != LatencyClass::WINDOW) {
+        fprintf(stderr, "LatencyClass holds %d samples, expected %d.\n", latency.Count(), LatencyClass::WINDOW);
+        return 1;
+    }
+
+    if (latency.Percentile(50) != 68 || latency.Percentile(100) != 100 || latency.Percentile(1) != 37) {
+        fprintf(stderr,
+                "LatencyClass percentiles are %lu %lu %lu, expected 37 68 100.\n",
+                latency.Percentile(1),
+                latency.Percentile(50),
+                latency.Percentile(100));
+        return 1;
+    }
+
+    if (latency.Jitter(95) != 1) {
+        fprintf(stderr, "LatencyClass jitter is %lu for a steady ramp, expected 1.\n", latency.Jitter(95));
+        return 1;
+    }
+
+    // One spike in an otherwise steady link shows up at the top percentiles only.
+    latency.Reset();
+    for (int i = 0; i < 40; ++i) {
+        latency.Add(i == 20 ? 90 : 30);
+    }
+
+    if (latency.Percentile(50) != 30 || latency.Percentile(100) != 90 || latency.Jitter(50) != 0
+        || latency.Jitter(100) != 60) {
+        fprintf(stderr, "LatencyClass didn't isolate a single slow packet.\n");
+        return 1;
+    }
+
+    // CommBufferClass keeps its average and hands out the percentiles too.
+    CommBufferClass queue(4, 4, 64);
+
+    for (int i = 0; i < 10; ++i) {
+        queue.Add_Delay(i == 9 ? 100 : 10);
+    }
+
+    if (queue.Avg_Response_Time() != 19 || queue.Response_Time_Percentile(50) != 10
+        || queue.Response_Time_Percentile(100) != 100) {
+        fprintf(stderr, "CommBufferClass response times don't match what was added.\n");
+        return 1;
+    }
+
+    queue.Reset_Response_Time();
+    if (queue.Response_Time_Percentile(100) != 0) {
+        fprintf(stderr, "CommBufferClass::Reset_Response_Time didn't clear the percentiles.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int test_framedelay()
+{
+    FrameDelayClass delay(95, 4);
+
+    // Never less than three send periods, always whole send periods, never more than a FRAMEINFO holds.
+    if (delay.Target(40, 0, 15, 3) != 9 || delay.Target(200, 40, 15, 3) != 30 || delay.Target(100000, 0, 60, 3) != 255
+        || delay.Target(100000, 0, 60, 4) != 252) {
+        fprintf(stderr, "FrameDelayClass::Target doesn't round and clamp as expected.\n");
+        return 1;
+    }
+
+    delay.Reset(9);
+
+    if (delay.Update(200, 40, 15, 3) != 30 || delay.Raises() != 1) {
+        fprintf(stderr, "FrameDelayClass didn't raise the delay at once.\n");
+        return 1;
+    }
+
+    // Lowering waits 'hold' updates and then goes one send period at a time.
+    for (int i = 0; i < 3; ++i) {
+        if (delay.Update(40, 0, 15, 3) != 30) {
+            fprintf(stderr, "FrameDelayClass lowered the delay after %d updates.\n", i + 1);
+            return 1;
+        }
+    }
+
+    if (delay.Update(40, 0, 15, 3) != 27 || delay.Lowers() != 1) {
+        fprintf(stderr, "FrameDelayClass didn't lower the delay after the hold time.\n");
+        return 1;
+    }
+
+    // A spike in the middle of a quiet spell starts the hold over.
+    delay.Update(40, 0, 15, 3);
+    delay.Update(208, 0, 15, 3);
+    for (int i = 0; i < 3; ++i) {
+        delay.Update(40, 0, 15, 3);
+    }
+
+    if (delay.Delay() != 27) {
+        fprintf(stderr, "FrameDelayClass kept counting down through an on-target update.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+** A link between the game host and one player, played out in ticks. Every send period a packet goes out with the
+** events for 'MaxAhead' frames later; a lost packet is resent after the retry time, as ConnectionClass would. The
+** ACK gives a response time sample, the same one connect.cpp hands to Add_Delay. A packet that arrives after the
+** frame it's meant for has started would stall every player.
+*/
+struct LinkPhase
+{
+    int Frames;
+    int Base;   // Fixed one way delay, in ticks.
+    int Spread; // Random extra one way delay, up to this many ticks.
+    int Loss;   // Chance out of 1000 that a packet or its ACK is lost.
+};
+
+struct LinkResult
+{
+    int Packets;
+    int Late;
+    long StallTicks;
+    long DelayFrames;
+    int Changes;
+};
+
+static uint32_t Next_Random(uint32_t& seed)
+{
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 8;
+}
+
+static int One_Way(uint32_t& seed, LinkPhase const& phase)
+{
+    // Squaring skews the spread so most packets are quick and a few are slow.
+    int r = Next_Random(seed) % 1000;
+
+    return phase.Base + phase.Spread * r * r / (1000 * 1000);
+}
+
+static LinkResult Simulate(LinkPhase const* phases, int count, bool adaptive, uint32_t seed)
+{
+    int const fps = 15;
+    int const ticks_per_frame = 60 / fps;
+    int const send_rate = 3;
+
+    LinkResult result = {0, 0, 0, 0, 0};
+    CommBufferClass queue(4, 4, 64);
+    FrameDelayClass control(95, 4);
+    int maxahead = 5;
+    int frame = 0;
+
+    control.Reset(maxahead);
+
+    for (int p = 0; p < count; ++p) {
+        for (int f = 0; f < phases[p].Frames; ++f, ++frame) {
+            int newahead = maxahead;
+
+            if (adaptive && frame > 0 && (frame & 0x1f) == 0) {
+                newahead =
+                    control.Update(queue.Response_Time_Percentile(95), queue.Response_Jitter(50), fps, send_rate);
+            } else if (!adaptive && frame > 0 && (frame & 0x7f) == 0) {
+                // What Generate_Real_Timing_Event did before: the average, straight into 'MaxAhead'.
+                newahead = (int)(queue.Avg_Response_Time() * fps / 120);
+                newahead = ((newahead + send_rate - 1) / send_rate) * send_rate;
+                newahead = std::max(newahead, send_rate * 3);
+            }
+
+            if (newahead != maxahead) {
+                maxahead = newahead;
+                ++result.Changes;
+            }
+
+            if (frame % send_rate != 0) {
+                continue;
+            }
+
+            int sent = frame * ticks_per_frame;
+            int retry = (int)queue.Avg_Response_Time() + 10;
+            int tries = 0;
+
+            while (Next_Random(seed) % 1000 < (uint32_t)phases[p].Loss) {
+                ++tries;
+            }
+
+            int arrive = sent + tries * retry + One_Way(seed, phases[p]);
+
+            // A lost ACK costs a resend too, but the packet itself was already there.
+            int acked = arrive + One_Way(seed, phases[p]);
+            while (Next_Random(seed) % 1000 < (uint32_t)phases[p].Loss) {
+                acked += retry;
+            }
+
+            queue.Add_Delay(acked - sent);
+
+            int due = (frame + maxahead) * ticks_per_frame;
+
+            ++result.Packets;
+            result.DelayFrames += maxahead;
+            if (arrive > due) {
+                ++result.Late;
+                result.StallTicks += arrive - due;
+            }
+        }
+    }
+
+    return result;
+}
+
+int test_latency_link()
+{
+    // A quiet LAN-like link, a congested spell with loss and jitter, then quiet again.
+    LinkPhase const phases[] = {
+        {2000, 8, 8, 10},
+        {3000, 14, 30, 60},
+        {3000, 8, 8, 10},
+    };
+    int const count = sizeof(phases) / sizeof(phases[0]);
+    int ret = 0;
+
+    LinkResult old_rule = Simulate(phases, count, false, 2024);
+    LinkResult new_rule = Simulate(phases, count, true, 2024);
+
+    printf("Average rule:    %4d of %d packets late (%ld ticks stalled), %.2f frames input delay, %d changes\n",
+           old_rule.Late,
+           old_rule.Packets,
+           old_rule.StallTicks,
+           (double)old_rule.DelayFrames / old_rule.Packets,
+           old_rule.Changes);
+    printf("Percentile rule: %4d of %d packets late (%ld ticks stalled), %.2f frames input delay, %d changes\n",
+           new_rule.Late,
+           new_rule.Packets,
+           new_rule.StallTicks,
+           (double)new_rule.DelayFrames / new_rule.Packets,
+           new_rule.Changes);
+
+    if (new_rule.Late * 2 > old_rule.Late) {
+        fprintf(stderr, "Percentile frame delay didn't halve the late packets.\n");
+        ret = 1;
+    }
+
+    // 250 evaluations; hysteresis should keep the changes to a few per phase.
+    if (new_rule.Changes > 20) {
+        fprintf(stderr, "Percentile frame delay changed %d times, it's oscillating.\n", new_rule.Changes);
+        ret = 1;
+    }
+
+    // On a quiet link the delay has to stay at or near the three send period minimum.
+    LinkPhase const quiet[] = {{3000, 8, 8, 10}};
+    LinkResult settled = Simulate(quiet, 1, true, 7);
+
+    if (settled.DelayFrames > (long)settled.Packets * 10) {
+        fprintf(stderr, "Percentile frame delay averaged more than 10 frames on a quiet link.\n");
+        ret = 1;
+    }
+
+    return ret;
+}
+
+int bench_latency()
+{
+    LatencyClass latency;
+    uint32_t seed = 99;
+    unsigned long sum = 0;
+    int const rounds = 100000;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < rounds; ++i) {
+        latency.Add(Next_Random(seed) % 120);
+        if ((i & 0x1f) == 0) {
+            sum += latency.Percentile(95) + latency.Jitter(95);
+        }
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("Latency samples and percentiles %8.3f us per sample (%lu)\n", secs * 1000000.0 / rounds, sum);
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_latency();
+    ret |= test_framedelay();
+    ret |= test_latency_link();
+
+    // Benchmarks only run when asked for, e.g. "test_latency bench".
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        ret |= bench_latency();
+    }
+
+    return ret;
+}
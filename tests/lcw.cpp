@@ -1,8 +1,295 @@
 #include "common/lcw.h"
+#include "common/lcwpipe.h"
+#include "common/xpipe.h"
 
 #include <stdint.h>
 #include <string.h>
+#include <chrono>
 #include <iostream>
+#include <vector>
+
+// Straight port of the original byte at a time decoder, used as the reference for conformance.
+static int Reference_LCW_Uncompress(void const* source, void* dest, unsigned length)
+{
+    unsigned char *source_ptr, *dest_ptr, *copy_ptr, *dest_end, op_code;
+    unsigned count;
+
+    source_ptr = (unsigned char*)source;
+    dest_ptr = (unsigned char*)dest;
+    dest_end = dest_ptr + length;
+
+    while (dest_ptr < dest_end) {
+        op_code = *source_ptr++;
+
+        if (!(op_code & 0x80)) {
+            count = (op_code >> 4) + 3;
+            copy_ptr = dest_ptr - ((unsigned)*source_ptr++ + (((unsigned)op_code & 0x0f) << 8));
+            if (count > (unsigned)(dest_end - dest_ptr)) {
+                count = dest_end - dest_ptr;
+            }
+            while (count--)
+                *dest_ptr++ = *copy_ptr++;
+        } else if (!(op_code & 0x40)) {
+            if (op_code == 0x80) {
+                return (int)(dest_ptr - (unsigned char*)dest);
+            }
+            count = op_code & 0x3f;
+            if (count > (unsigned)(dest_end - dest_ptr)) {
+                count = dest_end - dest_ptr;
+            }
+            while (count--)
+                *dest_ptr++ = *source_ptr++;
+        } else if (op_code == 0xfe) {
+            count = *source_ptr++;
+            count += (*source_ptr++) << 8;
+            if (count > (unsigned)(dest_end - dest_ptr)) {
+                count = dest_end - dest_ptr;
+            }
+            memset(dest_ptr, (*source_ptr++), count);
+            dest_ptr += count;
+        } else if (op_code == 0xff) {
+            count = *source_ptr++;
+            count += (*source_ptr++) << 8;
+            copy_ptr = (unsigned char*)dest + *source_ptr++;
+            copy_ptr += (*source_ptr++) << 8;
+            if (count > (unsigned)(dest_end - dest_ptr)) {
+                count = dest_end - dest_ptr;
+            }
+            while (count--)
+                *dest_ptr++ = *copy_ptr++;
+        } else {
+            count = (op_code & 0x3f) + 3;
+            copy_ptr = (unsigned char*)dest + *source_ptr + ((unsigned)*(source_ptr + 1) << 8);
+            source_ptr += 2;
+            if (count > (unsigned)(dest_end - dest_ptr)) {
+                count = dest_end - dest_ptr;
+            }
+            while (count--)
+                *dest_ptr++ = *copy_ptr++;
+        }
+    }
+
+    return (int)(dest_ptr - (unsigned char*)dest);
+}
+
+// The original exhaustive search compressor, kept as the baseline for ratio and speed comparisons.
+static int Reference_LCW_Comp(const void* src, void* dst, unsigned int bytes)
+{
+    if (!bytes) {
+        return 0;
+    }
+
+    const unsigned char* getp = (const unsigned char*)(src);
+    unsigned char* putp = (unsigned char*)(dst);
+    const unsigned char* getstart = getp;
+    const unsigned char* getend = getp + bytes;
+    unsigned char* putstart = putp;
+    bool cmd_one;
+    unsigned char* cmd_onep = putp;
+    *putp++ = 0x81;
+    *putp++ = *getp++;
+    cmd_one = true;
+
+    while (getp < getend) {
+        if (getend - getp > 64 && *getp == *(getp + 64)) {
+            const unsigned char* rlemax = (getend - getp) < 0xFFFF ? getend : getp + 0xFFFF;
+            const unsigned char* rlep;
+
+            for (rlep = getp + 1; *rlep == *getp && rlep < rlemax; ++rlep)
+                ;
+
+            unsigned short run_length = rlep - getp;
+
+            if (run_length >= 0x41) {
+                cmd_one = false;
+                *putp++ = 0xFE;
+                *putp++ = (unsigned char)run_length;
+                *putp++ = run_length >> 8;
+                *putp++ = *getp;
+                getp = rlep;
+                continue;
+            }
+        }
+
+        int block_size = 0;
+        const unsigned char* offchk = getstart;
+        const unsigned char* offsetp = getp;
+        while (offchk < getp) {
+            while (offchk < getp && *offchk != *getp) {
+                ++offchk;
+            }
+
+            if (offchk >= getp) {
+                break;
+            }
+
+            int i;
+            for (i = 1; &getp[i] < getend; ++i) {
+                if (offchk[i] != getp[i]) {
+                    break;
+                }
+            }
+
+            if (i >= block_size) {
+                block_size = i;
+                offsetp = offchk;
+            }
+
+            ++offchk;
+        }
+
+        if (block_size <= 2) {
+            if (cmd_one && *cmd_onep < 0xBF) {
+                ++*cmd_onep;
+                *putp++ = *getp++;
+            } else {
+                cmd_onep = putp;
+                *putp++ = 0x81;
+                *putp++ = *getp++;
+                cmd_one = true;
+            }
+        } else {
+            unsigned short offset;
+            unsigned short rel_offset = getp - offsetp;
+            if (block_size > 0xA || (rel_offset > 0xFFF)) {
+                if (block_size > 0x40) {
+                    *putp++ = 0xFF;
+                    *putp++ = block_size;
+                    *putp++ = block_size >> 8;
+                } else {
+                    *putp++ = (block_size - 3) | 0xC0;
+                }
+
+                offset = offsetp - getstart;
+            } else {
+                offset = rel_offset << 8 | (16 * (block_size - 3) + (rel_offset >> 8));
+            }
+            *putp++ = (unsigned char)offset;
+            *putp++ = offset >> 8;
+            getp += block_size;
+            cmd_one = false;
+        }
+    }
+
+    *putp++ = 0x80;
+    return putp - putstart;
+}
+
+// Small deterministic generator so the corpus is identical on every run and platform.
+static uint32_t corpus_seed;
+
+static unsigned Corpus_Random(unsigned range)
+{
+    corpus_seed = corpus_seed * 1664525 + 1013904223;
+    return (corpus_seed >> 8) % range;
+}
+
+// Builds a valid LCW stream exercising every command with a spread of offsets and lengths.
+static std::vector<unsigned char> Make_Stream(unsigned target, unsigned& out)
+{
+    std::vector<unsigned char> s;
+    out = 0;
+
+    while (out < target) {
+        unsigned cmd = out == 0 ? 0 : Corpus_Random(5);
+        if (cmd == 0) {
+            unsigned count = 1 + Corpus_Random(63);
+            s.push_back(0x80 | count);
+            for (unsigned i = 0; i < count; ++i) {
+                s.push_back(Corpus_Random(256) & 0xF3);
+            }
+            out += count;
+        } else if (cmd == 1) {
+            unsigned limit = out < 0xFFF ? out : 0xFFF;
+            unsigned offset = 1 + Corpus_Random(Corpus_Random(2) ? (limit < 20 ? limit : 20) : limit);
+            unsigned count = 3 + Corpus_Random(8);
+            s.push_back(((count - 3) << 4) | (offset >> 8));
+            s.push_back(offset & 0xFF);
+            out += count;
+        } else if (cmd == 2) {
+            unsigned offset = Corpus_Random(out);
+            unsigned count = 3 + Corpus_Random(61);
+            s.push_back(0xC0 | (count - 3));
+            s.push_back(offset & 0xFF);
+            s.push_back(offset >> 8);
+            out += count;
+        } else if (cmd == 3) {
+            unsigned offset = out - 1 - Corpus_Random(out < 40 ? out : 40);
+            unsigned count = Corpus_Random(400);
+            s.push_back(0xFF);
+            s.push_back(count & 0xFF);
+            s.push_back(count >> 8);
+            s.push_back(offset & 0xFF);
+            s.push_back(offset >> 8);
+            out += count;
+        } else {
+            unsigned count = Corpus_Random(300);
+            s.push_back(0xFE);
+            s.push_back(count & 0xFF);
+            s.push_back(count >> 8);
+            s.push_back(Corpus_Random(256));
+            out += count;
+        }
+    }
+
+    s.push_back(0x80);
+    return s;
+}
+
+// Imitates a save game stream: runs of fixed layout object records with slowly varying fields and padding.
+static std::vector<unsigned char> Make_Save_Stream(unsigned size)
+{
+    std::vector<unsigned char> s;
+    uint32_t coord = 0x00400040;
+
+    while (s.size() < size) {
+        unsigned type = Corpus_Random(6);
+        unsigned record = 96 + type * 24;
+        unsigned count = 1 + Corpus_Random(40);
+        for (unsigned n = 0; n < count && s.size() < size; ++n) {
+            unsigned char rec[256];
+            memset(rec, 0, record);
+            uint32_t vtable = 0x0804A000 + type * 0x40;
+            memcpy(&rec[0], &vtable, 4);
+            coord += Corpus_Random(0x300);
+            memcpy(&rec[4], &coord, 4);
+            rec[8] = Corpus_Random(256);
+            rec[9] = type;
+            rec[12] = 0xFF;
+            for (unsigned i = 16; i < record; i += 4 + Corpus_Random(24)) {
+                rec[i] = Corpus_Random(4) == 0 ? Corpus_Random(256) : 0;
+            }
+            s.insert(s.end(), rec, rec + record);
+        }
+    }
+
+    s.resize(size);
+    return s;
+}
+
+// Compresses and checks the data survives the round trip at every effort level.
+static int Check_Round_Trip(char const* label, unsigned char const* data, unsigned length)
+{
+    int ret = 0;
+    std::vector<unsigned char> comp(length + length / 63 + 2);
+    std::vector<unsigned char> decomp(length + 1);
+
+    for (int effort = LCW_EFFORT_FASTEST; effort <= LCW_EFFORT_BEST; ++effort) {
+        int complen = LCW_Comp(data, comp.data(), length, effort);
+        if (complen > (int)comp.size()) {
+            fprintf(stderr, "LCW_Comp overran its worst case size on %s at effort %d.\n", label, effort);
+            return 1;
+        }
+
+        int len = LCW_Uncompress_Safe(comp.data(), decomp.data(), complen, length);
+        if (len != (int)length || memcmp(decomp.data(), data, length) != 0) {
+            fprintf(stderr, "LCW_Comp did not round trip %s at effort %d.\n", label, effort);
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
 
 int test_lcw()
 {
@@ -10,7 +297,7 @@ int test_lcw()
 
 // Embed test image data to compress/decompress.
 #include "testimage.inc"
-    char lcwbuff[image_data_length + (image_data_length / 128 + 1)];
+    char lcwbuff[image_data_length + (image_data_length / 63 + 2)];
     char decompbuff[image_data_length];
 
     LCW_Comp(image_data, lcwbuff, image_data_length);
@@ -26,11 +313,281 @@ int test_lcw()
     return ret;
 }
 
+int test_lcw_comp()
+{
+    int ret = 0;
+
+#include "testimage.inc"
+    ret |= Check_Round_Trip("image", image_data, image_data_length);
+
+    corpus_seed = 0x53415645;
+    std::vector<unsigned char> save = Make_Save_Stream(150000);
+    ret |= Check_Round_Trip("save stream", save.data(), save.size());
+
+    // Inputs beyond 64k can only reach far data with relative offsets.
+    std::vector<unsigned char> corpus(200000);
+    for (unsigned i = 0; i < corpus.size(); i += 4096) {
+        unsigned len = i % 3 ? 4096 : 37;
+        memcpy(&corpus[i], &save[(i * 7) % (save.size() - 4096)], len);
+    }
+    ret |= Check_Round_Trip("large", corpus.data(), corpus.size());
+
+    std::vector<unsigned char> noise(70000);
+    std::vector<unsigned char> zeros(140000, 0);
+    for (unsigned i = 0; i < noise.size(); ++i) {
+        noise[i] = Corpus_Random(256);
+    }
+    ret |= Check_Round_Trip("noise", noise.data(), noise.size());
+    ret |= Check_Round_Trip("zeros", zeros.data(), zeros.size());
+
+    for (unsigned len = 1; len < 80; ++len) {
+        ret |= Check_Round_Trip("short", save.data() + len, len);
+        ret |= Check_Round_Trip("short zeros", zeros.data(), len);
+    }
+
+    return ret;
+}
+
+int test_lcw_conformance()
+{
+    int ret = 0;
+
+    corpus_seed = 0x4C4357;
+
+    for (int i = 0; i < 200; ++i) {
+        unsigned out;
+        std::vector<unsigned char> stream = Make_Stream(1 + Corpus_Random(60000), out);
+
+        // Decode into a smaller buffer every so often to exercise run truncation.
+        unsigned length = (i % 4) == 3 ? out / 2 + 1 : out;
+        std::vector<unsigned char> expected(length);
+        std::vector<unsigned char> fast(length);
+        std::vector<unsigned char> safe(length);
+
+        int ref_len = Reference_LCW_Uncompress(stream.data(), expected.data(), length);
+        int fast_len = LCW_Uncompress(stream.data(), fast.data(), length);
+        int safe_len = LCW_Uncompress_Safe(stream.data(), safe.data(), stream.size(), length);
+
+        if (fast_len != ref_len || fast != expected) {
+            fprintf(stderr, "LCW_Uncompress differs from reference decoder on corpus stream %d.\n", i);
+            ret = 1;
+        }
+
+        if (safe_len != ref_len || safe != expected) {
+            fprintf(stderr, "LCW_Uncompress_Safe differs from reference decoder on corpus stream %d.\n", i);
+            ret = 1;
+        }
+
+        // Uncompress in place with the data at the tail of the output buffer, as the VQA and straw code does.
+        std::vector<unsigned char> inplace(out + stream.size());
+        memcpy(&inplace[out], stream.data(), stream.size());
+        LCW_Uncompress(&inplace[out], inplace.data(), out + stream.size());
+
+        if (memcmp(inplace.data(), expected.data(), length) != 0) {
+            fprintf(stderr, "LCW_Uncompress in place differs from reference decoder on corpus stream %d.\n", i);
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
+
+int test_lcw_fuzz()
+{
+    int ret = 0;
+    const unsigned guard = 64;
+
+    corpus_seed = 0x46555A5A;
+
+    for (int i = 0; i < 2000; ++i) {
+        unsigned out;
+        std::vector<unsigned char> stream = Make_Stream(1 + Corpus_Random(4000), out);
+
+        // Corrupt the valid stream by flipping bytes and truncating it, or replace it outright with noise.
+        int mode = Corpus_Random(3);
+        if (mode == 0) {
+            for (unsigned flips = 1 + Corpus_Random(8); flips > 0; --flips) {
+                stream[Corpus_Random(stream.size())] ^= 1 << Corpus_Random(8);
+            }
+        } else if (mode == 1) {
+            stream.resize(Corpus_Random(stream.size()));
+        } else {
+            for (unsigned j = 0; j < stream.size(); ++j) {
+                stream[j] = Corpus_Random(256);
+            }
+        }
+
+        // Exactly sized source so memory checkers catch any over read.
+        unsigned char* source = new unsigned char[stream.size() + 1];
+        memcpy(source, stream.data(), stream.size());
+
+        std::vector<unsigned char> dest(out + guard, 0xA5);
+        int len = LCW_Uncompress_Safe(source, dest.data(), stream.size(), out);
+        delete[] source;
+
+        if (len > (int)out) {
+            fprintf(
+                stderr, "LCW_Uncompress_Safe reported %d bytes for a %u byte buffer on fuzz case %d.\n", len, out, i);
+            ret = 1;
+        }
+
+        for (unsigned j = out; j < out + guard; ++j) {
+            if (dest[j] != 0xA5) {
+                fprintf(stderr, "LCW_Uncompress_Safe wrote past the destination on fuzz case %d.\n", i);
+                ret = 1;
+                break;
+            }
+        }
+    }
+
+    return ret;
+}
+
+// A corrupt block stops an LCWPipe rather than passing on what it could decode.
+int test_lcw_pipe()
+{
+    int ret = 0;
+
+    corpus_seed = 0x50495045;
+    std::vector<unsigned char> save = Make_Save_Stream(20000);
+
+    MemoryPipe compressed;
+    LCWPipe comp(LCWPipe::COMPRESS, 4096);
+    comp.Put_To(compressed);
+    comp.Put(save.data(), save.size());
+    comp.End();
+
+    MemoryPipe restored;
+    LCWPipe decomp(LCWPipe::DECOMPRESS, 4096);
+    decomp.Put_To(restored);
+    decomp.Put(compressed.Get_Buffer(), compressed.Get_Length());
+    decomp.Flush();
+    if (decomp.Is_Failed() || restored.Get_Length() != (int)save.size()
+        || memcmp(restored.Get_Buffer(), save.data(), save.size()) != 0) {
+        fprintf(stderr, "LCWPipe didn't round trip a save stream.\n");
+        ret = 1;
+    }
+
+    // A block whose first command copies from before the start of the output, then a good block.
+    static unsigned char const corrupt[] = {3, 0, 3, 0, 0x0F, 0xFF, 0x80};
+    MemoryPipe dropped;
+    LCWPipe bad(LCWPipe::DECOMPRESS, 4096);
+    bad.Put_To(dropped);
+    if (bad.Put(corrupt, sizeof(corrupt)) != 0 || !bad.Is_Failed()
+        || bad.Put(compressed.Get_Buffer(), compressed.Get_Length()) != 0 || bad.Flush() != 0
+        || dropped.Get_Length() != 0) {
+        fprintf(stderr, "LCWPipe didn't stop at a corrupt block.\n");
+        ret = 1;
+    }
+
+    // A header for a block bigger than the pipe's buffers.
+    static unsigned char const oversize[] = {0xFF, 0x7F, 0x00, 0x10};
+    LCWPipe big(LCWPipe::DECOMPRESS, 4096);
+    big.Put_To(dropped);
+    if (big.Put(oversize, sizeof(oversize)) != 0 || !big.Is_Failed()) {
+        fprintf(stderr, "LCWPipe accepted a block bigger than its buffers.\n");
+        ret = 1;
+    }
+
+    return ret;
+}
+
+// Decodes the stream repeatedly for roughly a fixed amount of time per decoder.
+static void Bench_Decoders(char const* label, unsigned char const* stream, unsigned stream_len, unsigned length)
+{
+    static char const* names[] = {"reference", "LCW_Uncompress", "LCW_Uncompress_Safe"};
+    std::vector<unsigned char> dest(length);
+
+    for (int variant = 0; variant < 3; ++variant) {
+        double bytes = 0;
+        double secs = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        do {
+            for (int i = 0; i < 16; ++i) {
+                if (variant == 0) {
+                    Reference_LCW_Uncompress(stream, dest.data(), length);
+                } else if (variant == 1) {
+                    LCW_Uncompress(stream, dest.data(), length);
+                } else {
+                    LCW_Uncompress_Safe(stream, dest.data(), stream_len, length);
+                }
+                bytes += length;
+            }
+            secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (secs < 0.1);
+
+        printf("%-8s %-20s %8.1f MB/s\n", label, names[variant], bytes / secs / 1e6);
+    }
+}
+
+// Compresses the data in blocks, as LCWPipe does, for roughly a fixed amount of time per compressor.
+static void Bench_Compressors(char const* label, unsigned char const* data, unsigned length, unsigned block)
+{
+    std::vector<unsigned char> comp(block + block / 63 + 2);
+
+    for (int variant = 0; variant < 4; ++variant) {
+        static int const efforts[] = {0, LCW_EFFORT_FASTEST, LCW_EFFORT_DEFAULT, LCW_EFFORT_BEST};
+        static char const* names[] = {"reference", "effort 1", "effort 5", "effort 9"};
+        unsigned total = 0;
+        double bytes = 0;
+        double secs = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        do {
+            total = 0;
+            for (unsigned pos = 0; pos < length; pos += block) {
+                unsigned len = length - pos < block ? length - pos : block;
+                if (variant == 0) {
+                    total += Reference_LCW_Comp(data + pos, comp.data(), len);
+                } else {
+                    total += LCW_Comp(data + pos, comp.data(), len, efforts[variant]);
+                }
+            }
+            bytes += length;
+            secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (secs < 0.1);
+
+        printf("%-8s %-20s %6.2f%% %8.1f MB/s\n", label, names[variant], total * 100.0 / length, bytes / secs / 1e6);
+    }
+}
+
+int bench_lcw()
+{
+#include "testimage.inc"
+    static unsigned char lcwbuff[image_data_length + (image_data_length / 63 + 2)];
+    int complen = LCW_Comp(image_data, lcwbuff, image_data_length);
+
+    Bench_Decoders("image", lcwbuff, complen, image_data_length);
+
+    // The synthetic corpus has the longer back references typical of shapes and VQA codebooks.
+    unsigned out;
+    corpus_seed = 0x42454E43;
+    std::vector<unsigned char> stream = Make_Stream(60000, out);
+    Bench_Decoders("corpus", stream.data(), stream.size(), out);
+
+    // Save games go through LCWPipe in 4k blocks, shapes are compressed whole.
+    std::vector<unsigned char> save = Make_Save_Stream(256 * 1024);
+    Bench_Compressors("save", save.data(), save.size(), 4096);
+    Bench_Compressors("image", image_data, image_data_length, image_data_length);
+
+    return 0;
+}
+
 int main(int argc, char** argv)
 {
     int ret = 0;
 
     ret |= test_lcw();
+    ret |= test_lcw_comp();
+    ret |= test_lcw_conformance();
+    ret |= test_lcw_fuzz();
+    ret |= test_lcw_pipe();
+
+    // Benchmarks only run when asked for, e.g. "test_lcw bench".
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        ret |= bench_lcw();
+    }
 
     return ret;
 }
@@ -0,0 +1,473 @@
+#include "common/linksim.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+int test_linksim_unreliable()
+{
+    LinkNetClass net(77);
+    LinkSimClass a(net, 1);
+    LinkSimClass b(net, 2);
+    LinkNetClass::SettingsType link = {6, 4, 100, 50, 50};
+
+    net.Set_Link(link);
+    a.Create_Connection(2);
+    b.Create_Connection(1);
+
+    int const count = 1000;
+    int received = 0;
+    int duplicates = 0;
+    int reordered = 0;
+    int last = -1;
+    std::vector<int> seen(count, 0);
+
+    for (int i = 0; i < count + 40; ++i) {
+        if (i < count) {
+            a.Send_Private_Message(&i, sizeof(i), 0, 2);
+        }
+        net.Advance(1);
+        b.Service();
+
+        int value;
+        int len;
+        int id;
+
+        while (b.Get_Private_Message(&value, &len, &id)) {
+            if (len != sizeof(value) || id != 1 || value < 0 || value >= count) {
+                fprintf(stderr, "LinkSimClass handed up a packet that wasn't sent.\n");
+                return 1;
+            }
+            if (seen[value]++) {
+                ++duplicates;
+            } else {
+                ++received;
+            }
+            if (value < last) {
+                ++reordered;
+            }
+            last = value;
+        }
+    }
+
+    printf("Unreliable: %d of %d arrived, %d duplicates, %d out of order\n", received, count, duplicates, reordered);
+
+    if (received < count * 85 / 100 || received > count * 95 / 100 || duplicates == 0 || reordered == 0) {
+        fprintf(stderr, "LinkNetClass didn't lose, duplicate and reorder packets as configured.\n");
+        return 1;
+    }
+
+    if (net.Packets_Lost() != (unsigned)(count - received)) {
+        fprintf(stderr, "LinkNetClass counted %u lost, %d went missing.\n", net.Packets_Lost(), count - received);
+        return 1;
+    }
+
+    return 0;
+}
+
+int test_linksim_reliable()
+{
+    LinkNetClass net(5);
+    LinkSimClass a(net, 1);
+    LinkSimClass b(net, 2);
+    LinkNetClass::SettingsType link = {8, 8, 200, 100, 100};
+
+    net.Set_Link(link);
+    a.Create_Connection(2);
+    b.Create_Connection(1);
+    a.Set_Timing(20, -1, 600);
+    b.Set_Timing(20, -1, 600);
+
+    int const count = 500;
+    int next = 0;
+    std::vector<int> seen(count, 0);
+
+    for (int tick = 0; tick < 5000 && (next < count || a.Private_Num_Send() > 0); ++tick) {
+        while (next < count && a.Send_Private_Message(&next, sizeof(next), 1, 2)) {
+            ++next;
+        }
+
+        net.Advance(1);
+
+        if (!a.Service() || !b.Service()) {
+            fprintf(stderr, "LinkSimClass timed out a connection that was still there.\n");
+            return 1;
+        }
+
+        int value;
+        int len;
+        int id;
+
+        while (b.Get_Private_Message(&value, &len, &id)) {
+            seen[value]++;
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (seen[i] != 1) {
+            fprintf(stderr, "Guaranteed packet %d arrived %d times.\n", i, seen[i]);
+            return 1;
+        }
+    }
+
+    printf("Reliable: %d packets with %u resends, response time %lu ticks, 95th percentile %lu\n",
+           count,
+           a.Resends(),
+           a.Response_Time(),
+           a.Response_Time_Percentile(95));
+
+    if (a.Private_Num_Send() != 0 || a.Resends() == 0 || a.Response_Time() < 16) {
+        fprintf(stderr, "LinkSimClass didn't resend and time lost packets.\n");
+        return 1;
+    }
+
+    // With the other side gone, packets time out and Service says so.
+    LinkSimClass lonely(net, 3);
+    lonely.Create_Connection(4);
+    lonely.Set_Timing(20, -1, 600);
+    lonely.Send_Private_Message(&next, sizeof(next), 1, 4);
+    net.Advance(601);
+
+    if (lonely.Service() != 0) {
+        fprintf(stderr, "LinkSimClass didn't report a timed out connection.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+** A small lockstep game over the simulated link. Every frame each player sends the command it wants run
+** MAX_AHEAD frames later; nobody runs a frame until they have everyone's command for it. The game state is a CRC
+** of every command run, and each player logs it per frame just as the game would.
+*/
+enum
+{
+    PLAYERS = 4,
+    MAX_AHEAD = 8,
+    TICKS_PER_FRAME = 4,
+    FRAMES = 600,
+};
+
+struct CommandType
+{
+    int32_t Frame;
+    int32_t Value;
+};
+
+struct PlayerType
+{
+    LinkSimClass* Link;
+    long Frame;
+    unsigned long NextTick;
+    uint32_t State;
+    uint32_t Seed;
+    std::map<long, std::map<int, int32_t> > Commands;
+};
+
+struct GameResult
+{
+    unsigned Sent;
+    unsigned Lost;
+    unsigned Delivered;
+    unsigned Resends;
+    int Stalls;
+    int Frames;
+};
+
+static std::string Log_Name(int id)
+{
+    char name[32];
+    sprintf(name, "linksim_%d.log", id);
+    return name;
+}
+
+static GameResult Play(uint32_t seed, int desync_player, long desync_frame)
+{
+    LinkNetClass net(seed);
+    LinkNetClass::SettingsType link = {10, 12, 30, 10, 20};
+    PlayerType players[PLAYERS];
+    GameResult result = {0, 0, 0, 0, 0, 0};
+
+    net.Set_Link(link);
+
+    // One player on a worse line than the others.
+    LinkNetClass::SettingsType bad = {16, 20, 80, 10, 40};
+    net.Set_Link(bad, 12 + PLAYERS - 1, -1);
+
+    for (int i = 0; i < PLAYERS; ++i) {
+        players[i].Link = new LinkSimClass(net, 12 + i);
+        players[i].Link->Set_Timing(30, -1, 1200);
+        players[i].Link->Set_Log(Log_Name(12 + i).c_str());
+        players[i].Frame = 0;
+        players[i].NextTick = 0;
+        players[i].State = 0;
+        players[i].Seed = 1000 + i;
+
+        for (int j = 0; j < PLAYERS; ++j) {
+            players[i].Link->Create_Connection(12 + j);
+        }
+    }
+
+    for (unsigned long tick = 0; tick < FRAMES * TICKS_PER_FRAME * 4; ++tick) {
+        bool done = true;
+
+        net.Set_Time(tick);
+
+        for (int i = 0; i < PLAYERS; ++i) {
+            PlayerType& player = players[i];
+            CommandType command;
+            int len;
+            int id;
+
+            player.Link->Service();
+            while (player.Link->Get_Private_Message(&command, &len, &id)) {
+                player.Commands[command.Frame][id] = command.Value;
+            }
+
+            if (player.Frame >= FRAMES) {
+                continue;
+            }
+            done = false;
+
+            if (tick < player.NextTick) {
+                continue;
+            }
+
+            std::map<int, int32_t>& commands = player.Commands[player.Frame];
+
+            if (player.Frame >= MAX_AHEAD && (int)commands.size() < PLAYERS) {
+                ++result.Stalls;
+                continue;
+            }
+
+            // Run the frame: fold in everyone's commands, in player order.
+            for (std::map<int, int32_t>::iterator it = commands.begin(); it != commands.end(); ++it) {
+                player.State = (player.State ^ (uint32_t)it->second) * 16777619u + it->first;
+            }
+            if (i == desync_player && player.Frame == desync_frame) {
+                player.State ^= 1;
+            }
+            player.Link->Log_Frame_CRC(player.Frame, player.State);
+
+            // Our own command for later goes in our own list and out to everyone else.
+            player.Seed = player.Seed * 1664525 + 1013904223;
+            command.Frame = player.Frame + MAX_AHEAD;
+            command.Value = (int32_t)(player.Seed >> 8);
+            player.Commands[command.Frame][12 + i] = command.Value;
+            player.Link->Send_Private_Message(&command, sizeof(command), 1);
+
+            player.Commands.erase(player.Frame);
+            player.Frame++;
+            player.NextTick = tick + TICKS_PER_FRAME;
+        }
+
+        if (done) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < PLAYERS; ++i) {
+        result.Resends += players[i].Link->Resends();
+        result.Frames += players[i].Frame;
+        delete players[i].Link;
+    }
+
+    result.Sent = net.Packets_Sent();
+    result.Lost = net.Packets_Lost();
+    result.Delivered = net.Packets_Delivered();
+
+    return result;
+}
+
+/*
+** First frame the players' CRC logs disagree on, -1 if they all match, -2 if one is missing.
+*/
+static long First_Desync()
+{
+    std::vector<FILE*> logs;
+    long frame = -1;
+
+    for (int i = 0; i < PLAYERS; ++i) {
+        logs.push_back(fopen(Log_Name(12 + i).c_str(), "rt"));
+        if (logs.back() == NULL) {
+            frame = -2;
+        }
+    }
+
+    while (frame == -1) {
+        long first_frame = 0;
+        unsigned long first_crc = 0;
+        int ended = 0;
+
+        for (int i = 0; i < PLAYERS && frame == -1; ++i) {
+            long f;
+            unsigned long crc;
+
+            if (fscanf(logs[i], "%ld %lx", &f, &crc) != 2) {
+                ++ended;
+                continue;
+            }
+            if (i == 0) {
+                first_frame = f;
+                first_crc = crc;
+            } else if (f != first_frame || crc != first_crc) {
+                frame = first_frame;
+            }
+        }
+
+        if (ended == PLAYERS) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < PLAYERS; ++i) {
+        if (logs[i] != NULL) {
+            fclose(logs[i]);
+        }
+        remove(Log_Name(12 + i).c_str());
+    }
+
+    return frame;
+}
+
+int test_linksim_lockstep()
+{
+    GameResult first = Play(2024, -1, 0);
+    long desync = First_Desync();
+
+    printf("Lockstep: %d frames, %u packets sent, %u lost, %u resent, %d stalls\n",
+           first.Frames,
+           first.Sent,
+           first.Lost,
+           first.Resends,
+           first.Stalls);
+
+    if (first.Frames != PLAYERS * FRAMES || desync != -1) {
+        fprintf(stderr, "Lockstep game over a lossy link didn't finish in sync (first desync %ld).\n", desync);
+        return 1;
+    }
+
+    // The same seed plays out the same way, down to the last packet.
+    GameResult again = Play(2024, -1, 0);
+    First_Desync();
+
+    if (again.Sent != first.Sent || again.Lost != first.Lost || again.Delivered != first.Delivered
+        || again.Resends != first.Resends || again.Stalls != first.Stalls) {
+        fprintf(stderr, "Replaying the same seed gave a different game.\n");
+        return 1;
+    }
+
+    GameResult other = Play(7, -1, 0);
+    First_Desync();
+
+    if (other.Lost == first.Lost && other.Stalls == first.Stalls && other.Resends == first.Resends) {
+        fprintf(stderr, "A different seed gave the same game.\n");
+        return 1;
+    }
+
+    // A player whose state goes wrong shows up in the logs on that very frame.
+    Play(2024, 2, 321);
+    desync = First_Desync();
+
+    if (desync != 321) {
+        fprintf(stderr, "CRC logs put the desync on frame %ld, not 321.\n", desync);
+        return 1;
+    }
+
+    return 0;
+}
+
+#ifndef _WIN32
+/*
+** Two nets, each with one player, as two processes would have them, talking over loopback.
+*/
+int test_linksim_processes()
+{
+    LinkNetClass net1(1);
+    LinkNetClass net2(2);
+    LinkNetClass::SettingsType link = {2, 2, 100, 0, 0};
+    uint16_t base = 0;
+
+    for (uint16_t port = 46000; port < 47000 && base == 0; port += 16) {
+        if (net1.Open(port, 1)) {
+            if (net2.Open(port, 2)) {
+                base = port;
+            } else {
+                net1.Close();
+            }
+        }
+    }
+
+    if (base == 0) {
+        printf("Processes: no free loopback ports, skipped\n");
+        return 0;
+    }
+
+    net1.Set_Link(link);
+    net2.Set_Link(link);
+
+    LinkSimClass a(net1, 1);
+    LinkSimClass b(net2, 2);
+
+    a.Create_Connection(2);
+    b.Create_Connection(1);
+
+    int const count = 200;
+    int next = 0;
+    std::vector<int> seen(count, 0);
+
+    for (int tick = 0; tick < 20000 && (next < count || a.Private_Num_Send() > 0); ++tick) {
+        while (next < count && a.Send_Private_Message(&next, sizeof(next), 1, 2)) {
+            ++next;
+        }
+
+        net1.Advance(1);
+        net2.Advance(1);
+        a.Service();
+        b.Service();
+
+        int value;
+        int len;
+        int id;
+
+        while (b.Get_Private_Message(&value, &len, &id)) {
+            seen[value]++;
+        }
+
+        usleep(100);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (seen[i] != 1) {
+            fprintf(stderr, "Packet %d between processes arrived %d times.\n", i, seen[i]);
+            return 1;
+        }
+    }
+
+    printf("Processes: %d packets over loopback, %u lost on the way out and resent\n", count, net1.Packets_Lost());
+
+    return 0;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_linksim_unreliable();
+    ret |= test_linksim_reliable();
+    ret |= test_linksim_lockstep();
+#ifndef _WIN32
+    ret |= test_linksim_processes();
+#endif
+
+    return ret;
+}
@@ -0,0 +1,250 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/ini.h"
+#include "common/memflag.h"
+#include "common/xstraw.h"
+#ifdef SLAB_ALLOC
+#include "common/slaballoc.h"
+#endif
+
+#include <string>
+#include <thread>
+
+static MemoryStatsType Stats(MemoryTagType tag)
+{
+    MemoryStatsType stats;
+    Memory_Stats(tag, stats);
+    return stats;
+}
+
+int test_memtag()
+{
+    MemoryStatsType before = Stats(MEM_TAG_SHAPE);
+    MemoryStatsType total = Stats(MEM_TAG_COUNT);
+
+    char* block = (char*)Alloc(100000, Memory_Tag_Flag(MEM_TAG_SHAPE, MEM_CLEAR));
+    if (block == NULL || ((uintptr_t)block % 16) != 0 || block[0] != 0 || block[99999] != 0) {
+        fprintf(stderr, "Alloc with a tag didn't return a cleared, aligned block.\n");
+        return 1;
+    }
+
+    MemoryStatsType during = Stats(MEM_TAG_SHAPE);
+    if (during.Current - before.Current != 100000 || during.Allocs - before.Allocs != 1
+        || during.Peak < during.Current) {
+        fprintf(stderr, "Alloc didn't account the block to its tag.\n");
+        return 1;
+    }
+    if (Stats(MEM_TAG_COUNT).Current - total.Current != 100000) {
+        fprintf(stderr, "Alloc didn't account the block to the total.\n");
+        return 1;
+    }
+
+    // Growing keeps the tag and the contents, and moves the peak.
+    memset(block, 0x5A, 100000);
+    block = (char*)Resize_Alloc(block, 300000);
+    during = Stats(MEM_TAG_SHAPE);
+    if (block == NULL || block[99999] != 0x5A || during.Current - before.Current != 300000
+        || during.Peak - before.Current < 300000) {
+        fprintf(stderr, "Resize_Alloc didn't keep the block's accounting.\n");
+        return 1;
+    }
+
+    Free(block);
+    MemoryStatsType after = Stats(MEM_TAG_SHAPE);
+    if (after.Current != before.Current || after.Frees - before.Frees != 1) {
+        fprintf(stderr, "Free didn't take the block off its tag.\n");
+        return 1;
+    }
+
+    // Resize_Alloc of nothing is an Alloc, and everything handed out is back.
+    void* fresh = Resize_Alloc(NULL, 64);
+    fresh = Resize_Alloc(fresh, 128);
+    Free(fresh);
+    if (Stats(MEM_TAG_COUNT).Current != total.Current) {
+        fprintf(stderr, "Alloc, Resize_Alloc and Free left bytes on the total.\n");
+        return 1;
+    }
+
+    Memory_Tag_Add(MEM_TAG_VQA, 5000);
+    if (Stats(MEM_TAG_VQA).Current != 5000) {
+        fprintf(stderr, "Memory_Tag_Add didn't account the memory.\n");
+        return 1;
+    }
+    Memory_Tag_Add(MEM_TAG_VQA, -5000);
+    if (Stats(MEM_TAG_VQA).Current != 0 || Stats(MEM_TAG_VQA).Frees != 1) {
+        fprintf(stderr, "Memory_Tag_Add didn't take the memory back off.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+** Scoped tags nest, and only apply to the thread that set them.
+*/
+static void Thread_Alloc(char** block)
+{
+    *block = new char[7000];
+}
+
+int test_memtag_scope()
+{
+    MemoryStatsType map = Stats(MEM_TAG_MAP);
+    MemoryStatsType heap = Stats(MEM_TAG_HEAP);
+    char* outer;
+    char* inner;
+    char* other;
+
+    {
+        MemoryTagClass tag(MEM_TAG_MAP);
+        outer = new char[3000];
+        {
+            MemoryTagClass tag(MEM_TAG_HEAP);
+            inner = new char[2000];
+        }
+
+        std::thread thread(Thread_Alloc, &other);
+        thread.join();
+    }
+
+    if (Stats(MEM_TAG_MAP).Current - map.Current != 3000 || Stats(MEM_TAG_HEAP).Current - heap.Current != 2000) {
+        fprintf(stderr, "MemoryTagClass didn't account allocations to the innermost tag.\n");
+        return 1;
+    }
+
+    char* later = new char[1000];
+    if (Stats(MEM_TAG_MAP).Current - map.Current != 3000) {
+        fprintf(stderr, "MemoryTagClass didn't restore the tag when it went out of scope.\n");
+        return 1;
+    }
+
+    delete[] outer;
+    delete[] inner;
+    delete[] other;
+    delete[] later;
+
+    if (Stats(MEM_TAG_MAP).Current != map.Current || Stats(MEM_TAG_HEAP).Current != heap.Current) {
+        fprintf(stderr, "delete didn't take the blocks off their tags.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+#ifdef SLAB_ALLOC
+/*
+** Small blocks from new come out of the pools, but still count under the tag in effect and go back through Free.
+*/
+int test_memtag_slab()
+{
+    MemoryStatsType before = Stats(MEM_TAG_AUDIO);
+    char* block;
+
+    {
+        MemoryTagClass tag(MEM_TAG_AUDIO);
+        block = new char[40];
+    }
+
+    size_t size;
+    MemoryTagType tag;
+    if (!Slab_Info(block, size, tag) || tag != MEM_TAG_AUDIO) {
+        fprintf(stderr, "new didn't take a small block from the pools for its tag.\n");
+        return 1;
+    }
+
+    MemoryStatsType during = Stats(MEM_TAG_AUDIO);
+    if (during.Current - before.Current != size || during.Allocs - before.Allocs != 1) {
+        fprintf(stderr, "A block from the pools wasn't accounted to its tag.\n");
+        return 1;
+    }
+
+    // Growing moves the block out of the pools under the same tag.
+    strcpy(block, "pooled");
+    block = (char*)Resize_Alloc(block, 4000);
+    if (Slab_Owns(block) || strcmp(block, "pooled") != 0 || Stats(MEM_TAG_AUDIO).Current - before.Current != 4000) {
+        fprintf(stderr, "Resize_Alloc didn't move a pool block with its contents and tag.\n");
+        return 1;
+    }
+
+    char* small = (char*)Alloc(24, Memory_Tag_Flag(MEM_TAG_AUDIO, MEM_NEW));
+    if (!Slab_Owns(small)) {
+        fprintf(stderr, "Alloc with MEM_NEW didn't use the pools.\n");
+        return 1;
+    }
+
+    Free(small);
+    delete[] block;
+
+    MemoryStatsType after = Stats(MEM_TAG_AUDIO);
+    if (after.Current != before.Current || after.Frees - before.Frees != 3) {
+        fprintf(stderr, "Free didn't take pool blocks off their tag.\n");
+        return 1;
+    }
+
+    return 0;
+}
+#endif
+
+int test_memtag_ini()
+{
+    std::string text = "[Basic]\r\nName=Tagged\r\n\r\n[Units]\r\n";
+    char line[64];
+
+    for (int i = 0; i < 500; ++i) {
+        snprintf(line, sizeof(line), "%d=Greece,2TNK,256,%d,64,Guard,None\r\n", i, i);
+        text += line;
+    }
+
+    MemoryStatsType before = Stats(MEM_TAG_INI);
+    {
+        INIClass ini;
+        BufferStraw straw(text.data(), (int)text.size());
+        ini.Load(straw);
+
+        if (Stats(MEM_TAG_INI).Current - before.Current < text.size()) {
+            fprintf(stderr, "INIClass::Load didn't account its memory to INI.\n");
+            return 1;
+        }
+    }
+
+    if (Stats(MEM_TAG_INI).Current != before.Current) {
+        fprintf(stderr, "INIClass didn't give back its INI memory.\n");
+        return 1;
+    }
+
+    char report[1024];
+    int length = Memory_Report(report, sizeof(report));
+    if (length != (int)strlen(report) || strstr(report, "INI") == NULL || strstr(report, "Total") == NULL) {
+        fprintf(stderr, "Memory_Report didn't list the subsystems.\n");
+        return 1;
+    }
+
+    // A short buffer is cut off rather than overrun.
+    char small[40];
+    length = Memory_Report(small, sizeof(small));
+    if (length != (int)strlen(small) || length >= (int)sizeof(small)) {
+        fprintf(stderr, "Memory_Report overran a short buffer.\n");
+        return 1;
+    }
+
+    printf("%s", report);
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_memtag();
+    ret |= test_memtag_scope();
+#ifdef SLAB_ALLOC
+    ret |= test_memtag_slab();
+#endif
+    ret |= test_memtag_ini();
+
+    return ret;
+}
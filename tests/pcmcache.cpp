@@ -0,0 +1,156 @@
+#include "common/pcmcache.h"
+#include "common/soscomp.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+static std::vector<uint8_t> Make_PCM(size_t size, uint8_t fill)
+{
+    return std::vector<uint8_t>(size, fill);
+}
+
+int test_pcmcache()
+{
+    int ret = 0;
+    PCMCacheClass cache(1000);
+    char samples[8];
+
+    // Fill past the limit; the oldest entry goes first.
+    cache.Add(&samples[0], 1, Make_PCM(400, 0));
+    cache.Add(&samples[1], 1, Make_PCM(400, 1));
+
+    if (cache.Find(&samples[0], 1) == nullptr) {
+        fprintf(stderr, "PCMCacheClass::Find missed a cached sample.\n");
+        ret = 1;
+    }
+
+    PCMCacheClass::PCMPtr held = cache.Find(&samples[1], 1);
+    cache.Add(&samples[2], 1, Make_PCM(400, 2));
+
+    if (cache.Find(&samples[0], 1) != nullptr || cache.Find(&samples[1], 1) == nullptr
+        || cache.Find(&samples[2], 1) == nullptr || cache.Size() != 800 || cache.Count() != 2
+        || cache.Evictions() != 1) {
+        fprintf(stderr, "PCMCacheClass didn't evict the least recently used sample.\n");
+        ret = 1;
+    }
+
+    // A changed check value means the buffer now holds a different sample.
+    if (cache.Find(&samples[2], 2) != nullptr || cache.Count() != 1) {
+        fprintf(stderr, "PCMCacheClass::Find returned a sample with a stale check value.\n");
+        ret = 1;
+    }
+
+    // Data still in use outlives its entry.
+    cache.Set_Limit(0);
+
+    if (cache.Count() != 0 || cache.Size() != 0 || held == nullptr || held->size() != 400 || (*held)[399] != 1) {
+        fprintf(stderr, "PCMCacheClass::Set_Limit didn't empty the cache or released data in use.\n");
+        ret = 1;
+    }
+
+    // Too big to cache at all, but still handed back.
+    cache.Set_Limit(100);
+    PCMCacheClass::PCMPtr big = cache.Add(&samples[3], 1, Make_PCM(200, 3));
+
+    if (big == nullptr || big->size() != 200 || cache.Count() != 0) {
+        fprintf(stderr, "PCMCacheClass::Add mishandled a sample larger than the cache.\n");
+        ret = 1;
+    }
+
+    // Re-adding replaces rather than duplicates.
+    cache.Add(&samples[4], 1, Make_PCM(50, 4));
+    cache.Add(&samples[4], 2, Make_PCM(60, 5));
+
+    if (cache.Count() != 1 || cache.Size() != 60 || cache.Find(&samples[4], 2) == nullptr) {
+        fprintf(stderr, "PCMCacheClass::Add didn't replace an existing entry.\n");
+        ret = 1;
+    }
+
+    uint8_t data[1000];
+    memset(data, 7, sizeof(data));
+    uint32_t check = PCMCacheClass::Check(data, sizeof(data));
+    data[496] = 8;
+
+    // Only a spread of bytes is looked at, but a different sample in the same buffer differs at most of them.
+    if (PCMCacheClass::Check(data, sizeof(data)) == check || PCMCacheClass::Check(data, sizeof(data) - 1) == check) {
+        fprintf(stderr, "PCMCacheClass::Check didn't notice a changed sample.\n");
+        ret = 1;
+    }
+
+    return ret;
+}
+
+int bench_pcmcache()
+{
+    // A second of 22kHz 16 bit mono, about the length of a unit response.
+    unsigned const samples = 22050;
+    std::vector<int16_t> wave(samples);
+
+    for (unsigned i = 0; i < samples; ++i) {
+        wave[i] = (int16_t)(sin(i * 0.05) * 12000 + sin(i * 0.31) * 4000);
+    }
+
+    std::vector<uint8_t> packed(samples);
+    _SOS_COMPRESS_INFO info = {};
+    info.wBitSize = 16;
+    info.wChannels = 1;
+    info.lpSource = (char*)wave.data();
+    info.lpDest = (char*)packed.data();
+    sosCODECInitStream(&info);
+    sosCODECCompressData(&info, samples * 2);
+
+    std::vector<uint8_t> decoded(samples * 2);
+    PCMCacheClass cache(4 * 1024 * 1024);
+    uint32_t check = PCMCacheClass::Check(packed.data(), packed.size());
+    cache.Add(packed.data(), check, std::vector<uint8_t>(decoded));
+
+    int plays = 0;
+    double decode_secs = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    do {
+        info.wBitSize = 16;
+        info.wChannels = 1;
+        info.lpSource = (char*)packed.data();
+        info.lpDest = (char*)decoded.data();
+        sosCODECInitStream(&info);
+        sosCODECDecompressData(&info, samples * 2);
+        ++plays;
+        decode_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (decode_secs < 0.2);
+
+    int decode_plays = plays;
+    plays = 0;
+    double cached_secs = 0;
+    start = std::chrono::steady_clock::now();
+
+    do {
+        PCMCacheClass::PCMPtr pcm = cache.Find(packed.data(), PCMCacheClass::Check(packed.data(), packed.size()));
+        memcpy(decoded.data(), pcm->data(), pcm->size());
+        ++plays;
+        cached_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (cached_secs < 0.2);
+
+    printf("ADPCM decode    %8.3f us per 1s sample\n", decode_secs * 1000000.0 / decode_plays);
+    printf("PCM cache hit   %8.3f us per 1s sample\n", cached_secs * 1000000.0 / plays);
+
+    return cache.Hits() != (unsigned)plays;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_pcmcache();
+
+    // Benchmarks only run when asked for, e.g. "test_pcmcache bench".
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        ret |= bench_pcmcache();
+    }
+
+    return ret;
+}
@@ -0,0 +1,427 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common/blowpipe.h"
+#include "common/blwstraw.h"
+#include "common/lcwpipe.h"
+#include "common/lcwstraw.h"
+#include "common/savefield.h"
+#include "common/shastraw.h"
+#include "common/xpipe.h"
+#include "common/xstraw.h"
+
+#include <chrono>
+#include <vector>
+
+/*
+** The fields of a map cell as CellClass::Save writes them in SAVEFORMAT_MAP_FIELDS, at the same sizes.
+*/
+enum
+{
+    CELL_OVERLAPPERS = 10,
+    CELL_COUNT = 128 * 128,
+    CELL_IMAGE = 176, // sizeof(CellClass) in a 64-bit build.
+    SAVE_BLOCK = 4096,
+};
+
+struct TestCellType
+{
+    unsigned char Flags;
+    unsigned char Zones[4];
+    short Jammed;
+    int Trigger;
+    short TType;
+    unsigned char TIcon;
+    signed char Overlay;
+    unsigned char OverlayData;
+    signed char Smudge;
+    unsigned char SmudgeData;
+    signed char Owner;
+    signed char InfType;
+    int Mapped;
+    int Visible;
+    unsigned char Composite;
+    signed char Land;
+    signed char OverrideLand;
+    int Occupier;
+    int Overlappers[CELL_OVERLAPPERS];
+    int Flag;
+};
+
+static bool Same_Cell(TestCellType const& a, TestCellType const& b)
+{
+    return a.Flags == b.Flags && memcmp(a.Zones, b.Zones, sizeof(a.Zones)) == 0 && a.Jammed == b.Jammed
+           && a.Trigger == b.Trigger && a.TType == b.TType && a.TIcon == b.TIcon && a.Overlay == b.Overlay
+           && a.OverlayData == b.OverlayData && a.Smudge == b.Smudge && a.SmudgeData == b.SmudgeData
+           && a.Owner == b.Owner && a.InfType == b.InfType && a.Mapped == b.Mapped && a.Visible == b.Visible
+           && a.Composite == b.Composite && a.Land == b.Land && a.OverrideLand == b.OverrideLand
+           && a.Occupier == b.Occupier && memcmp(a.Overlappers, b.Overlappers, sizeof(a.Overlappers)) == 0
+           && a.Flag == b.Flag;
+}
+
+static void Put_Cell(Pipe& file, TestCellType const& cell)
+{
+    FieldRecord record;
+    record.Put(cell.Flags);
+    record.Put(cell.Zones);
+    record.Put(cell.Jammed);
+    record.Put(cell.Trigger);
+    record.Put(cell.TType);
+    record.Put(cell.TIcon);
+    record.Put(cell.Overlay);
+    record.Put(cell.OverlayData);
+    record.Put(cell.Smudge);
+    record.Put(cell.SmudgeData);
+    record.Put(cell.Owner);
+    record.Put(cell.InfType);
+    record.Put(cell.Mapped);
+    record.Put(cell.Visible);
+    record.Put(cell.Composite);
+    record.Put(cell.Land);
+    record.Put(cell.OverrideLand);
+    record.Put(cell.Occupier);
+    record.Put_Target_Slots(cell.Overlappers);
+    record.Put(cell.Flag);
+    record.Write(file);
+}
+
+static bool Get_Cell(Straw& file, TestCellType& cell)
+{
+    FieldRecord record;
+    if (!record.Read(file)) {
+        return false;
+    }
+
+    record.Get(cell.Flags);
+    record.Get(cell.Zones);
+    record.Get(cell.Jammed);
+    record.Get(cell.Trigger);
+    record.Get(cell.TType);
+    record.Get(cell.TIcon);
+    record.Get(cell.Overlay);
+    record.Get(cell.OverlayData);
+    record.Get(cell.Smudge);
+    record.Get(cell.SmudgeData);
+    record.Get(cell.Owner);
+    record.Get(cell.InfType);
+    record.Get(cell.Mapped);
+    record.Get(cell.Visible);
+    record.Get(cell.Composite);
+    record.Get(cell.Land);
+    record.Get(cell.OverrideLand);
+    record.Get(cell.Occupier);
+    record.Get_Target_Slots(cell.Overlappers);
+    record.Get(cell.Flag);
+
+    return record.Is_Done();
+}
+
+static uint32_t Next_Random(uint32_t& seed)
+{
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 8;
+}
+
+/*
+** A map like a mission's: terrain everywhere, something standing in one cell in twenty, and overlapping objects
+** in one in fifty.
+*/
+static void Make_Map(std::vector<TestCellType>& cells, uint32_t seed)
+{
+    cells.resize(CELL_COUNT);
+
+    for (int index = 0; index < CELL_COUNT; ++index) {
+        TestCellType& cell = cells[index];
+        memset(&cell, 0, sizeof(cell));
+
+        cell.Flags = (index & 3) ? 0x0C : 0;
+        for (int zone = 0; zone < 4; ++zone) {
+            cell.Zones[zone] = (unsigned char)(1 + (index >> 10));
+        }
+        cell.Trigger = -1;
+        cell.TType = (short)(Next_Random(seed) % 8 == 0 ? 0xFFFF : 100 + (index >> 9));
+        cell.TIcon = (unsigned char)(Next_Random(seed) % 16);
+        cell.Overlay = -1;
+        cell.Smudge = (Next_Random(seed) % 40 == 0) ? 3 : -1;
+        cell.Owner = -1;
+        cell.InfType = -1;
+        cell.Mapped = (index & 3) ? 0x1 : 0;
+        cell.Visible = cell.Mapped;
+        cell.Land = (signed char)(Next_Random(seed) % 3);
+        cell.OverrideLand = -1;
+
+        if (Next_Random(seed) % 20 == 0) {
+            cell.Occupier = (int)(0x04000000 | (Next_Random(seed) % 500));
+        }
+        if (Next_Random(seed) % 50 == 0) {
+            for (int slot = 0; slot < 1 + (int)(Next_Random(seed) % 3); ++slot) {
+                cell.Overlappers[Next_Random(seed) % CELL_OVERLAPPERS] = (int)(0x09000000 | (Next_Random(seed) % 500));
+            }
+        }
+    }
+}
+
+int test_savefield_record()
+{
+    int targets[CELL_OVERLAPPERS] = {0, 0x0300000A, 0, 0, 0x0500FFFF, 0, 0, 0, 0, 0x01000001};
+    int empty[CELL_OVERLAPPERS] = {0};
+    char buffer[256];
+
+    BufferPipe pipe(buffer, sizeof(buffer));
+    FieldRecord out;
+    out.Put((short)0x1234);
+    out.Put_Target_Slots(targets);
+    out.Put_Target_Slots(empty);
+    out.Write(pipe);
+
+    // The length, the short, a mask and three targets, and a mask on its own for the empty slots.
+    int written = (int)(1 + sizeof(short) + sizeof(unsigned short) * 2 + sizeof(int) * 3);
+
+    short value;
+    int loaded[CELL_OVERLAPPERS];
+    int loaded_empty[CELL_OVERLAPPERS];
+    FieldRecord in;
+    BufferStraw straw(buffer, written);
+    if (!in.Read(straw)) {
+        fprintf(stderr, "The record didn't read back.\n");
+        return 1;
+    }
+    in.Get(value);
+    in.Get_Target_Slots(loaded);
+    in.Get_Target_Slots(loaded_empty);
+    if (!in.Is_Done() || value != 0x1234 || memcmp(loaded, targets, sizeof(targets)) != 0
+        || memcmp(loaded_empty, empty, sizeof(empty)) != 0) {
+        fprintf(stderr, "The record's fields didn't come back as they were saved.\n");
+        return 1;
+    }
+
+    // A save cut off in the middle of the record.
+    FieldRecord cut;
+    BufferStraw cut_straw(buffer, written - 2);
+    if (cut.Read(cut_straw)) {
+        fprintf(stderr, "FieldRecord read past the end of the save.\n");
+        return 1;
+    }
+
+    // Getting more than the record holds, and leaving some of it unread.
+    FieldRecord over;
+    BufferStraw over_straw(buffer, written);
+    over.Read(over_straw);
+    over.Get(value);
+    over.Get_Target_Slots(loaded);
+    over.Get_Target_Slots(loaded_empty);
+    over.Get(value);
+    if (over.Is_Done() || value != 0) {
+        fprintf(stderr, "FieldRecord gave a field the record doesn't have.\n");
+        return 1;
+    }
+
+    FieldRecord under;
+    BufferStraw under_straw(buffer, written);
+    under.Read(under_straw);
+    under.Get(value);
+    if (under.Is_Done()) {
+        fprintf(stderr, "FieldRecord was done with fields left unread.\n");
+        return 1;
+    }
+
+    // A mask naming slots the reader doesn't have.
+    FieldRecord narrow;
+    BufferStraw narrow_straw(buffer, written);
+    narrow.Read(narrow_straw);
+    int four[4];
+    narrow.Get(value);
+    narrow.Get_Target_Slots(four);
+    if (narrow.Is_Done()) {
+        fprintf(stderr, "FieldRecord took a mask with bits past its slots.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+** The same cell the way SAVEFORMAT_IMAGE keeps it: the class image, with the object pointers coded to targets in
+** place and the padding left as it is.
+*/
+static void Make_Image(TestCellType const& cell, char* image)
+{
+    memset(image, 0, CELL_IMAGE);
+    memcpy(image, &cell, offsetof(TestCellType, Occupier));
+
+    int64_t* pointers = (int64_t*)(image + 64);
+    pointers[0] = cell.Occupier;
+    for (int slot = 0; slot < CELL_OVERLAPPERS; ++slot) {
+        pointers[1 + slot] = cell.Overlappers[slot];
+    }
+    pointers[1 + CELL_OVERLAPPERS] = cell.Flag;
+}
+
+static void Save_Map(Pipe& file, std::vector<TestCellType> const& cells, bool image)
+{
+    char buffer[CELL_IMAGE];
+
+    for (int index = 0; index < CELL_COUNT; ++index) {
+        if (image) {
+            Make_Image(cells[index], buffer);
+            file.Put(buffer, CELL_IMAGE);
+        } else {
+            Put_Cell(file, cells[index]);
+        }
+    }
+}
+
+static void Save_Compressed_Map(MemoryPipe& compressed, std::vector<TestCellType> const& cells, bool image)
+{
+    LCWPipe pipe(LCWPipe::COMPRESS, SAVE_BLOCK);
+    pipe.Put_To(compressed);
+    Save_Map(pipe, cells, image);
+    pipe.End();
+}
+
+/*
+** A whole map through the compression a save uses, and back.
+*/
+int test_savefield_map()
+{
+    std::vector<TestCellType> cells;
+    Make_Map(cells, 12345);
+
+    MemoryPipe compressed;
+    Save_Compressed_Map(compressed, cells, false);
+
+    BufferStraw source(compressed.Get_Buffer(), compressed.Get_Length());
+    LCWStraw straw(LCWStraw::DECOMPRESS, SAVE_BLOCK);
+    straw.Get_From(source);
+
+    TestCellType cell;
+    for (int index = 0; index < CELL_COUNT; ++index) {
+        if (!Get_Cell(straw, cell) || !Same_Cell(cell, cells[index])) {
+            fprintf(stderr, "Cell %d didn't come back as it was saved.\n", index);
+            return 1;
+        }
+    }
+
+    char extra;
+    if (straw.Get(&extra, 1) != 0) {
+        fprintf(stderr, "The loaded map left data unread.\n");
+        return 1;
+    }
+
+    MemoryPipe image;
+    Save_Compressed_Map(image, cells, true);
+    if (compressed.Get_Length() >= image.Get_Length()) {
+        fprintf(stderr, "The field format didn't save smaller than the image format.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+** Load time and size for a full map in both formats, through the chain a save game uses: compressed, then
+** encrypted, and hashed in full before it's read. The image load includes the pass that turns the coded pointers
+** back into addresses, as Decode_All_Pointers does for cells.
+*/
+static char Objects[500];
+static char const Key[] = "A key just for the benchmark; any will do.";
+static char staging[4096];
+
+static void* Resolve(int64_t target)
+{
+    return &Objects[(target & 0xFFFF) % sizeof(Objects)];
+}
+
+void bench_savefield()
+{
+    std::vector<TestCellType> cells;
+    Make_Map(cells, 777);
+
+    for (int image = 1; image >= 0; --image) {
+        MemoryPipe raw;
+        Save_Map(raw, cells, image != 0);
+
+        MemoryPipe encrypted;
+        BlowPipe blow(BlowPipe::ENCRYPT);
+        LCWPipe lcw(LCWPipe::COMPRESS, SAVE_BLOCK);
+        blow.Key(Key, sizeof(Key));
+        blow.Put_To(encrypted);
+        lcw.Put_To(blow);
+        Save_Map(lcw, cells, image != 0);
+        lcw.End();
+
+        // Both load into a map that's already there, as the game's is.
+        std::vector<char> map((size_t)CELL_COUNT * CELL_IMAGE);
+        std::vector<TestCellType> loaded(CELL_COUNT);
+
+        const int rounds = 50;
+        void* volatile sink = NULL;
+        auto start = std::chrono::steady_clock::now();
+
+        for (int round = 0; round < rounds; ++round) {
+            BufferStraw hashed(encrypted.Get_Buffer(), encrypted.Get_Length());
+            SHAStraw sha;
+            sha.Get_From(hashed);
+            while (sha.Get(staging, sizeof(staging)) == sizeof(staging)) {
+            }
+
+            BufferStraw source(encrypted.Get_Buffer(), encrypted.Get_Length());
+            BlowStraw decrypt(BlowStraw::DECRYPT);
+            LCWStraw straw(LCWStraw::DECOMPRESS, SAVE_BLOCK);
+            decrypt.Key(Key, sizeof(Key));
+            decrypt.Get_From(source);
+            straw.Get_From(decrypt);
+
+            if (image) {
+                for (int index = 0; index < CELL_COUNT; ++index) {
+                    straw.Get(&map[(size_t)index * CELL_IMAGE], CELL_IMAGE);
+                }
+                for (int index = 0; index < CELL_COUNT; ++index) {
+                    int64_t* pointers = (int64_t*)&map[(size_t)index * CELL_IMAGE + 64];
+                    for (int slot = 0; slot < CELL_OVERLAPPERS + 2; ++slot) {
+                        if (pointers[slot] != 0) {
+                            sink = Resolve(pointers[slot]);
+                        }
+                    }
+                }
+            } else {
+                for (int index = 0; index < CELL_COUNT; ++index) {
+                    TestCellType& cell = loaded[index];
+                    Get_Cell(straw, cell);
+                    if (cell.Occupier != 0) {
+                        sink = Resolve(cell.Occupier);
+                    }
+                    for (int slot = 0; slot < CELL_OVERLAPPERS; ++slot) {
+                        if (cell.Overlappers[slot] != 0) {
+                            sink = Resolve(cell.Overlappers[slot]);
+                        }
+                    }
+                }
+            }
+        }
+
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%-6s %8d bytes raw %8d saved %8.3f ms per map load\n",
+               image ? "image" : "fields",
+               raw.Get_Length(),
+               encrypted.Get_Length(),
+               secs * 1000 / rounds);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_savefield_record();
+    ret |= test_savefield_map();
+
+    // Benchmarks only run when asked for, e.g. "test_savefield bench".
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        bench_savefield();
+    }
+
+    return ret;
+}
@@ -0,0 +1,382 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/slaballoc.h"
+#include "common/ini.h"
+#include "common/vector.h"
+#include "common/xpipe.h"
+#include "common/xstraw.h"
+
+#include <chrono>
+#include <new>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+** The test's own global new and delete, so the benchmark can switch between the pools and malloc at run time.
+** Being defined here keeps the library's newdel.cpp out of the link.
+*/
+static bool UseSlab = false;
+
+void* operator new(size_t size)
+{
+    void* ptr = UseSlab ? Slab_Alloc(size) : NULL;
+    if (ptr == NULL) {
+        ptr = malloc(size ? size : 1);
+    }
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (!Slab_Free(ptr)) {
+        free(ptr);
+    }
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+static uint32_t Next_Random(uint32_t& seed)
+{
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 8;
+}
+
+int test_slaballoc()
+{
+    std::vector<char*> blocks;
+    std::vector<size_t> sizes;
+    SlabStatsType before[SLAB_CLASSES];
+    SlabStatsType after;
+
+    for (int i = 0; i < SLAB_CLASSES; ++i) {
+        Slab_Stats(i, before[i]);
+    }
+
+    for (size_t size = 0; size <= SLAB_MAX_SIZE; ++size) {
+        char* block = (char*)Slab_Alloc(size);
+
+        if (block == NULL) {
+            fprintf(stderr, "Slab_Alloc(%d) failed.\n", (int)size);
+            return 1;
+        }
+        if ((uintptr_t)block % 16 != 0) {
+            fprintf(stderr, "Slab_Alloc(%d) returned a block that isn't 16 byte aligned.\n", (int)size);
+            return 1;
+        }
+        if (!Slab_Owns(block)) {
+            fprintf(stderr, "Slab_Owns doesn't know a block from Slab_Alloc(%d).\n", (int)size);
+            return 1;
+        }
+        memset(block, (int)(size & 0xFF), size);
+        blocks.push_back(block);
+        sizes.push_back(size);
+    }
+
+    // Every block still holds what was written, so none of them overlap.
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        for (size_t j = 0; j < sizes[i]; ++j) {
+            if (blocks[i][j] != (char)(sizes[i] & 0xFF)) {
+                fprintf(stderr, "Slab_Alloc(%d) block was overwritten.\n", (int)sizes[i]);
+                return 1;
+            }
+        }
+    }
+
+    if (Slab_Alloc(SLAB_MAX_SIZE + 1) != NULL) {
+        fprintf(stderr, "Slab_Alloc took a request bigger than SLAB_MAX_SIZE.\n");
+        return 1;
+    }
+
+    void* outside = malloc(64);
+    int local;
+    if (Slab_Owns(outside) || Slab_Owns(&local) || Slab_Owns(NULL) || Slab_Free(outside)) {
+        fprintf(stderr, "Slab_Owns claimed memory it didn't hand out.\n");
+        return 1;
+    }
+    free(outside);
+
+    for (int i = 0; i < SLAB_CLASSES; ++i) {
+        Slab_Stats(i, after);
+        if (after.InUse - before[i].InUse == 0 || after.Peak < after.InUse || after.Chunks == 0) {
+            fprintf(stderr, "Slab_Stats for the %d byte class doesn't show the new blocks.\n", (int)after.Size);
+            return 1;
+        }
+    }
+
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (!Slab_Free(blocks[i])) {
+            fprintf(stderr, "Slab_Free refused a block from Slab_Alloc(%d).\n", (int)sizes[i]);
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < SLAB_CLASSES; ++i) {
+        Slab_Stats(i, after);
+        if (after.InUse != before[i].InUse || after.Frees - before[i].Frees != after.Allocs - before[i].Allocs) {
+            fprintf(stderr, "Slab_Stats for the %d byte class doesn't balance after freeing.\n", (int)after.Size);
+            return 1;
+        }
+    }
+
+    // A freed block is the next one handed out for its class.
+    void* first = Slab_Alloc(40);
+    Slab_Free(first);
+    void* second = Slab_Alloc(33);
+    Slab_Free(second);
+
+    if (first != second) {
+        fprintf(stderr, "Slab_Alloc didn't reuse a freed block.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+** Several threads allocating and freeing at once, each checking its blocks keep their contents.
+*/
+static void Thread_Churn(int id, bool* failed)
+{
+    uint32_t seed = id + 1;
+    std::vector<unsigned char*> blocks(256, (unsigned char*)NULL);
+    std::vector<size_t> sizes(256, 0);
+
+    for (int round = 0; round < 200000; ++round) {
+        int slot = Next_Random(seed) & 0xFF;
+
+        if (blocks[slot] != NULL) {
+            for (size_t i = 0; i < sizes[slot]; ++i) {
+                if (blocks[slot][i] != (unsigned char)(slot ^ id)) {
+                    *failed = true;
+                }
+            }
+            Slab_Free(blocks[slot]);
+        }
+
+        sizes[slot] = Next_Random(seed) % (SLAB_MAX_SIZE + 1);
+        blocks[slot] = (unsigned char*)Slab_Alloc(sizes[slot]);
+        memset(blocks[slot], slot ^ id, sizes[slot]);
+    }
+
+    for (int slot = 0; slot < 256; ++slot) {
+        Slab_Free(blocks[slot]);
+    }
+}
+
+int test_slaballoc_threads()
+{
+    bool failed[4] = {false, false, false, false};
+    std::thread threads[4];
+
+    for (int i = 0; i < 4; ++i) {
+        threads[i] = std::thread(Thread_Churn, i, &failed[i]);
+    }
+    for (int i = 0; i < 4; ++i) {
+        threads[i].join();
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        if (failed[i]) {
+            fprintf(stderr, "Slab_Alloc blocks were overwritten with several threads allocating.\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+** A scenario file about the size of a big multiplayer map.
+*/
+static std::string Make_Scenario()
+{
+    std::string text;
+    char line[256];
+    uint32_t seed = 7;
+
+    text += "[Basic]\r\nName=Benchmark\r\nPlayer=Greece\r\nTheme=No Theme\r\n\r\n";
+    text += "[Map]\r\nTheater=TEMPERATE\r\nX=1\r\nY=1\r\nWidth=126\r\nHeight=126\r\n\r\n";
+
+    text += "[Waypoints]\r\n";
+    for (int i = 0; i < 100; ++i) {
+        snprintf(line, sizeof(line), "%d=%u\r\n", i, Next_Random(seed) % 16384);
+        text += line;
+    }
+
+    text += "\r\n[Trigs]\r\n";
+    for (int i = 0; i < 200; ++i) {
+        snprintf(line, sizeof(line), "trg%d=0,%d,0,0,13,0,-1,0,0,-1,0,7,0,0,0,-1,0,0,0,-1,0\r\n", i, i % 8);
+        text += line;
+    }
+
+    text += "\r\n[Units]\r\n";
+    for (int i = 0; i < 400; ++i) {
+        snprintf(line, sizeof(line), "%d=Greece,2TNK,256,%u,%u,Guard,None\r\n", i, Next_Random(seed) % 16384,
+                 Next_Random(seed) % 256);
+        text += line;
+    }
+
+    text += "\r\n[Infantry]\r\n";
+    for (int i = 0; i < 600; ++i) {
+        snprintf(line, sizeof(line), "%d=USSR,E1,256,%u,%d,Area Guard,64,None\r\n", i, Next_Random(seed) % 16384, i % 5);
+        text += line;
+    }
+
+    text += "\r\n[Structures]\r\n";
+    for (int i = 0; i < 300; ++i) {
+        snprintf(line, sizeof(line), "%d=USSR,POWR,256,%u,0,None,1,0\r\n", i, Next_Random(seed) % 16384);
+        text += line;
+    }
+
+    text += "\r\n[Terrain]\r\n";
+    for (int i = 0; i < 500; ++i) {
+        snprintf(line, sizeof(line), "%d=T%02d\r\n", (i * 37) % 16384, i % 17);
+        text += line;
+    }
+
+    text += "\r\n[MapPack]\r\n";
+    for (int i = 0; i < 120; ++i) {
+        snprintf(line, sizeof(line), "%d=", i + 1);
+        text += line;
+        for (int j = 0; j < 70; ++j) {
+            text += (char)('A' + Next_Random(seed) % 26);
+        }
+        text += "\r\n";
+    }
+
+    return text;
+}
+
+static double Seconds_Since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+** Scenario load and save/load both spend their allocations in INIClass. The transient phase is the rest of the
+** small stuff that comes and goes every frame: strings, vector growth and std::set nodes.
+*/
+static void Run_Phases(std::string const& scenario, double* times, unsigned long* sum)
+{
+    static char saved[512 * 1024];
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < 20; ++i) {
+        INIClass ini;
+        BufferStraw straw(scenario.data(), (int)scenario.size());
+        ini.Load(straw);
+        *sum += ini.Entry_Count("Units");
+    }
+    times[0] += Seconds_Since(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 20; ++i) {
+        INIClass ini;
+        BufferStraw straw(scenario.data(), (int)scenario.size());
+        ini.Load(straw);
+        ini.Put_Int("Basic", "Frame", i);
+        for (int j = 0; j < 200; ++j) {
+            char entry[16];
+            snprintf(entry, sizeof(entry), "%d", j);
+            ini.Put_String("Extra", entry, "Greece,2TNK,256,1234,64,Guard,None");
+        }
+
+        BufferPipe pipe(saved, sizeof(saved));
+        int length = ini.Save(pipe);
+
+        INIClass reload;
+        BufferStraw back(saved, length);
+        reload.Load(back);
+        *sum += reload.Entry_Count("Extra");
+    }
+    times[1] += Seconds_Since(start);
+
+    start = std::chrono::steady_clock::now();
+    uint32_t seed = 3;
+    for (int i = 0; i < 200; ++i) {
+        std::set<uint64_t> sent;
+        DynamicVectorClass<int> list;
+        std::vector<std::string> names;
+
+        for (int j = 0; j < 500; ++j) {
+            sent.insert(Next_Random(seed));
+            list.Add(j);
+            names.push_back(std::string("Message number ") + std::to_string(j));
+            if (j & 1) {
+                sent.erase(sent.begin());
+            }
+        }
+        *sum += sent.size() + list.Count() + names.size();
+    }
+    times[2] += Seconds_Since(start);
+}
+
+int bench_slaballoc()
+{
+    static char const* const phases[3] = {"scenario load", "save/load", "transient"};
+    std::string scenario = Make_Scenario();
+    double malloc_times[3] = {0, 0, 0};
+    double slab_times[3] = {0, 0, 0};
+    unsigned long sum = 0;
+
+    // Alternate so neither side gets a warmer cache.
+    for (int round = 0; round < 3; ++round) {
+        UseSlab = false;
+        Run_Phases(scenario, malloc_times, &sum);
+        UseSlab = true;
+        Run_Phases(scenario, slab_times, &sum);
+    }
+    UseSlab = false;
+
+    for (int i = 0; i < 3; ++i) {
+        printf("%-14s malloc %8.3f ms, slab %8.3f ms\n",
+               phases[i],
+               malloc_times[i] * 1000.0 / 3,
+               slab_times[i] * 1000.0 / 3);
+    }
+
+    for (int i = 0; i < SLAB_CLASSES; ++i) {
+        SlabStatsType stats;
+        Slab_Stats(i, stats);
+        printf("  %3d bytes: %8lu allocs, %6lu peak, %3lu chunks\n",
+               (int)stats.Size,
+               stats.Allocs,
+               stats.Peak,
+               stats.Chunks);
+    }
+
+    printf("(%lu)\n", sum);
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_slaballoc();
+    ret |= test_slaballoc_threads();
+
+    // Benchmarks only run when asked for, e.g. "test_slaballoc bench".
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        ret |= bench_slaballoc();
+    }
+
+    return ret;
+}
@@ -0,0 +1,212 @@
+#include "common/udpsock.h"
+
+#include <arpa/inet.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// Collects count packets, waiting up to a second for each batch to arrive.
+static int Receive_All(UDPSocketClass& sock, std::vector<UDPSocketClass::PacketType>& out, int count)
+{
+    UDPSocketClass::PacketType batch[UDPSocketClass::MAX_BATCH];
+
+    while ((int)out.size() < count && sock.Wait(1000)) {
+        int got;
+        while ((got = sock.Receive(batch, UDPSocketClass::MAX_BATCH)) > 0) {
+            out.insert(out.end(), batch, batch + got);
+        }
+    }
+
+    return (int)out.size();
+}
+
+int test_udpsock()
+{
+    int ret = 0;
+    UDPSocketClass a;
+    UDPSocketClass b;
+
+    if (!a.Open(0) || !b.Open(ntohs(a.Port()), 4)) {
+        fprintf(stderr, "UDPSocketClass::Open failed to bind on loopback.\n");
+        return 1;
+    }
+
+    // The second socket has to move up the span past the first.
+    if (b.Port() == a.Port()) {
+        fprintf(stderr, "UDPSocketClass::Open bound a port already in use.\n");
+        ret = 1;
+    }
+
+    std::vector<UDPSocketClass::PacketType> out(100);
+
+    for (int i = 0; i < 100; ++i) {
+        out[i].Address = htonl(INADDR_LOOPBACK);
+        out[i].Port = a.Port();
+        out[i].Length = 1 + i * 7;
+        memset(out[i].Data, i, out[i].Length);
+    }
+
+    unsigned calls = b.System_Calls();
+
+    if (b.Send(out.data(), 100) != 100 || b.Packets_Sent() != 100) {
+        fprintf(stderr, "UDPSocketClass::Send didn't send every packet.\n");
+        ret = 1;
+    }
+
+#ifdef __linux__
+    if (b.System_Calls() - calls > 100 / UDPSocketClass::MAX_BATCH + 1) {
+        fprintf(stderr, "UDPSocketClass::Send made %u calls for 100 packets.\n", b.System_Calls() - calls);
+        ret = 1;
+    }
+#endif
+
+    std::vector<UDPSocketClass::PacketType> in;
+
+    if (Receive_All(a, in, 100) != 100) {
+        fprintf(stderr, "UDPSocketClass::Receive got %d of 100 packets.\n", (int)in.size());
+        return 1;
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        if (in[i].Length != out[i].Length || memcmp(in[i].Data, out[i].Data, in[i].Length) != 0
+            || in[i].Port != b.Port() || in[i].Address != htonl(INADDR_LOOPBACK)) {
+            fprintf(stderr, "UDPSocketClass::Receive returned packet %d changed or from the wrong address.\n", i);
+            ret = 1;
+            break;
+        }
+    }
+
+    // Packets from ourselves are recognised, ones from another copy of the game on the same machine aren't.
+    if (!a.Is_Local(htonl(INADDR_LOOPBACK), a.Port()) || a.Is_Local(htonl(INADDR_LOOPBACK), b.Port())) {
+        fprintf(stderr, "UDPSocketClass::Is_Local confused the two sockets.\n");
+        ret = 1;
+    }
+
+    // Nothing waiting, so neither call may block.
+    UDPSocketClass::PacketType spare;
+    if (a.Wait(0) || a.Receive(&spare, 1) != 0) {
+        fprintf(stderr, "UDPSocketClass::Receive returned data when none was sent.\n");
+        ret = 1;
+    }
+
+    return ret;
+}
+
+// Two peers step a simulation in lockstep: each sends its frame's input and may only advance once it holds the
+// other's input for that frame, then both check they computed the same state.
+int test_udpsock_lockstep()
+{
+    UDPSocketClass peer[2];
+
+    if (!peer[0].Open(0) || !peer[1].Open(0)) {
+        fprintf(stderr, "UDPSocketClass::Open failed to bind on loopback.\n");
+        return 1;
+    }
+
+    uint32_t state[2] = {1, 1};
+    int const frames = 200;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < frames; ++frame) {
+        for (int p = 0; p < 2; ++p) {
+            UDPSocketClass::PacketType packet;
+            packet.Address = htonl(INADDR_LOOPBACK);
+            packet.Port = peer[p ^ 1].Port();
+            packet.Length = 8;
+            int32_t input[2] = {frame, frame * 31 + p};
+            memcpy(packet.Data, input, sizeof(input));
+            peer[p].Send(&packet, 1);
+        }
+
+        for (int p = 0; p < 2; ++p) {
+            // Wait for the other side's input for this frame, anything older is a duplicate.
+            UDPSocketClass::PacketType packet;
+            int32_t input[2] = {-1, 0};
+            bool have = false;
+            while (!have && peer[p].Wait(1000)) {
+                while (peer[p].Receive(&packet, 1) == 1) {
+                    memcpy(input, packet.Data, sizeof(input));
+                    if (input[0] == frame) {
+                        have = true;
+                        break;
+                    }
+                }
+            }
+
+            if (!have) {
+                fprintf(stderr, "Lockstep peer %d timed out on frame %d.\n", p, frame);
+                return 1;
+            }
+
+            int32_t mine = frame * 31 + p;
+            int32_t first = p == 0 ? mine : input[1];
+            int32_t second = p == 0 ? input[1] : mine;
+            state[p] = state[p] * 1664525 + first * 3 + second;
+        }
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Lockstep over loopback %8.3f us per frame\n", secs * 1000000.0 / frames);
+
+    if (state[0] != state[1]) {
+        fprintf(stderr, "Lockstep peers diverged.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int bench_udpsock()
+{
+    UDPSocketClass a;
+    UDPSocketClass b;
+    a.Open(0);
+    b.Open(0);
+    a.Set_Buffer_Size(1024 * 1024);
+
+    std::vector<UDPSocketClass::PacketType> out(UDPSocketClass::MAX_BATCH);
+    for (auto& packet : out) {
+        packet.Address = htonl(INADDR_LOOPBACK);
+        packet.Port = a.Port();
+        packet.Length = 64;
+        memset(packet.Data, 0x55, packet.Length);
+    }
+
+    for (int batch = 1; batch <= UDPSocketClass::MAX_BATCH; batch *= UDPSocketClass::MAX_BATCH) {
+        std::vector<UDPSocketClass::PacketType> in(batch);
+        unsigned packets = 0;
+        double secs = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        do {
+            int sent = b.Send(out.data(), batch);
+            int got = 0;
+            while (got < sent && a.Wait(100)) {
+                got += a.Receive(in.data(), batch);
+            }
+            packets += got;
+            secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (secs < 0.1);
+
+        printf("Loopback, %2d packets per call %8.3f us per packet\n", batch, secs * 1000000.0 / packets);
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_udpsock();
+    ret |= test_udpsock_lockstep();
+
+    // Benchmarks only run when asked for, e.g. "test_udpsock bench".
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        ret |= bench_udpsock();
+    }
+
+    return ret;
+}
@@ -0,0 +1,582 @@
+#include "common/lcw.h"
+#include "common/unvqbuff.h"
+#include "common/vqaloader.h"
+#include "common/vqatask.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Shape of the synthetic movie: a 64x32 image of 4x2 blocks with a full codebook every group.
+static const int MOVIE_WIDTH = 64;
+static const int MOVIE_HEIGHT = 32;
+static const int MOVIE_FRAMES = 40;
+static const int MOVIE_GROUP = 8;
+static const int BLOCKS_PER_ROW = MOVIE_WIDTH / 4;
+static const int NUM_BLOCKS = BLOCKS_PER_ROW * (MOVIE_HEIGHT / 2);
+static const int CB_ENTRIES = 256;
+
+// Codebooks arrive a piece per frame in CBP0 chunks rather than whole in a CBF0 chunk every group.
+static bool PartialCodebooks;
+static uint8_t LastPalette[768];
+static bool CheckPalette = true;
+
+// Stands in for the game's palette hook so the test doesn't need the display code.
+void VQA_Flag_To_Set_Palette(uint8_t* palette, int numbytes, bool slowpal)
+{
+    memcpy(LastPalette, palette, numbytes < (int)sizeof(LastPalette) ? numbytes : sizeof(LastPalette));
+}
+
+// With the OpenAL backend, movie audio pulls in the game's sound code, which needs these from the game.
+bool GameInFocus;
+int Misc;
+int RequiredCD;
+bool RunningAsDLL;
+
+bool Any_Locked()
+{
+    return false;
+}
+
+bool Force_CD_Available(int)
+{
+    return true;
+}
+
+void Prog_End(const char*, bool)
+{
+}
+
+static uint8_t Palette_Byte(int frame, int index)
+{
+    return (uint8_t)((index + frame) & 0x3F);
+}
+
+static uint8_t Codebook_Byte(int group, int entry, int index)
+{
+    return (uint8_t)(entry * 7 + index * 3 + group * 11);
+}
+
+static void Make_Pointers(int frame, int num_blocks, uint8_t* pointers)
+{
+    for (int block = 0; block < num_blocks; ++block) {
+        bool solid = frame == 0 || (block + frame) % 5 == 0;
+        pointers[block] = solid ? (uint8_t)(block * 3 + frame) : (uint8_t)(block * 13 + frame * 17);
+        pointers[block + num_blocks] = solid ? 15 : 0;
+    }
+}
+
+// What the drawer should produce for a frame. A codebook takes effect from the frame after the one completing it.
+static void Reference_Frame(int frame, uint8_t* image)
+{
+    uint8_t pointers[NUM_BLOCKS * 2];
+    Make_Pointers(frame, NUM_BLOCKS, pointers);
+    int group = PartialCodebooks ? frame / MOVIE_GROUP : frame > 0 ? (frame - 1) / MOVIE_GROUP : 0;
+
+    for (int block = 0; block < NUM_BLOCKS; ++block) {
+        uint8_t* dst = &image[(block / BLOCKS_PER_ROW) * 2 * MOVIE_WIDTH + (block % BLOCKS_PER_ROW) * 4];
+
+        for (int i = 0; i < 8; ++i) {
+            uint8_t pixel = pointers[block + NUM_BLOCKS] == 15 ? pointers[block]
+                                                                : Codebook_Byte(group, pointers[block], i);
+            dst[(i / 4) * MOVIE_WIDTH + i % 4] = pixel;
+        }
+    }
+}
+
+static void Put_Chunk(std::vector<uint8_t>& out, char const* id, void const* data, unsigned size)
+{
+    out.insert(out.end(), id, id + 4);
+    out.push_back((uint8_t)(size >> 24));
+    out.push_back((uint8_t)(size >> 16));
+    out.push_back((uint8_t)(size >> 8));
+    out.push_back((uint8_t)size);
+    out.insert(out.end(), (uint8_t const*)data, (uint8_t const*)data + size);
+
+    if (size & 1) {
+        out.push_back(0);
+    }
+}
+
+static std::vector<uint8_t> Build_Movie(int width = MOVIE_WIDTH,
+                                        int height = MOVIE_HEIGHT,
+                                        int num_frames = MOVIE_FRAMES)
+{
+    int num_blocks = (width / 4) * (height / 2);
+    std::vector<std::vector<uint8_t>> frames;
+
+    for (int frame = 0; frame < num_frames; ++frame) {
+        std::vector<uint8_t> body;
+
+        uint8_t codebook[CB_ENTRIES * 8];
+
+        if (frame == 0 || (!PartialCodebooks && frame % MOVIE_GROUP == 0)) {
+            for (int i = 0; i < (int)sizeof(codebook); ++i) {
+                codebook[i] = Codebook_Byte(frame / MOVIE_GROUP, i / 8, i % 8);
+            }
+            Put_Chunk(body, "CBF0", codebook, sizeof(codebook));
+        }
+
+        // Each frame of a group carries an eighth of the codebook for the next group.
+        if (PartialCodebooks) {
+            int piece = frame % MOVIE_GROUP;
+            for (int i = 0; i < (int)sizeof(codebook); ++i) {
+                codebook[i] = Codebook_Byte(frame / MOVIE_GROUP + 1, i / 8, i % 8);
+            }
+            Put_Chunk(body, "CBP0", &codebook[piece * sizeof(codebook) / 8], sizeof(codebook) / 8);
+        }
+
+        if (frame % 20 == 0) {
+            uint8_t palette[768];
+            for (int i = 0; i < (int)sizeof(palette); ++i) {
+                palette[i] = Palette_Byte(frame, i);
+            }
+            Put_Chunk(body, "CPL0", palette, sizeof(palette));
+        }
+
+        std::vector<uint8_t> pointers(num_blocks * 2);
+        Make_Pointers(frame, num_blocks, pointers.data());
+
+        if (frame & 1) {
+            std::vector<uint8_t> packed(num_blocks * 4);
+            Put_Chunk(body, "VPTZ", packed.data(), LCW_Comp(pointers.data(), packed.data(), pointers.size()));
+        } else {
+            Put_Chunk(body, "VPT0", pointers.data(), pointers.size());
+        }
+
+        std::vector<uint8_t> chunk;
+        Put_Chunk(chunk, "VQFR", body.data(), body.size());
+        frames.push_back(chunk);
+    }
+
+    VQAHeader header;
+    memset(&header, 0, sizeof(header));
+    header.Version = 2;
+    header.Frames = num_frames;
+    header.ImageWidth = width;
+    header.ImageHeight = height;
+    header.BlockWidth = 4;
+    header.BlockHeight = 2;
+    header.FPS = 15;
+    header.Groupsize = MOVIE_GROUP;
+    header.CBentries = CB_ENTRIES;
+
+    // Frame offsets are stored in words from the start of the file.
+    std::vector<uint8_t> finf;
+    unsigned offset = 12 + 8 + sizeof(header) + 8 + num_frames * 4;
+
+    for (auto& frame : frames) {
+        uint32_t foff = offset / 2;
+        finf.insert(finf.end(), (uint8_t*)&foff, (uint8_t*)&foff + 4);
+        offset += frame.size();
+    }
+
+    std::vector<uint8_t> form;
+    form.insert(form.end(), "WVQA", "WVQA" + 4);
+    Put_Chunk(form, "VQHD", &header, sizeof(header));
+    Put_Chunk(form, "FINF", finf.data(), finf.size());
+
+    for (auto& frame : frames) {
+        form.insert(form.end(), frame.begin(), frame.end());
+    }
+
+    std::vector<uint8_t> movie;
+    Put_Chunk(movie, "FORM", form.data(), form.size());
+    return movie;
+}
+
+struct MemoryStream
+{
+    std::vector<uint8_t> const* Data;
+    size_t Pos;
+    int ReadDelay; // Microseconds to stall each read, to starve the drawer.
+    size_t BytesRead;
+};
+
+static long Memory_Stream_Handler(VQAHandle* vqa, long action, void* buffer, long nbytes)
+{
+    MemoryStream* stream = (MemoryStream*)vqa->VQAio;
+
+    switch (action) {
+    case VQACMD_OPEN:
+        vqa->VQAio = buffer;
+        ((MemoryStream*)buffer)->Pos = 0;
+        return 0;
+
+    case VQACMD_READ:
+        if (stream->ReadDelay > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(stream->ReadDelay));
+        }
+        if (stream->Pos + nbytes > stream->Data->size()) {
+            return 1;
+        }
+        memcpy(buffer, stream->Data->data() + stream->Pos, nbytes);
+        stream->Pos += nbytes;
+        stream->BytesRead += nbytes;
+        return 0;
+
+    // A null buffer seeks from the start of the file, SEEK_CUR from the current position.
+    case VQACMD_SEEK: {
+        size_t pos = buffer == nullptr ? nbytes : stream->Pos + nbytes;
+        if (pos > stream->Data->size()) {
+            return 1;
+        }
+        stream->Pos = pos;
+        return 0;
+    }
+
+    case VQACMD_CLOSE:
+        vqa->VQAio = nullptr;
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+static int FramesSeen;
+static int FramesWrong;
+static int LastFrameSeen;
+
+static long Check_Frame(unsigned char* buffer, long frame_number)
+{
+    // A null buffer reports a frame the drawer skipped to catch up.
+    if (buffer != nullptr) {
+        uint8_t expected[MOVIE_WIDTH * MOVIE_HEIGHT];
+        Reference_Frame(frame_number, expected);
+
+        uint8_t palette[768];
+        for (int i = 0; i < (int)sizeof(palette); ++i) {
+            palette[i] = Palette_Byte(frame_number / 20 * 20, i);
+        }
+
+        if (frame_number <= LastFrameSeen || memcmp(buffer, expected, sizeof(expected)) != 0
+            || (CheckPalette && memcmp(LastPalette, palette, sizeof(palette)) != 0)) {
+            ++FramesWrong;
+        }
+
+        LastFrameSeen = frame_number;
+        ++FramesSeen;
+    }
+
+    return 0;
+}
+
+static int Play_Movie(std::vector<uint8_t> const& movie,
+                      int options,
+                      int read_delay,
+                      VQAStatistics& stats,
+                      DrawerCallbackFuncPtr callback = Check_Frame)
+{
+    MemoryStream stream = {&movie, 0, read_delay, 0};
+    VQAConfig config;
+    VQA_DefaultConfig(&config);
+    config.DrawerCallback = callback;
+    config.DrawFlags = VQACFGF_BUFFER;
+    config.OptionFlags = options;
+    config.ImageWidth = -1;
+    config.ImageHeight = -1;
+
+    FramesSeen = 0;
+    FramesWrong = 0;
+    LastFrameSeen = -1;
+
+    VQAHandle* vqa = VQA_Alloc();
+    VQA_Init(vqa, Memory_Stream_Handler);
+
+    if (VQA_Open(vqa, (char const*)&stream, &config) != VQAERR_NONE) {
+        VQA_Free(vqa);
+        return 1;
+    }
+
+    VQA_Play(vqa, VQAMODE_RUN);
+    VQA_GetStats(vqa, &stats);
+    VQA_Close(vqa);
+    VQA_Free(vqa);
+
+    return 0;
+}
+
+int test_vqa_play()
+{
+    int ret = 0;
+    std::vector<uint8_t> movie = Build_Movie();
+
+    struct
+    {
+        char const* Name;
+        int Options;
+        int ReadDelay;
+    } const runs[] = {
+        {"inline", VQAOPTF_SINGLESTEP, 0},
+        {"prefetch", VQAOPTF_SINGLESTEP | VQAOPTF_PREFETCH, 0},
+        {"prefetch with slow reads", VQAOPTF_SINGLESTEP | VQAOPTF_PREFETCH, 200},
+    };
+
+    for (auto& run : runs) {
+        VQAStatistics stats;
+
+        if (Play_Movie(movie, run.Options, run.ReadDelay, stats) != 0) {
+            fprintf(stderr, "VQA_Open failed on the synthetic movie (%s).\n", run.Name);
+            ret = 1;
+            continue;
+        }
+
+        if (FramesSeen != MOVIE_FRAMES || FramesWrong != 0 || stats.FramesLoaded != MOVIE_FRAMES
+            || stats.FramesDrawn != MOVIE_FRAMES) {
+            fprintf(stderr,
+                    "VQA_Play (%s) showed %d frames with %d wrong, loaded %d and drew %d.\n",
+                    run.Name,
+                    FramesSeen,
+                    FramesWrong,
+                    stats.FramesLoaded,
+                    stats.FramesDrawn);
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
+
+static int Seek_And_Play(VQAHandle* vqa, int frame)
+{
+    FramesSeen = 0;
+    FramesWrong = 0;
+    LastFrameSeen = frame - 1;
+    memset(LastPalette, 0, sizeof(LastPalette));
+
+    if (VQA_SeekFrame(vqa, frame, 0) != frame) {
+        fprintf(stderr, "VQA_SeekFrame failed to seek to frame %d.\n", frame);
+        return 1;
+    }
+
+    VQA_Play(vqa, VQAMODE_RUN);
+
+    if (FramesSeen != MOVIE_FRAMES - frame || FramesWrong != 0) {
+        fprintf(stderr,
+                "VQA_Play after seeking to frame %d showed %d frames with %d wrong.\n",
+                frame,
+                FramesSeen,
+                FramesWrong);
+        return 1;
+    }
+
+    return 0;
+}
+
+int test_vqa_seek()
+{
+    int ret = 0;
+
+    for (bool partial : {false, true}) {
+        PartialCodebooks = partial;
+        std::vector<uint8_t> movie = Build_Movie();
+
+        for (int options : {(int)VQAOPTF_SINGLESTEP, VQAOPTF_SINGLESTEP | VQAOPTF_SEEKINDEX}) {
+            // Group based seeking only knows about full codebooks and doesn't restore the palette.
+            if (partial && !(options & VQAOPTF_SEEKINDEX)) {
+                continue;
+            }
+
+            CheckPalette = (options & VQAOPTF_SEEKINDEX) != 0;
+
+            MemoryStream stream = {&movie, 0, 0, 0};
+            VQAConfig config;
+            VQA_DefaultConfig(&config);
+            config.DrawerCallback = Check_Frame;
+            config.DrawFlags = VQACFGF_BUFFER;
+            config.OptionFlags = options;
+            config.ImageWidth = -1;
+            config.ImageHeight = -1;
+
+            VQAHandle* vqa = VQA_Alloc();
+            VQA_Init(vqa, Memory_Stream_Handler);
+
+            if (VQA_Open(vqa, (char const*)&stream, &config) != VQAERR_NONE) {
+                fprintf(stderr, "VQA_Open failed on the synthetic movie.\n");
+                VQA_Free(vqa);
+                ret = 1;
+                continue;
+            }
+
+            // Scrub back and forth across group and palette boundaries, playing out to the end each time.
+            for (int frame : {13, 1, 39, 8, 20, 7, 21, 0, 33}) {
+                ret |= Seek_And_Play(vqa, frame);
+            }
+
+            if (VQA_SeekFrame(vqa, MOVIE_FRAMES, 0) >= 0 || VQA_SeekFrame(vqa, -1, 0) >= 0) {
+                fprintf(stderr, "VQA_SeekFrame accepted a frame outside the movie.\n");
+                ret = 1;
+            }
+
+            stream.BytesRead = 0;
+            VQA_SeekFrame(vqa, 31, 0);
+            printf("VQA_SeekFrame %-9s %-7s %6d bytes read to reach frame 31\n",
+                   (options & VQAOPTF_SEEKINDEX) ? "indexed" : "group",
+                   partial ? "partial" : "full",
+                   (int)stream.BytesRead);
+
+            VQA_Close(vqa);
+            VQA_Free(vqa);
+        }
+    }
+
+    PartialCodebooks = false;
+    CheckPalette = true;
+    return ret;
+}
+
+int bench_vqa()
+{
+    // A reader that stalls on each chunk; with prefetch the stalls overlap drawing.
+    std::vector<uint8_t> movie = Build_Movie();
+    int ret = 0;
+
+    for (int options : {(int)VQAOPTF_SINGLESTEP, VQAOPTF_SINGLESTEP | VQAOPTF_PREFETCH}) {
+        VQAStatistics stats;
+        auto start = std::chrono::steady_clock::now();
+        ret |= Play_Movie(movie, options, 100, stats);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        printf("VQA_Play %-8s %8.3f ms for %d frames, %d underruns\n",
+               (options & VQAOPTF_PREFETCH) ? "prefetch" : "inline",
+               secs * 1000.0,
+               stats.FramesDrawn,
+               stats.Underruns);
+    }
+
+    return ret;
+}
+
+typedef void (*UnVQFunc)(uint8_t*, uint8_t*, uint8_t*, unsigned, unsigned, unsigned);
+
+int test_unvq()
+{
+    int ret = 0;
+    uint32_t seed = 12345;
+    auto rand8 = [&seed]() {
+        seed = seed * 1103515245 + 12345;
+        return (uint8_t)(seed >> 16);
+    };
+
+    // Three pages of 16 byte entries covers both block sizes for the high bytes used below.
+    std::vector<uint8_t> codebook(3 * 256 * 16);
+    for (auto& byte : codebook) {
+        byte = rand8();
+    }
+
+    struct
+    {
+        char const* Name;
+        UnVQFunc Vector;
+        UnVQFunc Scalar;
+        int BlockHeight;
+        uint8_t Solid;
+    } const kinds[] = {
+        {"UnVQ_4x2", UnVQ_4x2, UnVQ_4x2_Scalar, 2, 15},
+        {"UnVQ_4x4", UnVQ_4x4, UnVQ_4x4_Scalar, 4, 255},
+    };
+
+    for (auto& kind : kinds) {
+        for (unsigned blocks_per_row : {1, 7, 8, 9, 16, 23, 80}) {
+            for (unsigned num_rows : {1, 3, 25}) {
+                for (unsigned pad : {0, 12}) {
+                    unsigned num_blocks = blocks_per_row * num_rows;
+                    unsigned buff_width = blocks_per_row * 4 + pad;
+                    std::vector<uint8_t> pointers(num_blocks * 2);
+
+                    for (unsigned i = 0; i < num_blocks; ++i) {
+                        uint8_t pick = rand8() & 3;
+                        pointers[i] = rand8();
+                        pointers[i + num_blocks] = pick == 3 ? kind.Solid : pick;
+                    }
+
+                    // Guard bytes past the image catch any stray wide store.
+                    size_t size = num_rows * kind.BlockHeight * buff_width + 64;
+                    std::vector<uint8_t> expected(size, 0xCD);
+                    std::vector<uint8_t> actual(size, 0xCD);
+                    uint8_t* cb = codebook.data();
+                    kind.Scalar(cb, pointers.data(), expected.data(), blocks_per_row, num_rows, buff_width);
+                    kind.Vector(cb, pointers.data(), actual.data(), blocks_per_row, num_rows, buff_width);
+
+                    if (expected != actual) {
+                        fprintf(stderr,
+                                "%s differs from the scalar expander for %u x %u blocks in a %u byte wide buffer.\n",
+                                kind.Name,
+                                blocks_per_row,
+                                num_rows,
+                                buff_width);
+                        ret = 1;
+                    }
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+int bench_unvq()
+{
+    // A full screen 320x200 movie image of 4x2 blocks, about a fifth of them solid.
+    unsigned const blocks_per_row = 80;
+    unsigned const num_rows = 100;
+    unsigned const num_blocks = blocks_per_row * num_rows;
+    std::vector<uint8_t> codebook(256 * 8);
+    std::vector<uint8_t> pointers(num_blocks * 2);
+    std::vector<uint8_t> image(320 * 200);
+
+    for (size_t i = 0; i < codebook.size(); ++i) {
+        codebook[i] = (uint8_t)(i * 7);
+    }
+
+    Make_Pointers(1, num_blocks, pointers.data());
+
+    for (UnVQFunc unvq : {UnVQ_4x2_Scalar, UnVQ_4x2}) {
+        int frames = 0;
+        double secs = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        do {
+            for (int i = 0; i < 100; ++i) {
+                unvq(codebook.data(), pointers.data(), image.data(), blocks_per_row, num_rows, 320);
+            }
+            frames += 100;
+            secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (secs < 0.2);
+
+        printf("%-15s %8.3f us per 320x200 frame\n",
+               unvq == UnVQ_4x2 ? "UnVQ_4x2" : "UnVQ_4x2_Scalar",
+               secs * 1000000.0 / frames);
+    }
+
+    // The same expander driven through VQA_DrawFrame_Buffer by playing a full screen movie.
+    std::vector<uint8_t> movie = Build_Movie(320, 200, 240);
+    VQAStatistics stats;
+    auto start = std::chrono::steady_clock::now();
+    int ret = Play_Movie(movie, VQAOPTF_SINGLESTEP, 0, stats, nullptr);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("VQA_Play        %8.3f us per 320x200 frame decoded and drawn\n", secs * 1000000.0 / stats.FramesDrawn);
+    return ret != 0 || stats.FramesDrawn != 240;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_vqa_play();
+    ret |= test_vqa_seek();
+    ret |= test_unvq();
+
+    // Benchmarks only run when asked for, e.g. "test_vqa bench".
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        ret |= bench_vqa();
+        ret |= bench_unvq();
+    }
+
+    return ret;
+}
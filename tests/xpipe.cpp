@@ -0,0 +1,132 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common/lcwpipe.h"
+#include "common/lcwstraw.h"
+#include "common/shapipe.h"
+#include "common/xpipe.h"
+#include "common/xstraw.h"
+
+#include <thread>
+#include <vector>
+
+static uint32_t Next_Random(uint32_t& seed)
+{
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 8;
+}
+
+/*
+** Game data in the odd sized pieces a save writes it in, compressible in places.
+*/
+static void Put_Pieces(Pipe& pipe, uint32_t seed)
+{
+    char piece[700];
+
+    for (int i = 0; i < 400; ++i) {
+        int length = 1 + Next_Random(seed) % sizeof(piece);
+        for (int j = 0; j < length; ++j) {
+            piece[j] = (i & 1) ? (char)Next_Random(seed) : (char)(j / 16);
+        }
+        pipe.Put(piece, length);
+    }
+    pipe.Flush();
+}
+
+int test_memorypipe()
+{
+    MemoryPipe memory(16);
+
+    if (memory.Get_Length() != 0 || memory.Put(NULL, 10) != 0 || memory.Put("x", 0) != 0) {
+        fprintf(stderr, "MemoryPipe took data it shouldn't have.\n");
+        return 1;
+    }
+
+    std::vector<char> expected;
+    uint32_t seed = 5;
+    for (int i = 0; i < 1000; ++i) {
+        char piece[64];
+        int length = 1 + Next_Random(seed) % sizeof(piece);
+        memset(piece, i, length);
+        if (memory.Put(piece, length) != length) {
+            fprintf(stderr, "MemoryPipe didn't take all of a piece.\n");
+            return 1;
+        }
+        expected.insert(expected.end(), piece, piece + length);
+    }
+
+    if (memory.Get_Length() != (int)expected.size()
+        || memcmp(memory.Get_Buffer(), expected.data(), expected.size()) != 0) {
+        fprintf(stderr, "MemoryPipe didn't keep what was sent to it.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+** Capturing data in memory and compressing it later on another thread gives exactly the bytes that compressing
+** it as it was produced does.
+*/
+static void Compress(MemoryPipe const* snapshot, char* out, char* digest)
+{
+    BufferPipe buffer(out, 1024 * 1024);
+    SHAPipe sha;
+    LCWPipe lcw(LCWPipe::COMPRESS, 4096);
+
+    sha.Put_To(buffer);
+    lcw.Put_To(sha);
+    if (snapshot != NULL) {
+        lcw.Put(snapshot->Get_Buffer(), snapshot->Get_Length());
+    } else {
+        Put_Pieces(lcw, 9);
+    }
+    lcw.Flush();
+    sha.Result(digest);
+    lcw.End();
+}
+
+int test_memorypipe_deferred()
+{
+    static char direct[1024 * 1024];
+    static char deferred[1024 * 1024];
+    char direct_digest[20];
+    char deferred_digest[20];
+
+    Compress(NULL, direct, direct_digest);
+
+    MemoryPipe snapshot;
+    Put_Pieces(snapshot, 9);
+    std::thread worker(Compress, &snapshot, deferred, deferred_digest);
+    worker.join();
+
+    if (memcmp(direct_digest, deferred_digest, sizeof(direct_digest)) != 0
+        || memcmp(direct, deferred, sizeof(direct)) != 0) {
+        fprintf(stderr, "Compressing a snapshot gave different output to compressing as it went.\n");
+        return 1;
+    }
+
+    // And it still decompresses to the original.
+    static char restored[1024 * 1024];
+    BufferStraw source(deferred, sizeof(deferred));
+    LCWStraw lcw(LCWStraw::DECOMPRESS, 4096);
+    lcw.Get_From(source);
+    if (lcw.Get(restored, snapshot.Get_Length()) != snapshot.Get_Length()
+        || memcmp(restored, snapshot.Get_Buffer(), snapshot.Get_Length()) != 0) {
+        fprintf(stderr, "A compressed snapshot didn't decompress to what was captured.\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = 0;
+
+    ret |= test_memorypipe();
+    ret |= test_memorypipe_deferred();
+
+    return ret;
+}
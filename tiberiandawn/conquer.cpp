@@ -1848,16 +1848,17 @@ long MixFileHandler(VQAHandle* vqa, long action, void* buffer, long nbytes)
         break;
 
     /*
-    **	VQACMD_SEEK asks that you perform a seek relative to the current
-    ** position. NBytes is a signed number, indicating seek direction
-    ** (positive for forward, negative for backward). Buffer has no meaning
-    ** here.
+    **	VQACMD_SEEK asks that you perform a seek. Buffer holds the origin:
+    ** SEEK_CUR for a seek relative to the current position, where NBytes
+    ** is a signed number indicating seek direction (positive for forward,
+    ** negative for backward), or NULL for an absolute seek to NBytes from
+    ** the start of the file.
     **
     ** Any error code returned will be remapped by VQA library into
     ** VQAERR_SEEK.
     */
     case VQACMD_SEEK:
-        error = (file->Seek(nbytes, SEEK_CUR) == -1);
+        error = (file->Seek(nbytes, buffer == NULL ? SEEK_SET : SEEK_CUR) == -1);
         break;
 
     /*
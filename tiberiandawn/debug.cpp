@@ -158,6 +158,12 @@ void Debug_Key(unsigned input)
             Explosion_Damage(Map.Pixel_To_Coord(Get_Mouse_X(), Get_Mouse_Y()), 250, NULL, WARHEAD_HE);
             break;
 
+        case KN_Y: {
+            char report[1024];
+            Memory_Report(report, sizeof(report));
+            DBG_INFO("Memory use by subsystem:\n%s", report);
+        } break;
+
         case KN_Z:
             //				new AnimClass(ANIM_LZ_SMOKE, Map.Pixel_To_Coord(Get_Mouse_X(), Get_Mouse_Y()));
             GDI_Ending();
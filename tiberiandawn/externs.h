@@ -50,6 +50,7 @@
 #include "infantry.h"
 #include "jshell.h"
 #include "common/vqaconfig.h"
+#include "common/arena.h"
 
 #ifdef REMASTER_BUILD
 #ifdef MEGAMAPS
@@ -90,6 +91,7 @@ extern bool Debug_Check_Map;
 extern bool Debug_Playtest;
 
 extern bool Debug_Heap_Dump;
+extern bool Debug_Memory_Report;
 extern bool Debug_Smart_Print;
 extern bool Debug_Trap_Check_Heap;
 extern bool Debug_Instant_Build;
@@ -231,6 +233,7 @@ extern int CarryOverPercent;
 extern char ScenarioName[_MAX_FNAME + _MAX_EXT];
 extern unsigned BuildLevel;
 extern uint32_t ScenarioCRC;
+extern ArenaClass ScenarioArena;
 
 #ifdef SCENARIO_EDITOR
 extern CELL CurrentCell;
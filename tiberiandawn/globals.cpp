@@ -54,6 +54,7 @@ bool Debug_Check_Map = false; // true = validate the map each frame
 bool Debug_Playtest = false;
 int In_Debugger = 0;
 bool Debug_Heap_Dump = false;       // true = print the Heap Dump
+bool Debug_Memory_Report = false;   // true = write memory.txt on exit
 bool Debug_Smart_Print = false;     // true = print everything that calls Smart_Printf
 bool Debug_Trap_Check_Heap = false; // true = check the Heap
 bool Debug_Instant_Build = false;
@@ -323,6 +324,12 @@ unsigned BuildLevel = 3; // Buildable level (1 = simplest)
 */
 uint32_t ScenarioCRC;
 
+/***************************************************************************
+**	Data that lives exactly as long as the current scenario is allocated from
+** here. It is reset in one go by Clear_Scenario.
+*/
+ArenaClass ScenarioArena;
+
 /***************************************************************************
 **	The various tutor and dialog messages are located in the data block
 **	referenced by this pointer.
@@ -36,6 +36,8 @@
 #define HEAP_H
 
 #include "vector.h"
+#include "freeslot.h"
+#include "activelist.h"
 
 /**************************************************************************
 **	This is a block memory managment handler. It is used when memory is to
@@ -104,9 +106,10 @@ protected:
     void* Buffer;
 
     /*
-    **	This is a boolean vector array of allocation flag bits.
+    **	This is a bit array of the free blocks. It hands out the lowest numbered
+    **	free block without examining every flag.
     */
-    BooleanVectorClass FreeFlag;
+    FreeSlotClass FreeSlots;
 
 private:
     // The assignment operator is not supported.
@@ -152,8 +155,9 @@ protected:
 /**************************************************************************
 **	This is a derivative of the fixed heap class. This class adds the
 **	ability to quickly iterate through the active (allocated) objects. Since the
-**	active array is a sequence of pointers, the overhead of this class
-**	is 4 bytes per potential allocated object (be warned).
+**	active array is a sequence of pointers, along with the position of each
+**	block in that array, the overhead of this class is a pointer and two
+**	integers per potential allocated object (be warned).
 */
 class FixedIHeapClass : public FixedHeapClass
 {
@@ -170,16 +174,18 @@ public:
 
     virtual void* Active_Ptr(int index)
     {
-        return ActivePointers[index];
+        return ActiveList[index];
     };
 
+protected:
+    void Activate(int index);
+
     /*
-    **	This is an array of pointers to allocated objects. Using this array
-    **	to control iteration through the objects ensures a minimum of processing.
-    **	It also allows access to this array so that custom sorting can be
-    **	performed.
+    **	The allocated objects in iteration order. Using this list to control
+    **	iteration through the objects ensures a minimum of processing, and it
+    **	knows where each block is in the order so freeing one doesn't search.
     */
-    DynamicVectorClass<void*> ActivePointers;
+    ActiveListClass ActiveList;
 };
 
 /**************************************************************************
@@ -217,7 +223,7 @@ public:
 
     virtual T* Ptr(int index)
     {
-        return (T*)FixedIHeapClass::ActivePointers[index];
+        return (T*)FixedIHeapClass::ActiveList[index];
     };
     virtual T* Raw_Ptr(int index)
     {
@@ -327,10 +333,13 @@ template <class T> int TFixedIHeapClass<T>::Load(FileClass& file)
         /*
         ** Get a pointer to the object, activate that object
         */
+        if (idx < 0 || idx >= TotalCount || !FreeSlots.Is_Free(idx)) {
+            return (false);
+        }
         ptr = (T*)(*this)[idx];
-        FreeFlag[idx] = true;
+        FreeSlots.Take(idx);
         ActiveCount++;
-        ActivePointers.Add(ptr);
+        Activate(idx);
 
         /*
         ** Load the object
@@ -2105,6 +2105,14 @@ bool Parse_Command_Line(int argc, char* argv[])
             continue;
         }
 
+        /*
+        **	Write the memory accounting to memory.txt on exit.
+        */
+        if (stricmp(string, "-MEMREPORT") == 0) {
+            Debug_Memory_Report = true;
+            continue;
+        }
+
 #ifdef CHEAT_KEYS
         /*
         **	Allow solo net play
@@ -478,6 +478,8 @@ void MapClass::Alloc_Cells(void)
     **	(it may have been loaded from a save-game file), so zero it out first.
     */
     new (&Array) VectorClass<CellClass>;
+
+    MemoryTagClass tag(MEM_TAG_MAP);
     Array.Resize(Size);
 }
 
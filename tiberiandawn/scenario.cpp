@@ -352,6 +352,16 @@ void Clear_Scenario(void)
     Base.Init();
 
     CurrentObject.Clear_All();
+
+    /*
+    **	Everything that was allocated for the scenario's lifetime goes at once.
+    */
+    if (ScenarioArena.High_Water() != 0) {
+        DBG_INFO("Scenario arena high water %lu bytes, %lu bytes reserved",
+                 ScenarioArena.High_Water(),
+                 ScenarioArena.Reserved());
+    }
+    ScenarioArena.Reset();
 }
 
 /***********************************************************************************************
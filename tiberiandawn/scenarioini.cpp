@@ -265,6 +265,7 @@ bool Read_Scenario_Ini(char* root, bool fresh)
     sprintf(fname, "%s.INI", root);
     CCINIClass ini;
     CCFileClass file(fname);
+    ini.Set_Arena(&ScenarioArena);
 
     int result = ini.Load(file, true);
     if (result == 0) {
@@ -681,6 +682,7 @@ bool Read_Scenario_Ini_File(char* scenario_file_name, char* bin_file_name, const
 
     CCINIClass ini;
     CCFileClass file(scenario_file_name);
+    ini.Set_Arena(&ScenarioArena);
 
     int result = ini.Load(file, true);
     if (result == 0) {
@@ -386,6 +386,13 @@ int main(int argc, char** argv)
         Settings.Save(ini);
         ini.Save(cfile);
 
+        /*
+        ** Leave a record of where the memory went this session, if asked for with -MEMREPORT.
+        */
+        if (Debug_Memory_Report) {
+            Memory_Report_File((std::string(Paths.User_Path()) + PathsClass::SEP + "memory.txt").c_str());
+        }
+
         VisiblePage.Clear();
         HiddenPage.Clear();
 